@@ -35,6 +35,7 @@ public:
 
 public:
 	static File*     Open(const wchar_t* Path);
+	static File*     Open(const wchar_t* Path, MODE Mode); // WRITE creates or truncates the file
 	static File*     Open(const FILE_PATH& Path);
 
 	static void      Close(File* pIFile);
@@ -52,6 +53,40 @@ public:
 	virtual uint64_t GetSize(void) = 0;
 
 	virtual bool     ReadBytes(void* pBuffer, uint32_t numBytes) = 0;
+	virtual bool     WriteBytes(const void* pBuffer, uint32_t numBytes) = 0;
+};
+
+// Mapped File
+class MappedFile
+{
+public:
+	// The whole file is mapped read only, the data stays valid until Close
+	static MappedFile*     Open(const wchar_t* Path);
+	static void            Close(MappedFile* pIMappedFile);
+
+public:
+	virtual const uint8_t* GetData(void) = 0;
+	virtual uint64_t       GetSize(void) = 0;
+};
+
+// Parallel
+class Parallel
+{
+public:
+	typedef void (*RANGE_FUNCTION)(void* pContext, uint32_t Begin, uint32_t End);
+
+public:
+	static uint32_t GetThreadCount(void); // worker threads plus the calling thread
+
+	// Runs pFunction over [0, Count) in ranges of at most Grain items, on the worker threads and the calling thread
+	// Returns when every range is done, calls made from inside a range run serially on the calling thread
+	static void     For(uint32_t Count, uint32_t Grain, RANGE_FUNCTION pFunction, void* pContext);
+
+	template <typename F>
+	static void     For(uint32_t Count, uint32_t Grain, F& Function)
+	{
+		For(Count, Grain, [](void* pContext, uint32_t Begin, uint32_t End) { (*static_cast<F*>(pContext))(Begin, End); }, &Function);
+	}
 };
 
 // System
@@ -0,0 +1,26 @@
+#ifndef CG_EXPORTER__HPP
+#define CG_EXPORTER__HPP
+
+#include <stdint.h>
+
+#include "CgImporter.hpp"
+
+class Exporter
+{
+public:
+	struct MDL_OPTIONS
+	{
+		uint32_t version; // MDL_VERSION_1 (or 0, the same layout), or MDL_VERSION_2 for a table of contents and one block per mesh
+	};
+
+public:
+	// Writes a version 1 file, reading it back with ReadMdl gives the same data
+	// Strings are written with their terminator and must be shorter than 255 characters, empty lists are not written
+	// A file written here and read back is written again byte for byte, given its version (MDL_VIEW::version).
+	// MDL_DATA does not keep the version or the layout of other files: the default version is 1, an empty node, bone or
+	// material block is dropped and version 1 meshes are written in one block
+	static bool WriteMdl(const wchar_t* path, const Importer::MDL_DATA& data);
+	static bool WriteMdl(const wchar_t* path, const Importer::MDL_DATA& data, const MDL_OPTIONS& options);
+};
+
+#endif // CG_EXPORTER__HPP
@@ -0,0 +1,33 @@
+#ifndef CG_IMAGE__HPP
+#define CG_IMAGE__HPP
+
+#include <stdint.h>
+
+/* Pixel format conversions of whole images (defined in Source/Image) */
+
+// The conversions produce (or consume) the R8G8B8A8 rows that CreateTexture uploads. Pitches are the distances in
+// bytes between the starts of two rows, the rows are split over the Parallel workers.
+class Image
+{
+public:
+	// RGB8 to RGBA8 with opaque alpha
+	static void RgbToRgba(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+
+	// BGRA8 to RGBA8 (and back), pSrc may be pDst
+	static void BgraToRgba(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+
+	// RGBA8 to RGBA8 with the color multiplied by alpha, rounded like round(c * a / 255), pSrc may be pDst
+	static void Premultiply(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+
+	// RGBA8 sRGB to RGBA32F linear and back, alpha is linear in both
+	// SrgbToLinear is within 3e-6 of the exact curve (relative error)
+	// LinearToSrgb clamps to [0, 1] (NaN gives 1) and is within one step of the exact encoding, almost always equal to it
+	static void SrgbToLinear(const uint8_t* pSrc, uint32_t srcPitch, float* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+	static void LinearToSrgb(const float* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+
+	// RGBA32F and RGBA16F to RGBA8 UNORM, clamped to [0, 1] (NaN gives 1) and rounded to nearest
+	static void FloatToUnorm8(const float* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+	static void HalfToUnorm8(const uint16_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height);
+};
+
+#endif // CG_IMAGE__HPP
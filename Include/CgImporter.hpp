@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "CgMath.hpp"
+
 class Importer
 {
 public:
@@ -54,8 +56,84 @@ public:
 		std::vector<Material> materials;
 	};
 
+	// Mesh of a mapped MDL file, the lists point into the mapping and are not aligned to their elements
+	// Vertex i has the layout of Vertex at pVertices + i * vertexStride
+	struct MeshView
+	{
+		std::string     name;
+		const uint8_t*  pVertices;
+		uint32_t        vertexStride;
+		uint32_t        vertexCount;
+		const uint16_t* pIndices;
+		uint32_t        indexCount;
+	};
+
+	// Block of a mapped MDL file, listed by the table of contents of version 2 files
+	// Version 1 files have no table of contents, their blocks are found (and loaded) by parsing the whole file
+	struct BlockInfo
+	{
+		uint32_t type;     // MDL_NODE, MDL_BONE, MDL_MTL or MDL_MESH
+		uint32_t nameHash; // MdlNameHash of the mesh of a version 2 mesh block, 0 otherwise
+		uint64_t offset;
+		uint64_t size;
+		uint32_t checksum; // 0 without a table of contents
+		bool     loaded;   // its contents are in the view
+	};
+
+	// Post-transform vertex cache statistics of a triangle list, simulated with a FIFO of cacheSize vertices
+	struct CACHE_STATS
+	{
+		float acmr; // transformed vertices per triangle, 0.5 at best and 3 at worst
+		float atvr; // transformed vertices per referenced vertex, 1 at best
+	};
+
+	struct OPTIMIZE_DESC
+	{
+		uint32_t cacheSize;         // vertices, 16 to 32 for current hardware
+		float    overdrawThreshold; // ACMR growth allowed to the overdraw clusters (1.05 is typical), 0 skips the overdraw pass
+	};
+
+	struct MDL_VIEW
+	{
+		std::vector<Node>      nodes;
+		std::vector<Bone>      bones;
+		std::vector<MeshView>  meshes;
+		std::vector<Material>  materials;
+		std::vector<BlockInfo> blocks;
+		uint32_t               version = 0;
+		class MappedFile*      pFile = nullptr; // open while the views are in use
+	};
+
 public:
+	// Maps the file, walks its blocks and then copies the meshes out on the Parallel workers, in file order
 	static bool ReadMdl(const wchar_t* path, MDL_DATA& rData);
+
+	// Maps the file and parses it in place, the mesh views stay valid until UnmapMdl
+	static bool MapMdl(const wchar_t* path, MDL_VIEW& rView);
+	static void UnmapMdl(MDL_VIEW& rView);
+
+	// Maps the file and reads the table of contents only, the blocks are then loaded on demand and appended to the view
+	// LoadMdlBlock verifies the checksum of the block, LoadMdlMesh loads the mesh blocks whose name hash matches
+	static bool OpenMdl(const wchar_t* path, MDL_VIEW& rView);
+	static bool LoadMdlBlock(MDL_VIEW& rView, uint32_t block);
+	static bool LoadMdlMesh(MDL_VIEW& rView, const char* pName);
+
+	// Optional optimization of imported meshes, the triangles are reordered for the vertex cache (Tipsify), then
+	// by clusters facing away from the center first for less overdraw, then the vertices by first use for fetch locality
+	// OptimizeMdl runs the meshes on the Parallel workers and gives the statistics over all of them
+	static bool GetCacheStats(const Mesh& mesh, uint32_t cacheSize, CACHE_STATS& rStats);
+	static bool OptimizeMesh(Mesh& rMesh, const OPTIMIZE_DESC& desc, CACHE_STATS& rBefore, CACHE_STATS& rAfter);
+	static bool OptimizeMdl(MDL_DATA& rData, const OPTIMIZE_DESC& desc, CACHE_STATS& rBefore, CACHE_STATS& rAfter);
+
+	// Vertex attribute streams, Set* resizes the vertex array to the size of the stream
+	static bool GetPositions(const std::vector<Vertex>& vertices, Vector3SoA& rPositions);
+	static bool GetNormals(const std::vector<Vertex>& vertices, Vector3SoA& rNormals);
+	static void SetPositions(const Vector3SoA& positions, std::vector<Vertex>& vertices);
+	static void SetNormals(const Vector3SoA& normals, std::vector<Vertex>& vertices);
+	static bool GetPositions(const MeshView& mesh, Vector3SoA& rPositions);
+	static bool GetNormals(const MeshView& mesh, Vector3SoA& rNormals);
+	static void GetVertices(const MeshView& mesh, std::vector<Vertex>& rVertices);
+	static void GetIndices(const MeshView& mesh, std::vector<uint16_t>& rIndices);
 };
 
 #endif // CG_IMPORTER__HPP
\ No newline at end of file
@@ -10,20 +10,45 @@
 #include <cstdint>
 
 #include <string>
+#include <type_traits>
+#include <vector>
 
 /* Notes: */
 /* All rotations are in radians */
 /* All matrices are row major */
 /* The coordinate system is left handed (+X is to the right, +Y is upwards, +Z is forwards) */
+/* The vector, quaternion and matrix types are trivially copyable, their members are defined inline in CgMath.inl */
 
 #define INF INFINITY
 
+// ------------------------------------------ SIMD -----------------------------------------------
+/* Vector4F and Matrix4F use SSE when targeting x86/x64, and AVX2 where the compiler targets it (/arch:AVX2). */
+/* Define CG_MATH_NO_SIMD to build the scalar reference implementation only. */
+/* The SIMD results match the reference bit for bit only without floating point contraction, see CMathSimd.cpp. */
+
+#if !defined(CG_MATH_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__))
+#define CG_MATH_SSE 1
+#if defined(__AVX2__)
+#define CG_MATH_AVX2 1
+#endif
+#if defined(__AVX2__) || defined(__F16C__)
+#define CG_MATH_F16C 1 // half float conversions, every AVX2 CPU has F16C
+#endif
+#endif
+
 // ----------------------------------------- Scalar ----------------------------------------------
 template <typename T>
 T Step(T v0, T v1, T step);
 
 template <typename T>
-T Clamp(T val, T min, T max);
+constexpr T Clamp(T val, T min, T max);
+
+// Batched functions: pOut[i] = f(pIn[i]) for i < count, the inputs and outputs may be the same array
+// SinCos for float is a polynomial approximation with an absolute error of at most 1.2e-7 for |x| <= 8192 (the range is not checked)
+// ReciprocalSqrt for float uses the SSE estimate refined by a Newton-Raphson step, the relative error is at most 4e-7 for normal x > 0
+// double (and ReciprocalSqrt for float without SSE) uses std::sin, std::cos and 1 / std::sqrt
+template <typename T> void SinCos(const T* pIn, T* pSin, T* pCos, uint32_t count);
+template <typename T> void ReciprocalSqrt(const T* pIn, T* pOut, uint32_t count);
 
 // ----------------------------------------- Vector ----------------------------------------------
 
@@ -36,31 +61,28 @@ struct Vector2
 		struct { T x, y; };
 	};
 
-	Vector2<T>();
-	Vector2<T>(T t);
-	Vector2<T>(T _x, T _y);
-	Vector2<T>(const Vector2<T>& v);
+	constexpr Vector2();
+	constexpr Vector2(T t);
+	constexpr Vector2(T _x, T _y);
 
-	Vector2<T>& operator = (const Vector2<T>& v);
+	constexpr T& operator[] (uint32_t i);
+	constexpr const T& operator[] (uint32_t i) const;
 
-	T& operator[] (uint32_t i);
-	const T& operator[] (uint32_t i) const;
+	constexpr Vector2<T>  operator + () const;
+	constexpr Vector2<T>  operator - () const;
 
-	Vector2<T>  operator + () const;
-	Vector2<T>  operator - () const;
+	constexpr Vector2<T>  operator +  (const Vector2<T>& v) const;
+	constexpr Vector2<T>  operator -  (const Vector2<T>& v) const;
+	constexpr Vector2<T>& operator += (const Vector2<T>& v);
+	constexpr Vector2<T>& operator -= (const Vector2<T>& v);
 
-	Vector2<T>  operator +  (const Vector2<T>& v) const;
-	Vector2<T>  operator -  (const Vector2<T>& v) const;
-	Vector2<T>& operator += (const Vector2<T>& v);
-	Vector2<T>& operator -= (const Vector2<T>& v);
+	constexpr Vector2<T>  operator *  (T t) const;
+	constexpr Vector2<T>& operator *= (T t);
 
-	Vector2<T>  operator *  (T t) const;
-	Vector2<T>& operator *= (T t);
+	constexpr bool        operator < (const Vector2<T>& v) const;
 
-	bool        operator < (const Vector2<T>& v) const;
-
-	bool        operator == (const Vector2<T>& v) const;
-	bool        operator != (const Vector2<T>& v) const;
+	constexpr bool        operator == (const Vector2<T>& v) const;
+	constexpr bool        operator != (const Vector2<T>& v) const;
 };
 
 template <typename T>
@@ -76,31 +98,28 @@ struct Vector3
 		};
 	};
 
-	Vector3<T>();
-	Vector3<T>(T t);
-	Vector3<T>(T _x, T _y, T _z);
-	Vector3<T>(const Vector3<T>& v);
-
-	Vector3<T>& operator = (const Vector3<T>& v);
+	constexpr Vector3();
+	constexpr Vector3(T t);
+	constexpr Vector3(T _x, T _y, T _z);
 
-	T& operator[] (uint32_t i);
-	const T& operator[] (uint32_t i) const;
+	constexpr T& operator[] (uint32_t i);
+	constexpr const T& operator[] (uint32_t i) const;
 
-	Vector3<T>  operator + () const;
-	Vector3<T>  operator - () const;
+	constexpr Vector3<T>  operator + () const;
+	constexpr Vector3<T>  operator - () const;
 
-	Vector3<T>  operator +  (const Vector3<T>& v) const;
-	Vector3<T>  operator -  (const Vector3<T>& v) const;
-	Vector3<T>& operator += (const Vector3<T>& v);
-	Vector3<T>& operator -= (const Vector3<T>& v);
+	constexpr Vector3<T>  operator +  (const Vector3<T>& v) const;
+	constexpr Vector3<T>  operator -  (const Vector3<T>& v) const;
+	constexpr Vector3<T>& operator += (const Vector3<T>& v);
+	constexpr Vector3<T>& operator -= (const Vector3<T>& v);
 
-	Vector3<T>  operator *  (T t) const;
-	Vector3<T>& operator *= (T t);
+	constexpr Vector3<T>  operator *  (T t) const;
+	constexpr Vector3<T>& operator *= (T t);
 
-	bool        operator < (const Vector3<T>& v) const;
+	constexpr bool        operator < (const Vector3<T>& v) const;
 
-	bool        operator == (const Vector3<T>& v) const;
-	bool        operator != (const Vector3<T>& v) const;
+	constexpr bool        operator == (const Vector3<T>& v) const;
+	constexpr bool        operator != (const Vector3<T>& v) const;
 };
 
 template <typename T>
@@ -117,31 +136,29 @@ struct Vector4
 		};
 	};
 
-	Vector4<T>();
-	Vector4<T>(T t);
-	Vector4<T>(T _x, T _y, T _z, T _w);
-	Vector4<T>(const Vector4<T>& v);
+	constexpr Vector4();
+	constexpr Vector4(T t);
+	constexpr Vector4(T _x, T _y, T _z, T _w);
+	constexpr Vector4(const Vector3<T>& v, T _w);
 
-	Vector4<T>& operator = (const Vector4<T>& v);
+	constexpr T& operator[] (uint32_t i);
+	constexpr const T& operator[] (uint32_t i) const;
 
-	T& operator[] (uint32_t i);
-	const T& operator[] (uint32_t i) const;
+	constexpr Vector4<T>  operator + () const;
+	constexpr Vector4<T>  operator - () const;
 
-	Vector4<T>  operator + () const;
-	Vector4<T>  operator - () const;
+	constexpr Vector4<T>  operator +  (const Vector4<T>& v) const;
+	constexpr Vector4<T>  operator -  (const Vector4<T>& v) const;
+	constexpr Vector4<T>& operator += (const Vector4<T>& v);
+	constexpr Vector4<T>& operator -= (const Vector4<T>& v);
 
-	Vector4<T>  operator +  (const Vector4<T>& v) const;
-	Vector4<T>  operator -  (const Vector4<T>& v) const;
-	Vector4<T>& operator += (const Vector4<T>& v);
-	Vector4<T>& operator -= (const Vector4<T>& v);
+	constexpr Vector4<T>  operator *  (T t) const;
+	constexpr Vector4<T>& operator *= (T t);
 
-	Vector4<T>  operator *  (T t) const;
-	Vector4<T>& operator *= (T t);
+	constexpr bool        operator < (const Vector4<T>& v) const;
 
-	bool        operator < (const Vector4<T>& v) const;
-
-	bool        operator == (const Vector4<T>& v) const;
-	bool        operator != (const Vector4<T>& v) const;
+	constexpr bool        operator == (const Vector4<T>& v) const;
+	constexpr bool        operator != (const Vector4<T>& v) const;
 };
 
 typedef Vector2<float>    Vector2F;
@@ -160,15 +177,15 @@ namespace Vector
 	template <typename T> T Length(const Vector3<T>& v);
 	template <typename T> T Length(const Vector4<T>& v);
 
-	template <typename T> T Dot(const Vector2<T>& v0, const Vector2<T>& v1);
-	template <typename T> T Dot(const Vector3<T>& v0, const Vector3<T>& v1);
-	template <typename T> T Dot(const Vector4<T>& v0, const Vector4<T>& v1);
+	template <typename T> constexpr T Dot(const Vector2<T>& v0, const Vector2<T>& v1);
+	template <typename T> constexpr T Dot(const Vector3<T>& v0, const Vector3<T>& v1);
+	template <typename T> constexpr T Dot(const Vector4<T>& v0, const Vector4<T>& v1);
 
 	template <typename T> Vector2<T> Normalize(const Vector2<T>& v);
 	template <typename T> Vector3<T> Normalize(const Vector3<T>& v);
 	template <typename T> Vector4<T> Normalize(const Vector4<T>& v);
 
-	template <typename T> Vector3<T> Cross(const Vector3<T>& v0, const Vector3<T>& v1);
+	template <typename T> constexpr Vector3<T> Cross(const Vector3<T>& v0, const Vector3<T>& v1);
 
 	template <typename T> T Distance(const Vector2<T>& v0, const Vector2<T>& v1);
 	template <typename T> T Distance(const Vector3<T>& v0, const Vector3<T>& v1);
@@ -177,6 +194,94 @@ namespace Vector
 	template <typename T> std::wstring ToString(const Vector2<T>& v);
 	template <typename T> std::wstring ToString(const Vector3<T>& v);
 	template <typename T> std::wstring ToString(const Vector4<T>& v);
+
+	// Batched functions: pOut[i] = f(pIn[i]) for i < count, pIn and pOut may be the same array
+	template <typename T> void Normalize(const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count);
+	template <typename T> void Normalize(const Vector4<T>* pIn, Vector4<T>* pOut, uint32_t count);
+}
+
+// ---------------------------------------- Vector SoA -------------------------------------------
+/* Structure of arrays vector streams: each component is stored in its own 32 byte aligned array */
+/* The bulk functions process 8 (AVX2) or 4 (SSE) vectors per iteration, the streams are allocated through Memory */
+
+struct Vector3SoA
+{
+	float*   x;
+	float*   y;
+	float*   z;
+	uint32_t count;
+	uint32_t capacity;
+	void*    pMemory;
+
+	Vector3SoA();
+	Vector3SoA(const Vector3SoA& v);
+	Vector3SoA(Vector3SoA&& v) noexcept;
+	~Vector3SoA();
+
+	Vector3SoA& operator = (const Vector3SoA& v);
+	Vector3SoA& operator = (Vector3SoA&& v) noexcept;
+
+	bool     Resize(uint32_t n); // new elements are zero
+	void     Release();
+
+	Vector3F Get(uint32_t i) const;
+	void     Set(uint32_t i, const Vector3F& v);
+
+	bool     Load(const Vector3F* pIn, uint32_t n);
+	bool     Load(const std::vector<Vector3F>& v);
+	bool     Load(const void* pIn, size_t stride, uint32_t n); // n x float[3], stride bytes apart
+	void     Store(Vector3F* pOut) const;
+	void     Store(std::vector<Vector3F>& v) const;
+	void     Store(void* pOut, size_t stride) const;
+};
+
+struct Vector4SoA
+{
+	float*   x;
+	float*   y;
+	float*   z;
+	float*   w;
+	uint32_t count;
+	uint32_t capacity;
+	void*    pMemory;
+
+	Vector4SoA();
+	Vector4SoA(const Vector4SoA& v);
+	Vector4SoA(Vector4SoA&& v) noexcept;
+	~Vector4SoA();
+
+	Vector4SoA& operator = (const Vector4SoA& v);
+	Vector4SoA& operator = (Vector4SoA&& v) noexcept;
+
+	bool     Resize(uint32_t n); // new elements are zero
+	void     Release();
+
+	Vector4F Get(uint32_t i) const;
+	void     Set(uint32_t i, const Vector4F& v);
+
+	bool     Load(const Vector4F* pIn, uint32_t n);
+	bool     Load(const std::vector<Vector4F>& v);
+	bool     Load(const void* pIn, size_t stride, uint32_t n); // n x float[4], stride bytes apart
+	void     Store(Vector4F* pOut) const;
+	void     Store(std::vector<Vector4F>& v) const;
+	void     Store(void* pOut, size_t stride) const;
+};
+
+namespace Vector
+{
+	// Bulk functions: r[i] = f(v0[i], v1[i]), the inputs must have the same size and r is resized to it (r may be an input)
+	// The float outputs need space for v.count values
+	bool Add(const Vector3SoA& v0, const Vector3SoA& v1, Vector3SoA& r);
+	bool Add(const Vector4SoA& v0, const Vector4SoA& v1, Vector4SoA& r);
+	bool Scale(const Vector3SoA& v, float s, Vector3SoA& r);
+	bool Scale(const Vector4SoA& v, float s, Vector4SoA& r);
+	bool Dot(const Vector3SoA& v0, const Vector3SoA& v1, float* pOut);
+	bool Dot(const Vector4SoA& v0, const Vector4SoA& v1, float* pOut);
+	bool Cross(const Vector3SoA& v0, const Vector3SoA& v1, Vector3SoA& r);
+	bool Normalize(const Vector3SoA& v, Vector3SoA& r);
+	bool Normalize(const Vector4SoA& v, Vector4SoA& r);
+	bool Length(const Vector3SoA& v, float* pOut);
+	bool Length(const Vector4SoA& v, float* pOut);
 }
 
 // --------------------------------------- Quaternion --------------------------------------------
@@ -193,54 +298,79 @@ struct Quaternion
 		struct { T x, y, z, w; };
 	};
 
-	Quaternion();
+	constexpr Quaternion();
 	Quaternion(const Vector3<T>& v);
-	Quaternion(const Vector4<T>& v);
+	constexpr Quaternion(const Vector4<T>& v);
 	Quaternion(T _x, T _y, T _z);
-	Quaternion(T _x, T _y, T _z, T _w);
+	constexpr Quaternion(T _x, T _y, T _z, T _w);
 	Quaternion(const struct Matrix3<T>& m);
 
-	Quaternion  operator *  (const Quaternion& q) const;
-	Quaternion& operator *= (const Quaternion& q);
+	constexpr Quaternion  operator *  (const Quaternion& q) const;
+	constexpr Quaternion& operator *= (const Quaternion& q);
 
-	Quaternion& operator = (const Vector4<T>& v);
-	Quaternion& operator = (const Quaternion& q);
+	constexpr Quaternion& operator = (const Vector4<T>& v);
+
+	constexpr Vector3<T>  Rotate(const Vector3<T>& v) const; // unit quaternions only, q * v * q^-1, same result as Matrix3x4(Matrix4(q)) * Vector4(v, 0)
 };
 
+namespace Quat
+{
+	template <typename T> constexpr T Dot(const Quaternion<T>& q0, const Quaternion<T>& q1);
+	template <typename T> T Length(const Quaternion<T>& q);
+
+	template <typename T> Quaternion<T> Normalize(const Quaternion<T>& q);
+	template <typename T> constexpr Quaternion<T> Conjugate(const Quaternion<T>& q);
+	template <typename T> constexpr Quaternion<T> Inverse(const Quaternion<T>& q);
+
+	// Interpolation along the shortest arc, the result is normalized
+	template <typename T> Quaternion<T> Nlerp(const Quaternion<T>& q0, const Quaternion<T>& q1, T t);
+	template <typename T> Quaternion<T> Slerp(const Quaternion<T>& q0, const Quaternion<T>& q1, T t);
+	template <typename T> Quaternion<T> SlerpFast(const Quaternion<T>& q0, const Quaternion<T>& q1, T t); // nlerp with a corrected t, the components are within 3.7e-4 of Slerp
+
+	// Batched functions: pOut[i] = f(pIn[i]) for i < count, the inputs and pOut may be the same array
+	template <typename T> void Normalize(const Quaternion<T>* pIn, Quaternion<T>* pOut, uint32_t count);
+	template <typename T> void Multiply(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, Quaternion<T>* pOut, uint32_t count); // pIn0[i] * pIn1[i]
+	template <typename T> void Rotate(const Quaternion<T>& q, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count);
+	template <typename T> void Nlerp(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, T t, Quaternion<T>* pOut, uint32_t count);
+	template <typename T> void Slerp(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, T t, Quaternion<T>* pOut, uint32_t count);
+	template <typename T> void Convert(const Vector3<T>* pIn, Quaternion<T>* pOut, uint32_t count); // Quaternion(x, y, z) from the Euler angles, within the SinCos error
+}
+
 // ----------------------------------------- Matrix ----------------------------------------------
 
+// prototypes for Matrix4::Matrix4(const Matrix3x4<T>&) and the Transform constructors
+template <typename T> struct Matrix3x4;
+template <typename T> struct Transform;
+
 template <typename T>
 struct Matrix2
 {
 	union
 	{
 		Vector2<T> rows[2];
-		float      elements[2][2];
+		T          elements[2][2];
 		struct { Vector2<T> v0, v1; };
 	};
 
-	Matrix2<T>();
-	Matrix2<T>(T t);
-	Matrix2<T>(const Vector2<T>& v0, const Vector2<T>& v1);
-	Matrix2<T>(const Matrix2& m);
-
-	Matrix2<T>& operator = (const Matrix2<T>& m);
+	constexpr Matrix2();
+	constexpr Matrix2(T t);
+	constexpr Matrix2(const Vector2<T>& v0, const Vector2<T>& v1);
 
-	Vector2<T>& operator[] (uint32_t i);
-	const Vector2<T>& operator[] (uint32_t i) const;
+	constexpr Vector2<T>& operator[] (uint32_t i);
+	constexpr const Vector2<T>& operator[] (uint32_t i) const;
 
-	Matrix2<T>  operator *  (T t) const;
-	Matrix2<T>& operator *= (T t);
+	constexpr Matrix2<T>  operator *  (T t) const;
+	constexpr Matrix2<T>& operator *= (T t);
 
-	Matrix2<T>  operator +  (const Matrix2<T>& m) const;
-	Matrix2<T>  operator -  (const Matrix2<T>& m) const;
-	Matrix2<T>& operator += (const Matrix2<T>& m);
-	Matrix2<T>& operator -= (const Matrix2<T>& m);
+	constexpr Matrix2<T>  operator +  (const Matrix2<T>& m) const;
+	constexpr Matrix2<T>  operator -  (const Matrix2<T>& m) const;
+	constexpr Matrix2<T>& operator += (const Matrix2<T>& m);
+	constexpr Matrix2<T>& operator -= (const Matrix2<T>& m);
 
-	Matrix2<T>  operator *  (const Matrix2<T>& m) const;
-	Matrix2<T>& operator *= (const Matrix2<T>& m);
+	constexpr Matrix2<T>  operator *  (const Matrix2<T>& m) const;
+	constexpr Matrix2<T>& operator *= (const Matrix2<T>& m);
 
-	Vector2<T>  operator  * (const Vector2<T>& v) const;
+	constexpr Vector2<T>  operator  * (const Vector2<T>& v) const;
 };
 
 template <typename T>
@@ -249,32 +379,29 @@ struct Matrix3
 	union
 	{
 		Vector3<T> rows[3];
-		float      elements[3][3];
+		T          elements[3][3];
 		struct { Vector3<T> v0, v1, v2; };
 	};
 
-	Matrix3<T>();
-	Matrix3<T>(T t);
-	Matrix3<T>(const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2);
-	Matrix3<T>(const Matrix3& m);
+	constexpr Matrix3();
+	constexpr Matrix3(T t);
+	constexpr Matrix3(const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2);
 
-	Matrix3<T>& operator = (const Matrix3<T>& m);
+	constexpr Vector3<T>& operator[] (uint32_t i);
+	constexpr const Vector3<T>& operator[] (uint32_t i) const;
 
-	Vector3<T>& operator[] (uint32_t i);
-	const Vector3<T>& operator[] (uint32_t i) const;
+	constexpr Matrix3<T>  operator *  (T t) const;
+	constexpr Matrix3<T>& operator *= (T t);
 
-	Matrix3<T>  operator *  (T t) const;
-	Matrix3<T>& operator *= (T t);
+	constexpr Matrix3<T>  operator +  (const Matrix3<T>& m) const;
+	constexpr Matrix3<T>  operator -  (const Matrix3<T>& m) const;
+	constexpr Matrix3<T>& operator += (const Matrix3<T>& m);
+	constexpr Matrix3<T>& operator -= (const Matrix3<T>& m);
 
-	Matrix3<T>  operator +  (const Matrix3<T>& m) const;
-	Matrix3<T>  operator -  (const Matrix3<T>& m) const;
-	Matrix3<T>& operator += (const Matrix3<T>& m);
-	Matrix3<T>& operator -= (const Matrix3<T>& m);
+	constexpr Matrix3<T>  operator *  (const Matrix3<T>& m) const;
+	constexpr Matrix3<T>& operator *= (const Matrix3<T>& m);
 
-	Matrix3<T>  operator *  (const Matrix3<T>& m) const;
-	Matrix3<T>& operator *= (const Matrix3<T>& m);
-
-	Vector3<T>  operator  * (const Vector3<T>& v) const;
+	constexpr Vector3<T>  operator  * (const Vector3<T>& v) const;
 };
 
 template <typename T>
@@ -283,61 +410,382 @@ struct Matrix4
 	union
 	{
 		Vector4<T> rows[4];
-		float      elements[4][4];
+		T          elements[4][4];
 		struct { Vector4<T> v0, v1, v2, v3; };
 	};
 
-	Matrix4<T>();
-	Matrix4<T>(T t);
-	Matrix4<T>(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2, const Vector4<T>& v3);
-	Matrix4<T>(const Matrix4& m);
-	Matrix4<T>(const Quaternion<T>& q);
+	constexpr Matrix4();
+	constexpr Matrix4(T t);
+	constexpr Matrix4(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2, const Vector4<T>& v3);
+	constexpr Matrix4(const Quaternion<T>& q);
+	constexpr Matrix4(const Matrix3x4<T>& m);
+	constexpr Matrix4(const Transform<T>& t);
+
+	constexpr Vector4<T>& operator[] (uint32_t i);
+	constexpr const Vector4<T>& operator[] (uint32_t i) const;
+
+	constexpr Matrix4<T>  operator *  (T t) const;
+	constexpr Matrix4<T>& operator *= (T t);
 
-	Matrix4<T>& operator = (const Matrix4<T>& m);
+	constexpr Matrix4<T>  operator +  (const Matrix4<T>& m) const;
+	constexpr Matrix4<T>  operator -  (const Matrix4<T>& m) const;
+	constexpr Matrix4<T>& operator += (const Matrix4<T>& m);
+	constexpr Matrix4<T>& operator -= (const Matrix4<T>& m);
 
-	Vector4<T>& operator[] (uint32_t i);
-	const Vector4<T>& operator[] (uint32_t i) const;
+	constexpr Matrix4<T>  operator *  (const Matrix4<T>& m) const;
+	constexpr Matrix4<T>& operator *= (const Matrix4<T>& m);
 
-	Matrix4<T>  operator *  (T t) const;
-	Matrix4<T>& operator *= (T t);
+	constexpr Vector4<T>  operator  * (const Vector4<T>& v) const;
+};
+
+// Affine transform in 48 bytes: the first three rows of the transform, the last row (0, 0, 0, 1) is implied
+// rows[i] = (m[0][i], m[1][i], m[2][i], m[3][i]) for the Matrix4 m it is built from, so Matrix3x4(a) * Matrix3x4(b) == Matrix3x4(a * b)
+// Each row transforms <v, 1> with a dot product, the layout of a row major float3x4 in HLSL
+template <typename T>
+struct Matrix3x4
+{
+	union
+	{
+		Vector4<T> rows[3];
+		T          elements[3][4];
+		struct { Vector4<T> v0, v1, v2; };
+	};
+
+	constexpr Matrix3x4();
+	constexpr Matrix3x4(T t);
+	constexpr Matrix3x4(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2);
+	constexpr explicit Matrix3x4(const Matrix4<T>& m); // drops the last row of the transform
+	constexpr Matrix3x4(const Transform<T>& t);
 
-	Matrix4<T>  operator +  (const Matrix4<T>& m) const;
-	Matrix4<T>  operator -  (const Matrix4<T>& m) const;
-	Matrix4<T>& operator += (const Matrix4<T>& m);
-	Matrix4<T>& operator -= (const Matrix4<T>& m);
+	constexpr Vector4<T>& operator[] (uint32_t i);
+	constexpr const Vector4<T>& operator[] (uint32_t i) const;
 
-	Matrix4<T>  operator *  (const Matrix4<T>& m) const;
-	Matrix4<T>& operator *= (const Matrix4<T>& m);
+	constexpr Matrix3x4<T>  operator *  (const Matrix3x4<T>& m) const;
+	constexpr Matrix3x4<T>& operator *= (const Matrix3x4<T>& m);
 
-	Vector4<T>  operator  * (const Vector4<T>& v) const;
+	constexpr Vector3<T>  operator  * (const Vector4<T>& v) const;
 };
 
-typedef Matrix2<float> Matrix2F;
-typedef Matrix3<float> Matrix3F;
-typedef Matrix4<float> Matrix4F;
+typedef Matrix2<float>   Matrix2F;
+typedef Matrix3<float>   Matrix3F;
+typedef Matrix4<float>   Matrix4F;
+typedef Matrix3x4<float> Matrix3x4F;
 
 namespace Matrix
 {
 	template <typename T> Matrix2<T> Inverse(const Matrix2<T>& m);
 	template <typename T> Matrix3<T> Inverse(const Matrix3<T>& m);
 	template <typename T> Matrix4<T> Inverse(const Matrix4<T>& m);
+	template <typename T> Matrix3x4<T> Inverse(const Matrix3x4<T>& m);
 
-	template <typename T> Matrix2<T> Transpose(const Matrix2<T>& m);
-	template <typename T> Matrix3<T> Transpose(const Matrix3<T>& m);
-	template <typename T> Matrix4<T> Transpose(const Matrix4<T>& m);
+	// Cheaper inverses of Matrix4 transforms with a known structure, the last column of m must be <0, 0, 0, 1>
+	template <typename T> Matrix4<T> InverseAffine(const Matrix4<T>& m); // any invertible rotation, scale and shear plus translation
+	template <typename T> Matrix4<T> InverseRigid(const Matrix4<T>& m);  // rotation and translation only, the rotation is transposed
 
-	template <typename T> Matrix4<T> Translate(const Vector3<T>& v);
-	template <typename T> Matrix4<T> Scale(const Vector3<T>& v);
+	template <typename T> constexpr Matrix2<T> Transpose(const Matrix2<T>& m);
+	template <typename T> constexpr Matrix3<T> Transpose(const Matrix3<T>& m);
+	template <typename T> constexpr Matrix4<T> Transpose(const Matrix4<T>& m);
+
+	template <typename T> constexpr Matrix4<T> Translate(const Vector3<T>& v);
+	template <typename T> constexpr Matrix4<T> Scale(const Vector3<T>& v);
 	template <typename T> Matrix4<T> Rotate(const Vector3<T>& v);
 
 	template <typename T> std::wstring ToString(const Matrix2<T>& m);
 	template <typename T> std::wstring ToString(const Matrix3<T>& m);
 	template <typename T> std::wstring ToString(const Matrix4<T>& m);
+	template <typename T> std::wstring ToString(const Matrix3x4<T>& m);
+
+	// Batched transforms: pOut[i] = f(m, pIn[i]) for i < count, pIn and pOut may be the same array
+	template <typename T> void Transform(const Matrix4<T>& m, const Vector4<T>* pIn, Vector4<T>* pOut, uint32_t count);        // m * v
+	template <typename T> void TransformPoints(const Matrix4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count);  // x * m[0] + y * m[1] + z * m[2] + m[3], Matrix3x4(m) * <v, 1>
+	template <typename T> void TransformVectors(const Matrix4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count); // x * m[0] + y * m[1] + z * m[2], Matrix3x4(m) * <v, 0>
+	template <typename T> void Multiply(const Matrix4<T>& m, const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count);         // m * pIn[i]
+	template <typename T> void Multiply(const Matrix4<T>* pIn, const Matrix4<T>& m, Matrix4<T>* pOut, uint32_t count);         // pIn[i] * m
+	template <typename T> void InverseAffine(const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count);                         // InverseAffine(pIn[i])
+	template <typename T> void InverseRigid(const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count);                          // InverseRigid(pIn[i])
+
+	template <typename T> void TransformPoints(const Matrix3x4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count);  // m * <v, 1>
+	template <typename T> void TransformVectors(const Matrix3x4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count); // m * <v, 0>
+	template <typename T> void Multiply(const Matrix3x4<T>& m, const Matrix3x4<T>* pIn, Matrix3x4<T>* pOut, uint32_t count);     // m * pIn[i]
+	template <typename T> void Multiply(const Matrix3x4<T>* pIn, const Matrix3x4<T>& m, Matrix3x4<T>* pOut, uint32_t count);     // pIn[i] * m
+	template <typename T> void Convert(const Matrix4<T>* pIn, Matrix3x4<T>* pOut, uint32_t count);                               // Matrix3x4(pIn[i])
+
+	template <typename T> void Rotate(const Vector3<T>* pIn, Matrix4<T>* pOut, uint32_t count); // Rotate(pIn[i]), through Quat::Convert
+}
+
+// ------------------------------------- Dual Quaternion -----------------------------------------
+
+// Rigid transform (rotation followed by translation) in 32 bytes: real is the rotation, dual = 0.5 * <t, 0> * real
+// Points are transformed like the Matrix4 the dual quaternion is built from, so DualQuaternion(a) * DualQuaternion(b) matches a * b
+template <typename T = float>
+struct DualQuaternion
+{
+	Quaternion<T> real;
+	Quaternion<T> dual;
+
+	constexpr DualQuaternion();
+	constexpr DualQuaternion(const Quaternion<T>& r, const Quaternion<T>& d);
+	constexpr DualQuaternion(const Quaternion<T>& q, const Vector3<T>& t); // same transform as Translate(t) * Matrix4(q)
+	explicit DualQuaternion(const Matrix4<T>& m);                          // rotation and translation only
+
+	constexpr DualQuaternion  operator *  (const DualQuaternion& q) const;
+	constexpr DualQuaternion& operator *= (const DualQuaternion& q);
+
+	constexpr Vector3<T> GetTranslation() const;
+
+	// unit dual quaternions only
+	constexpr Vector3<T> TransformPoint(const Vector3<T>& p) const;
+	constexpr Vector3<T> TransformVector(const Vector3<T>& v) const;
+};
+
+typedef DualQuaternion<float> DualQuaternionF;
+
+namespace DualQuat
+{
+	template <typename T> DualQuaternion<T> Normalize(const DualQuaternion<T>& q);
+	template <typename T> constexpr DualQuaternion<T> Inverse(const DualQuaternion<T>& q); // unit dual quaternions only
+
+	// Dual quaternion linear blending: the weighted sum over the shortest arcs, normalized
+	template <typename T> DualQuaternion<T> Blend(const DualQuaternion<T>& q0, const DualQuaternion<T>& q1, T t);
+	template <typename T> DualQuaternion<T> Blend(const DualQuaternion<T>* pIn, const T* pWeights, uint32_t count);
+
+	// Batched functions: pOut[i] = f(pIn[i]) for i < count, the inputs and pOut may be the same array
+	template <typename T> void Convert(const Matrix4<T>* pIn, DualQuaternion<T>* pOut, uint32_t count); // DualQuaternion(pIn[i])
+	template <typename T> void Multiply(const DualQuaternion<T>* pIn0, const DualQuaternion<T>* pIn1, DualQuaternion<T>* pOut, uint32_t count); // pIn0[i] * pIn1[i]
+	template <typename T> void TransformPoints(const DualQuaternion<T>& q, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count);
+}
+
+// ---------------------------------------- Transform --------------------------------------------
+
+// Translation, rotation and scale in 40 bytes, the same transform as Translate(translation) * Matrix4(rotation) * Scale(scale)
+// Composition and inversion are exact for uniform scale; a non-uniform parent scale under a rotated child is a shear,
+// which a TRS cannot hold, so the scales are multiplied component-wise as animation systems usually do
+template <typename T = float>
+struct Transform
+{
+	Vector3<T>    translation;
+	Quaternion<T> rotation;
+	Vector3<T>    scale;
+
+	constexpr Transform(); // identity
+	constexpr Transform(const Vector3<T>& t, const Quaternion<T>& r, const Vector3<T>& s);
+	explicit Transform(const Matrix4<T>& m); // decomposition, the last column of m must be <0, 0, 0, 1>
+
+	constexpr Transform  operator *  (const Transform& t) const; // parent * child, like the Matrix4 product
+	constexpr Transform& operator *= (const Transform& t);
+
+	constexpr Vector3<T> TransformPoint(const Vector3<T>& p) const;
+	constexpr Vector3<T> TransformVector(const Vector3<T>& v) const;
+};
+
+typedef Transform<float> TransformF;
+
+namespace Xform
+{
+	template <typename T> constexpr Transform<T> Inverse(const Transform<T>& t); // the scale must not be zero
+
+	// Linear blending of translation and scale, nlerp of the rotation along the shortest arc
+	template <typename T> Transform<T> Lerp(const Transform<T>& t0, const Transform<T>& t1, T t);
+	template <typename T> Transform<T> Blend(const Transform<T>* pIn, const T* pWeights, uint32_t count); // the weights should sum to 1
+
+	// Batched functions: pOut[i] = f(pIn[i]) for i < count, the inputs and pOut may be the same array
+	template <typename T> void Multiply(const Transform<T>* pIn0, const Transform<T>* pIn1, Transform<T>* pOut, uint32_t count); // pIn0[i] * pIn1[i]
+	template <typename T> void Convert(const Matrix4<T>* pIn, Transform<T>* pOut, uint32_t count);    // Transform(pIn[i])
+	template <typename T> void Convert(const Transform<T>* pIn, Matrix3x4<T>* pOut, uint32_t count);  // Matrix3x4(pIn[i])
+}
+
+// ----------------------------------------- Bounds ----------------------------------------------
+
+// Plane dot(normal, p) + distance = 0, the normals of the planes bounding a volume point inwards
+template <typename T = float>
+struct Plane
+{
+	Vector3<T> normal;
+	T          distance;
+
+	constexpr Plane();
+	constexpr Plane(const Vector3<T>& n, T d);
+	constexpr Plane(const Vector3<T>& n, const Vector3<T>& p); // plane through p
+
+	constexpr T Distance(const Vector3<T>& p) const; // signed, in units of |normal|
+};
+
+template <typename T = float>
+struct AABB
+{
+	Vector3<T> min;
+	Vector3<T> max;
+
+	constexpr AABB(); // empty, min > max until a point is merged
+	constexpr AABB(const Vector3<T>& vMin, const Vector3<T>& vMax);
+
+	constexpr Vector3<T> GetCenter() const;
+	constexpr Vector3<T> GetExtents() const; // half size
+
+	constexpr void Merge(const Vector3<T>& p);
+	constexpr void Merge(const AABB<T>& b);
+};
+
+template <typename T = float>
+struct Sphere
+{
+	Vector3<T> center;
+	T          radius;
+
+	constexpr Sphere();
+	constexpr Sphere(const Vector3<T>& c, T r);
+};
+
+// Frustum planes in the order left, right, bottom, top, near, far
+template <typename T = float>
+struct Frustum
+{
+	Plane<T> planes[6];
+
+	constexpr Frustum();
+	explicit Frustum(const Matrix4<T>& m); // m is the view-projection the shaders apply with mul(m, p), D3D clip space (0 <= z <= w)
+};
+
+typedef Plane<float>   PlaneF;
+typedef AABB<float>    AABBF;
+typedef Sphere<float>  SphereF;
+typedef Frustum<float> FrustumF;
+
+enum INTERSECTION
+{
+	INTERSECTION_OUTSIDE = 0,
+	INTERSECTION_PARTIAL = 1,
+	INTERSECTION_INSIDE  = 2
+};
+
+namespace Bounds
+{
+	template <typename T> Plane<T> Normalize(const Plane<T>& p);
+
+	// Bounding box of the transformed box, m transforms points like Matrix3x4(m) * <p, 1>
+	template <typename T> AABB<T> Transform(const AABB<T>& b, const Matrix4<T>& m);
+	template <typename T> AABB<T> Transform(const AABB<T>& b, const Matrix3x4<T>& m);
+
+	template <typename T> INTERSECTION Classify(const Frustum<T>& f, const AABB<T>& b);
+	template <typename T> INTERSECTION Classify(const Frustum<T>& f, const Sphere<T>& s);
+
+	// Batched visibility: bit (i % 32) of pVisible[i / 32] is set when pIn[i] is not outside the frustum
+	// pVisible holds (count + 31) / 32 words, returns the number of visible volumes
+	template <typename T> uint32_t Cull(const Frustum<T>& f, const AABB<T>* pIn, uint32_t count, uint32_t* pVisible);
+	template <typename T> uint32_t Cull(const Frustum<T>& f, const Sphere<T>* pIn, uint32_t count, uint32_t* pVisible);
+}
+
+// ---------------------------------------- Packing ----------------------------------------------
+/* Quantized encodings for animation data and vertex streams (defined in CMathPack.cpp) */
+
+// Smallest three quaternion in 48 bits: the largest component is dropped (q and -q are the same rotation, so it is made positive)
+// and the other three are stored in order as 15 bit values in [-1/sqrt(2), 1/sqrt(2)] above bit 0.
+// Bit 0 of elements[0] and elements[1] holds the index of the dropped component.
+struct PackedQuaternion
+{
+	uint16_t elements[3];
+};
+
+// Octahedral unit vector in 32 bits, two SNORM16 values (DXGI_FORMAT_R16G16_SNORM)
+struct PackedNormal
+{
+	int16_t elements[2];
+};
+
+// Position in a bounding box as four SNORM16 values (DXGI_FORMAT_R16G16B16A16_SNORM): p = center + extents * <x, y, z>, w is 1
+struct PackedPosition
+{
+	int16_t elements[4];
+};
+
+namespace Pack
+{
+	// Unit quaternions, the decoded components are within 7e-5 of the encoded ones
+	PackedQuaternion  EncodeQuaternion(const Quaternion<float>& q);
+	Quaternion<float> DecodeQuaternion(const PackedQuaternion& p);
+
+	// Unit vectors, the decoded vector is within 7e-5 of the encoded one
+	PackedNormal EncodeNormal(const Vector3F& n);
+	Vector3F     DecodeNormal(const PackedNormal& p);
+
+	// Points inside b, the decoded components are within extents / 65534 (plus rounding) of the encoded ones
+	PackedPosition EncodePosition(const Vector3F& p, const AABBF& b);
+	Vector3F       DecodePosition(const PackedPosition& p, const AABBF& b);
+	Matrix4F       GetDecodeMatrix(const AABBF& b); // mul(m, p) decodes a PackedPosition in a shader
+
+	// IEEE 754 half float, rounded to nearest even like F16C (NaN payloads are truncated and quieted)
+	uint16_t EncodeHalf(float f);
+	float    DecodeHalf(uint16_t h);
+
+	// Batched functions: pOut[i] = f(pIn[i]) for i < count, with the same results as the functions above
+	void EncodeQuaternions(const Quaternion<float>* pIn, PackedQuaternion* pOut, uint32_t count);
+	void DecodeQuaternions(const PackedQuaternion* pIn, Quaternion<float>* pOut, uint32_t count);
+	void EncodeNormals(const Vector3F* pIn, PackedNormal* pOut, uint32_t count);
+	void DecodeNormals(const PackedNormal* pIn, Vector3F* pOut, uint32_t count);
+	void EncodePositions(const Vector3F* pIn, const AABBF& b, PackedPosition* pOut, uint32_t count);
+	void DecodePositions(const PackedPosition* pIn, const AABBF& b, Vector3F* pOut, uint32_t count);
+	void EncodeHalves(const float* pIn, uint16_t* pOut, uint32_t count); // any float data, e.g. 4 * count values for Vector4F
+	void DecodeHalves(const uint16_t* pIn, float* pOut, uint32_t count);
 }
 
 // Global vector operators
-template <typename T> Vector2<T> operator * (T t, const Vector2<T>& v);
-template <typename T> Vector3<T> operator * (T t, const Vector3<T>& v);
-template <typename T> Vector4<T> operator * (T t, const Vector4<T>& v);
+template <typename T> constexpr Vector2<T> operator * (T t, const Vector2<T>& v);
+template <typename T> constexpr Vector3<T> operator * (T t, const Vector3<T>& v);
+template <typename T> constexpr Vector4<T> operator * (T t, const Vector4<T>& v);
+
+// SIMD kernels behind the Matrix4F product, inverse and the batched float functions (defined in CMathSimd.cpp)
+// The scalar templates are the reference implementation, the inline operators only call these outside of constant evaluation
+#if CG_MATH_SSE
+namespace Simd
+{
+	void Multiply(const Matrix4F& m0, const Matrix4F& m1, Matrix4F& r);
+	void Inverse(const Matrix4F& m, Matrix4F& r);
+	void InverseAffine(const Matrix4F& m, Matrix4F& r);
+	void InverseRigid(const Matrix4F& m, Matrix4F& r);
+
+	void Normalize(const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void Normalize(const Vector4F* pIn, Vector4F* pOut, uint32_t count);
+
+	void Transform(const Matrix4F& m, const Vector4F* pIn, Vector4F* pOut, uint32_t count);
+	void TransformPoints(const Matrix4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void TransformVectors(const Matrix4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void Multiply(const Matrix4F& m, const Matrix4F* pIn, Matrix4F* pOut, uint32_t count);
+	void Multiply(const Matrix4F* pIn, const Matrix4F& m, Matrix4F* pOut, uint32_t count);
+	void InverseAffine(const Matrix4F* pIn, Matrix4F* pOut, uint32_t count);
+	void InverseRigid(const Matrix4F* pIn, Matrix4F* pOut, uint32_t count);
+
+	void Multiply(const Matrix3x4F& m0, const Matrix3x4F& m1, Matrix3x4F& r);
+	void TransformPoints(const Matrix3x4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void TransformVectors(const Matrix3x4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void Multiply(const Matrix3x4F& m, const Matrix3x4F* pIn, Matrix3x4F* pOut, uint32_t count);
+	void Multiply(const Matrix3x4F* pIn, const Matrix3x4F& m, Matrix3x4F* pOut, uint32_t count);
+	void Convert(const Matrix4F* pIn, Matrix3x4F* pOut, uint32_t count);
+
+	uint32_t Cull(const FrustumF& f, const AABBF* pIn, uint32_t count, uint32_t* pVisible);
+	uint32_t Cull(const FrustumF& f, const SphereF* pIn, uint32_t count, uint32_t* pVisible);
+
+	void Normalize(const Quaternion<float>* pIn, Quaternion<float>* pOut, uint32_t count);
+	void Multiply(const Quaternion<float>* pIn0, const Quaternion<float>* pIn1, Quaternion<float>* pOut, uint32_t count);
+	void Rotate(const Quaternion<float>& q, const Vector3F* pIn, Vector3F* pOut, uint32_t count);
+	void Nlerp(const Quaternion<float>* pIn0, const Quaternion<float>* pIn1, float t, Quaternion<float>* pOut, uint32_t count);
+	void Convert(const Vector3F* pIn, Quaternion<float>* pOut, uint32_t count);
+
+	void SinCos(const float* pIn, float* pSin, float* pCos, uint32_t count);
+	void ReciprocalSqrt(const float* pIn, float* pOut, uint32_t count);
+
+	void EncodeQuaternions(const Quaternion<float>* pIn, PackedQuaternion* pOut, uint32_t count);
+	void DecodeQuaternions(const PackedQuaternion* pIn, Quaternion<float>* pOut, uint32_t count);
+	void EncodeNormals(const Vector3F* pIn, PackedNormal* pOut, uint32_t count);
+	void DecodeNormals(const PackedNormal* pIn, Vector3F* pOut, uint32_t count);
+	void EncodePositions(const Vector3F* pIn, const AABBF& b, PackedPosition* pOut, uint32_t count);
+	void DecodePositions(const PackedPosition* pIn, const AABBF& b, Vector3F* pOut, uint32_t count);
+#if CG_MATH_F16C
+	void EncodeHalves(const float* pIn, uint16_t* pOut, uint32_t count);
+	void DecodeHalves(const uint16_t* pIn, float* pOut, uint32_t count);
+#endif
+}
+#endif
+
+#include "CgMath.inl"
 
-#endif // CG_MATH__HPP
\ No newline at end of file
+#endif // CG_MATH__HPP
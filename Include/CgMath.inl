@@ -0,0 +1,790 @@
+#ifndef CG_MATH__INL
+#define CG_MATH__INL
+
+/* Inline definitions of the CgMath.hpp types, included at the end of CgMath.hpp */
+/* The constexpr members only access the union members they initialize (elements/rows) so that they can be used in constant expressions */
+
+// ------------------------------------ Scalar functions ------------------------------------------
+
+template <typename T>
+inline T Step(T v0, T v1, T step)
+{
+	T d = v1 - v0;
+
+	if constexpr (std::is_floating_point<T>::value) { return (std::fabs(d) > step) ? (v0 + std::copysign(step, d)) : v1; }
+	else if constexpr (std::is_signed<T>::value)    { return static_cast<T>((std::abs(static_cast<int64_t>(d)) > step) ? (v0 + std::copysign(step, d)) : v1); }
+	else                                            { return static_cast<T>((d > step) ? (v0 + step) : v1); }
+}
+
+template <typename T>
+constexpr T Clamp(T val, T min, T max)
+{
+	val = (max < val) ? max : val;
+	return (val < min) ? min : val;
+}
+
+// ----------------------------------------- Vector2 ----------------------------------------------
+
+template <typename T> constexpr Vector2<T>::Vector2() : elements{} { }
+template <typename T> constexpr Vector2<T>::Vector2(T t) : elements{ t, t } { }
+template <typename T> constexpr Vector2<T>::Vector2(T _x, T _y) : elements{ _x, _y } { }
+
+template <typename T> constexpr T& Vector2<T>::operator[] (uint32_t i) { return elements[i]; }
+template <typename T> constexpr const T& Vector2<T>::operator[] (uint32_t i) const { return elements[i]; }
+
+template <typename T> constexpr Vector2<T> Vector2<T>::operator + () const { return *this; }
+template <typename T> constexpr Vector2<T> Vector2<T>::operator - () const
+{
+	static_assert(std::is_signed<T>::value, "cannot use unary minus operator on unsigned type");
+	return Vector2<T>(-elements[0], -elements[1]);
+}
+
+template <typename T> constexpr Vector2<T>  Vector2<T>::operator +  (const Vector2<T>& v) const { return Vector2<T>(elements[0] + v[0], elements[1] + v[1]); }
+template <typename T> constexpr Vector2<T>  Vector2<T>::operator -  (const Vector2<T>& v) const { return Vector2<T>(elements[0] - v[0], elements[1] - v[1]); }
+template <typename T> constexpr Vector2<T>& Vector2<T>::operator += (const Vector2<T>& v) { elements[0] += v[0]; elements[1] += v[1]; return *this; }
+template <typename T> constexpr Vector2<T>& Vector2<T>::operator -= (const Vector2<T>& v) { elements[0] -= v[0]; elements[1] -= v[1]; return *this; }
+
+template <typename T> constexpr Vector2<T>  Vector2<T>::operator *  (T t) const { return Vector2<T>(elements[0] * t, elements[1] * t); }
+template <typename T> constexpr Vector2<T>& Vector2<T>::operator *= (T t) { elements[0] *= t; elements[1] *= t; return *this; }
+
+template <typename T> constexpr bool Vector2<T>::operator < (const Vector2<T>& v) const
+{
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		if (elements[i] < v[i]) return true;
+		else if (elements[i] > v[i]) return false;
+	}
+	return false;
+}
+
+template <typename T> constexpr bool Vector2<T>::operator == (const Vector2<T>& v) const { return (elements[0] == v[0]) && (elements[1] == v[1]); }
+template <typename T> constexpr bool Vector2<T>::operator != (const Vector2<T>& v) const { return !(*this == v); }
+
+// ----------------------------------------- Vector3 ----------------------------------------------
+
+template <typename T> constexpr Vector3<T>::Vector3() : elements{} { }
+template <typename T> constexpr Vector3<T>::Vector3(T t) : elements{ t, t, t } { }
+template <typename T> constexpr Vector3<T>::Vector3(T _x, T _y, T _z) : elements{ _x, _y, _z } { }
+
+template <typename T> constexpr T& Vector3<T>::operator[] (uint32_t i) { return elements[i]; }
+template <typename T> constexpr const T& Vector3<T>::operator[] (uint32_t i) const { return elements[i]; }
+
+template <typename T> constexpr Vector3<T> Vector3<T>::operator + () const { return *this; }
+template <typename T> constexpr Vector3<T> Vector3<T>::operator - () const
+{
+	static_assert(std::is_signed<T>::value, "cannot use unary minus operator on unsigned type");
+	return Vector3<T>(-elements[0], -elements[1], -elements[2]);
+}
+
+template <typename T> constexpr Vector3<T>  Vector3<T>::operator +  (const Vector3<T>& v) const { return Vector3<T>(elements[0] + v[0], elements[1] + v[1], elements[2] + v[2]); }
+template <typename T> constexpr Vector3<T>  Vector3<T>::operator -  (const Vector3<T>& v) const { return Vector3<T>(elements[0] - v[0], elements[1] - v[1], elements[2] - v[2]); }
+template <typename T> constexpr Vector3<T>& Vector3<T>::operator += (const Vector3<T>& v) { elements[0] += v[0]; elements[1] += v[1]; elements[2] += v[2]; return *this; }
+template <typename T> constexpr Vector3<T>& Vector3<T>::operator -= (const Vector3<T>& v) { elements[0] -= v[0]; elements[1] -= v[1]; elements[2] -= v[2]; return *this; }
+
+template <typename T> constexpr Vector3<T>  Vector3<T>::operator *  (T t) const { return Vector3<T>(elements[0] * t, elements[1] * t, elements[2] * t); }
+template <typename T> constexpr Vector3<T>& Vector3<T>::operator *= (T t) { elements[0] *= t; elements[1] *= t; elements[2] *= t; return *this; }
+
+template <typename T> constexpr bool Vector3<T>::operator < (const Vector3<T>& v) const
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (elements[i] < v[i]) return true;
+		else if (elements[i] > v[i]) return false;
+	}
+	return false;
+}
+
+template <typename T> constexpr bool Vector3<T>::operator == (const Vector3<T>& v) const { return (elements[0] == v[0]) && (elements[1] == v[1]) && (elements[2] == v[2]); }
+template <typename T> constexpr bool Vector3<T>::operator != (const Vector3<T>& v) const { return !(*this == v); }
+
+// ----------------------------------------- Vector4 ----------------------------------------------
+
+template <typename T> constexpr Vector4<T>::Vector4() : elements{} { }
+template <typename T> constexpr Vector4<T>::Vector4(T t) : elements{ t, t, t, t } { }
+template <typename T> constexpr Vector4<T>::Vector4(T _x, T _y, T _z, T _w) : elements{ _x, _y, _z, _w } { }
+template <typename T> constexpr Vector4<T>::Vector4(const Vector3<T>& v, T _w) : elements{ v[0], v[1], v[2], _w } { }
+
+template <typename T> constexpr T& Vector4<T>::operator[] (uint32_t i) { return elements[i]; }
+template <typename T> constexpr const T& Vector4<T>::operator[] (uint32_t i) const { return elements[i]; }
+
+template <typename T> constexpr Vector4<T> Vector4<T>::operator + () const { return *this; }
+template <typename T> constexpr Vector4<T> Vector4<T>::operator - () const
+{
+	static_assert(std::is_signed<T>::value, "cannot use unary minus operator on unsigned type");
+	return Vector4<T>(-elements[0], -elements[1], -elements[2], -elements[3]);
+}
+
+template <typename T> constexpr Vector4<T>  Vector4<T>::operator +  (const Vector4<T>& v) const { return Vector4<T>(elements[0] + v[0], elements[1] + v[1], elements[2] + v[2], elements[3] + v[3]); }
+template <typename T> constexpr Vector4<T>  Vector4<T>::operator -  (const Vector4<T>& v) const { return Vector4<T>(elements[0] - v[0], elements[1] - v[1], elements[2] - v[2], elements[3] - v[3]); }
+template <typename T> constexpr Vector4<T>& Vector4<T>::operator += (const Vector4<T>& v) { elements[0] += v[0]; elements[1] += v[1]; elements[2] += v[2]; elements[3] += v[3]; return *this; }
+template <typename T> constexpr Vector4<T>& Vector4<T>::operator -= (const Vector4<T>& v) { elements[0] -= v[0]; elements[1] -= v[1]; elements[2] -= v[2]; elements[3] -= v[3]; return *this; }
+
+template <typename T> constexpr Vector4<T>  Vector4<T>::operator *  (T t) const { return Vector4<T>(elements[0] * t, elements[1] * t, elements[2] * t, elements[3] * t); }
+template <typename T> constexpr Vector4<T>& Vector4<T>::operator *= (T t) { elements[0] *= t; elements[1] *= t; elements[2] *= t; elements[3] *= t; return *this; }
+
+template <typename T> constexpr bool Vector4<T>::operator < (const Vector4<T>& v) const
+{
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (elements[i] < v[i]) return true;
+		else if (elements[i] > v[i]) return false;
+	}
+	return false;
+}
+
+template <typename T> constexpr bool Vector4<T>::operator == (const Vector4<T>& v) const { return (elements[0] == v[0]) && (elements[1] == v[1]) && (elements[2] == v[2]) && (elements[3] == v[3]); }
+template <typename T> constexpr bool Vector4<T>::operator != (const Vector4<T>& v) const { return !(*this == v); }
+
+template <typename T> constexpr Vector2<T> operator * (T t, const Vector2<T>& v) { return v * t; }
+template <typename T> constexpr Vector3<T> operator * (T t, const Vector3<T>& v) { return v * t; }
+template <typename T> constexpr Vector4<T> operator * (T t, const Vector4<T>& v) { return v * t; }
+
+// ------------------------------------ Vector functions ------------------------------------------
+
+template <typename T> constexpr T Vector::Dot(const Vector2<T>& v0, const Vector2<T>& v1) { return (v0[0] * v1[0]) + (v0[1] * v1[1]); }
+template <typename T> constexpr T Vector::Dot(const Vector3<T>& v0, const Vector3<T>& v1) { return (v0[0] * v1[0]) + (v0[1] * v1[1]) + (v0[2] * v1[2]); }
+template <typename T> constexpr T Vector::Dot(const Vector4<T>& v0, const Vector4<T>& v1) { return (v0[0] * v1[0]) + (v0[1] * v1[1]) + (v0[2] * v1[2]) + (v0[3] * v1[3]); }
+
+template <typename T> inline T Vector::Length(const Vector2<T>& v) { return std::sqrt(Vector::Dot(v, v)); }
+template <typename T> inline T Vector::Length(const Vector3<T>& v) { return std::sqrt(Vector::Dot(v, v)); }
+template <typename T> inline T Vector::Length(const Vector4<T>& v) { return std::sqrt(Vector::Dot(v, v)); }
+
+template <typename T> inline Vector2<T> Vector::Normalize(const Vector2<T>& v) { return v * (static_cast<T>(1) / Vector::Length(v)); }
+template <typename T> inline Vector3<T> Vector::Normalize(const Vector3<T>& v) { return v * (static_cast<T>(1) / Vector::Length(v)); }
+template <typename T> inline Vector4<T> Vector::Normalize(const Vector4<T>& v) { return v * (static_cast<T>(1) / Vector::Length(v)); }
+
+template <typename T> constexpr Vector3<T> Vector::Cross(const Vector3<T>& v0, const Vector3<T>& v1)
+{
+	return Vector3<T>(
+		(v0[1] * v1[2]) - (v0[2] * v1[1]),
+		(v0[2] * v1[0]) - (v0[0] * v1[2]),
+		(v0[0] * v1[1]) - (v0[1] * v1[0])
+	);
+}
+
+template <typename T> inline T Vector::Distance(const Vector2<T>& v0, const Vector2<T>& v1) { return Vector::Length(v1 - v0); }
+template <typename T> inline T Vector::Distance(const Vector3<T>& v0, const Vector3<T>& v1) { return Vector::Length(v1 - v0); }
+template <typename T> inline T Vector::Distance(const Vector4<T>& v0, const Vector4<T>& v1) { return Vector::Length(v1 - v0); }
+
+// --------------------------------------- Quaternion ---------------------------------------------
+
+template <typename T> constexpr Quaternion<T>::Quaternion() : elements{} { }
+template <typename T> inline Quaternion<T>::Quaternion(const Vector3<T>& v) : Quaternion<T>(v[0], v[1], v[2]) { }
+template <typename T> constexpr Quaternion<T>::Quaternion(const Vector4<T>& v) : elements{ v[0], v[1], v[2], v[3] } { }
+template <typename T> constexpr Quaternion<T>::Quaternion(T _x, T _y, T _z, T _w) : elements{ _x, _y, _z, _w } { }
+
+template <typename T> constexpr Quaternion<T> Quaternion<T>::operator * (const Quaternion<T>& q) const
+{
+	const T* a = elements;
+	const T* b = q.elements;
+
+	return Quaternion<T>(
+		a[3]*b[0] + a[0]*b[3] + a[1]*b[2] - a[2]*b[1],
+		a[3]*b[1] - a[0]*b[2] + a[1]*b[3] + a[2]*b[0],
+		a[3]*b[2] + a[0]*b[1] - a[1]*b[0] + a[2]*b[3],
+		a[3]*b[3] - a[0]*b[0] - a[1]*b[1] - a[2]*b[2]
+	);
+}
+
+template <typename T> constexpr Quaternion<T>& Quaternion<T>::operator *= (const Quaternion<T>& q)
+{
+	*this = *this * q;
+	return *this;
+}
+
+template <typename T> constexpr Quaternion<T>& Quaternion<T>::operator = (const Vector4<T>& v)
+{
+	*this = Quaternion<T>(v);
+	return *this;
+}
+
+template <typename T> constexpr Vector3<T> Quaternion<T>::Rotate(const Vector3<T>& v) const
+{
+	// q * v * q^-1 expanded: v' = v + w * t + u x t, where t = 2 * (u x v)
+	const Vector3<T> u(elements[0], elements[1], elements[2]);
+	const Vector3<T> t = Vector::Cross(u, v) * static_cast<T>(2);
+	return v + t * elements[3] + Vector::Cross(u, t);
+}
+
+// ---------------------------------- Quaternion functions ----------------------------------------
+
+template <typename T> constexpr T Quat::Dot(const Quaternion<T>& q0, const Quaternion<T>& q1)
+{
+	return (q0.elements[0] * q1.elements[0]) + (q0.elements[1] * q1.elements[1]) + (q0.elements[2] * q1.elements[2]) + (q0.elements[3] * q1.elements[3]);
+}
+
+template <typename T> inline T Quat::Length(const Quaternion<T>& q) { return std::sqrt(Quat::Dot(q, q)); }
+
+template <typename T> inline Quaternion<T> Quat::Normalize(const Quaternion<T>& q)
+{
+	const T s = static_cast<T>(1) / Quat::Length(q);
+	return Quaternion<T>(q.elements[0] * s, q.elements[1] * s, q.elements[2] * s, q.elements[3] * s);
+}
+
+template <typename T> constexpr Quaternion<T> Quat::Conjugate(const Quaternion<T>& q)
+{
+	return Quaternion<T>(-q.elements[0], -q.elements[1], -q.elements[2], q.elements[3]);
+}
+
+template <typename T> constexpr Quaternion<T> Quat::Inverse(const Quaternion<T>& q)
+{
+	const T s = static_cast<T>(1) / Quat::Dot(q, q);
+	return Quaternion<T>(-q.elements[0] * s, -q.elements[1] * s, -q.elements[2] * s, q.elements[3] * s);
+}
+
+template <typename T> inline Quaternion<T> Quat::Nlerp(const Quaternion<T>& q0, const Quaternion<T>& q1, T t)
+{
+	// q1 is negated when the quaternions are more than 90 degrees apart to take the shortest arc
+	const T s = (Quat::Dot(q0, q1) < static_cast<T>(0)) ? static_cast<T>(-1) : static_cast<T>(1);
+
+	Quaternion<T> r;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		r.elements[i] = q0.elements[i] + (q1.elements[i] * s - q0.elements[i]) * t;
+	}
+	return Quat::Normalize(r);
+}
+
+template <typename T> inline Quaternion<T> Quat::Slerp(const Quaternion<T>& q0, const Quaternion<T>& q1, T t)
+{
+	T d = Quat::Dot(q0, q1);
+	T s = static_cast<T>(1);
+
+	if (d < static_cast<T>(0))
+	{
+		d = -d;
+		s = -s;
+	}
+
+	// nearly parallel, sin(theta) would be too small to divide by
+	if (d > static_cast<T>(0.9995))
+	{
+		return Quat::Nlerp(q0, q1, t);
+	}
+
+	const T theta = std::acos(d);
+	const T rcp   = static_cast<T>(1) / std::sin(theta);
+	const T w0    = std::sin((static_cast<T>(1) - t) * theta) * rcp;
+	const T w1    = std::sin(t * theta) * rcp * s;
+
+	Quaternion<T> r;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		r.elements[i] = q0.elements[i] * w0 + q1.elements[i] * w1;
+	}
+	return r;
+}
+
+template <typename T> inline Quaternion<T> Quat::SlerpFast(const Quaternion<T>& q0, const Quaternion<T>& q1, T t)
+{
+	// Polynomial fit of the slerp parameter correction for nlerp, depending on the angle between the quaternions
+	const T d = std::fabs(Quat::Dot(q0, q1));
+	const T a = static_cast<T>(1.0904) + d * (static_cast<T>(-3.2452) + d * (static_cast<T>(3.55645) - d * static_cast<T>(1.43519)));
+	const T b = static_cast<T>(0.848013) + d * (static_cast<T>(-1.06021) + d * static_cast<T>(0.215638));
+	const T h = t - static_cast<T>(0.5);
+	const T k = a * h * h + b;
+
+	return Quat::Nlerp(q0, q1, t + t * h * (t - static_cast<T>(1)) * k);
+}
+
+// ----------------------------------------- Matrix2 ----------------------------------------------
+
+template <typename T> constexpr Matrix2<T>::Matrix2() : Matrix2<T>(static_cast<T>(1)) { }
+template <typename T> constexpr Matrix2<T>::Matrix2(T t) : rows{ Vector2<T>(t, 0), Vector2<T>(0, t) } { }
+template <typename T> constexpr Matrix2<T>::Matrix2(const Vector2<T>& v0, const Vector2<T>& v1) : rows{ v0, v1 } { }
+
+template <typename T> constexpr Vector2<T>& Matrix2<T>::operator[] (uint32_t i) { return rows[i]; }
+template <typename T> constexpr const Vector2<T>& Matrix2<T>::operator[] (uint32_t i) const { return rows[i]; }
+
+template <typename T> constexpr Matrix2<T>  Matrix2<T>::operator *  (T t) const { return Matrix2<T>(rows[0] * t, rows[1] * t); }
+template <typename T> constexpr Matrix2<T>& Matrix2<T>::operator *= (T t) { rows[0] *= t; rows[1] *= t; return *this; }
+
+template <typename T> constexpr Matrix2<T>  Matrix2<T>::operator +  (const Matrix2<T>& m) const { return Matrix2<T>(rows[0] + m[0], rows[1] + m[1]); }
+template <typename T> constexpr Matrix2<T>  Matrix2<T>::operator -  (const Matrix2<T>& m) const { return Matrix2<T>(rows[0] - m[0], rows[1] - m[1]); }
+template <typename T> constexpr Matrix2<T>& Matrix2<T>::operator += (const Matrix2<T>& m) { rows[0] += m[0]; rows[1] += m[1]; return *this; }
+template <typename T> constexpr Matrix2<T>& Matrix2<T>::operator -= (const Matrix2<T>& m) { rows[0] -= m[0]; rows[1] -= m[1]; return *this; }
+
+template <typename T> constexpr Matrix2<T> Matrix2<T>::operator * (const Matrix2<T>& m) const
+{
+	// r[c] = sum_k (m[c][k] * this[k])
+	Matrix2<T> r;
+	for (uint32_t c = 0; c < 2; c++)
+	{
+		r[c] = rows[0] * m[c][0] + rows[1] * m[c][1];
+	}
+	return r;
+}
+
+template <typename T> constexpr Matrix2<T>& Matrix2<T>::operator *= (const Matrix2<T>& m) { *this = *this * m; return *this; }
+
+template <typename T> constexpr Vector2<T> Matrix2<T>::operator * (const Vector2<T>& v) const
+{
+	return Vector2<T>(Vector::Dot(v, rows[0]), Vector::Dot(v, rows[1]));
+}
+
+// ----------------------------------------- Matrix3 ----------------------------------------------
+
+template <typename T> constexpr Matrix3<T>::Matrix3() : Matrix3<T>(static_cast<T>(1)) { }
+template <typename T> constexpr Matrix3<T>::Matrix3(T t) : rows{ Vector3<T>(t, 0, 0), Vector3<T>(0, t, 0), Vector3<T>(0, 0, t) } { }
+template <typename T> constexpr Matrix3<T>::Matrix3(const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2) : rows{ v0, v1, v2 } { }
+
+template <typename T> constexpr Vector3<T>& Matrix3<T>::operator[] (uint32_t i) { return rows[i]; }
+template <typename T> constexpr const Vector3<T>& Matrix3<T>::operator[] (uint32_t i) const { return rows[i]; }
+
+template <typename T> constexpr Matrix3<T>  Matrix3<T>::operator *  (T t) const { return Matrix3<T>(rows[0] * t, rows[1] * t, rows[2] * t); }
+template <typename T> constexpr Matrix3<T>& Matrix3<T>::operator *= (T t) { rows[0] *= t; rows[1] *= t; rows[2] *= t; return *this; }
+
+template <typename T> constexpr Matrix3<T>  Matrix3<T>::operator +  (const Matrix3<T>& m) const { return Matrix3<T>(rows[0] + m[0], rows[1] + m[1], rows[2] + m[2]); }
+template <typename T> constexpr Matrix3<T>  Matrix3<T>::operator -  (const Matrix3<T>& m) const { return Matrix3<T>(rows[0] - m[0], rows[1] - m[1], rows[2] - m[2]); }
+template <typename T> constexpr Matrix3<T>& Matrix3<T>::operator += (const Matrix3<T>& m) { rows[0] += m[0]; rows[1] += m[1]; rows[2] += m[2]; return *this; }
+template <typename T> constexpr Matrix3<T>& Matrix3<T>::operator -= (const Matrix3<T>& m) { rows[0] -= m[0]; rows[1] -= m[1]; rows[2] -= m[2]; return *this; }
+
+template <typename T> constexpr Matrix3<T> Matrix3<T>::operator * (const Matrix3<T>& m) const
+{
+	// r[c] = sum_k (m[c][k] * this[k])
+	Matrix3<T> r;
+	for (uint32_t c = 0; c < 3; c++)
+	{
+		r[c] = rows[0] * m[c][0] + rows[1] * m[c][1] + rows[2] * m[c][2];
+	}
+	return r;
+}
+
+template <typename T> constexpr Matrix3<T>& Matrix3<T>::operator *= (const Matrix3<T>& m) { *this = *this * m; return *this; }
+
+template <typename T> constexpr Vector3<T> Matrix3<T>::operator * (const Vector3<T>& v) const
+{
+	return Vector3<T>(Vector::Dot(v, rows[0]), Vector::Dot(v, rows[1]), Vector::Dot(v, rows[2]));
+}
+
+// ----------------------------------------- Matrix4 ----------------------------------------------
+
+template <typename T> constexpr Matrix4<T>::Matrix4() : Matrix4<T>(static_cast<T>(1)) { }
+template <typename T> constexpr Matrix4<T>::Matrix4(T t) : rows{ Vector4<T>(t, 0, 0, 0), Vector4<T>(0, t, 0, 0), Vector4<T>(0, 0, t, 0), Vector4<T>(0, 0, 0, t) } { }
+template <typename T> constexpr Matrix4<T>::Matrix4(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2, const Vector4<T>& v3) : rows{ v0, v1, v2, v3 } { }
+
+template <typename T> constexpr Matrix4<T>::Matrix4(const Quaternion<T>& q) : Matrix4<T>(static_cast<T>(1))
+{
+	const T* v = q.elements;
+
+	const T qxx = v[0] * v[0];
+	const T qxy = v[0] * v[1];
+	const T qxz = v[0] * v[2];
+	const T qxw = v[3] * v[0];
+	const T qyy = v[1] * v[1];
+	const T qyz = v[1] * v[2];
+	const T qyw = v[3] * v[1];
+	const T qzz = v[2] * v[2];
+	const T qzw = v[3] * v[2];
+
+	const T one = static_cast<T>(1);
+	const T two = static_cast<T>(2);
+
+	rows[0] = Vector4<T>(one - two * (qyy + qzz), two * (qxy + qzw), two * (qxz - qyw), 0);
+	rows[1] = Vector4<T>(two * (qxy - qzw), one - two * (qxx + qzz), two * (qyz + qxw), 0);
+	rows[2] = Vector4<T>(two * (qxz + qyw), two * (qyz - qxw), one - two * (qxx + qyy), 0);
+}
+
+template <typename T> constexpr Matrix4<T>::Matrix4(const Matrix3x4<T>& m) : rows{
+	Vector4<T>(m[0][0], m[1][0], m[2][0], 0),
+	Vector4<T>(m[0][1], m[1][1], m[2][1], 0),
+	Vector4<T>(m[0][2], m[1][2], m[2][2], 0),
+	Vector4<T>(m[0][3], m[1][3], m[2][3], 1) } { }
+
+template <typename T> constexpr Matrix4<T>::Matrix4(const Transform<T>& t) : Matrix4<T>(t.rotation)
+{
+	rows[0] *= t.scale[0];
+	rows[1] *= t.scale[1];
+	rows[2] *= t.scale[2];
+	rows[3] = Vector4<T>(t.translation, static_cast<T>(1));
+}
+
+template <typename T> constexpr Vector4<T>& Matrix4<T>::operator[] (uint32_t i) { return rows[i]; }
+template <typename T> constexpr const Vector4<T>& Matrix4<T>::operator[] (uint32_t i) const { return rows[i]; }
+
+template <typename T> constexpr Matrix4<T>  Matrix4<T>::operator *  (T t) const { return Matrix4<T>(rows[0] * t, rows[1] * t, rows[2] * t, rows[3] * t); }
+template <typename T> constexpr Matrix4<T>& Matrix4<T>::operator *= (T t) { rows[0] *= t; rows[1] *= t; rows[2] *= t; rows[3] *= t; return *this; }
+
+template <typename T> constexpr Matrix4<T>  Matrix4<T>::operator +  (const Matrix4<T>& m) const { return Matrix4<T>(rows[0] + m[0], rows[1] + m[1], rows[2] + m[2], rows[3] + m[3]); }
+template <typename T> constexpr Matrix4<T>  Matrix4<T>::operator -  (const Matrix4<T>& m) const { return Matrix4<T>(rows[0] - m[0], rows[1] - m[1], rows[2] - m[2], rows[3] - m[3]); }
+template <typename T> constexpr Matrix4<T>& Matrix4<T>::operator += (const Matrix4<T>& m) { rows[0] += m[0]; rows[1] += m[1]; rows[2] += m[2]; rows[3] += m[3]; return *this; }
+template <typename T> constexpr Matrix4<T>& Matrix4<T>::operator -= (const Matrix4<T>& m) { rows[0] -= m[0]; rows[1] -= m[1]; rows[2] -= m[2]; rows[3] -= m[3]; return *this; }
+
+template <typename T> constexpr Matrix4<T> Matrix4<T>::operator * (const Matrix4<T>& m) const
+{
+	Matrix4<T> r;
+
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			Simd::Multiply(*this, m, r);
+			return r;
+		}
+	}
+#endif
+
+	// r[c] = sum_k (m[c][k] * this[k])
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		r[c] = rows[0] * m[c][0] + rows[1] * m[c][1] + rows[2] * m[c][2] + rows[3] * m[c][3];
+	}
+	return r;
+}
+
+template <typename T> constexpr Matrix4<T>& Matrix4<T>::operator *= (const Matrix4<T>& m) { *this = *this * m; return *this; }
+
+template <typename T> constexpr Vector4<T> Matrix4<T>::operator * (const Vector4<T>& v) const
+{
+	return Vector4<T>(Vector::Dot(v, rows[0]), Vector::Dot(v, rows[1]), Vector::Dot(v, rows[2]), Vector::Dot(v, rows[3]));
+}
+
+// ---------------------------------------- Matrix3x4 ---------------------------------------------
+
+template <typename T> constexpr Matrix3x4<T>::Matrix3x4() : Matrix3x4<T>(static_cast<T>(1)) { }
+template <typename T> constexpr Matrix3x4<T>::Matrix3x4(T t) : rows{ Vector4<T>(t, 0, 0, 0), Vector4<T>(0, t, 0, 0), Vector4<T>(0, 0, t, 0) } { }
+template <typename T> constexpr Matrix3x4<T>::Matrix3x4(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2) : rows{ v0, v1, v2 } { }
+
+template <typename T> constexpr Matrix3x4<T>::Matrix3x4(const Matrix4<T>& m) : rows{
+	Vector4<T>(m[0][0], m[1][0], m[2][0], m[3][0]),
+	Vector4<T>(m[0][1], m[1][1], m[2][1], m[3][1]),
+	Vector4<T>(m[0][2], m[1][2], m[2][2], m[3][2]) } { }
+
+template <typename T> constexpr Matrix3x4<T>::Matrix3x4(const Transform<T>& t) : Matrix3x4<T>(Matrix4<T>(t)) { }
+
+template <typename T> constexpr Vector4<T>& Matrix3x4<T>::operator[] (uint32_t i) { return rows[i]; }
+template <typename T> constexpr const Vector4<T>& Matrix3x4<T>::operator[] (uint32_t i) const { return rows[i]; }
+
+template <typename T> constexpr Matrix3x4<T> Matrix3x4<T>::operator * (const Matrix3x4<T>& m) const
+{
+	Matrix3x4<T> r;
+
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			Simd::Multiply(*this, m, r);
+			return r;
+		}
+	}
+#endif
+
+	// r[i] = sum_k (this[i][k] * m[k]) + <0, 0, 0, this[i][3]>
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		r[i] = m[0] * rows[i][0] + m[1] * rows[i][1] + m[2] * rows[i][2] + Vector4<T>(0, 0, 0, rows[i][3]);
+	}
+	return r;
+}
+
+template <typename T> constexpr Matrix3x4<T>& Matrix3x4<T>::operator *= (const Matrix3x4<T>& m) { *this = *this * m; return *this; }
+
+template <typename T> constexpr Vector3<T> Matrix3x4<T>::operator * (const Vector4<T>& v) const
+{
+	return Vector3<T>(Vector::Dot(v, rows[0]), Vector::Dot(v, rows[1]), Vector::Dot(v, rows[2]));
+}
+
+// ------------------------------------ Matrix functions ------------------------------------------
+
+template <typename T> constexpr Matrix2<T> Matrix::Transpose(const Matrix2<T>& m)
+{
+	return Matrix2<T>(
+		Vector2<T>(m[0][0], m[1][0]),
+		Vector2<T>(m[0][1], m[1][1])
+	);
+}
+
+template <typename T> constexpr Matrix3<T> Matrix::Transpose(const Matrix3<T>& m)
+{
+	return Matrix3<T>(
+		Vector3<T>(m[0][0], m[1][0], m[2][0]),
+		Vector3<T>(m[0][1], m[1][1], m[2][1]),
+		Vector3<T>(m[0][2], m[1][2], m[2][2])
+	);
+}
+
+template <typename T> constexpr Matrix4<T> Matrix::Transpose(const Matrix4<T>& m)
+{
+	return Matrix4<T>(
+		Vector4<T>(m[0][0], m[1][0], m[2][0], m[3][0]),
+		Vector4<T>(m[0][1], m[1][1], m[2][1], m[3][1]),
+		Vector4<T>(m[0][2], m[1][2], m[2][2], m[3][2]),
+		Vector4<T>(m[0][3], m[1][3], m[2][3], m[3][3])
+	);
+}
+
+template <typename T> constexpr Matrix4<T> Matrix::Translate(const Vector3<T>& v)
+{
+	Matrix4<T> m(static_cast<T>(1));
+	m[3] = Vector4<T>(v, static_cast<T>(1));
+	return m;
+}
+
+template <typename T> constexpr Matrix4<T> Matrix::Scale(const Vector3<T>& v)
+{
+	Matrix4<T> m(static_cast<T>(1));
+	m[0][0] = v[0];
+	m[1][1] = v[1];
+	m[2][2] = v[2];
+	return m;
+}
+
+template <typename T> inline Matrix4<T> Matrix::Rotate(const Vector3<T>& v)
+{
+	return Matrix4<T>(Quaternion<T>(v));
+}
+
+// ------------------------------------- Dual Quaternion -----------------------------------------
+
+template <typename T> constexpr DualQuaternion<T>::DualQuaternion() : real(0, 0, 0, 1), dual(0, 0, 0, 0) { }
+template <typename T> constexpr DualQuaternion<T>::DualQuaternion(const Quaternion<T>& r, const Quaternion<T>& d) : real(r), dual(d) { }
+
+template <typename T> constexpr DualQuaternion<T>::DualQuaternion(const Quaternion<T>& q, const Vector3<T>& t) : real(q), dual()
+{
+	dual = Quaternion<T>(t[0], t[1], t[2], 0) * q;
+	for (uint32_t i = 0; i < 4; i++) { dual.elements[i] *= static_cast<T>(0.5); }
+}
+
+template <typename T> constexpr DualQuaternion<T> DualQuaternion<T>::operator * (const DualQuaternion<T>& q) const
+{
+	// (r0 + e d0)(r1 + e d1) = r0 r1 + e (r0 d1 + d0 r1)
+	const Quaternion<T> d0 = real * q.dual;
+	const Quaternion<T> d1 = dual * q.real;
+
+	DualQuaternion<T> r(real * q.real, d0);
+	for (uint32_t i = 0; i < 4; i++) { r.dual.elements[i] += d1.elements[i]; }
+	return r;
+}
+
+template <typename T> constexpr DualQuaternion<T>& DualQuaternion<T>::operator *= (const DualQuaternion<T>& q) { *this = *this * q; return *this; }
+
+template <typename T> constexpr Vector3<T> DualQuaternion<T>::GetTranslation() const
+{
+	// t = 2 * (dual * conjugate(real)).xyz
+	const Vector3<T> r(real.elements[0], real.elements[1], real.elements[2]);
+	const Vector3<T> d(dual.elements[0], dual.elements[1], dual.elements[2]);
+	return (d * real.elements[3] - r * dual.elements[3] + Vector::Cross(r, d)) * static_cast<T>(2);
+}
+
+template <typename T> constexpr Vector3<T> DualQuaternion<T>::TransformVector(const Vector3<T>& v) const
+{
+	// v' = v + w * t + u x t, where t = 2 * (u x v)
+	const Vector3<T> u(real.elements[0], real.elements[1], real.elements[2]);
+	const Vector3<T> t = Vector::Cross(u, v) * static_cast<T>(2);
+	return v + t * real.elements[3] + Vector::Cross(u, t);
+}
+
+template <typename T> constexpr Vector3<T> DualQuaternion<T>::TransformPoint(const Vector3<T>& p) const
+{
+	return TransformVector(p) + GetTranslation();
+}
+
+// ---------------------------------- Dual Quaternion functions -----------------------------------
+
+template <typename T> inline DualQuaternion<T> DualQuat::Normalize(const DualQuaternion<T>& q)
+{
+	// scale both parts by 1 / |real|, then remove the component of dual along real so that dot(real, dual) = 0
+	const T s = static_cast<T>(1) / Quat::Length(q.real);
+
+	DualQuaternion<T> r;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		r.real.elements[i] = q.real.elements[i] * s;
+		r.dual.elements[i] = q.dual.elements[i] * s;
+	}
+
+	const T d = Quat::Dot(r.real, r.dual);
+	for (uint32_t i = 0; i < 4; i++) { r.dual.elements[i] -= r.real.elements[i] * d; }
+
+	return r;
+}
+
+template <typename T> constexpr DualQuaternion<T> DualQuat::Inverse(const DualQuaternion<T>& q)
+{
+	return DualQuaternion<T>(Quat::Conjugate(q.real), Quat::Conjugate(q.dual));
+}
+
+template <typename T> inline DualQuaternion<T> DualQuat::Blend(const DualQuaternion<T>& q0, const DualQuaternion<T>& q1, T t)
+{
+	const DualQuaternion<T> q[2] = { q0, q1 };
+	const T w[2] = { static_cast<T>(1) - t, t };
+	return DualQuat::Blend(q, w, 2);
+}
+
+template <typename T> inline DualQuaternion<T> DualQuat::Blend(const DualQuaternion<T>* pIn, const T* pWeights, uint32_t count)
+{
+	DualQuaternion<T> r(Quaternion<T>(0, 0, 0, 0), Quaternion<T>(0, 0, 0, 0));
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		// q and -q are the same transform, take the one on the same side as the first
+		const T w = (Quat::Dot(pIn[0].real, pIn[i].real) < static_cast<T>(0)) ? -pWeights[i] : pWeights[i];
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			r.real.elements[j] += pIn[i].real.elements[j] * w;
+			r.dual.elements[j] += pIn[i].dual.elements[j] * w;
+		}
+	}
+
+	return DualQuat::Normalize(r);
+}
+
+// ---------------------------------------- Transform --------------------------------------------
+
+template <typename T> constexpr Transform<T>::Transform() : translation(), rotation(0, 0, 0, 1), scale(static_cast<T>(1)) { }
+template <typename T> constexpr Transform<T>::Transform(const Vector3<T>& t, const Quaternion<T>& r, const Vector3<T>& s) : translation(t), rotation(r), scale(s) { }
+
+template <typename T> constexpr Transform<T> Transform<T>::operator * (const Transform<T>& t) const
+{
+	// the child translation is scaled and rotated by the parent, the rotations are concatenated like the matrices
+	return Transform<T>(TransformPoint(t.translation), rotation * t.rotation, Vector3<T>(scale[0] * t.scale[0], scale[1] * t.scale[1], scale[2] * t.scale[2]));
+}
+
+template <typename T> constexpr Transform<T>& Transform<T>::operator *= (const Transform<T>& t) { *this = *this * t; return *this; }
+
+template <typename T> constexpr Vector3<T> Transform<T>::TransformVector(const Vector3<T>& v) const
+{
+	// rotated like Quaternion::Rotate: v' = s + w * t + u x t, where t = 2 * (u x s)
+	const Vector3<T> s(v[0] * scale[0], v[1] * scale[1], v[2] * scale[2]);
+	const Vector3<T> u(rotation.elements[0], rotation.elements[1], rotation.elements[2]);
+	const Vector3<T> t = Vector::Cross(u, s) * static_cast<T>(2);
+	return s + t * rotation.elements[3] + Vector::Cross(u, t);
+}
+
+template <typename T> constexpr Vector3<T> Transform<T>::TransformPoint(const Vector3<T>& p) const
+{
+	return TransformVector(p) + translation;
+}
+
+// ------------------------------------ Transform functions ---------------------------------------
+
+template <typename T> constexpr Transform<T> Xform::Inverse(const Transform<T>& t)
+{
+	// S^-1 * R^-1 * T^-1, the inverse scale commutes with the rotation only when it is uniform
+	const Vector3<T> s(static_cast<T>(1) / t.scale[0], static_cast<T>(1) / t.scale[1], static_cast<T>(1) / t.scale[2]);
+	const Quaternion<T> r = Quat::Conjugate(t.rotation);
+	const Vector3<T> p = r.Rotate(-t.translation);
+
+	return Transform<T>(Vector3<T>(p[0] * s[0], p[1] * s[1], p[2] * s[2]), r, s);
+}
+
+template <typename T> inline Transform<T> Xform::Lerp(const Transform<T>& t0, const Transform<T>& t1, T t)
+{
+	return Transform<T>(
+		t0.translation + (t1.translation - t0.translation) * t,
+		Quat::Nlerp(t0.rotation, t1.rotation, t),
+		t0.scale + (t1.scale - t0.scale) * t
+	);
+}
+
+template <typename T> inline Transform<T> Xform::Blend(const Transform<T>* pIn, const T* pWeights, uint32_t count)
+{
+	Transform<T> r(Vector3<T>(), Quaternion<T>(0, 0, 0, 0), Vector3<T>());
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		// q and -q are the same rotation, take the one on the same side as the first
+		const T w = (Quat::Dot(pIn[0].rotation, pIn[i].rotation) < static_cast<T>(0)) ? -pWeights[i] : pWeights[i];
+		for (uint32_t j = 0; j < 4; j++) { r.rotation.elements[j] += pIn[i].rotation.elements[j] * w; }
+
+		r.translation += pIn[i].translation * pWeights[i];
+		r.scale += pIn[i].scale * pWeights[i];
+	}
+
+	r.rotation = Quat::Normalize(r.rotation);
+	return r;
+}
+
+// ----------------------------------------- Bounds ----------------------------------------------
+
+template <typename T> constexpr Plane<T>::Plane() : normal(), distance(0) { }
+template <typename T> constexpr Plane<T>::Plane(const Vector3<T>& n, T d) : normal(n), distance(d) { }
+template <typename T> constexpr Plane<T>::Plane(const Vector3<T>& n, const Vector3<T>& p) : normal(n), distance(-Vector::Dot(n, p)) { }
+
+template <typename T> constexpr T Plane<T>::Distance(const Vector3<T>& p) const { return Vector::Dot(p, normal) + distance; }
+
+template <typename T> constexpr AABB<T>::AABB() : min{ static_cast<T>(INF) }, max{ static_cast<T>(-INF) } { }
+template <typename T> constexpr AABB<T>::AABB(const Vector3<T>& vMin, const Vector3<T>& vMax) : min{ vMin }, max{ vMax } { }
+
+template <typename T> constexpr Vector3<T> AABB<T>::GetCenter() const { return (min + max) * static_cast<T>(0.5); }
+template <typename T> constexpr Vector3<T> AABB<T>::GetExtents() const { return (max - min) * static_cast<T>(0.5); }
+
+template <typename T> constexpr void AABB<T>::Merge(const Vector3<T>& p)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		min[i] = (p[i] < min[i]) ? p[i] : min[i];
+		max[i] = (max[i] < p[i]) ? p[i] : max[i];
+	}
+}
+
+template <typename T> constexpr void AABB<T>::Merge(const AABB<T>& b)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		min[i] = (b.min[i] < min[i]) ? b.min[i] : min[i];
+		max[i] = (max[i] < b.max[i]) ? b.max[i] : max[i];
+	}
+}
+
+template <typename T> constexpr Sphere<T>::Sphere() : center(), radius(0) { }
+template <typename T> constexpr Sphere<T>::Sphere(const Vector3<T>& c, T r) : center(c), radius(r) { }
+
+template <typename T> constexpr Frustum<T>::Frustum() : planes{} { }
+
+template <typename T> inline Frustum<T>::Frustum(const Matrix4<T>& m) : planes{}
+{
+	// Rows of the clip space transform c = m * <p, 1>, a point is inside when -c.w <= c.x <= c.w, -c.w <= c.y <= c.w and 0 <= c.z <= c.w
+	Vector4<T> r[4];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		r[i] = Vector4<T>(m[0][i], m[1][i], m[2][i], m[3][i]);
+	}
+
+	const Vector4<T> p[6] = { r[3] + r[0], r[3] - r[0], r[3] + r[1], r[3] - r[1], r[2], r[3] - r[2] };
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		planes[i] = Bounds::Normalize(Plane<T>(Vector3<T>(p[i][0], p[i][1], p[i][2]), p[i][3]));
+	}
+}
+
+// ------------------------------------- Bounds functions -----------------------------------------
+
+template <typename T> inline Plane<T> Bounds::Normalize(const Plane<T>& p)
+{
+	const T s = static_cast<T>(1) / Vector::Length(p.normal);
+	return Plane<T>(p.normal * s, p.distance * s);
+}
+
+template <typename T> inline AABB<T> Bounds::Transform(const AABB<T>& b, const Matrix4<T>& m)
+{
+	return Bounds::Transform(b, Matrix3x4<T>(m));
+}
+
+template <typename T> inline AABB<T> Bounds::Transform(const AABB<T>& b, const Matrix3x4<T>& m)
+{
+	// the center is transformed as a point, the extents by the absolute value of the linear part
+	const Vector3<T> c = m * Vector4<T>(b.GetCenter(), static_cast<T>(1));
+	const Vector3<T> e = b.GetExtents();
+
+	Vector3<T> r;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		r[i] = std::fabs(m[i][0]) * e[0] + std::fabs(m[i][1]) * e[1] + std::fabs(m[i][2]) * e[2];
+	}
+
+	return AABB<T>(c - r, c + r);
+}
+
+// ----------------------------------------- Layout ----------------------------------------------
+
+// The types are copied with memcpy into mapped upload buffers, they must stay trivially copyable and tightly packed
+static_assert(std::is_trivially_copyable<Vector2F>::value && std::is_trivially_copyable<Vector3F>::value && std::is_trivially_copyable<Vector4F>::value, "vectors must be trivially copyable");
+static_assert(std::is_trivially_copyable<Quaternion<float>>::value && std::is_trivially_copyable<DualQuaternionF>::value, "quaternions must be trivially copyable");
+static_assert(std::is_trivially_copyable<TransformF>::value && (sizeof(TransformF) == 40), "transforms must be trivially copyable and packed");
+static_assert(std::is_trivially_copyable<Matrix3F>::value && std::is_trivially_copyable<Matrix4F>::value && std::is_trivially_copyable<Matrix3x4F>::value, "matrices must be trivially copyable");
+static_assert((sizeof(Vector3F) == 12) && (sizeof(Vector4F) == 16) && (sizeof(Matrix4F) == 64) && (sizeof(Matrix3x4F) == 48), "unexpected padding");
+
+#endif // CG_MATH__INL
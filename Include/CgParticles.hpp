@@ -0,0 +1,82 @@
+#ifndef CG_PARTICLES__HPP
+#define CG_PARTICLES__HPP
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "CgMath.hpp"
+
+/* CPU particle simulation (defined in Source/Particles) */
+
+// Particles are stored as structure of arrays streams and integrated 8 (AVX2) or 4 (SSE) at a time on the Parallel
+// workers. Dead particles are removed by moving the last particle into their slot, so the order is not kept.
+class ParticleSystem
+{
+public:
+	// Particles spawn uniformly in the box position +- extents, every value is base +- jitter
+	struct EMITTER_DESC
+	{
+		Vector3F position;
+		Vector3F extents;
+		Vector3F velocity;
+		Vector3F velocityJitter;
+		Vector4F color;          // RGBA, the alpha fades out over the life in the vertex stream
+		float    lifetime;       // seconds
+		float    lifetimeJitter;
+		float    size;
+	};
+
+	// Colliders are solid: particles are pushed out of them and their velocity is reflected
+	// The normals of the planes point to the free side and are unit length
+	struct SIMULATION_DESC
+	{
+		Vector3F gravity;
+		float    drag;         // fraction of the velocity lost per second
+		float    restitution;  // fraction of the normal velocity kept by a bounce
+	};
+
+	// Vertex stream of the particles for CreateVertexBuffer or a mapped buffer
+	struct Vertex
+	{
+		float    position[3];
+		float    size;
+		uint32_t color;       // RGBA8
+	};
+
+public:
+	ParticleSystem(void);
+
+	// Removes every particle, the seed makes the emission reproducible
+	bool     Initialize(uint32_t capacity, uint32_t seed);
+	void     SetSimulation(const SIMULATION_DESC& desc);
+	void     AddCollider(const PlaneF& plane);
+	void     AddCollider(const SphereF& sphere);
+	void     ClearColliders(void);
+
+	// Returns the number of particles emitted, less than count when the capacity is reached
+	uint32_t Emit(const EMITTER_DESC& desc, uint32_t count);
+	void     Update(float dt);
+
+	// pOut holds GetCount() vertices, returns the number written
+	uint32_t WriteVertices(Vertex* pOut) const;
+
+	uint32_t GetCount(void) const;
+	uint32_t GetCapacity(void) const;
+
+	const Vector3SoA& GetPositions(void) const;
+	const Vector3SoA& GetVelocities(void) const;
+
+private:
+	Vector3SoA           m_Positions;
+	Vector3SoA           m_Velocities;
+	Vector4SoA           m_Colors;
+	Vector3SoA           m_Life;      // x age, y 1 / lifetime, z size
+	uint32_t             m_Count;
+	uint32_t             m_Seeds[8];  // xorshift state of each lane of the generator
+	SIMULATION_DESC      m_Simulation;
+	std::vector<PlaneF>  m_Planes;
+	std::vector<SphereF> m_Spheres;
+};
+
+#endif // CG_PARTICLES__HPP
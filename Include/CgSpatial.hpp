@@ -0,0 +1,327 @@
+#ifndef CG_SPATIAL__HPP
+#define CG_SPATIAL__HPP
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "CgImporter.hpp"
+#include "CgMath.hpp"
+
+/* Spatial acceleration structures for picking, visibility and proximity queries (defined in Source/Spatial) */
+
+// ---------------------------------------- Mesh BVH ---------------------------------------------
+
+// Bounding volume hierarchy over the triangles of a mesh, built with binned SAH and collapsed into nodes of four
+// children whose boxes are tested together. The hierarchy is static, rebuild it when the vertices change.
+class MeshBvh
+{
+public:
+	enum : uint32_t
+	{
+		MAX_LEAF_TRIANGLES = 4,
+		SIGNATURE          = 0x00485642, // 'BVH'
+		VERSION            = 1
+	};
+
+	// Child boxes as a structure of arrays, unused slots have an inverted box that no query overlaps
+	// child[i] is a node index when count[i] is 0, otherwise the first of count[i] triangles of a leaf
+	struct Node
+	{
+		float    minX[4];
+		float    minY[4];
+		float    minZ[4];
+		float    maxX[4];
+		float    maxY[4];
+		float    maxZ[4];
+		uint32_t child[4];
+		uint32_t count[4];
+	};
+
+	// Triangle in leaf order with the edges of the intersection test, index is the triangle of the source index list
+	struct Triangle
+	{
+		Vector3F v0;
+		Vector3F e1; // v1 - v0
+		Vector3F e2; // v2 - v0
+		uint32_t index;
+	};
+
+	struct Hit
+	{
+		float    distance; // ray parameter t of origin + t * direction
+		float    u;        // barycentric weight of v1
+		float    v;        // barycentric weight of v2
+		uint32_t triangle; // indices[3 * triangle] is the first vertex
+	};
+
+	// Serialized form: the header followed by the nodes and the triangles
+	struct HEADER
+	{
+		uint32_t signature;
+		uint32_t version;
+		uint32_t nodeCount;
+		uint32_t triangleCount;
+		float    bounds[6]; // min, max
+	};
+
+public:
+	MeshBvh(void);
+
+	// The build splits the top of the tree on the calling thread and the subtrees on the Parallel workers
+	bool Build(const Importer::Mesh& mesh);
+	bool Build(const Vector3F* pPositions, uint32_t vertexCount, const uint16_t* pIndices, uint32_t indexCount);
+
+	// Triangles are two sided. Raycast returns the closest hit with t in [0, maxDistance],
+	// IntersectSegment returns true when anything lies between p0 and p1 (line of sight)
+	bool     Raycast(const Vector3F& origin, const Vector3F& direction, float maxDistance, Hit& rHit) const;
+	bool     IntersectSegment(const Vector3F& p0, const Vector3F& p1) const;
+
+	// Appends the source index of every triangle overlapping the box, returns the number appended
+	uint32_t Overlap(const AABBF& box, std::vector<uint32_t>& rTriangles) const;
+
+	const AABBF& GetBounds(void) const;
+	uint32_t     GetNodeCount(void) const;
+	uint32_t     GetTriangleCount(void) const;
+
+	// Baking at import time: Save appends the serialized form to rData, Load replaces the hierarchy with it
+	bool Save(std::vector<uint8_t>& rData) const;
+	bool Load(const uint8_t* pData, size_t size);
+
+private:
+	std::vector<Node>     m_Nodes; // m_Nodes[0] is the root
+	std::vector<Triangle> m_Triangles;
+	AABBF                 m_Bounds;
+};
+
+// --------------------------------------- Loose Octree -------------------------------------------
+
+// Dynamic index over scene objects for culling and proximity queries. The cells of the nodes are expanded by half
+// their size on every side, so an object is stored in the one node whose cell contains its center and whose cell
+// size is at least the size of the object: inserting, moving and removing an object walk one path of the tree and
+// leave the rest of the scene untouched. Objects outside the world bounds are kept in the root.
+class LooseOctree
+{
+public:
+	enum : uint32_t
+	{
+		MAX_DEPTH      = 20,
+		INVALID_HANDLE = 0xFFFFFFFF
+	};
+
+public:
+	LooseOctree(void);
+
+	// Removes all objects, the world bounds are made cubic and the smallest cells are 2^maxDepth times smaller
+	bool Initialize(const AABBF& worldBounds, uint32_t maxDepth);
+
+	// Handles are dense indices (removed handles are reused) that the caller can use to index its own arrays
+	// bounds are in object space, world transforms points like Matrix3x4(world) * <p, 1>
+	uint32_t Insert(const AABBF& bounds, const Matrix4F& world);
+	void     Move(uint32_t handle, const Matrix4F& world);
+	void     Move(const uint32_t* pHandles, const Matrix4F* pWorlds, uint32_t count);
+	void     SetBounds(uint32_t handle, const AABBF& bounds, const Matrix4F& world);
+	void     Remove(uint32_t handle);
+
+	// Append the handles of the objects whose world bounds are not outside the volume, return the number appended
+	uint32_t Query(const FrustumF& frustum, std::vector<uint32_t>& rHandles) const;
+	uint32_t Query(const SphereF& sphere, std::vector<uint32_t>& rHandles) const;
+	uint32_t Query(const AABBF& box, std::vector<uint32_t>& rHandles) const;
+
+	const AABBF& GetWorldBounds(uint32_t handle) const;
+	uint32_t     GetObjectCount(void) const;
+	uint32_t     GetNodeCount(void) const;
+
+private:
+	// The world bounds of the objects of a node are packed for the batched culling of Bounds::Cull
+	struct Node
+	{
+		AABBF                 looseBounds;
+		uint32_t              cell[3];     // cell coordinates at depth
+		uint32_t              depth;
+		uint32_t              parent;
+		uint32_t              children[8]; // 0 when absent, the root is never a child
+		uint32_t              childCount;
+		std::vector<AABBF>    bounds;
+		std::vector<uint32_t> objects;
+	};
+
+	struct Object
+	{
+		AABBF    bounds; // object space
+		uint32_t node;   // INVALID_HANDLE for free handles
+		uint32_t slot;   // index in the arrays of the node, next free handle for free handles
+	};
+
+	uint32_t AllocateNode(uint32_t parent, uint32_t depth, const uint32_t* pCell);
+	void     Link(uint32_t handle, const AABBF& worldBounds);
+	void     Unlink(uint32_t handle);
+
+private:
+	std::vector<Node>     m_Nodes;     // m_Nodes[0] is the root
+	std::vector<uint32_t> m_FreeNodes;
+	std::vector<Object>   m_Objects;
+	uint32_t              m_FreeObject;
+	uint32_t              m_ObjectCount;
+	Vector3F              m_Origin;    // min corner of the world cube
+	float                 m_Size;      // edge of the world cube
+	uint32_t              m_MaxDepth;
+};
+
+// --------------------------------------- Broadphase ---------------------------------------------
+
+// Sort and sweep over the bounds of the bodies of a simulation. The bodies stay sorted by their min along one axis
+// between frames, so the sort is an insertion sort over the few bodies that changed order. The sorted bodies are then
+// split into slabs along a second axis, keeping their order, and each slab is swept on its own, testing the intervals
+// of eight following bodies at once. The axes are the two along which the bodies are spread the most.
+class Broadphase
+{
+public:
+	enum : uint32_t
+	{
+		INVALID_HANDLE = 0xFFFFFFFF
+	};
+
+	struct Pair
+	{
+		uint32_t a; // a < b
+		uint32_t b;
+	};
+
+public:
+	Broadphase(void);
+
+	// Handles are dense indices (removed handles are reused) that the caller can use to index its own arrays
+	uint32_t Add(const AABBF& bounds);
+	void     Remove(uint32_t handle);
+	void     Update(uint32_t handle, const AABBF& bounds);
+	void     Update(const uint32_t* pHandles, const AABBF* pBounds, uint32_t count);
+
+	// Sorts the bodies and appends every overlapping pair once, returns the number appended
+	// The pairs are ordered by the sweep, the sweep is split over the Parallel workers
+	uint32_t FindPairs(std::vector<Pair>& rPairs);
+
+	const AABBF& GetBounds(uint32_t handle) const;
+	uint32_t     GetBodyCount(void) const;
+
+private:
+	struct Entry
+	{
+		float    key;    // min of the bounds along the sweep axis
+		uint32_t handle;
+	};
+
+	// Bodies [begin, end) of a slab, a pair is reported by the slab that contains the larger min of the slab axis
+	struct Range
+	{
+		uint32_t begin;
+		uint32_t end;
+		float    low;
+		float    high;
+	};
+
+	void Sort(void);
+
+private:
+	std::vector<AABBF>             m_Bounds;     // per handle
+	std::vector<uint8_t>           m_Flags;      // per handle
+	std::vector<uint32_t>          m_Free;
+	std::vector<Entry>             m_Order;      // sorted by key, removed bodies are dropped by the next sort
+	std::vector<Entry>             m_Scratch;
+	std::vector<float>             m_Slabs[6];   // min and max of the sweep axis, the slab axis and the last axis, per slab
+	std::vector<uint32_t>          m_SlabHandles;
+	std::vector<Range>             m_Ranges;
+	std::vector<std::vector<Pair>> m_RangePairs; // per range, kept between frames for their capacity
+	uint32_t                       m_Axis;
+	uint32_t                       m_BodyCount;
+	uint32_t                       m_Added;      // entries appended unsorted since the last sort
+	uint32_t                       m_Removed;    // entries of removed bodies in m_Order
+};
+
+// ------------------------------------- Light Clusters -------------------------------------------
+
+// Assignment of point and spot lights to the froxels of a perspective view: the screen is split into tiles and the
+// depth range into slices whose thickness grows with the distance. Every slice is tested on its own (the slices are
+// split over the Parallel workers), eight clusters at a time: the range of a light against the view space box of the
+// cluster, and the cone of a spot light against the bounding sphere of the cluster.
+class LightClusters
+{
+public:
+	enum LIGHT_TYPE : uint32_t
+	{
+		LIGHT_POINT = 0,
+		LIGHT_SPOT  = 1
+	};
+
+	// Tile row 0 is the top of the screen, the slices are exponential between nearDepth and farDepth
+	struct CLUSTER_DESC
+	{
+		uint32_t tilesX;
+		uint32_t tilesY;
+		uint32_t slices;
+		float    nearDepth; // view depth, clip space w
+		float    farDepth;
+	};
+
+	struct Light
+	{
+		Vector3F   position;  // world space
+		float      range;
+		Vector3F   direction; // spot lights, unit length
+		float      angle;     // spot lights, half angle in radians up to pi / 2
+		LIGHT_TYPE type;
+	};
+
+	// Lights of cluster (slice * tilesY + y) * tilesX + x are GetIndices()[offset, offset + count)
+	struct Cluster
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+public:
+	LightClusters(void);
+
+	bool Initialize(const CLUSTER_DESC& desc);
+
+	// view and projection are applied like the view-projection of FrustumF, at most 65535 lights
+	bool Build(const Matrix4F& view, const Matrix4F& projection, const Light* pLights, uint32_t count);
+
+	// The slice of a view depth is floor(log2(depth) * scale + bias), depths outside [nearDepth, farDepth] have no cluster
+	void GetSliceParameters(float& rScale, float& rBias) const;
+
+	const std::vector<Cluster>&  GetClusters(void) const;
+	const std::vector<uint16_t>& GetIndices(void) const;
+	uint32_t                     GetClusterCount(void) const;
+
+private:
+	// View space light, the slices [firstSlice, lastSlice] overlap its range
+	struct ViewLight
+	{
+		Vector3F position;
+		float    range;
+		Vector3F direction;
+		float    cosAngle;
+		float    sinAngle;
+		uint32_t type;
+		uint32_t firstSlice;
+		uint32_t lastSlice;
+	};
+
+	void BuildSlice(uint32_t slice);
+
+private:
+	CLUSTER_DESC                       m_Desc;
+	uint32_t                           m_TileStride;   // tiles of a slice rounded up to 8
+	std::vector<Vector3F>              m_Rays;         // point and direction of the (tilesX + 1) * (tilesY + 1) tile corners
+	Vector4F                           m_DepthRow;     // clip space w of a view space point
+	std::vector<float>                 m_Bounds[10];   // box min, max, sphere center and radius, m_TileStride per slice
+	std::vector<ViewLight>             m_Lights;
+	std::vector<std::vector<uint32_t>> m_SliceLights;  // per slice, the lights overlapping it
+	std::vector<std::vector<uint32_t>> m_SliceMasks;   // per slice, a bit per light for every tile
+	std::vector<std::vector<uint16_t>> m_SliceIndices; // per slice
+	std::vector<Cluster>               m_Clusters;
+	std::vector<uint16_t>              m_Indices;
+};
+
+#endif // CG_SPATIAL__HPP
@@ -1,6 +1,7 @@
 #ifndef MDL_HPP
 #define MDL_HPP
 
+#include <stddef.h>
 #include <stdint.h>
 
 /*
@@ -19,6 +20,7 @@
 * |-----------------|-----------------------------|
 * |    UInt32       |   End of File 'EOF'         |
 * |_________________|_____________________________|
+* * Note: Version 2 files have a table of contents between the header and the first block.
 *
 * _________________________________________________
 * |                MDL Header Format              |
@@ -31,7 +33,42 @@
 * |-----------------|-----------------------------|
 * |    Uint32[6]    |  Reserved                   |
 * |_________________|_____________________________|
-* 
+*
+* _________________________________________________
+* |          MDL Table of Contents (v2)           |
+* |-----------------------------------------------|
+* |    Type         |  Description                |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Signature 'TOC'            |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Block count                |
+* |-----------------|-----------------------------|
+* |    Uint32[2]    |  Reserved                   |
+* |-----------------|-----------------------------|
+* |    TOC_Entry[]  |  One entry per block        |
+* |_________________|_____________________________|
+*
+* _________________________________________________
+* |             MDL TOC Entry Format (v2)         |
+* |-----------------------------------------------|
+* |    Type         |  Description                |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Block type                 |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Name hash                  |
+* |-----------------|-----------------------------|
+* |    Uint64       |  Offset                     |
+* |-----------------|-----------------------------|
+* |    Uint64       |  Size                       |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Checksum                   |
+* |-----------------|-----------------------------|
+* |    Uint32       |  Reserved                   |
+* |_________________|_____________________________|
+* * Note: The offset is the position of the 'BLK' signature in the file and the block runs to the end of its 'END'.
+*         The checksum is MdlChecksum of the bytes of the block. Each mesh has its own block, the name hash of a mesh
+*         block is MdlNameHash of the mesh name (0 for the other blocks).
+*
 * _________________________________________________
 * |                MDL String Format              |
 * |-----------------------------------------------|
@@ -250,9 +287,16 @@ enum
 	MDL_MESH    = 0x4853454D, // 'MESH'
 	MDL_INDEX   = 0x58444E49, // 'INDX'
 	MDL_TEXTURE = 0x54584554, // 'TEXT'
+	MDL_TOC     = 0x00434F54, // 'TOC'
 	MDL_END     = 0x00444E45  // 'END'
 };
 
+enum
+{
+	MDL_VERSION_1 = 1,
+	MDL_VERSION_2 = 2  // table of contents, one block per mesh
+};
+
 struct MDL_HEADER
 {
 	uint32_t signature;
@@ -300,4 +344,25 @@ struct MDL_MATRIX_DATA
 	float    elements[16];
 };
 
+struct MDL_TOC_HEADER
+{
+	uint32_t signature;
+	uint32_t count;
+	uint32_t reserved[2];
+};
+
+struct MDL_TOC_ENTRY
+{
+	uint32_t type;
+	uint32_t name_hash;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t checksum;
+	uint32_t reserved;
+};
+
+// CRC-32C of the bytes of a block and FNV-1a of a mesh name without its terminator (defined in CImporter.cpp)
+uint32_t MdlChecksum(const void* pData, size_t size);
+uint32_t MdlNameHash(const char* pName);
+
 #endif // MDL_HPP
\ No newline at end of file
@@ -0,0 +1,1213 @@
+// Regression tests for LibCG, each test returns false and prints the failed check on an error
+// Usage: LibTests [<text>], only runs the tests whose name contains <text>
+
+#include <Cg.hpp>
+#include <CgExporter.hpp>
+#include <CgImporter.hpp>
+#include <CgMath.hpp>
+#include <CgParticles.hpp>
+#include <CgSpatial.hpp>
+#include <MdlFormat.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <cwchar>
+#include <random>
+#include <vector>
+
+#define CHECK(x) if (!(x)) { Console::Write(L"  %hs:%d: CHECK(%hs) failed\n", __FILE__, __LINE__, #x); return false; }
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+// Empty bounds, like a default AABBF, overlap nothing
+static bool Overlaps(const AABBF& a, const AABBF& b)
+{
+	for (uint32_t k = 0; k < 3; k++)
+	{
+		if ((a.min[k] > a.max[k]) || (b.min[k] > b.max[k])) { return false; }
+		if ((a.min[k] > b.max[k]) || (b.min[k] > a.max[k])) { return false; }
+	}
+	return true;
+}
+
+// Every pair once, in any order, and the same pairs as the brute force test
+static bool CheckPairs(const Broadphase& broadphase, const std::vector<uint32_t>& handles, const std::vector<Broadphase::Pair>& pairs)
+{
+	std::vector<uint8_t> found(handles.size() * handles.size(), 0);
+	for (const Broadphase::Pair& p : pairs)
+	{
+		CHECK((p.a < p.b) && (p.b < handles.size()));
+		CHECK(found[p.a * handles.size() + p.b] == 0);
+		found[p.a * handles.size() + p.b] = 1;
+	}
+
+	for (uint32_t a = 0; a < handles.size(); a++)
+	{
+		for (uint32_t b = a + 1; b < handles.size(); b++)
+		{
+			const bool overlap = Overlaps(broadphase.GetBounds(handles[a]), broadphase.GetBounds(handles[b]));
+			CHECK(overlap == (found[a * handles.size() + b] != 0));
+		}
+	}
+
+	return true;
+}
+
+// Brute force ray test of one triangle, Moller-Trumbore with both sides, true for a hit with t in [0, maxDistance]
+static bool RayTriangle(const Vector3F* pV, const Vector3F& origin, const Vector3F& direction, float maxDistance, float& rT)
+{
+	const Vector3F e1  = pV[1] - pV[0];
+	const Vector3F e2  = pV[2] - pV[0];
+	const Vector3F p   = Vector::Cross(direction, e2);
+	const float    det = Vector::Dot(e1, p);
+	if (det == 0.0f) { return false; }
+
+	const Vector3F s = origin - pV[0];
+	const Vector3F q = Vector::Cross(s, e1);
+	const float    u = Vector::Dot(s, p) / det;
+	const float    v = Vector::Dot(direction, q) / det;
+	rT = Vector::Dot(e2, q) / det;
+
+	return (u >= 0.0f) && (v >= 0.0f) && (u + v <= 1.0f) && (rT >= 0.0f) && (rT <= maxDistance);
+}
+
+// Brute force box test of one triangle: the 13 separating axes of the box faces, the triangle normal and the cross
+// products of the edges with the box axes
+static bool BoxTriangle(const AABBF& box, const Vector3F* pV)
+{
+	const Vector3F edges[3] = { pV[1] - pV[0], pV[2] - pV[1], pV[0] - pV[2] };
+	const Vector3F units[3] = { Vector3F(1, 0, 0), Vector3F(0, 1, 0), Vector3F(0, 0, 1) };
+
+	Vector3F axes[13] = { units[0], units[1], units[2], Vector::Cross(edges[0], edges[1]) };
+	for (uint32_t i = 0; i < 9; i++) { axes[4 + i] = Vector::Cross(units[i / 3], edges[i % 3]); }
+
+	for (const Vector3F& a : axes)
+	{
+		float triMin = INF, triMax = -INF;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			triMin = std::min(triMin, Vector::Dot(a, pV[i]));
+			triMax = std::max(triMax, Vector::Dot(a, pV[i]));
+		}
+
+		const float center = Vector::Dot(a, box.GetCenter());
+		const Vector3F h = box.GetExtents();
+		const float radius = h.x * std::fabs(a.x) + h.y * std::fabs(a.y) + h.z * std::fabs(a.z);
+		if ((triMin > center + radius) || (triMax < center - radius)) { return false; }
+	}
+
+	return true;
+}
+
+// Left handed perspective with w = view z, 90 degrees both ways
+static Matrix4F CreatePerspective(float n, float f)
+{
+	Matrix4F projection(1.0f);
+	projection[2][2] = f / (f - n);
+	projection[2][3] = 1.0f;
+	projection[3][2] = -n * f / (f - n);
+	projection[3][3] = 0.0f;
+	return projection;
+}
+
+// A small model, the mesh names are distinct so that the meshes can be found after a read
+static Importer::MDL_DATA CreateModel(void)
+{
+	Importer::MDL_DATA data;
+
+	Importer::Node node = {};
+	node.name = "root";
+	node.matrix[0] = node.matrix[5] = node.matrix[10] = node.matrix[15] = 1.0f;
+	data.nodes.push_back(node);
+
+	for (uint32_t m = 0; m < 2; m++)
+	{
+		Importer::Mesh mesh;
+		mesh.name = (m == 0) ? "first" : "second";
+
+		for (uint32_t i = 0; i < 3 + m; i++)
+		{
+			Importer::Vertex v = {};
+			v.position[0] = static_cast<float>(i);
+			v.position[1] = static_cast<float>(m);
+			v.uv[0] = 0.25f * i;
+			mesh.vertices.push_back(v);
+		}
+		mesh.indices = { 0, 1, 2 };
+
+		data.meshes.push_back(mesh);
+	}
+
+	return data;
+}
+
+static bool LoadBytes(const wchar_t* pPath, std::vector<uint8_t>& rBytes)
+{
+	File* pFile = File::Open(pPath);
+	CHECK(pFile != nullptr);
+	rBytes.resize(static_cast<size_t>(pFile->GetSize()));
+	const bool read = pFile->ReadBytes(rBytes.data(), static_cast<uint32_t>(rBytes.size()));
+	File::Close(pFile);
+	CHECK(read);
+	return true;
+}
+
+static bool SaveBytes(const wchar_t* pPath, const std::vector<uint8_t>& bytes)
+{
+	File* pFile = File::Open(pPath, File::WRITE);
+	CHECK(pFile != nullptr);
+	const bool written = pFile->WriteBytes(bytes.data(), static_cast<uint32_t>(bytes.size()));
+	File::Close(pFile);
+	CHECK(written);
+	return true;
+}
+
+// Table of contents entry i of a version 2 file
+static MDL_TOC_ENTRY GetTocEntry(const std::vector<uint8_t>& bytes, uint32_t i)
+{
+	MDL_TOC_ENTRY entry = {};
+	memcpy(&entry, bytes.data() + sizeof(MDL_HEADER) + sizeof(MDL_TOC_HEADER) + i * sizeof(MDL_TOC_ENTRY), sizeof(MDL_TOC_ENTRY));
+	return entry;
+}
+
+static bool SameMesh(const Importer::Mesh& a, const Importer::Mesh& b)
+{
+	// the names read from the file keep their terminator
+	CHECK(strcmp(a.name.c_str(), b.name.c_str()) == 0);
+	CHECK(a.indices == b.indices);
+	CHECK(a.vertices.size() == b.vertices.size());
+	CHECK((a.vertices.size() == 0) || (memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Importer::Vertex)) == 0));
+	return true;
+}
+
+// ------------------------------------------ Tests -----------------------------------------------
+
+static bool TestBroadphaseUnbounded(void)
+{
+	Broadphase broadphase;
+	std::vector<uint32_t> handles;
+
+	handles.push_back(broadphase.Add(AABBF(Vector3F(0, 0, 0), Vector3F(1, 1, 1))));
+	handles.push_back(broadphase.Add(AABBF(Vector3F(0.5f, 0.5f, 0.5f), Vector3F(2, 2, 2))));
+	handles.push_back(broadphase.Add(AABBF(Vector3F(5, 5, 5), Vector3F(6, 6, 6))));
+	handles.push_back(broadphase.Add(AABBF()));                                                      // empty, min = INF
+	handles.push_back(broadphase.Add(AABBF(Vector3F(-INF, -INF, -INF), Vector3F(INF, INF, INF)))); // unbounded
+
+	std::vector<Broadphase::Pair> pairs;
+	broadphase.FindPairs(pairs);
+	CHECK(CheckPairs(broadphase, handles, pairs));
+
+	return true;
+}
+
+static bool TestBroadphaseHuge(void)
+{
+	Broadphase broadphase;
+	std::vector<uint32_t> handles;
+
+	// enough bodies for several slabs, the huge bodies reach past the outer slab bounds
+	for (uint32_t i = 0; i < 4096; i++)
+	{
+		const Vector3F p(static_cast<float>(i % 64) * 1.5f, static_cast<float>(i / 64) * 1.5f, static_cast<float>(i % 7));
+		handles.push_back(broadphase.Add(AABBF(p, p + Vector3F(1, 1, 1))));
+	}
+	handles.push_back(broadphase.Add(AABBF(Vector3F(-1.0e30f, 10, 0), Vector3F(1.0e30f, 11, 1))));
+	handles.push_back(broadphase.Add(AABBF(Vector3F(10, -1.0e30f, 0), Vector3F(11, 1.0e30f, 1))));
+
+	std::vector<Broadphase::Pair> pairs;
+	broadphase.FindPairs(pairs);
+	CHECK(CheckPairs(broadphase, handles, pairs));
+
+	// the unbounded body has to go in every slab
+	handles.push_back(broadphase.Add(AABBF(Vector3F(-INF, -INF, -INF), Vector3F(INF, INF, INF))));
+
+	pairs.clear();
+	broadphase.FindPairs(pairs);
+	CHECK(CheckPairs(broadphase, handles, pairs));
+
+	return true;
+}
+
+static bool TestBroadphaseBruteForce(void)
+{
+	std::mt19937 rng(17);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	auto randomBounds = [&]()
+	{
+		const Vector3F c(u(rng) * 50.0f, u(rng) * 20.0f, u(rng) * 5.0f);
+		const float size = (rng() % 16 == 0) ? 15.0f : 1.5f;
+		const Vector3F h(std::fabs(u(rng)) * size, std::fabs(u(rng)) * size, std::fabs(u(rng)) * size);
+		return AABBF(c - h, c + h);
+	};
+
+	// the reference: the bounds of the live handles, every pair tested
+	Broadphase broadphase;
+	std::vector<AABBF> bounds;
+	std::vector<uint8_t> live;
+	auto add = [&]()
+	{
+		const AABBF b = randomBounds();
+		const uint32_t handle = broadphase.Add(b);
+		if (handle >= bounds.size()) { bounds.resize(handle + 1); live.resize(handle + 1, 0); }
+		bounds[handle] = b;
+		live[handle] = 1;
+	};
+
+	for (uint32_t i = 0; i < 3000; i++) { add(); }
+
+	for (uint32_t frame = 0; frame < 6; frame++)
+	{
+		std::vector<Broadphase::Pair> pairs;
+		CHECK(broadphase.FindPairs(pairs) == pairs.size());
+
+		const size_t n = bounds.size();
+		std::vector<uint8_t> found(n * n, 0);
+		for (const Broadphase::Pair& p : pairs)
+		{
+			CHECK((p.a < p.b) && (p.b < n) && live[p.a] && live[p.b]);
+			CHECK(found[p.a * n + p.b] == 0);
+			found[p.a * n + p.b] = 1;
+		}
+
+		uint32_t expected = 0;
+		for (uint32_t a = 0; a < n; a++)
+		{
+			for (uint32_t b = a + 1; live[a] && (b < n); b++)
+			{
+				const bool overlap = live[b] && Overlaps(bounds[a], bounds[b]);
+				CHECK(overlap == (found[a * n + b] != 0));
+				expected += overlap ? 1 : 0;
+			}
+		}
+		CHECK((expected > 0) && (expected == pairs.size()));
+
+		// small moves keep most of the order, some bodies jump, are removed or added
+		std::vector<uint32_t> handles;
+		std::vector<AABBF> updates;
+		for (uint32_t h = 0; h < n; h++)
+		{
+			if (!live[h]) { continue; }
+
+			const uint32_t action = rng() % 16;
+			if (action == 0)
+			{
+				broadphase.Remove(h);
+				live[h] = 0;
+			}
+			else if (action == 1)
+			{
+				bounds[h] = randomBounds();
+				broadphase.Update(h, bounds[h]);
+			}
+			else if (action < 10)
+			{
+				const Vector3F d(u(rng) * 0.5f, u(rng) * 0.5f, u(rng) * 0.5f);
+				bounds[h] = AABBF(bounds[h].min + d, bounds[h].max + d);
+				handles.push_back(h);
+				updates.push_back(bounds[h]);
+			}
+		}
+		broadphase.Update(handles.data(), updates.data(), static_cast<uint32_t>(handles.size()));
+
+		for (uint32_t i = 0; i < 100; i++) { add(); }
+	}
+
+	return true;
+}
+
+static bool TestBvhSharedNode(void)
+{
+	// a grid of quads, saved and loaded back
+	std::vector<Vector3F> positions;
+	std::vector<uint16_t> indices;
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		const float x = static_cast<float>(i % 8);
+		const float y = static_cast<float>(i / 8);
+		const uint16_t first = static_cast<uint16_t>(positions.size());
+
+		positions.push_back(Vector3F(x, y, 0));
+		positions.push_back(Vector3F(x + 1, y, 0));
+		positions.push_back(Vector3F(x, y + 1, 0));
+		indices.insert(indices.end(), { first, static_cast<uint16_t>(first + 1), static_cast<uint16_t>(first + 2) });
+	}
+
+	MeshBvh bvh;
+	CHECK(bvh.Build(positions.data(), static_cast<uint32_t>(positions.size()), indices.data(), static_cast<uint32_t>(indices.size())));
+
+	std::vector<uint8_t> data;
+	CHECK(bvh.Save(data));
+
+	MeshBvh loaded;
+	CHECK(loaded.Load(data.data(), data.size()));
+	CHECK(loaded.GetNodeCount() == bvh.GetNodeCount());
+
+	// node 2 is a child of both node 0 and node 1, its depth depends on the path
+	MeshBvh::HEADER header = { MeshBvh::SIGNATURE, MeshBvh::VERSION, 3, 0, { 0, 0, 0, 1, 1, 1 } };
+	MeshBvh::Node nodes[3] = {};
+	for (MeshBvh::Node& node : nodes)
+	{
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			node.minX[k] = node.minY[k] = node.minZ[k] = INF;
+			node.maxX[k] = node.maxY[k] = node.maxZ[k] = -INF;
+		}
+	}
+
+	auto link = [&](uint32_t parent, uint32_t slot, uint32_t child)
+	{
+		MeshBvh::Node& node = nodes[parent];
+		node.minX[slot] = node.minY[slot] = node.minZ[slot] = 0.0f;
+		node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = 1.0f;
+		node.child[slot] = child;
+	};
+	link(0, 0, 1);
+	link(0, 1, 2);
+	link(1, 0, 2);
+
+	data.resize(sizeof(header) + sizeof(nodes));
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), nodes, sizeof(nodes));
+
+	CHECK(!loaded.Load(data.data(), data.size()));
+	CHECK(loaded.GetNodeCount() == bvh.GetNodeCount());
+
+	return true;
+}
+
+static bool TestBvhBruteForce(void)
+{
+	// a soup of small random triangles, large enough for several levels
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	std::vector<Vector3F> positions;
+	std::vector<uint16_t> indices;
+	for (uint32_t i = 0; i < 2000; i++)
+	{
+		const Vector3F c(u(rng) * 10.0f, u(rng) * 10.0f, u(rng) * 10.0f);
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			indices.push_back(static_cast<uint16_t>(positions.size()));
+			positions.push_back(c + Vector3F(u(rng), u(rng), u(rng)));
+		}
+	}
+
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	auto getTriangle = [&](uint32_t t, Vector3F* pV) { for (uint32_t k = 0; k < 3; k++) { pV[k] = positions[indices[3 * t + k]]; } };
+
+	MeshBvh bvh;
+	CHECK(bvh.Build(positions.data(), static_cast<uint32_t>(positions.size()), indices.data(), static_cast<uint32_t>(indices.size())));
+	CHECK(bvh.GetTriangleCount() == triangleCount);
+
+	uint32_t hits = 0;
+	for (uint32_t r = 0; r < 500; r++)
+	{
+		const Vector3F origin(u(rng) * 15.0f, u(rng) * 15.0f, u(rng) * 15.0f);
+		const Vector3F target(u(rng) * 10.0f, u(rng) * 10.0f, u(rng) * 10.0f);
+		const Vector3F direction = Vector::Normalize(target - origin);
+		const float maxDistance = (r % 2 == 0) ? INF : 10.0f;
+
+		float closest = INF;
+		uint32_t closestTriangle = 0;
+		bool segmentHit = false;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			Vector3F v[3];
+			getTriangle(t, v);
+
+			float distance = 0.0f;
+			if (RayTriangle(v, origin, direction, maxDistance, distance) && (distance < closest))
+			{
+				closest = distance;
+				closestTriangle = t;
+			}
+			segmentHit = segmentHit || RayTriangle(v, origin, target - origin, 1.0f, distance);
+		}
+
+		// the triangle may differ only when two hits are as close
+		MeshBvh::Hit hit = {};
+		const bool bvhHit = bvh.Raycast(origin, direction, maxDistance, hit);
+		CHECK(bvhHit == (closest < INF));
+		hits += bvhHit ? 1 : 0;
+		CHECK(!bvhHit || (std::fabs(hit.distance - closest) <= 1e-4f * (1.0f + closest)));
+		CHECK(!bvhHit || (hit.triangle == closestTriangle) || (std::fabs(hit.distance - closest) <= 1e-4f));
+
+		CHECK(bvh.IntersectSegment(origin, target) == segmentHit);
+	}
+	CHECK((hits > 50) && (hits < 450));
+
+	uint32_t overlaps = 0;
+	for (uint32_t b = 0; b < 200; b++)
+	{
+		const Vector3F c(u(rng) * 12.0f, u(rng) * 12.0f, u(rng) * 12.0f);
+		const Vector3F h(std::fabs(u(rng)) * 3.0f, std::fabs(u(rng)) * 3.0f, std::fabs(u(rng)) * 3.0f);
+		const AABBF box(c - h, c + h);
+
+		std::vector<uint32_t> expected;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			Vector3F v[3];
+			getTriangle(t, v);
+			if (BoxTriangle(box, v)) { expected.push_back(t); }
+		}
+
+		std::vector<uint32_t> found;
+		CHECK(bvh.Overlap(box, found) == found.size());
+		std::sort(found.begin(), found.end());
+		CHECK(found == expected);
+		overlaps += static_cast<uint32_t>(found.size());
+	}
+	CHECK(overlaps > 200);
+
+	return true;
+}
+
+static bool TestOctreeBruteForce(void)
+{
+	std::mt19937 rng(16);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	auto randomWorld = [&]()
+	{
+		const Vector3F t(u(rng) * 120.0f, u(rng) * 120.0f, u(rng) * 120.0f); // some outside the world bounds
+		return Matrix::Translate(t) * Matrix4F(Quaternion<float>(u(rng) * 3.0f, u(rng) * 3.0f, u(rng) * 3.0f));
+	};
+	auto randomBounds = [&]()
+	{
+		const float size = (rng() % 8 == 0) ? 30.0f : 2.0f;
+		const Vector3F h(std::fabs(u(rng)) * size + 0.01f, std::fabs(u(rng)) * size + 0.01f, std::fabs(u(rng)) * size + 0.01f);
+		return AABBF(-h, h);
+	};
+
+	LooseOctree octree;
+	CHECK(octree.Initialize(AABBF(Vector3F(-100, -100, -100), Vector3F(100, 100, 100)), 6));
+
+	// the reference: the bounds of every live handle, scanned linearly
+	std::vector<AABBF> localBounds;
+	std::vector<AABBF> worldBounds;
+	std::vector<uint8_t> live;
+	auto insert = [&]()
+	{
+		const AABBF bounds = randomBounds();
+		const Matrix4F world = randomWorld();
+		const uint32_t handle = octree.Insert(bounds, world);
+		if (handle >= worldBounds.size()) { localBounds.resize(handle + 1); worldBounds.resize(handle + 1); live.resize(handle + 1, 0); }
+		localBounds[handle] = bounds;
+		worldBounds[handle] = Bounds::Transform(bounds, world);
+		live[handle] = 1;
+	};
+
+	for (uint32_t i = 0; i < 1000; i++) { insert(); }
+
+	// moves one at a time and in batches, new bounds, removals and inserts that reuse the handles
+	for (uint32_t round = 0; round < 4; round++)
+	{
+		std::vector<uint32_t> handles;
+		std::vector<Matrix4F> worlds;
+		for (uint32_t h = 0; h < worldBounds.size(); h++)
+		{
+			if (!live[h]) { continue; }
+
+			const uint32_t action = rng() % 8;
+			if (action == 0)
+			{
+				octree.Remove(h);
+				live[h] = 0;
+			}
+			else if (action == 1)
+			{
+				localBounds[h] = randomBounds();
+				const Matrix4F world = randomWorld();
+				octree.SetBounds(h, localBounds[h], world);
+				worldBounds[h] = Bounds::Transform(localBounds[h], world);
+			}
+			else if (action == 2)
+			{
+				const Matrix4F world = randomWorld();
+				octree.Move(h, world);
+				worldBounds[h] = Bounds::Transform(localBounds[h], world);
+			}
+			else if (action == 3)
+			{
+				handles.push_back(h);
+				worlds.push_back(randomWorld());
+				worldBounds[h] = Bounds::Transform(localBounds[h], worlds.back());
+			}
+		}
+		octree.Move(handles.data(), worlds.data(), static_cast<uint32_t>(handles.size()));
+
+		for (uint32_t i = 0; i < 100; i++) { insert(); }
+	}
+
+	uint32_t liveCount = 0;
+	for (uint32_t h = 0; h < worldBounds.size(); h++)
+	{
+		if (!live[h]) { continue; }
+		CHECK(octree.GetWorldBounds(h).min == worldBounds[h].min);
+		CHECK(octree.GetWorldBounds(h).max == worldBounds[h].max);
+		liveCount++;
+	}
+	CHECK(octree.GetObjectCount() == liveCount);
+
+	auto compare = [&](std::vector<uint32_t>& rFound, auto inside)
+	{
+		std::vector<uint32_t> expected;
+		for (uint32_t h = 0; h < worldBounds.size(); h++)
+		{
+			if (live[h] && inside(worldBounds[h])) { expected.push_back(h); }
+		}
+
+		std::sort(rFound.begin(), rFound.end());
+		CHECK(rFound == expected);
+		return true;
+	};
+
+	uint32_t found = 0;
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		const Vector3F c(u(rng) * 110.0f, u(rng) * 110.0f, u(rng) * 110.0f);
+		const Vector3F h(std::fabs(u(rng)) * 40.0f, std::fabs(u(rng)) * 40.0f, std::fabs(u(rng)) * 40.0f);
+		const AABBF box(c - h, c + h);
+
+		std::vector<uint32_t> handles;
+		CHECK(octree.Query(box, handles) == handles.size());
+		CHECK(compare(handles, [&](const AABBF& b) { return Overlaps(box, b); }));
+		found += static_cast<uint32_t>(handles.size());
+
+		const SphereF sphere(c, h.x);
+		handles.clear();
+		CHECK(octree.Query(sphere, handles) == handles.size());
+		CHECK(compare(handles, [&](const AABBF& b)
+		{
+			float d = 0.0f;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const float e = std::max(std::max(b.min[k] - sphere.center[k], sphere.center[k] - b.max[k]), 0.0f);
+				d += e * e;
+			}
+			return d <= sphere.radius * sphere.radius;
+		}));
+		found += static_cast<uint32_t>(handles.size());
+
+		// left handed perspective with w = view z, looking from c in a random direction
+		const float n = 1.0f;
+		const float f = 150.0f;
+		Matrix4F projection(1.0f);
+		projection[2][2] = f / (f - n);
+		projection[2][3] = 1.0f;
+		projection[3][2] = -n * f / (f - n);
+		projection[3][3] = 0.0f;
+
+		const Matrix4F view = Matrix::InverseRigid(Matrix::Translate(c) * Matrix4F(Quaternion<float>(u(rng) * 3.0f, u(rng) * 3.0f, u(rng) * 3.0f)));
+		const FrustumF frustum(projection * view);
+		handles.clear();
+		CHECK(octree.Query(frustum, handles) == handles.size());
+		CHECK(compare(handles, [&](const AABBF& b) { return Bounds::Classify(frustum, b) != INTERSECTION_OUTSIDE; }));
+		found += static_cast<uint32_t>(handles.size());
+	}
+	CHECK((found > 0) && (found < 150 * liveCount));
+
+	return true;
+}
+
+static bool TestLightClustersUnbounded(void)
+{
+	// 3 x 3 tiles leave padding lanes in the last group of 8, a light of unbounded range touches every cluster
+	LightClusters clusters;
+	CHECK(clusters.Initialize(LightClusters::CLUSTER_DESC{ 3, 3, 4, 1.0f, 100.0f }));
+
+	const Matrix4F projection = CreatePerspective(1.0f, 100.0f);
+
+	const float ranges[2] = { INF, 1.0e30f };
+	for (float range : ranges)
+	{
+		const LightClusters::Light light = { Vector3F(0, 0, 10), range, Vector3F(0, 0, 1), 0.0f, LightClusters::LIGHT_POINT };
+		CHECK(clusters.Build(Matrix4F(1.0f), projection, &light, 1));
+
+		for (const LightClusters::Cluster& cluster : clusters.GetClusters())
+		{
+			CHECK(cluster.count == 1);
+			CHECK(clusters.GetIndices()[cluster.offset] == 0);
+		}
+	}
+
+	return true;
+}
+
+static bool TestLightClustersBruteForce(void)
+{
+	std::mt19937 rng(20);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	// 15 x 9 tiles leave padding lanes, the lights are made in view space and moved to the world
+	const LightClusters::CLUSTER_DESC desc = { 15, 9, 16, 0.5f, 200.0f };
+	LightClusters clusters;
+	CHECK(clusters.Initialize(desc));
+
+	const Matrix4F view = Matrix::Translate(Vector3F(3.0f, -2.0f, 5.0f)) * Matrix4F(Quaternion<float>(0.3f, -0.7f, 0.2f));
+	const Matrix4F inverse = Matrix::Inverse(view);
+	const Matrix4F projection = CreatePerspective(desc.nearDepth, desc.farDepth);
+
+	// applied like the view-projection of FrustumF
+	auto apply = [](const Matrix4F& m, const Vector3F& v, float w)
+	{
+		const Vector4F r = m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * w;
+		return Vector3F(r.x, r.y, r.z);
+	};
+
+	std::vector<LightClusters::Light> lights(300);
+	std::vector<LightClusters::Light> viewLights(lights.size());
+	for (uint32_t i = 0; i < lights.size(); i++)
+	{
+		const float z = std::fabs(u(rng)) * 220.0f - 10.0f;
+		LightClusters::Light& rView = viewLights[i];
+		rView.position  = Vector3F(u(rng) * (std::fabs(z) + 5.0f), u(rng) * (std::fabs(z) + 5.0f), z);
+		rView.range     = 1.0f + std::fabs(u(rng)) * 20.0f;
+		rView.direction = Vector::Normalize(Vector3F(u(rng), u(rng), u(rng)));
+		rView.angle     = 0.05f + std::fabs(u(rng)) * 1.5f;
+		rView.type      = (i % 2 == 0) ? LightClusters::LIGHT_POINT : LightClusters::LIGHT_SPOT;
+
+		lights[i] = rView;
+		lights[i].position = apply(inverse, rView.position, 1.0f);
+		lights[i].direction = Vector::Normalize(apply(inverse, rView.direction, 0.0f));
+	}
+
+	CHECK(clusters.Build(view, projection, lights.data(), static_cast<uint32_t>(lights.size())));
+	CHECK(clusters.GetClusterCount() == desc.tilesX * desc.tilesY * desc.slices);
+
+	// > 0 outside, < 0 inside, the lights within the tolerance of a cluster are not checked
+	auto getMargin = [](const LightClusters::Light& light, const AABBF& box)
+	{
+		float d2 = 0.0f;
+		for (uint32_t a = 0; a < 3; a++)
+		{
+			const float d = std::fmax(std::fmax(box.min[a] - light.position[a], light.position[a] - box.max[a]), 0.0f);
+			d2 += d * d;
+		}
+		float margin = std::sqrt(d2) - light.range;
+
+		if (light.type == LightClusters::LIGHT_SPOT)
+		{
+			// bounding sphere of the box against the cone
+			const Vector3F v = box.GetCenter() - light.position;
+			const float r = Vector::Length(box.GetExtents());
+			const float along = Vector::Dot(v, light.direction);
+			const float across = std::sqrt(std::fmax(Vector::Dot(v, v) - along * along, 0.0f));
+			const float distance = std::cos(light.angle) * across - std::sin(light.angle) * along;
+			margin = std::fmax(margin, std::fmax(distance - r, std::fmax(along - r - light.range, -r - along)));
+		}
+
+		return margin;
+	};
+
+	const float step = std::log2(desc.farDepth / desc.nearDepth) / static_cast<float>(desc.slices);
+	uint32_t touched = 0;
+	uint32_t missed = 0;
+	for (uint32_t s = 0; s < desc.slices; s++)
+	{
+		const float depths[2] = { desc.nearDepth * std::exp2(step * s), desc.nearDepth * std::exp2(step * (s + 1)) };
+
+		for (uint32_t y = 0; y < desc.tilesY; y++)
+		{
+			for (uint32_t x = 0; x < desc.tilesX; x++)
+			{
+				// the view space points of the tile corners at the depths of the slice
+				AABBF box;
+				for (uint32_t c = 0; c < 8; c++)
+				{
+					const float ndcX = -1.0f + 2.0f * static_cast<float>(x + (c & 1)) / static_cast<float>(desc.tilesX);
+					const float ndcY = 1.0f - 2.0f * static_cast<float>(y + ((c >> 1) & 1)) / static_cast<float>(desc.tilesY);
+					const float depth = depths[c >> 2];
+					box.Merge(Vector3F(ndcX * depth, ndcY * depth, depth));
+				}
+
+				const LightClusters::Cluster& cluster = clusters.GetClusters()[(s * desc.tilesY + y) * desc.tilesX + x];
+				const uint16_t* pIndices = clusters.GetIndices().data() + cluster.offset;
+				CHECK(cluster.offset + cluster.count <= clusters.GetIndices().size());
+				CHECK(std::adjacent_find(pIndices, pIndices + cluster.count, std::greater_equal<uint16_t>()) == pIndices + cluster.count);
+
+				for (uint32_t l = 0; l < lights.size(); l++)
+				{
+					const float margin = getMargin(viewLights[l], box);
+					const bool found = std::binary_search(pIndices, pIndices + cluster.count, static_cast<uint16_t>(l));
+
+					if (std::fabs(margin) > 1.0e-3f * (1.0f + Vector::Length(viewLights[l].position)))
+					{
+						CHECK(found == (margin < 0.0f));
+					}
+					touched += found ? 1 : 0;
+					missed += found ? 0 : 1;
+				}
+			}
+		}
+	}
+	CHECK((touched > 1000) && (missed > touched));
+
+	return true;
+}
+
+static bool TestParticlesScalarStep(void)
+{
+	// the reference steps a copy of the particles one at a time and removes the dead ones in the same order, the
+	// lifetimes have no jitter so that the size of a particle tells its lifetime, small emissions of different
+	// lifetimes leave dead particles at the end of the streams when others die
+	struct Particle { Vector3F p; Vector3F v; float age; float invLife; float size; };
+
+	ParticleSystem particles;
+	CHECK(particles.Initialize(20000, 19));
+
+	const ParticleSystem::SIMULATION_DESC simulation = { Vector3F(0.0f, -9.8f, 0.0f), 0.5f, 0.5f };
+	const PlaneF ground(Vector3F(0.0f, 1.0f, 0.0f), 0.0f);
+	const SphereF sphere(Vector3F(1.0f, 1.0f, 0.0f), 1.5f);
+	particles.SetSimulation(simulation);
+	particles.AddCollider(ground);
+	particles.AddCollider(sphere);
+
+	std::vector<Particle> reference;
+	auto emit = [&](float lifetime, float size, uint32_t count)
+	{
+		ParticleSystem::EMITTER_DESC desc = {};
+		desc.position       = Vector3F(0.0f, 2.0f, 0.0f);
+		desc.extents        = Vector3F(2.0f, 1.5f, 2.0f);
+		desc.velocity       = Vector3F(0.0f, -3.0f, 0.0f);
+		desc.velocityJitter = Vector3F(2.0f, 2.0f, 2.0f);
+		desc.color          = Vector4F(1.0f, 1.0f, 1.0f, 1.0f);
+		desc.lifetime       = lifetime;
+		desc.size           = size;
+
+		const uint32_t first = particles.GetCount();
+		if (particles.Emit(desc, count) != count) { return false; }
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			reference.push_back({ particles.GetPositions().Get(i), particles.GetVelocities().Get(i), 0.0f, 1.0f / lifetime, size });
+		}
+		return true;
+	};
+
+	auto step = [&](Particle& r, float dt)
+	{
+		const float damping = std::fmax(1.0f - simulation.drag * dt, 0.0f);
+		r.v = (r.v + simulation.gravity * dt) * damping;
+		r.p = r.p + r.v * dt;
+
+		const float d = Vector::Dot(ground.normal, r.p) + ground.distance;
+		if (d < 0.0f)
+		{
+			r.p = r.p - ground.normal * d;
+			const float vn = Vector::Dot(ground.normal, r.v);
+			if (vn < 0.0f) { r.v = r.v - ground.normal * ((1.0f + simulation.restitution) * vn); }
+		}
+
+		const Vector3F offset = r.p - sphere.center;
+		const float length = Vector::Length(offset);
+		if (length < sphere.radius)
+		{
+			const Vector3F n = (length > 0.0f) ? offset * (1.0f / length) : Vector3F(0.0f, 1.0f, 0.0f);
+			r.p = r.p + n * (sphere.radius - length);
+			const float vn = Vector::Dot(n, r.v);
+			if (vn < 0.0f) { r.v = r.v - n * ((1.0f + simulation.restitution) * vn); }
+		}
+
+		r.age += dt;
+	};
+
+	auto near = [](const Vector3F& a, const Vector3F& b)
+	{
+		const Vector3F d = a - b;
+		return std::fmax(std::fabs(d.x), std::fmax(std::fabs(d.y), std::fabs(d.z))) <= 1.0e-4f * (1.0f + Vector::Length(b));
+	};
+
+	// not multiples of the SIMD widths, more than one parallel range
+	const float lifetimes[3] = { 0.3f, 1.0f, 0.6f };
+	uint32_t longLived = 0;
+	for (uint32_t k = 0; k < 300; k++)
+	{
+		CHECK(emit(lifetimes[k % 3], static_cast<float>(k % 3 + 1), 37 + k % 5));
+		longLived += (k % 3 == 1) ? 37 + k % 5 : 0;
+	}
+
+	const float dt = 1.0f / 60.0f;
+	uint32_t bounces = 0;
+	for (uint32_t frame = 0; frame < 50; frame++)
+	{
+		if (frame == 10) { CHECK(emit(0.6f, 3.0f, 4999)); }
+
+		particles.Update(dt);
+
+		for (Particle& r : reference)
+		{
+			const float vy = r.v.y;
+			step(r, dt);
+			bounces += ((vy < 0.0f) && (r.v.y > 0.0f)) ? 1 : 0;
+		}
+
+		for (uint32_t i = 0; i < reference.size(); )
+		{
+			if (reference[i].age * reference[i].invLife < 1.0f)
+			{
+				i++;
+				continue;
+			}
+
+			reference[i] = reference.back();
+			reference.pop_back();
+		}
+
+		CHECK(particles.GetCount() == reference.size());
+
+		std::vector<ParticleSystem::Vertex> vertices(particles.GetCount());
+		CHECK(particles.WriteVertices(vertices.data()) == vertices.size());
+
+		for (uint32_t i = 0; i < reference.size(); i++)
+		{
+			const Particle& r = reference[i];
+			CHECK(near(particles.GetPositions().Get(i), r.p));
+			CHECK(near(particles.GetVelocities().Get(i), r.v));
+			CHECK(vertices[i].size == r.size);
+		}
+	}
+
+	// after 50 frames only the particles that live a second are alive, the colliders were hit
+	CHECK(reference.size() == longLived);
+	CHECK(bounces > 1000);
+
+	return true;
+}
+
+static bool TestOptimizeMeshBruteForce(void)
+{
+	std::mt19937 rng(25);
+	const uint32_t cacheSize = 16;
+
+	// a 60 x 60 grid with its vertices and triangles shuffled and each triangle rotated, the positions are distinct
+	// and two vertices are not referenced
+	const uint32_t side = 61;
+	Importer::Mesh mesh;
+	mesh.name = "Grid";
+	mesh.vertices.resize(side * side + 2);
+	for (uint32_t v = 0; v < mesh.vertices.size(); v++)
+	{
+		Importer::Vertex& rVertex = mesh.vertices[v];
+		rVertex = {};
+		rVertex.position[0] = static_cast<float>(v % side);
+		rVertex.position[1] = static_cast<float>(v / side);
+		rVertex.uv[0] = static_cast<float>(v);
+	}
+
+	std::vector<uint32_t> remap(mesh.vertices.size());
+	for (uint32_t v = 0; v < remap.size(); v++) { remap[v] = v; }
+	std::shuffle(remap.begin(), remap.end(), rng);
+
+	std::vector<uint32_t> triangles;
+	for (uint32_t y = 0; y + 1 < side; y++)
+	{
+		for (uint32_t x = 0; x + 1 < side; x++)
+		{
+			const uint32_t v = y * side + x;
+			triangles.insert(triangles.end(), { v, v + 1, v + side, v + 1, v + side + 1, v + side });
+		}
+	}
+
+	std::vector<uint32_t> order(triangles.size() / 3);
+	for (uint32_t t = 0; t < order.size(); t++) { order[t] = t; }
+	std::shuffle(order.begin(), order.end(), rng);
+
+	for (uint32_t t : order)
+	{
+		const uint32_t r = rng() % 3;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			mesh.indices.push_back(static_cast<uint16_t>(remap[triangles[3 * t + (k + r) % 3]]));
+		}
+	}
+
+	std::vector<Importer::Vertex> vertices(mesh.vertices.size());
+	for (uint32_t v = 0; v < remap.size(); v++) { vertices[remap[v]] = mesh.vertices[v]; }
+	mesh.vertices.swap(vertices);
+
+	// the triangles as the uv of their vertices, rotated to start at the lowest one to keep their winding, sorted
+	auto getTriangles = [](const Importer::Mesh& m)
+	{
+		std::vector<std::array<float, 3>> list;
+		for (size_t i = 0; i < m.indices.size(); i += 3)
+		{
+			std::array<float, 3> t = { m.vertices[m.indices[i]].uv[0], m.vertices[m.indices[i + 1]].uv[0], m.vertices[m.indices[i + 2]].uv[0] };
+			std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+			list.push_back(t);
+		}
+		std::sort(list.begin(), list.end());
+		return list;
+	};
+
+	// transformed vertices per triangle with a FIFO of cacheSize vertices
+	auto getAcmr = [&](const Importer::Mesh& m)
+	{
+		std::vector<uint16_t> fifo;
+		uint32_t misses = 0;
+		for (uint16_t index : m.indices)
+		{
+			if (std::find(fifo.begin(), fifo.end(), index) == fifo.end())
+			{
+				fifo.push_back(index);
+				fifo.erase(fifo.begin(), fifo.end() - std::min<size_t>(fifo.size(), cacheSize));
+				misses++;
+			}
+		}
+		return static_cast<float>(misses) / static_cast<float>(m.indices.size() / 3);
+	};
+
+	const std::vector<std::array<float, 3>> expected = getTriangles(mesh);
+	const float acmr = getAcmr(mesh);
+
+	Importer::CACHE_STATS stats = {};
+	CHECK(Importer::GetCacheStats(mesh, cacheSize, stats));
+	CHECK(std::fabs(stats.acmr - acmr) < 1.0e-5f);
+
+	// Tipsify alone, then with the overdraw pass that gives back part of its gain
+	const float thresholds[2] = { 0.0f, 1.05f };
+	for (float threshold : thresholds)
+	{
+		Importer::Mesh optimized = mesh;
+		Importer::CACHE_STATS before = {};
+		Importer::CACHE_STATS after = {};
+		CHECK(Importer::OptimizeMesh(optimized, Importer::OPTIMIZE_DESC{ cacheSize, threshold }, before, after));
+
+		CHECK(optimized.vertices.size() == mesh.vertices.size());
+		CHECK(getTriangles(optimized) == expected);
+
+		// the unreferenced vertices are last
+		for (uint32_t v = side * side; v < optimized.vertices.size(); v++)
+		{
+			CHECK(optimized.vertices[v].uv[0] >= static_cast<float>(side * side));
+		}
+
+		CHECK(std::fabs(before.acmr - acmr) < 1.0e-5f);
+		CHECK(std::fabs(after.acmr - getAcmr(optimized)) < 1.0e-5f);
+		CHECK(after.acmr < 0.5f * before.acmr);
+	}
+
+	return true;
+}
+
+static bool TestReadMdlAppends(void)
+{
+	const wchar_t* pPath = L"LibTests.mdl";
+	const Importer::MDL_DATA model = CreateModel();
+
+	CHECK(Exporter::WriteMdl(pPath, model));
+
+	// the meshes already in the data are kept, the file is appended after them
+	Importer::MDL_DATA data;
+	data.meshes.push_back(model.meshes[1]);
+	data.meshes[0].name = "existing";
+
+	CHECK(Importer::ReadMdl(pPath, data));
+	CHECK(data.meshes.size() == 3);
+	CHECK(data.meshes[0].name == "existing");
+	CHECK(data.meshes[0].vertices.size() == model.meshes[1].vertices.size());
+	CHECK(SameMesh(data.meshes[1], model.meshes[0]));
+	CHECK(SameMesh(data.meshes[2], model.meshes[1]));
+
+	CHECK(Importer::ReadMdl(pPath, data));
+	CHECK(data.meshes.size() == 5);
+	CHECK(data.nodes.size() == 2);
+	CHECK(SameMesh(data.meshes[3], model.meshes[0]));
+	CHECK(SameMesh(data.meshes[4], model.meshes[1]));
+
+	return true;
+}
+
+static bool TestLoadMdlBlockFailure(void)
+{
+	const wchar_t* pPath = L"LibTests.mdl";
+	const Importer::MDL_DATA model = CreateModel();
+
+	CHECK(Exporter::WriteMdl(pPath, model, Exporter::MDL_OPTIONS{ MDL_VERSION_2 }));
+
+	std::vector<uint8_t> bytes;
+	CHECK(LoadBytes(pPath, bytes));
+
+	// break the end of the list of the second mesh block, after its mesh is read, and keep the checksum valid
+	MDL_TOC_HEADER toc = {};
+	memcpy(&toc, bytes.data() + sizeof(MDL_HEADER), sizeof(MDL_TOC_HEADER));
+
+	bool corrupted = false;
+	for (uint32_t i = 0; i < toc.count; i++)
+	{
+		const size_t entryOffset = sizeof(MDL_HEADER) + sizeof(MDL_TOC_HEADER) + i * sizeof(MDL_TOC_ENTRY);
+		MDL_TOC_ENTRY entry = GetTocEntry(bytes, i);
+
+		if ((entry.type == MDL_MESH) && (entry.name_hash == MdlNameHash("second")))
+		{
+			bytes[static_cast<size_t>(entry.offset + entry.size) - 1] ^= 0xFF;
+			entry.checksum = MdlChecksum(bytes.data() + entry.offset, static_cast<size_t>(entry.size));
+			memcpy(bytes.data() + entryOffset, &entry, sizeof(MDL_TOC_ENTRY));
+			corrupted = true;
+		}
+	}
+	CHECK(corrupted);
+
+	CHECK(SaveBytes(pPath, bytes));
+
+	// the failed loads leave the view as it was, loading again fails the same way
+	Importer::MDL_VIEW view;
+	CHECK(Importer::OpenMdl(pPath, view));
+	CHECK(Importer::LoadMdlMesh(view, "first"));
+	CHECK(view.meshes.size() == 1);
+
+	for (uint32_t attempt = 0; attempt < 2; attempt++)
+	{
+		CHECK(!Importer::LoadMdlMesh(view, "second"));
+		CHECK(view.meshes.size() == 1);
+
+		for (const Importer::BlockInfo& block : view.blocks)
+		{
+			CHECK((block.type != MDL_MESH) || (block.nameHash != MdlNameHash("second")) || !block.loaded);
+		}
+	}
+
+	Importer::UnmapMdl(view);
+	return true;
+}
+
+static bool TestReadMdlChecksum(void)
+{
+	const wchar_t* pPath = L"LibTests.mdl";
+	const Importer::MDL_DATA model = CreateModel();
+
+	CHECK(Exporter::WriteMdl(pPath, model, Exporter::MDL_OPTIONS{ MDL_VERSION_2 }));
+
+	std::vector<uint8_t> bytes;
+	CHECK(LoadBytes(pPath, bytes));
+
+	Importer::MDL_DATA data;
+	CHECK(Importer::ReadMdl(pPath, data));
+	CHECK(data.meshes.size() == 2);
+
+	// the uv 0.25 of a vertex of the first mesh changes in its last bit, the file stays well formed but its checksum
+	// does not match: Read and Map check every block like LoadMdlMesh
+	MDL_TOC_HEADER toc = {};
+	memcpy(&toc, bytes.data() + sizeof(MDL_HEADER), sizeof(MDL_TOC_HEADER));
+
+	const float uv = 0.25f;
+	bool corrupted = false;
+	for (uint32_t i = 0; !corrupted && (i < toc.count); i++)
+	{
+		const MDL_TOC_ENTRY entry = GetTocEntry(bytes, i);
+		for (size_t b = static_cast<size_t>(entry.offset); !corrupted && (entry.type == MDL_MESH) && (b + sizeof(float) <= entry.offset + entry.size); b++)
+		{
+			if (memcmp(bytes.data() + b, &uv, sizeof(float)) == 0)
+			{
+				bytes[b] ^= 0x01;
+				corrupted = true;
+			}
+		}
+	}
+	CHECK(corrupted);
+	CHECK(SaveBytes(pPath, bytes));
+
+	Importer::MDL_DATA corrupt;
+	CHECK(!Importer::ReadMdl(pPath, corrupt));
+
+	Importer::MDL_VIEW view;
+	CHECK(!Importer::MapMdl(pPath, view));
+	Importer::UnmapMdl(view);
+
+	return true;
+}
+
+static bool TestWriteMdlRoundTrip(void)
+{
+	const wchar_t* pPath = L"LibTests.mdl";
+	const wchar_t* pCopyPath = L"LibTests.copy.mdl";
+
+	Importer::MDL_DATA model = CreateModel();
+
+	Importer::Bone bone = {};
+	bone.name = "bone";
+	bone.offset_matrix[0] = bone.offset_matrix[5] = bone.offset_matrix[10] = bone.offset_matrix[15] = 2.0f;
+	model.bones.push_back(bone);
+
+	Importer::Material material = {};
+	material.name = "material";
+	material.texture = "texture.png";
+	model.materials.push_back(material);
+
+	// read, written again with the version of the file and compared
+	const uint32_t versions[] = { 0, MDL_VERSION_1, MDL_VERSION_2 };
+	for (uint32_t version : versions)
+	{
+		CHECK(Exporter::WriteMdl(pPath, model, Exporter::MDL_OPTIONS{ version }));
+
+		Importer::MDL_VIEW view;
+		CHECK(Importer::OpenMdl(pPath, view));
+		const uint32_t fileVersion = view.version;
+		Importer::UnmapMdl(view);
+		CHECK(fileVersion == version);
+
+		Importer::MDL_DATA data;
+		CHECK(Importer::ReadMdl(pPath, data));
+		CHECK(Exporter::WriteMdl(pCopyPath, data, Exporter::MDL_OPTIONS{ fileVersion }));
+
+		std::vector<uint8_t> bytes;
+		std::vector<uint8_t> copy;
+		CHECK(LoadBytes(pPath, bytes));
+		CHECK(LoadBytes(pCopyPath, copy));
+		CHECK(bytes == copy);
+	}
+
+	return true;
+}
+
+// ------------------------------------------- Main -----------------------------------------------
+
+struct Test
+{
+	const wchar_t* pName;
+	bool (*pFunction)(void);
+};
+
+static const Test TESTS[] =
+{
+	{ L"Broadphase.Unbounded",     TestBroadphaseUnbounded     },
+	{ L"Broadphase.Huge",          TestBroadphaseHuge          },
+	{ L"Broadphase.BruteForce",    TestBroadphaseBruteForce    },
+	{ L"MeshBvh.SharedNode",       TestBvhSharedNode           },
+	{ L"MeshBvh.BruteForce",       TestBvhBruteForce           },
+	{ L"LooseOctree.BruteForce",   TestOctreeBruteForce        },
+	{ L"LightClusters.Unbounded",  TestLightClustersUnbounded  },
+	{ L"LightClusters.BruteForce", TestLightClustersBruteForce },
+	{ L"Particles.ScalarStep",     TestParticlesScalarStep     },
+	{ L"Importer.Optimize",        TestOptimizeMeshBruteForce  },
+	{ L"Importer.ReadAppends",     TestReadMdlAppends          },
+	{ L"Importer.LoadFailure",     TestLoadMdlBlockFailure     },
+	{ L"Importer.ReadChecksum",    TestReadMdlChecksum         },
+	{ L"Exporter.RoundTrip",       TestWriteMdlRoundTrip       },
+};
+
+int32_t CgMain(int32_t argc, const wchar_t* argv[])
+{
+	const wchar_t* pFilter = (argc > 1) ? argv[1] : nullptr;
+	uint32_t failed = 0;
+
+	for (const Test& test : TESTS)
+	{
+		if ((pFilter != nullptr) && (wcsstr(test.pName, pFilter) == nullptr))
+		{
+			continue;
+		}
+
+		const bool passed = test.pFunction();
+		Console::Write(L"%s %s\n", passed ? L"[ OK ]" : L"[FAIL]", test.pName);
+
+		failed += passed ? 0 : 1;
+	}
+
+	Console::Write(L"%u failed\n", failed);
+	return (failed == 0) ? STATUS::SUCCESS : STATUS::UNSUCCESSFUL;
+}
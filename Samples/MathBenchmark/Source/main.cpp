@@ -0,0 +1,465 @@
+// Microbenchmarks for CgMath
+// Builds from the math sources alone, without the rest of LibCG, so that it also runs on Linux:
+//   g++ -O2 -std=c++20 -march=native -I Include Samples/MathBenchmark/Source/main.cpp Source/Math/CMath.cpp Source/Math/CMathPack.cpp Source/Math/CMathSimd.cpp -o MathBenchmark
+// Usage: MathBenchmark [--json] [--filter <text>]
+//   --json   prints the results as JSON instead of a table
+//   --filter only runs the benchmarks whose name contains <text>
+
+#include "CgMath.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Every benchmark works on arrays of COUNT elements, small enough to stay in the L1/L2 caches
+const uint32_t COUNT   = 1024;
+const uint32_t SAMPLES = 7;
+const double   MIN_SAMPLE_NS = 20.0e6;
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+// Keeps the compiler from removing or merging the repeated runs of a benchmark
+static inline void ClobberMemory(void)
+{
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : : "memory");
+#endif
+}
+
+static const char* GetSimdName(void)
+{
+#if CG_MATH_AVX2
+	return "avx2";
+#elif CG_MATH_SSE
+	return "sse";
+#else
+	return "scalar";
+#endif
+}
+
+struct Result
+{
+	std::string Name;
+	const char* Mode;
+	uint32_t    Count;
+	double      NsPerOp;
+};
+
+class Benchmark
+{
+private:
+	std::vector<Result> m_Results;
+	const char*         m_pFilter;
+	double              m_Checksum;
+
+public:
+	Benchmark(const char* pFilter)
+	{
+		m_pFilter  = pFilter;
+		m_Checksum = 0.0;
+	}
+
+	// f processes nOps elements per call, the result is the best time per element over SAMPLES samples
+	template <typename F> void Run(const char* pName, const char* pMode, uint32_t nOps, F&& f)
+	{
+		if ((m_pFilter != nullptr) && (strstr(pName, m_pFilter) == nullptr))
+		{
+			return;
+		}
+
+		typedef std::chrono::steady_clock Clock;
+
+		// calibrate the number of calls per sample
+		uint64_t calls = 1;
+		for (;;)
+		{
+			const Clock::time_point t0 = Clock::now();
+			for (uint64_t i = 0; i < calls; i++) { f(); ClobberMemory(); }
+			const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+			if (ns >= MIN_SAMPLE_NS) { break; }
+			calls *= 2;
+		}
+
+		double best = INFINITY;
+		for (uint32_t s = 0; s < SAMPLES; s++)
+		{
+			const Clock::time_point t0 = Clock::now();
+			for (uint64_t i = 0; i < calls; i++) { f(); ClobberMemory(); }
+			const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+			best = std::fmin(best, ns / (static_cast<double>(calls) * nOps));
+		}
+
+		m_Results.push_back({ pName, pMode, nOps, best });
+	}
+
+	template <typename T> void Consume(const T* pData, uint32_t count)
+	{
+		const float* p = reinterpret_cast<const float*>(pData);
+		for (uint32_t i = 0; i < count * (sizeof(T) / sizeof(float)); i++) { m_Checksum += p[i]; }
+	}
+
+	void PrintTable(void) const
+	{
+		printf("%-40s %-8s %10s %14s\n", "benchmark", "mode", "ns/op", "Mop/s");
+		for (const Result& r : m_Results)
+		{
+			printf("%-40s %-8s %10.3f %14.2f\n", r.Name.c_str(), r.Mode, r.NsPerOp, 1.0e3 / r.NsPerOp);
+		}
+		printf("simd: %s, checksum: %g\n", GetSimdName(), m_Checksum);
+	}
+
+	void PrintJson(void) const
+	{
+		printf("{\n");
+		printf("  \"simd\": \"%s\",\n", GetSimdName());
+		printf("  \"count\": %u,\n", COUNT);
+		printf("  \"checksum\": %.17g,\n", m_Checksum);
+		printf("  \"results\": [\n");
+		for (size_t i = 0; i < m_Results.size(); i++)
+		{
+			const Result& r = m_Results[i];
+			printf("    { \"name\": \"%s\", \"mode\": \"%s\", \"count\": %u, \"ns_per_op\": %.4f, \"ops_per_second\": %.1f }%s\n",
+				r.Name.c_str(), r.Mode, r.Count, r.NsPerOp, 1.0e9 / r.NsPerOp, (i + 1 < m_Results.size()) ? "," : "");
+		}
+		printf("  ]\n");
+		printf("}\n");
+	}
+};
+
+// ------------------------------------------ Inputs ----------------------------------------------
+
+struct Inputs
+{
+	std::vector<float>             Scalars;
+	std::vector<float>             Lengths;
+	std::vector<Vector3F>          Vectors3;
+	std::vector<Vector4F>          Vectors4;
+	std::vector<Quaternion<float>> Quaternions;
+	std::vector<Matrix4F>          Matrices;
+	std::vector<Matrix4F>          RigidMatrices;
+	std::vector<Matrix3x4F>        AffineMatrices;
+	std::vector<DualQuaternionF>   DualQuaternions;
+	std::vector<TransformF>        Transforms;
+	std::vector<AABBF>             Boxes;
+	std::vector<SphereF>           Spheres;
+
+	Inputs(void)
+	{
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+		for (uint32_t i = 0; i < COUNT; i++)
+		{
+			const Vector3F angles(u(rng) * 3.0f, u(rng) * 3.0f, u(rng) * 3.0f);
+			const Vector3F translation(u(rng) * 10.0f, u(rng) * 10.0f, u(rng) * 10.0f);
+			const Quaternion<float> q(angles.x, angles.y, angles.z);
+			const Matrix4F rigid = Matrix::Translate(translation) * Matrix4F(q);
+
+			Scalars.push_back(u(rng) * 10.0f);
+			Lengths.push_back(std::fabs(u(rng)) * 100.0f + 0.01f);
+			Vectors3.push_back(Vector3F(u(rng), u(rng), u(rng)));
+			Vectors4.push_back(Vector4F(u(rng), u(rng), u(rng), u(rng)));
+			Quaternions.push_back(q);
+			Matrices.push_back(rigid * Matrix::Scale(Vector3F(1.0f + u(rng) * 0.5f, 1.0f + u(rng) * 0.5f, 1.0f + u(rng) * 0.5f)));
+			RigidMatrices.push_back(rigid);
+			AffineMatrices.push_back(Matrix3x4F(Matrices.back()));
+			DualQuaternions.push_back(DualQuaternionF(q, translation));
+			Transforms.push_back(TransformF(Matrices.back()));
+
+			const Vector3F center(u(rng) * 50.0f, u(rng) * 50.0f, u(rng) * 50.0f);
+			const Vector3F extents(std::fabs(u(rng)) * 5.0f, std::fabs(u(rng)) * 5.0f, std::fabs(u(rng)) * 5.0f);
+			Boxes.push_back(AABBF(center - extents, center + extents));
+			Spheres.push_back(SphereF(center, std::fabs(u(rng)) * 5.0f));
+		}
+	}
+};
+
+// ---------------------------------------- Benchmarks --------------------------------------------
+
+static void RunScalarBenchmarks(Benchmark& b, const Inputs& in)
+{
+	std::vector<float> s(COUNT), c(COUNT);
+
+	b.Run("SinCos", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { s[i] = std::sin(in.Scalars[i]); c[i] = std::cos(in.Scalars[i]); } });
+	b.Run("SinCos", "batched", COUNT, [&]() { SinCos(in.Scalars.data(), s.data(), c.data(), COUNT); });
+	b.Consume(s.data(), COUNT);
+	b.Consume(c.data(), COUNT);
+
+	b.Run("ReciprocalSqrt", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { s[i] = 1.0f / std::sqrt(in.Lengths[i]); } });
+	b.Run("ReciprocalSqrt", "batched", COUNT, [&]() { ReciprocalSqrt(in.Lengths.data(), s.data(), COUNT); });
+	b.Consume(s.data(), COUNT);
+}
+
+static void RunVectorBenchmarks(Benchmark& b, const Inputs& in)
+{
+	std::vector<Vector3F> v3(COUNT);
+	std::vector<Vector4F> v4(COUNT);
+
+	b.Run("Vector::Normalize(Vector3F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = Vector::Normalize(in.Vectors3[i]); } });
+	b.Run("Vector::Normalize(Vector3F)", "batched", COUNT, [&]() { Vector::Normalize(in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Vector::Normalize(Vector4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v4[i] = Vector::Normalize(in.Vectors4[i]); } });
+	b.Run("Vector::Normalize(Vector4F)", "batched", COUNT, [&]() { Vector::Normalize(in.Vectors4.data(), v4.data(), COUNT); });
+	b.Consume(v4.data(), COUNT);
+
+	b.Run("Vector::Cross(Vector3F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = Vector::Cross(in.Vectors3[i], in.Vectors3[COUNT - 1 - i]); } });
+	b.Consume(v3.data(), COUNT);
+}
+
+static void RunMatrixBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const Matrix4F&   m  = in.Matrices[0];
+	const Matrix3x4F& ma = in.AffineMatrices[0];
+
+	std::vector<Matrix4F>   r4(COUNT);
+	std::vector<Matrix3x4F> r34(COUNT);
+	std::vector<Vector3F>   v3(COUNT);
+	std::vector<Vector4F>   v4(COUNT);
+
+	b.Run("Matrix4F::operator*", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = m * in.Matrices[i]; } });
+	b.Run("Matrix4F::operator*", "batched", COUNT, [&]() { Matrix::Multiply(m, in.Matrices.data(), r4.data(), COUNT); });
+	b.Consume(r4.data(), COUNT);
+
+	// chained element-wise operators, the temporaries of trivially copyable types fold into a single pass
+	b.Run("Matrix4F a + b * s - c", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = in.Matrices[i] + in.RigidMatrices[i] * 0.5f - m; } });
+	b.Run("Vector3F a + b * s - c", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = in.Vectors3[i] + in.Vectors3[COUNT - 1 - i] * 0.5f - in.Vectors3[0]; } });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::Inverse(Matrix4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = Matrix::Inverse(in.Matrices[i]); } });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::InverseAffine(Matrix4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = Matrix::InverseAffine(in.Matrices[i]); } });
+	b.Run("Matrix::InverseAffine(Matrix4F)", "batched", COUNT, [&]() { Matrix::InverseAffine(in.Matrices.data(), r4.data(), COUNT); });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::InverseRigid(Matrix4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = Matrix::InverseRigid(in.RigidMatrices[i]); } });
+	b.Run("Matrix::InverseRigid(Matrix4F)", "batched", COUNT, [&]() { Matrix::InverseRigid(in.RigidMatrices.data(), r4.data(), COUNT); });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::Transpose(Matrix4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = Matrix::Transpose(in.Matrices[i]); } });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::Rotate", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r4[i] = Matrix::Rotate(in.Vectors3[i]); } });
+	b.Run("Matrix::Rotate", "batched", COUNT, [&]() { Matrix::Rotate(in.Vectors3.data(), r4.data(), COUNT); });
+	b.Consume(r4.data(), COUNT);
+
+	b.Run("Matrix::Transform(Matrix4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v4[i] = m * in.Vectors4[i]; } });
+	b.Run("Matrix::Transform(Matrix4F)", "batched", COUNT, [&]() { Matrix::Transform(m, in.Vectors4.data(), v4.data(), COUNT); });
+	b.Consume(v4.data(), COUNT);
+
+	b.Run("Matrix::TransformPoints(Matrix4F)", "scalar", COUNT, [&]()
+	{
+		const Matrix3x4F a(m);
+		for (uint32_t i = 0; i < COUNT; i++) { v3[i] = a * Vector4F(in.Vectors3[i], 1.0f); }
+	});
+	b.Run("Matrix::TransformPoints(Matrix4F)", "batched", COUNT, [&]() { Matrix::TransformPoints(m, in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Matrix::TransformVectors(Matrix4F)", "batched", COUNT, [&]() { Matrix::TransformVectors(m, in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Matrix3x4F::operator*", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r34[i] = ma * in.AffineMatrices[i]; } });
+	b.Run("Matrix3x4F::operator*", "batched", COUNT, [&]() { Matrix::Multiply(ma, in.AffineMatrices.data(), r34.data(), COUNT); });
+	b.Consume(r34.data(), COUNT);
+
+	b.Run("Matrix::Inverse(Matrix3x4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { r34[i] = Matrix::Inverse(in.AffineMatrices[i]); } });
+	b.Consume(r34.data(), COUNT);
+
+	b.Run("Matrix::Convert(Matrix4F)", "batched", COUNT, [&]() { Matrix::Convert(in.Matrices.data(), r34.data(), COUNT); });
+	b.Consume(r34.data(), COUNT);
+
+	b.Run("Matrix::TransformPoints(Matrix3x4F)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = ma * Vector4F(in.Vectors3[i], 1.0f); } });
+	b.Run("Matrix::TransformPoints(Matrix3x4F)", "batched", COUNT, [&]() { Matrix::TransformPoints(ma, in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+}
+
+static void RunQuaternionBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const Quaternion<float>& q = in.Quaternions[0];
+
+	std::vector<Quaternion<float>> rq(COUNT);
+	std::vector<Vector3F>          v3(COUNT);
+
+	b.Run("Quaternion(x, y, z)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = Quaternion<float>(in.Vectors3[i].x, in.Vectors3[i].y, in.Vectors3[i].z); } });
+	b.Run("Quaternion(x, y, z)", "batched", COUNT, [&]() { Quat::Convert(in.Vectors3.data(), rq.data(), COUNT); });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("Matrix4F(Quaternion)", "scalar", COUNT, [&]() { Matrix4F m; for (uint32_t i = 0; i < COUNT; i++) { m = Matrix4F(in.Quaternions[i]); v3[i] = Vector3F(m[0][0], m[1][1], m[2][2]); } });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Quat::Normalize", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = Quat::Normalize(in.Quaternions[i]); } });
+	b.Run("Quat::Normalize", "batched", COUNT, [&]() { Quat::Normalize(in.Quaternions.data(), rq.data(), COUNT); });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("Quaternion::operator*", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = in.Quaternions[i] * in.Quaternions[COUNT - 1 - i]; } });
+	b.Run("Quaternion::operator*", "batched", COUNT, [&]() { Quat::Multiply(in.Quaternions.data(), in.Quaternions.data(), rq.data(), COUNT); });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("Quaternion::Rotate", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = q.Rotate(in.Vectors3[i]); } });
+	b.Run("Quaternion::Rotate", "batched", COUNT, [&]() { Quat::Rotate(q, in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Quat::Nlerp", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = Quat::Nlerp(in.Quaternions[i], in.Quaternions[COUNT - 1 - i], 0.3f); } });
+	b.Run("Quat::Nlerp", "batched", COUNT, [&]() { Quat::Nlerp(in.Quaternions.data(), in.Quaternions.data() + 1, 0.3f, rq.data(), COUNT - 1); });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("Quat::Slerp", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = Quat::Slerp(in.Quaternions[i], in.Quaternions[COUNT - 1 - i], 0.3f); } });
+	b.Run("Quat::SlerpFast", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = Quat::SlerpFast(in.Quaternions[i], in.Quaternions[COUNT - 1 - i], 0.3f); } });
+	b.Consume(rq.data(), COUNT);
+}
+
+static void RunDualQuaternionBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const DualQuaternionF& q = in.DualQuaternions[0];
+
+	std::vector<DualQuaternionF> rq(COUNT);
+	std::vector<Vector3F>        v3(COUNT);
+
+	b.Run("DualQuaternion::operator*", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rq[i] = q * in.DualQuaternions[i]; } });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("DualQuat::Convert(Matrix4F)", "batched", COUNT, [&]() { DualQuat::Convert(in.RigidMatrices.data(), rq.data(), COUNT); });
+	b.Consume(rq.data(), COUNT);
+
+	b.Run("DualQuat::TransformPoints", "batched", COUNT, [&]() { DualQuat::TransformPoints(q, in.Vectors3.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+}
+
+static void RunTransformBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const TransformF& t = in.Transforms[0];
+
+	std::vector<TransformF> rt(COUNT);
+	std::vector<Matrix3x4F> r34(COUNT);
+
+	b.Run("Transform::operator*", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rt[i] = t * in.Transforms[i]; } });
+	b.Consume(rt.data(), COUNT);
+
+	b.Run("Xform::Inverse", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rt[i] = Xform::Inverse(in.Transforms[i]); } });
+	b.Consume(rt.data(), COUNT);
+
+	b.Run("Xform::Lerp", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { rt[i] = Xform::Lerp(in.Transforms[i], in.Transforms[COUNT - 1 - i], 0.3f); } });
+	b.Consume(rt.data(), COUNT);
+
+	b.Run("Xform::Convert(Matrix4F)", "batched", COUNT, [&]() { Xform::Convert(in.Matrices.data(), rt.data(), COUNT); });
+	b.Consume(rt.data(), COUNT);
+
+	b.Run("Xform::Convert(TransformF)", "batched", COUNT, [&]() { Xform::Convert(in.Transforms.data(), r34.data(), COUNT); });
+	b.Consume(r34.data(), COUNT);
+}
+
+static void RunBoundsBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const FrustumF f(in.RigidMatrices[0]);
+
+	std::vector<uint32_t> visible((COUNT + 31) / 32);
+	std::vector<AABBF>    boxes(in.Boxes);
+
+	b.Run("Bounds::Classify(AABB)", "scalar", COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < COUNT; i++) { visible[i / 32] = (visible[i / 32] << 1) | (Bounds::Classify(f, in.Boxes[i]) != INTERSECTION_OUTSIDE); }
+	});
+	b.Run("Bounds::Cull(AABB)", "batched", COUNT, [&]() { Bounds::Cull(f, in.Boxes.data(), COUNT, visible.data()); });
+
+	b.Run("Bounds::Classify(Sphere)", "scalar", COUNT, [&]()
+	{
+		for (uint32_t i = 0; i < COUNT; i++) { visible[i / 32] = (visible[i / 32] << 1) | (Bounds::Classify(f, in.Spheres[i]) != INTERSECTION_OUTSIDE); }
+	});
+	b.Run("Bounds::Cull(Sphere)", "batched", COUNT, [&]() { Bounds::Cull(f, in.Spheres.data(), COUNT, visible.data()); });
+
+	b.Run("Bounds::Transform(AABB)", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { boxes[i] = Bounds::Transform(in.Boxes[i], in.AffineMatrices[i]); } });
+	b.Consume(boxes.data(), COUNT);
+}
+
+static void RunPackBenchmarks(Benchmark& b, const Inputs& in)
+{
+	const AABBF bounds(Vector3F(-1.0f), Vector3F(1.0f));
+
+	std::vector<Quaternion<float>> q(COUNT);
+	std::vector<Vector3F>          v3(COUNT);
+	std::vector<Vector3F>          normals(COUNT);
+	std::vector<float>             f(4 * COUNT);
+	std::vector<PackedQuaternion>  pq(COUNT);
+	std::vector<PackedNormal>      pn(COUNT);
+	std::vector<PackedPosition>    pp(COUNT);
+	std::vector<uint16_t>          ph(4 * COUNT);
+
+	Vector::Normalize(in.Vectors3.data(), normals.data(), COUNT);
+
+	b.Run("Pack::EncodeQuaternion", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { pq[i] = Pack::EncodeQuaternion(in.Quaternions[i]); } });
+	b.Run("Pack::EncodeQuaternion", "batched", COUNT, [&]() { Pack::EncodeQuaternions(in.Quaternions.data(), pq.data(), COUNT); });
+	b.Run("Pack::DecodeQuaternion", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { q[i] = Pack::DecodeQuaternion(pq[i]); } });
+	b.Run("Pack::DecodeQuaternion", "batched", COUNT, [&]() { Pack::DecodeQuaternions(pq.data(), q.data(), COUNT); });
+	b.Consume(q.data(), COUNT);
+
+	b.Run("Pack::EncodeNormal", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { pn[i] = Pack::EncodeNormal(normals[i]); } });
+	b.Run("Pack::EncodeNormal", "batched", COUNT, [&]() { Pack::EncodeNormals(normals.data(), pn.data(), COUNT); });
+	b.Run("Pack::DecodeNormal", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = Pack::DecodeNormal(pn[i]); } });
+	b.Run("Pack::DecodeNormal", "batched", COUNT, [&]() { Pack::DecodeNormals(pn.data(), v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	b.Run("Pack::EncodePosition", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { pp[i] = Pack::EncodePosition(in.Vectors3[i], bounds); } });
+	b.Run("Pack::EncodePosition", "batched", COUNT, [&]() { Pack::EncodePositions(in.Vectors3.data(), bounds, pp.data(), COUNT); });
+	b.Run("Pack::DecodePosition", "scalar", COUNT, [&]() { for (uint32_t i = 0; i < COUNT; i++) { v3[i] = Pack::DecodePosition(pp[i], bounds); } });
+	b.Run("Pack::DecodePosition", "batched", COUNT, [&]() { Pack::DecodePositions(pp.data(), bounds, v3.data(), COUNT); });
+	b.Consume(v3.data(), COUNT);
+
+	const float* pFloats = in.Vectors4.data()->elements;
+	b.Run("Pack::EncodeHalf", "scalar", 4 * COUNT, [&]() { for (uint32_t i = 0; i < 4 * COUNT; i++) { ph[i] = Pack::EncodeHalf(pFloats[i]); } });
+	b.Run("Pack::EncodeHalf", "batched", 4 * COUNT, [&]() { Pack::EncodeHalves(pFloats, ph.data(), 4 * COUNT); });
+	b.Run("Pack::DecodeHalf", "scalar", 4 * COUNT, [&]() { for (uint32_t i = 0; i < 4 * COUNT; i++) { f[i] = Pack::DecodeHalf(ph[i]); } });
+	b.Run("Pack::DecodeHalf", "batched", 4 * COUNT, [&]() { Pack::DecodeHalves(ph.data(), f.data(), 4 * COUNT); });
+	b.Consume(f.data(), 4 * COUNT);
+}
+
+int main(int argc, const char* argv[])
+{
+	bool        bJson   = false;
+	const char* pFilter = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+		{
+			bJson = true;
+		}
+		else if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc))
+		{
+			pFilter = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--json] [--filter <text>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const Inputs in;
+	Benchmark b(pFilter);
+
+	RunScalarBenchmarks(b, in);
+	RunVectorBenchmarks(b, in);
+	RunMatrixBenchmarks(b, in);
+	RunQuaternionBenchmarks(b, in);
+	RunDualQuaternionBenchmarks(b, in);
+	RunTransformBenchmarks(b, in);
+	RunBoundsBenchmarks(b, in);
+	RunPackBenchmarks(b, in);
+
+	if (bJson) { b.PrintJson(); }
+	else       { b.PrintTable(); }
+
+	return 0;
+}
@@ -0,0 +1,340 @@
+// Known answers: the SIMD and the scalar builds can agree on a wrong result, these checks compare the public functions
+// with results computed another way (the SIMD build of CgMath, like main.cpp)
+
+#include "CgMath.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "MathTests.hpp"
+
+#define CHECK(x) if (!(x)) { printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); return false; }
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static bool Near(const Vector3F& a, const Vector3F& b, float tolerance)
+{
+	return (std::fabs(a.x - b.x) <= tolerance) && (std::fabs(a.y - b.y) <= tolerance) && (std::fabs(a.z - b.z) <= tolerance);
+}
+
+static bool Near(const Quaternion<float>& a, const Quaternion<float>& b, float tolerance)
+{
+	bool near = true;
+	for (uint32_t i = 0; i < 4; i++) { near = near && (std::fabs(a.elements[i] - b.elements[i]) <= tolerance); }
+	return near;
+}
+
+// q and -q are the same rotation
+static bool NearRotation(const Quaternion<float>& a, const Quaternion<float>& b, float tolerance)
+{
+	return Near(a, b, tolerance) || Near(a, Quaternion<float>(-b.x, -b.y, -b.z, -b.w), tolerance);
+}
+
+static bool NearIdentity(const Matrix4F& m, float tolerance)
+{
+	bool near = true;
+	for (uint32_t i = 0; i < 16; i++) { near = near && (std::fabs(m.elements[i / 4][i % 4] - ((i / 4 == i % 4) ? 1.0f : 0.0f)) <= tolerance); }
+	return near;
+}
+
+static Quaternion<float> RandomRotation(std::mt19937& rRng)
+{
+	std::uniform_real_distribution<float> u(-3.0f, 3.0f);
+	return Quaternion<float>(u(rRng), u(rRng), u(rRng));
+}
+
+static Vector3F RandomVector(std::mt19937& rRng, float range)
+{
+	std::uniform_real_distribution<float> u(-range, range);
+	return Vector3F(u(rRng), u(rRng), u(rRng));
+}
+
+// ----------------------------------------- Checks -----------------------------------------------
+
+// Inverse(m) * m is the identity for the well conditioned matrices, general and affine
+static bool CheckInverse(void)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> u(-0.05f, 0.05f);
+
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		const Vector3F s(1.0f + std::fabs(u(rng)) * 10.0f, 1.5f, 0.75f);
+		const Matrix4F rigid = Matrix::Translate(RandomVector(rng, 10.0f)) * Matrix4F(RandomRotation(rng));
+		const Matrix4F affine = rigid * Matrix::Scale(s);
+
+		Matrix4F e = Matrix::Scale(Vector3F(1.0f, 1.0f, 1.0f));
+		for (uint32_t j = 0; j < 16; j++) { e.elements[j / 4][j % 4] += u(rng); }
+		const Matrix4F general = affine * e;
+
+		CHECK(NearIdentity(Matrix::Inverse(general) * general, 1e-4f));
+		CHECK(NearIdentity(general * Matrix::Inverse(general), 1e-4f));
+		CHECK(NearIdentity(Matrix::InverseAffine(affine) * affine, 1e-4f));
+		CHECK(NearIdentity(Matrix::InverseRigid(rigid) * rigid, 1e-4f));
+	}
+
+	// a diagonal matrix with powers of two has an exact inverse
+	const Matrix4F d = Matrix::Translate(Vector3F(4.0f, -8.0f, 2.0f)) * Matrix::Scale(Vector3F(2.0f, 0.5f, 4.0f));
+	const Matrix4F r = Matrix::Inverse(d);
+	CHECK((r[0][0] == 0.5f) && (r[1][1] == 2.0f) && (r[2][2] == 0.25f));
+	CHECK((r[3][0] == -2.0f) && (r[3][1] == 16.0f) && (r[3][2] == -0.5f) && (r[3][3] == 1.0f));
+
+	return true;
+}
+
+// q.Rotate(v) and the batched Quat::Rotate agree with the rotation matrix of q, a quarter turn about z maps x to y
+static bool CheckRotate(void)
+{
+	std::mt19937 rng(2);
+
+	const Quaternion<float> z90(0.0f, 0.0f, std::sqrt(0.5f), std::sqrt(0.5f));
+	CHECK(Near(z90.Rotate(Vector3F(1.0f, 0.0f, 0.0f)), Vector3F(0.0f, 1.0f, 0.0f), 1e-6f));
+	CHECK(Near(z90.Rotate(Vector3F(0.0f, 1.0f, 0.0f)), Vector3F(-1.0f, 0.0f, 0.0f), 1e-6f));
+
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		const Quaternion<float> q = RandomRotation(rng);
+		const Matrix3x4F m = Matrix3x4F(Matrix4F(q));
+
+		Vector3F v[11], r[11];
+		for (uint32_t j = 0; j < 11; j++) { v[j] = RandomVector(rng, 4.0f); }
+		Quat::Rotate(q, v, r, 11);
+
+		for (uint32_t j = 0; j < 11; j++)
+		{
+			const Vector3F expected = m * Vector4F(v[j], 0.0f);
+			CHECK(Near(q.Rotate(v[j]), expected, 1e-5f));
+			CHECK(Near(r[j], expected, 1e-5f));
+		}
+	}
+
+	return true;
+}
+
+// The interpolations return their end points at t = 0 and t = 1, and the middle of a turn about one axis at t = 0.5
+static bool CheckInterpolation(void)
+{
+	std::mt19937 rng(3);
+
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		Quaternion<float> q0[5], q1[5], r[5];
+		for (uint32_t j = 0; j < 5; j++) { q0[j] = RandomRotation(rng); q1[j] = RandomRotation(rng); }
+
+		for (uint32_t j = 0; j < 5; j++)
+		{
+			CHECK(NearRotation(Quat::Slerp(q0[j], q1[j], 0.0f), q0[j], 1e-6f));
+			CHECK(NearRotation(Quat::Slerp(q0[j], q1[j], 1.0f), q1[j], 1e-6f));
+			CHECK(NearRotation(Quat::Nlerp(q0[j], q1[j], 0.0f), q0[j], 1e-6f));
+			CHECK(NearRotation(Quat::Nlerp(q0[j], q1[j], 1.0f), q1[j], 1e-6f));
+			CHECK(NearRotation(Quat::SlerpFast(q0[j], q1[j], 0.0f), q0[j], 1e-6f));
+			CHECK(NearRotation(Quat::SlerpFast(q0[j], q1[j], 1.0f), q1[j], 1e-6f));
+		}
+
+		Quat::Slerp(q0, q1, 1.0f, r, 5);
+		for (uint32_t j = 0; j < 5; j++) { CHECK(NearRotation(r[j], q1[j], 1e-6f)); }
+		Quat::Nlerp(q0, q1, 0.0f, r, 5);
+		for (uint32_t j = 0; j < 5; j++) { CHECK(NearRotation(r[j], q0[j], 1e-6f)); }
+	}
+
+	// half of a 120 degree turn about z is a 60 degree turn
+	const Quaternion<float> a(0.0f, 0.0f, 0.0f, 1.0f);
+	const Quaternion<float> b(0.0f, 0.0f, std::sin(1.04719755f), std::cos(1.04719755f));
+	const Quaternion<float> half(0.0f, 0.0f, std::sin(0.52359878f), std::cos(0.52359878f));
+	CHECK(Near(Quat::Slerp(a, b, 0.5f), half, 1e-6f));
+	CHECK(Near(Quat::Nlerp(a, b, 0.5f), half, 1e-6f));
+
+	return true;
+}
+
+// Matrix4 -> Transform -> Matrix4 and Transform -> Matrix4 -> Transform give back their input, and the points move alike
+static bool CheckTransformRoundTrip(void)
+{
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<float> u(0.25f, 4.0f);
+
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		const TransformF t(RandomVector(rng, 10.0f), RandomRotation(rng), Vector3F(u(rng), u(rng), u(rng)));
+		const Matrix4F m(t);
+		const TransformF back(m);
+
+		CHECK(Near(back.translation, t.translation, 1e-5f));
+		CHECK(NearRotation(back.rotation, t.rotation, 1e-5f));
+		CHECK(Near(back.scale, t.scale, 1e-5f));
+
+		const Matrix4F m2(back);
+		for (uint32_t j = 0; j < 4; j++) { CHECK(Near(m2[j].xyz, m[j].xyz, 1e-4f)); }
+
+		const Vector3F p = RandomVector(rng, 4.0f);
+		CHECK(Near(t.TransformPoint(p), Matrix3x4F(m) * Vector4F(p, 1.0f), 1e-4f));
+
+		// uniform scale: the inverse is exact
+		const TransformF uniform(t.translation, t.rotation, Vector3F(t.scale.x, t.scale.x, t.scale.x));
+		const TransformF identity = Xform::Inverse(uniform) * uniform;
+		CHECK(Near(identity.translation, Vector3F(0.0f, 0.0f, 0.0f), 1e-4f));
+		CHECK(NearRotation(identity.rotation, Quaternion<float>(0.0f, 0.0f, 0.0f, 1.0f), 1e-5f));
+		CHECK(Near(identity.scale, Vector3F(1.0f, 1.0f, 1.0f), 1e-5f));
+	}
+
+	return true;
+}
+
+// Matrix4 -> DualQuaternion keeps the rigid transform, its inverse undoes it and the product matches the Matrix4 product
+static bool CheckDualQuaternionRoundTrip(void)
+{
+	std::mt19937 rng(5);
+
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		const Quaternion<float> q = RandomRotation(rng);
+		const Vector3F t = RandomVector(rng, 10.0f);
+		const Matrix4F a = Matrix::Translate(t) * Matrix4F(q);
+		const Matrix4F b = Matrix::Translate(RandomVector(rng, 10.0f)) * Matrix4F(RandomRotation(rng));
+
+		const DualQuaternionF da(a);
+		const DualQuaternionF db(b);
+		CHECK(NearRotation(da.real, q, 1e-5f));
+		CHECK(Near(da.GetTranslation(), t, 1e-5f));
+
+		const Vector3F p = RandomVector(rng, 4.0f);
+		CHECK(Near(da.TransformPoint(p), Matrix3x4F(a) * Vector4F(p, 1.0f), 1e-4f));
+		CHECK(Near((da * db).TransformPoint(p), Matrix3x4F(a * b) * Vector4F(p, 1.0f), 1e-4f));
+		CHECK(Near((DualQuat::Inverse(da) * da).TransformPoint(p), p, 1e-4f));
+
+		Vector3F r;
+		DualQuat::TransformPoints(da, &p, &r, 1);
+		CHECK(Near(r, Matrix3x4F(a) * Vector4F(p, 1.0f), 1e-4f));
+	}
+
+	return true;
+}
+
+// The decoded values stay within the bounds stated in CgMath.hpp
+static bool CheckPack(void)
+{
+	std::mt19937 rng(6);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	const AABBF box(Vector3F(-2.0f, 0.0f, 10.0f), Vector3F(6.0f, 1.0f, 50.0f));
+	const Vector3F extents = box.GetExtents();
+
+	for (uint32_t i = 0; i < 1024; i++)
+	{
+		const Quaternion<float> q = RandomRotation(rng);
+		CHECK(NearRotation(Pack::DecodeQuaternion(Pack::EncodeQuaternion(q)), q, 7e-5f));
+
+		const Vector3F n = Vector::Normalize(Vector3F(u(rng), u(rng), u(rng)));
+		CHECK(Near(Pack::DecodeNormal(Pack::EncodeNormal(n)), n, 7e-5f));
+
+		const Vector3F p(box.min.x + (u(rng) + 1.0f) * extents.x, box.min.y + (u(rng) + 1.0f) * extents.y, box.min.z + (u(rng) + 1.0f) * extents.z);
+		const Vector3F d = Pack::DecodePosition(Pack::EncodePosition(p, box), box);
+		for (uint32_t j = 0; j < 3; j++) { CHECK(std::fabs(d[j] - p[j]) <= extents[j] / 65534.0f + 4e-6f); }
+
+		// half floats keep 11 significant bits
+		const float f = u(rng) * 1000.0f;
+		CHECK(std::fabs(Pack::DecodeHalf(Pack::EncodeHalf(f)) - f) <= std::fabs(f) * (1.0f / 2048.0f));
+	}
+
+	// the axes of the octahedron and the corners of the box are exact
+	CHECK(Pack::DecodeNormal(Pack::EncodeNormal(Vector3F(0.0f, 0.0f, -1.0f))) == Vector3F(0.0f, 0.0f, -1.0f));
+	CHECK(Pack::DecodePosition(Pack::EncodePosition(box.max, box), box) == box.max);
+	CHECK(Pack::DecodePosition(Pack::EncodePosition(box.min, box), box) == box.min);
+
+	// known half encodings
+	CHECK((Pack::EncodeHalf(1.0f) == 0x3C00) && (Pack::EncodeHalf(-2.0f) == 0xC000) && (Pack::EncodeHalf(65504.0f) == 0x7BFF));
+	CHECK((Pack::EncodeHalf(65520.0f) == 0x7C00) && (Pack::EncodeHalf(5.9604645e-8f) == 0x0001) && (Pack::DecodeHalf(0x3555) == 0.333251953125f));
+
+	return true;
+}
+
+// The scalar only operators (see MathOps.inl) on small integers, which are exact
+static bool CheckScalarOps(void)
+{
+	const Vector4F a(1.0f, 2.0f, 3.0f, 4.0f);
+	const Vector4F b(-2.0f, 0.5f, 4.0f, 1.0f);
+	CHECK((a + b) == Vector4F(-1.0f, 2.5f, 7.0f, 5.0f));
+	CHECK(Vector::Dot(a, b) == 15.0f);
+
+	const Matrix4F m(Vector4F(1.0f, 2.0f, 3.0f, 4.0f), Vector4F(5.0f, 6.0f, 7.0f, 8.0f), Vector4F(9.0f, 10.0f, 11.0f, 12.0f), Vector4F(13.0f, 14.0f, 15.0f, 16.0f));
+	const Matrix4F t = Matrix::Transpose(m);
+	for (uint32_t i = 0; i < 16; i++) { CHECK(t.elements[i / 4][i % 4] == m.elements[i % 4][i / 4]); }
+
+	const Matrix4F sum = m + t * 2.0f;
+	for (uint32_t i = 0; i < 16; i++) { CHECK(sum.elements[i / 4][i % 4] == m.elements[i / 4][i % 4] + 2.0f * m.elements[i % 4][i / 4]); }
+
+	// each row dotted with the vector
+	CHECK((m * a) == Vector4F(30.0f, 70.0f, 110.0f, 150.0f));
+
+	// a quarter turn about z maps the x axis to y
+	const Matrix4F r(Quaternion<float>(0.0f, 0.0f, std::sqrt(0.5f), std::sqrt(0.5f)));
+	CHECK(Near(Matrix3x4F(r) * Vector4F(1.0f, 0.0f, 0.0f, 0.0f), Vector3F(0.0f, 1.0f, 0.0f), 1e-6f));
+	CHECK(r[3] == Vector4F(0.0f, 0.0f, 0.0f, 1.0f));
+
+	return true;
+}
+
+// Translate * rotate * scale moves a point by the scale, then the rotation, then the translation, like the Matrix3x4 overload
+static bool CheckTransformPoints(void)
+{
+	const Quaternion<float> q(0.3f, -0.5f, 1.1f);
+	const Vector3F t(1.0f, 2.0f, 3.0f);
+	const Vector3F s(2.0f, 3.0f, 4.0f);
+	const Matrix4F m = Matrix::Translate(t) * Matrix4F(q) * Matrix::Scale(s);
+
+	Vector3F origin(0.0f, 0.0f, 0.0f), r;
+	Matrix::TransformPoints(Matrix::Translate(t), &origin, &r, 1);
+	CHECK((r.x == 1.0f) && (r.y == 2.0f) && (r.z == 3.0f));
+
+	// scaled by <2, 3, 4>, then moved by <1, 2, 3>
+	const Vector3F one(1.0f, 1.0f, 1.0f);
+	Matrix::TransformPoints(Matrix::Translate(t) * Matrix::Scale(s), &one, &r, 1);
+	CHECK((r.x == 3.0f) && (r.y == 5.0f) && (r.z == 7.0f));
+	Matrix::TransformVectors(Matrix::Translate(t) * Matrix::Scale(s), &one, &r, 1);
+	CHECK((r.x == 2.0f) && (r.y == 3.0f) && (r.z == 4.0f));
+
+	// enough points for the SIMD loops and their remainder
+	Vector3F points[11], r4[11], r34[11];
+	for (uint32_t i = 0; i < 11; i++) { points[i] = Vector3F(0.5f * i - 2.0f, 1.0f - 0.25f * i, 0.125f * i * i); }
+
+	Matrix::TransformPoints(m, points, r4, 11);
+	Matrix::TransformPoints(Matrix3x4F(m), points, r34, 11);
+	for (uint32_t i = 0; i < 11; i++)
+	{
+		const Vector3F p = points[i];
+		CHECK(Near(r4[i], q.Rotate(Vector3F(p.x * s.x, p.y * s.y, p.z * s.z)) + t, 1e-4f));
+		CHECK((r4[i].x == r34[i].x) && (r4[i].y == r34[i].y) && (r4[i].z == r34[i].z));
+	}
+
+	Matrix::TransformVectors(m, points, r4, 11);
+	Matrix::TransformVectors(Matrix3x4F(m), points, r34, 11);
+	for (uint32_t i = 0; i < 11; i++)
+	{
+		const Vector3F p = points[i];
+		CHECK(Near(r4[i], q.Rotate(Vector3F(p.x * s.x, p.y * s.y, p.z * s.z)), 1e-4f));
+		CHECK((r4[i].x == r34[i].x) && (r4[i].y == r34[i].y) && (r4[i].z == r34[i].z));
+	}
+
+	return true;
+}
+
+// ------------------------------------------ Table -----------------------------------------------
+
+static const Check CHECKS[] =
+{
+	{ "Matrix4F operators",         CheckScalarOps               },
+	{ "Matrix::Inverse",            CheckInverse                 },
+	{ "Quaternion::Rotate",         CheckRotate                  },
+	{ "Quat::Slerp",                CheckInterpolation           },
+	{ "Transform(Matrix4F)",        CheckTransformRoundTrip      },
+	{ "DualQuaternion(Matrix4F)",   CheckDualQuaternionRoundTrip },
+	{ "Pack",                       CheckPack                    },
+	{ "Matrix::TransformPoints",    CheckTransformPoints         }
+};
+
+const Check* GetChecks(uint32_t& rCount)
+{
+	rCount = sizeof(CHECKS) / sizeof(CHECKS[0]);
+	return CHECKS;
+}
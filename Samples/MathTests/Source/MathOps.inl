@@ -0,0 +1,195 @@
+// The ops compared by MathTests, included by main.cpp against the SIMD build of CgMath and by Reference.cpp against
+// the CG_MATH_NO_SIMD build. Every op reads the Inputs as CgMath types and writes count * width floats.
+// Only the functions with a Simd path are listed. The Vector4F operators and Dot, the Matrix4F sum and scale,
+// Matrix4F * Vector4F, Transpose and Matrix4F(Quaternion) are scalar only, both builds run the same inline code for them;
+// Checks.cpp checks their results.
+
+template <typename T> static const T* Get(const std::vector<float>& data) { return reinterpret_cast<const T*>(data.data()); }
+template <typename T> static T*       Out(float* pOut) { return reinterpret_cast<T*>(pOut); }
+
+// ----------------------------------------- Scalar ----------------------------------------------
+
+static void OpSinCos(const Inputs& in, float* pOut)
+{
+	std::vector<float> angles(in.count), s(in.count), c(in.count);
+	for (uint32_t i = 0; i < in.count; i++) { angles[i] = in.vectors4[i] * 10.0f; }
+
+	SinCos(angles.data(), s.data(), c.data(), in.count);
+	for (uint32_t i = 0; i < in.count; i++) { pOut[2 * i] = s[i]; pOut[2 * i + 1] = c[i]; }
+}
+
+static void OpReciprocalSqrt(const Inputs& in, float* pOut)
+{
+	std::vector<float> lengths(in.count);
+	for (uint32_t i = 0; i < in.count; i++) { lengths[i] = std::fabs(in.vectors4[i]) * 100.0f + 0.01f; }
+
+	ReciprocalSqrt(lengths.data(), pOut, in.count);
+}
+
+// ----------------------------------------- Vector ----------------------------------------------
+
+static void OpNormalize3(const Inputs& in, float* pOut)
+{
+	Vector::Normalize(Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpNormalize4(const Inputs& in, float* pOut)
+{
+	Vector::Normalize(Get<Vector4F>(in.vectors4), Out<Vector4F>(pOut), in.count);
+}
+
+// --------------------------------------- Quaternion --------------------------------------------
+
+static void OpQuatNormalize(const Inputs& in, float* pOut)
+{
+	Quat::Normalize(Get<Quaternion<float>>(in.vectors4), Out<Quaternion<float>>(pOut), in.count);
+}
+
+static void OpQuatMultiply(const Inputs& in, float* pOut)
+{
+	const Quaternion<float>* q = Get<Quaternion<float>>(in.quaternions);
+	Quat::Multiply(q, Get<Quaternion<float>>(in.vectors4), Out<Quaternion<float>>(pOut), in.count);
+}
+
+static void OpQuatRotate(const Inputs& in, float* pOut)
+{
+	const Quaternion<float>& q = Get<Quaternion<float>>(in.quaternions)[0];
+	Quat::Rotate(q, Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpQuatNlerp(const Inputs& in, float* pOut)
+{
+	const Quaternion<float>* q = Get<Quaternion<float>>(in.quaternions);
+	Quat::Nlerp(q, q + 1, 0.3f, Out<Quaternion<float>>(pOut), in.count - 1);
+	Out<Quaternion<float>>(pOut)[in.count - 1] = q[0];
+}
+
+static void OpQuatConvert(const Inputs& in, float* pOut)
+{
+	Quat::Convert(Get<Vector3F>(in.vectors3), Out<Quaternion<float>>(pOut), in.count);
+}
+
+// ----------------------------------------- Matrix ----------------------------------------------
+
+static void OpMatrixMultiply(const Inputs& in, float* pOut)
+{
+	const Matrix4F* m0 = Get<Matrix4F>(in.matrices);
+	const Matrix4F* m1 = Get<Matrix4F>(in.generalMatrices);
+	for (uint32_t i = 0; i < in.count; i++) { Out<Matrix4F>(pOut)[i] = m0[i] * m1[i]; }
+}
+
+static void OpInverse(const Inputs& in, float* pOut)
+{
+	const Matrix4F* m = Get<Matrix4F>(in.generalMatrices);
+	for (uint32_t i = 0; i < in.count; i++) { Out<Matrix4F>(pOut)[i] = Matrix::Inverse(m[i]); }
+}
+
+static void OpInverseAffine(const Inputs& in, float* pOut)
+{
+	const Matrix4F* m = Get<Matrix4F>(in.matrices);
+	for (uint32_t i = 0; i < in.count; i++) { Out<Matrix4F>(pOut)[i] = Matrix::InverseAffine(m[i]); }
+}
+
+static void OpInverseRigid(const Inputs& in, float* pOut)
+{
+	const Matrix4F* m = Get<Matrix4F>(in.rigidMatrices);
+	for (uint32_t i = 0; i < in.count; i++) { Out<Matrix4F>(pOut)[i] = Matrix::InverseRigid(m[i]); }
+}
+
+static void OpBatchTransform(const Inputs& in, float* pOut)
+{
+	Matrix::Transform(Get<Matrix4F>(in.matrices)[0], Get<Vector4F>(in.vectors4), Out<Vector4F>(pOut), in.count);
+}
+
+static void OpBatchTransformPoints(const Inputs& in, float* pOut)
+{
+	Matrix::TransformPoints(Get<Matrix4F>(in.matrices)[0], Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpBatchTransformVectors(const Inputs& in, float* pOut)
+{
+	Matrix::TransformVectors(Get<Matrix4F>(in.matrices)[0], Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpBatchMultiplyLeft(const Inputs& in, float* pOut)
+{
+	Matrix::Multiply(Get<Matrix4F>(in.matrices)[0], Get<Matrix4F>(in.generalMatrices), Out<Matrix4F>(pOut), in.count);
+}
+
+static void OpBatchMultiplyRight(const Inputs& in, float* pOut)
+{
+	Matrix::Multiply(Get<Matrix4F>(in.generalMatrices), Get<Matrix4F>(in.matrices)[0], Out<Matrix4F>(pOut), in.count);
+}
+
+static void OpBatchInverseAffine(const Inputs& in, float* pOut)
+{
+	Matrix::InverseAffine(Get<Matrix4F>(in.matrices), Out<Matrix4F>(pOut), in.count);
+}
+
+static void OpBatchInverseRigid(const Inputs& in, float* pOut)
+{
+	Matrix::InverseRigid(Get<Matrix4F>(in.rigidMatrices), Out<Matrix4F>(pOut), in.count);
+}
+
+static void OpAffineMultiply(const Inputs& in, float* pOut)
+{
+	const Matrix3x4F* m = Get<Matrix3x4F>(in.affineMatrices);
+	for (uint32_t i = 0; i < in.count; i++) { Out<Matrix3x4F>(pOut)[i] = m[i] * m[in.count - 1 - i]; }
+}
+
+static void OpAffineTransformPoints(const Inputs& in, float* pOut)
+{
+	Matrix::TransformPoints(Get<Matrix3x4F>(in.affineMatrices)[0], Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpAffineTransformVectors(const Inputs& in, float* pOut)
+{
+	Matrix::TransformVectors(Get<Matrix3x4F>(in.affineMatrices)[0], Get<Vector3F>(in.vectors3), Out<Vector3F>(pOut), in.count);
+}
+
+static void OpAffineMultiplyLeft(const Inputs& in, float* pOut)
+{
+	Matrix::Multiply(Get<Matrix3x4F>(in.affineMatrices)[0], Get<Matrix3x4F>(in.affineMatrices), Out<Matrix3x4F>(pOut), in.count);
+}
+
+static void OpAffineMultiplyRight(const Inputs& in, float* pOut)
+{
+	Matrix::Multiply(Get<Matrix3x4F>(in.affineMatrices), Get<Matrix3x4F>(in.affineMatrices)[0], Out<Matrix3x4F>(pOut), in.count);
+}
+
+static void OpAffineConvert(const Inputs& in, float* pOut)
+{
+	Matrix::Convert(Get<Matrix4F>(in.generalMatrices), Out<Matrix3x4F>(pOut), in.count);
+}
+
+// ------------------------------------------ Table -----------------------------------------------
+
+static const Op OPS[] =
+{
+	{ "SinCos",                               2,  0, OpSinCos                 },
+	{ "ReciprocalSqrt",                       1,  7, OpReciprocalSqrt         },
+	{ "Vector::Normalize(Vector3F)",          3,  0, OpNormalize3             },
+	{ "Vector::Normalize(Vector4F)",          4,  0, OpNormalize4             },
+	{ "Quat::Normalize",                      4,  0, OpQuatNormalize          },
+	{ "Quat::Multiply",                       4,  0, OpQuatMultiply           },
+	{ "Quat::Rotate",                         3,  0, OpQuatRotate             },
+	{ "Quat::Nlerp",                          4,  0, OpQuatNlerp              },
+	{ "Quat::Convert",                        4,  0, OpQuatConvert            },
+	{ "Matrix4F * Matrix4F",                  16, 0, OpMatrixMultiply         },
+	{ "Matrix::Inverse(Matrix4F)",            16, 8, OpInverse                },
+	{ "Matrix::InverseAffine(Matrix4F)",      16, 0, OpInverseAffine          },
+	{ "Matrix::InverseRigid(Matrix4F)",       16, 0, OpInverseRigid           },
+	{ "Matrix::Transform(Matrix4F)",          4,  0, OpBatchTransform         },
+	{ "Matrix::TransformPoints(Matrix4F)",    3,  0, OpBatchTransformPoints   },
+	{ "Matrix::TransformVectors(Matrix4F)",   3,  0, OpBatchTransformVectors  },
+	{ "Matrix::Multiply(m, pIn)",             16, 0, OpBatchMultiplyLeft      },
+	{ "Matrix::Multiply(pIn, m)",             16, 0, OpBatchMultiplyRight     },
+	{ "Matrix::InverseAffine(pIn)",           16, 0, OpBatchInverseAffine     },
+	{ "Matrix::InverseRigid(pIn)",            16, 0, OpBatchInverseRigid      },
+	{ "Matrix3x4F * Matrix3x4F",              12, 0, OpAffineMultiply         },
+	{ "Matrix::TransformPoints(Matrix3x4F)",  3,  0, OpAffineTransformPoints  },
+	{ "Matrix::TransformVectors(Matrix3x4F)", 3,  0, OpAffineTransformVectors },
+	{ "Matrix::Multiply(m, pIn) 3x4",         12, 0, OpAffineMultiplyLeft     },
+	{ "Matrix::Multiply(pIn, m) 3x4",         12, 0, OpAffineMultiplyRight    },
+	{ "Matrix::Convert",                      12, 0, OpAffineConvert          }
+};
@@ -0,0 +1,42 @@
+#ifndef MATH_TESTS__HPP
+#define MATH_TESTS__HPP
+
+#include <cstdint>
+#include <vector>
+
+// Inputs of the comparisons as plain floats, main.cpp (SIMD) and Reference.cpp (scalar) read them as their own CgMath types
+struct Inputs
+{
+	uint32_t           count;
+	std::vector<float> vectors3;        // Vector3F
+	std::vector<float> vectors4;        // Vector4F
+	std::vector<float> quaternions;     // unit Quaternion<float>
+	std::vector<float> matrices;        // Matrix4F, translation * rotation * scale
+	std::vector<float> rigidMatrices;   // Matrix4F, translation * rotation
+	std::vector<float> affineMatrices;  // Matrix3x4F of matrices
+	std::vector<float> generalMatrices; // Matrix4F, well conditioned
+};
+
+// An op writes count * width floats, ulps is 0 when the SIMD result must match the reference bit for bit, otherwise
+// the largest error allowed in units in the last place of the largest reference value of the same element
+struct Op
+{
+	const char* pName;
+	uint32_t    width;
+	uint32_t    ulps;
+	void        (*pFunction)(const Inputs& in, float* pOut);
+};
+
+// Known answers of Checks.cpp, a check prints the failed condition and returns false
+struct Check
+{
+	const char* pName;
+	bool        (*pFunction)(void);
+};
+
+// The ops of MathOps.inl built with CG_MATH_NO_SIMD, in the same order
+const Op* GetReferenceOps(uint32_t& rCount);
+
+const Check* GetChecks(uint32_t& rCount);
+
+#endif // MATH_TESTS__HPP
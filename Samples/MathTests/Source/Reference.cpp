@@ -0,0 +1,34 @@
+// The scalar reference: CgMath built with CG_MATH_NO_SIMD inside its own namespace, so that its templates and the
+// functions of CMath.cpp do not collide with the SIMD build of main.cpp
+
+#ifndef CG_MATH_NO_SIMD
+#define CG_MATH_NO_SIMD
+#endif
+
+// the headers of CgMath.hpp and CMath.cpp stay in the global namespace, their include guards skip them below
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cwchar>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <strsafe.h>
+#endif
+
+#include "MathTests.hpp"
+
+namespace Reference
+{
+#include "CgMath.hpp"
+#include "../../../Source/Math/CMath.cpp"
+#include "MathOps.inl"
+}
+
+const Op* GetReferenceOps(uint32_t& rCount)
+{
+	rCount = sizeof(Reference::OPS) / sizeof(Reference::OPS[0]);
+	return Reference::OPS;
+}
@@ -0,0 +1,183 @@
+// Compares the SIMD kernels of CgMath with the scalar reference (the CG_MATH_NO_SIMD build, see Reference.cpp), then
+// checks known answers (Checks.cpp)
+// Builds from the math sources alone, without the rest of LibCG, so that it also runs on Linux:
+//   g++ -O2 -std=c++20 -march=native -ffp-contract=off -fno-tree-vectorize -I Include Samples/MathTests/Source/main.cpp Samples/MathTests/Source/Reference.cpp Samples/MathTests/Source/Checks.cpp Source/Math/CMath.cpp Source/Math/CMathPack.cpp Source/Math/CMathSimd.cpp -o MathTests
+// The bit exact ops only match when a * b + c is not fused (the MSVC default), hence the two flags for GCC
+// Usage: MathTests [--filter <text>]
+//   --filter only runs the ops and checks whose name contains <text>
+
+#include "CgMath.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "MathTests.hpp"
+
+#include "MathOps.inl"
+
+// Not a multiple of the SIMD widths, the kernels also run their remainder loops
+const uint32_t COUNT = 1027;
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static const char* GetSimdName(void)
+{
+#if CG_MATH_AVX2
+	return "avx2";
+#elif CG_MATH_SSE
+	return "sse";
+#else
+	return "scalar";
+#endif
+}
+
+template <typename T> static void Append(std::vector<float>& rData, const T& value)
+{
+	const float* p = reinterpret_cast<const float*>(&value);
+	rData.insert(rData.end(), p, p + sizeof(T) / sizeof(float));
+}
+
+static void CreateInputs(Inputs& rInputs)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+	rInputs.count = COUNT;
+
+	for (uint32_t i = 0; i < COUNT; i++)
+	{
+		const Vector3F angles(u(rng) * 3.0f, u(rng) * 3.0f, u(rng) * 3.0f);
+		const Vector3F translation(u(rng) * 10.0f, u(rng) * 10.0f, u(rng) * 10.0f);
+		const Quaternion<float> q(angles.x, angles.y, angles.z);
+		const Matrix4F rigid = Matrix::Translate(translation) * Matrix4F(q);
+		const Matrix4F m = rigid * Matrix::Scale(Vector3F(1.0f + u(rng) * 0.5f, 1.0f + u(rng) * 0.5f, 1.0f + u(rng) * 0.5f));
+
+		// m * (I + E) with |E| small enough to keep the condition number close to the one of m
+		Matrix4F e = Matrix::Scale(Vector3F(1.0f, 1.0f, 1.0f));
+		for (uint32_t j = 0; j < 16; j++) { e.elements[j / 4][j % 4] += u(rng) * 0.05f; }
+		const Matrix4F general = m * e;
+
+		Append(rInputs.vectors3, Vector3F(u(rng), u(rng), u(rng)));
+		Append(rInputs.vectors4, Vector4F(u(rng), u(rng), u(rng), u(rng)));
+		Append(rInputs.quaternions, q);
+		Append(rInputs.matrices, m);
+		Append(rInputs.rigidMatrices, rigid);
+		Append(rInputs.affineMatrices, Matrix3x4F(m));
+		Append(rInputs.generalMatrices, general);
+	}
+}
+
+// Largest error of an element in units in the last place of its largest reference value, any NaN or a different
+// infinity counts as an infinite error
+static double GetMaxUlps(const float* pResult, const float* pReference, uint32_t count, uint32_t width)
+{
+	double maxUlps = 0.0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const float* a = pResult + i * width;
+		const float* b = pReference + i * width;
+
+		float scale = 0.0f;
+		for (uint32_t j = 0; j < width; j++) { scale = std::fmax(scale, std::fabs(b[j])); }
+
+		const double ulp = static_cast<double>(std::nextafter(scale, INFINITY)) - static_cast<double>(scale);
+		for (uint32_t j = 0; j < width; j++)
+		{
+			if (a[j] == b[j]) { continue; }
+
+			const double error = std::fabs(static_cast<double>(a[j]) - static_cast<double>(b[j])) / ulp;
+			maxUlps = std::isnan(error) ? INFINITY : std::fmax(maxUlps, error);
+		}
+	}
+
+	return maxUlps;
+}
+
+// ------------------------------------------- Main -----------------------------------------------
+
+int main(int argc, char** argv)
+{
+	const char* pFilter = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc))
+		{
+			pFilter = argv[++i];
+		}
+		else
+		{
+			printf("Usage: %s [--filter <text>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Inputs inputs = {};
+	CreateInputs(inputs);
+
+	uint32_t referenceCount = 0;
+	const Op* pReferenceOps = GetReferenceOps(referenceCount);
+
+	const uint32_t opCount = sizeof(OPS) / sizeof(OPS[0]);
+	if (referenceCount != opCount)
+	{
+		printf("Error: the reference has %u ops instead of %u\n", referenceCount, opCount);
+		return 1;
+	}
+
+	uint32_t failed = 0;
+
+	for (uint32_t i = 0; i < opCount; i++)
+	{
+		const Op& op = OPS[i];
+		if ((pFilter != nullptr) && (strstr(op.pName, pFilter) == nullptr))
+		{
+			continue;
+		}
+
+		std::vector<float> result(COUNT * op.width);
+		std::vector<float> reference(COUNT * op.width);
+		op.pFunction(inputs, result.data());
+		pReferenceOps[i].pFunction(inputs, reference.data());
+
+		bool passed = false;
+		if (op.ulps == 0)
+		{
+			passed = memcmp(result.data(), reference.data(), result.size() * sizeof(float)) == 0;
+			printf("%s %-40s bit exact\n", passed ? "[ OK ]" : "[FAIL]", op.pName);
+		}
+		else
+		{
+			const double ulps = GetMaxUlps(result.data(), reference.data(), COUNT, op.width);
+			passed = ulps <= op.ulps;
+			printf("%s %-40s %.2f ulps (at most %u)\n", passed ? "[ OK ]" : "[FAIL]", op.pName, ulps, op.ulps);
+		}
+
+		failed += passed ? 0 : 1;
+	}
+
+	uint32_t checkCount = 0;
+	const Check* pChecks = GetChecks(checkCount);
+
+	for (uint32_t i = 0; i < checkCount; i++)
+	{
+		const Check& check = pChecks[i];
+		if ((pFilter != nullptr) && (strstr(check.pName, pFilter) == nullptr))
+		{
+			continue;
+		}
+
+		const bool passed = check.pFunction();
+		printf("%s %s\n", passed ? "[ OK ]" : "[FAIL]", check.pName);
+
+		failed += passed ? 0 : 1;
+	}
+
+	printf("simd: %s, %u failed\n", GetSimdName(), failed);
+
+	return (failed == 0) ? 0 : 1;
+}
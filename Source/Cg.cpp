@@ -6,6 +6,7 @@
 
 #include "System/CConsole.hpp"
 #include "System/CMemory.hpp"
+#include "System/CParallel.hpp"
 
 bool CgInitialize(int32_t argc, const wchar_t* argv[]);
 bool CgUninitialize(void);
@@ -61,6 +62,11 @@ bool CgInitialize(int32_t argc, const wchar_t* argv[])
 		status = CConsole::Initialize();
 	}
 
+	if (status)
+	{
+		status = CParallel::Initialize();
+	}
+
 	return status;
 }
 
@@ -68,6 +74,11 @@ bool CgUninitialize(void)
 {
 	bool status = true;
 
+	if (!CParallel::Uninitialize())
+	{
+		status = false;
+	}
+
 	if (!CConsole::Uninitialize())
 	{
 		status = false;
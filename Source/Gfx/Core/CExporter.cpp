@@ -0,0 +1,446 @@
+#include "CExporter.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "Cg.hpp"
+#include "MdlFormat.hpp"
+
+#define WRITE_BUFFER (1 << 20) // bytes gathered before a write to the file
+
+bool Exporter::WriteMdl(const wchar_t* path, const Importer::MDL_DATA& data)
+{
+	MDL_OPTIONS options = { MDL_VERSION_1 };
+
+	return WriteMdl(path, data, options);
+}
+
+bool Exporter::WriteMdl(const wchar_t* path, const Importer::MDL_DATA& data, const MDL_OPTIONS& options)
+{
+	bool status = true;
+
+	// version 0 files have the layout of version 1, they are written back with their version
+	if (options.version > MDL_VERSION_2)
+	{
+		Console::Write(L"Error: Unsupported MDL version %u\n", options.version);
+		status = false;
+	}
+
+	if (status)
+	{
+		MDL_Exporter exporter(data, options.version);
+		status = exporter.Write(path);
+	}
+
+	return status;
+}
+
+MDL_Exporter::MDL_Exporter(const Importer::MDL_DATA& rData, uint32_t version) : m_rData(rData)
+{
+	m_Version = version;
+	m_pFile = nullptr;
+	m_pOut = &m_Buffer;
+}
+
+MDL_Exporter::~MDL_Exporter(void)
+{
+	CgAssert(m_pFile == nullptr, L"MDL file not closed\n");
+}
+
+bool MDL_Exporter::Write(const wchar_t* path)
+{
+	bool status = true;
+
+	m_pFile = File::Open(path, File::WRITE);
+
+	if (m_pFile == nullptr)
+	{
+		status = false;
+	}
+
+	if (status)
+	{
+		m_Buffer.reserve(WRITE_BUFFER);
+		m_pOut = &m_Buffer;
+
+		MDL_HEADER mdl_header = { 0 };
+		mdl_header.signature = MDL_SIG;
+		mdl_header.version = m_Version;
+		WriteBytes(&mdl_header, sizeof(MDL_HEADER));
+
+		if (m_Version >= MDL_VERSION_2)
+		{
+			status = WriteTableOfContents();
+		}
+	}
+
+	if (status)
+	{
+		status = WriteBlocks();
+	}
+
+	if (status)
+	{
+		WriteUInt32(MDL_EOF);
+		status = Flush();
+	}
+
+	if (m_pFile != nullptr)
+	{
+		File::Close(m_pFile);
+		m_pFile = nullptr;
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::WriteTableOfContents(void)
+{
+	bool status = true;
+
+	const size_t meshBlocks = m_rData.meshes.size();
+	const uint32_t count = (m_rData.nodes.empty() ? 0 : 1) + (m_rData.bones.empty() ? 0 : 1) + (m_rData.materials.empty() ? 0 : 1) + static_cast<uint32_t>(meshBlocks);
+
+	MDL_TOC_HEADER toc_header = { 0 };
+	toc_header.signature = MDL_TOC;
+	toc_header.count = count;
+	WriteBytes(&toc_header, sizeof(MDL_TOC_HEADER));
+
+	// the blocks are serialized once here for their sizes and checksums, and again when they are written
+	uint64_t offset = sizeof(MDL_HEADER) + sizeof(MDL_TOC_HEADER) + static_cast<uint64_t>(count) * sizeof(MDL_TOC_ENTRY);
+
+	auto addEntry = [&](uint32_t type, size_t first, size_t length, uint32_t name_hash)
+	{
+		m_Block.clear();
+		m_pOut = &m_Block;
+
+		if (WriteBlock(type, first, length))
+		{
+			MDL_TOC_ENTRY toc_entry = { 0 };
+			toc_entry.type = type;
+			toc_entry.name_hash = name_hash;
+			toc_entry.offset = offset;
+			toc_entry.size = m_Block.size();
+			toc_entry.checksum = MdlChecksum(m_Block.data(), m_Block.size());
+
+			m_pOut = &m_Buffer;
+			WriteBytes(&toc_entry, sizeof(MDL_TOC_ENTRY));
+
+			offset += m_Block.size();
+		}
+		else
+		{
+			status = false;
+		}
+
+		m_pOut = &m_Buffer;
+	};
+
+	if (!m_rData.nodes.empty())
+	{
+		addEntry(MDL_NODE, 0, m_rData.nodes.size(), 0);
+	}
+
+	if (status && !m_rData.bones.empty())
+	{
+		addEntry(MDL_BONE, 0, m_rData.bones.size(), 0);
+	}
+
+	if (status && !m_rData.materials.empty())
+	{
+		addEntry(MDL_MTL, 0, m_rData.materials.size(), 0);
+	}
+
+	for (size_t i = 0; status && (i < meshBlocks); i++)
+	{
+		addEntry(MDL_MESH, i, 1, MdlNameHash(m_rData.meshes[i].name.c_str()));
+	}
+
+	m_Block = std::vector<uint8_t>();
+
+	return status;
+}
+
+bool MDL_Exporter::WriteBlocks(void)
+{
+	bool status = true;
+
+	if (!m_rData.nodes.empty())
+	{
+		status = WriteBlock(MDL_NODE, 0, m_rData.nodes.size());
+	}
+
+	if (status && !m_rData.bones.empty())
+	{
+		status = WriteBlock(MDL_BONE, 0, m_rData.bones.size());
+	}
+
+	if (status && !m_rData.materials.empty())
+	{
+		status = WriteBlock(MDL_MTL, 0, m_rData.materials.size());
+	}
+
+	if (status && !m_rData.meshes.empty())
+	{
+		if (m_Version >= MDL_VERSION_2)
+		{
+			for (size_t i = 0; status && (i < m_rData.meshes.size()); i++)
+			{
+				status = WriteBlock(MDL_MESH, i, 1);
+			}
+		}
+		else
+		{
+			status = WriteBlock(MDL_MESH, 0, m_rData.meshes.size());
+		}
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::Flush(void)
+{
+	bool status = true;
+
+	for (size_t written = 0; status && (written < m_Buffer.size()); )
+	{
+		const uint32_t numBytes = (m_Buffer.size() - written > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(m_Buffer.size() - written);
+
+		status = m_pFile->WriteBytes(m_Buffer.data() + written, numBytes);
+		written += numBytes;
+	}
+
+	m_Buffer.clear();
+
+	return status;
+}
+
+void MDL_Exporter::WriteBytes(const void* pBuffer, size_t numBytes)
+{
+	const uint8_t* pBytes = static_cast<const uint8_t*>(pBuffer);
+
+	m_pOut->insert(m_pOut->end(), pBytes, pBytes + numBytes);
+}
+
+void MDL_Exporter::WriteUInt32(uint32_t value)
+{
+	WriteBytes(&value, sizeof(uint32_t));
+}
+
+bool MDL_Exporter::WriteBlock(uint32_t type, size_t first, size_t count)
+{
+	bool status = true;
+
+	if (count > UINT32_MAX)
+	{
+		Console::Write(L"Error: MDL list too large\n");
+		status = false;
+	}
+
+	if (status)
+	{
+		MDL_BLOCK_HEADER block_header = { 0 };
+		block_header.signature = MDL_BLOCK;
+		block_header.type = type;
+		WriteBytes(&block_header, sizeof(MDL_BLOCK_HEADER));
+
+		WriteListHeader(type, static_cast<uint32_t>(count));
+	}
+
+	for (size_t i = first; status && (i < first + count); i++)
+	{
+		if (type == MDL_NODE)
+		{
+			status = WriteNode(m_rData.nodes[i]);
+		}
+		else if (type == MDL_BONE)
+		{
+			status = WriteBone(m_rData.bones[i]);
+		}
+		else if (type == MDL_MTL)
+		{
+			status = WriteMtl(m_rData.materials[i]);
+		}
+		else
+		{
+			status = WriteMesh(m_rData.meshes[i]);
+		}
+
+		// the file is written a buffer at a time, and never while a block is gathered for its checksum
+		if (status && (m_pOut == &m_Buffer) && (m_Buffer.size() >= WRITE_BUFFER))
+		{
+			status = Flush();
+		}
+	}
+
+	if (status)
+	{
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::WriteNode(const Importer::Node& node)
+{
+	bool status = true;
+
+	WriteUInt32(MDL_NODE);
+
+	status = WriteString(node.name) && WriteString(node.parent);
+
+	if (status)
+	{
+		WriteMatrix(node.matrix);
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::WriteBone(const Importer::Bone& bone)
+{
+	bool status = true;
+
+	WriteUInt32(MDL_BONE);
+
+	status = WriteString(bone.name);
+
+	if (status)
+	{
+		WriteMatrix(bone.offset_matrix);
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::WriteMtl(const Importer::Material& mtl)
+{
+	bool status = true;
+
+	WriteUInt32(MDL_MTL);
+
+	status = WriteString(mtl.name) && WriteString(mtl.texture);
+
+	if (status)
+	{
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+bool MDL_Exporter::WriteMesh(const Importer::Mesh& mesh)
+{
+	bool status = true;
+
+	// the same limits as the importer
+	if (mesh.vertices.size() > UINT32_MAX / sizeof(MDL_VERTEX_DATA))
+	{
+		Console::Write(L"Error: Vertex list too large\n");
+		status = false;
+	}
+	else if (mesh.indices.size() > UINT32_MAX / sizeof(uint16_t))
+	{
+		Console::Write(L"Error: Index list too large\n");
+		status = false;
+	}
+
+	if (status)
+	{
+		WriteUInt32(MDL_MESH);
+
+		status = WriteString(mesh.name);
+	}
+
+	if (status)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+		WriteListHeader(MDL_VERTEX, vertexCount);
+
+		// the records are filled in place, resize zeroes their padding
+		const size_t base = m_pOut->size();
+		m_pOut->resize(base + static_cast<size_t>(vertexCount) * sizeof(MDL_VERTEX_DATA));
+
+		uint8_t* pRecord = m_pOut->data() + base;
+		const uint16_t signature = MDL_VERTEX;
+
+		for (uint32_t i = 0; i < vertexCount; i++, pRecord += sizeof(MDL_VERTEX_DATA))
+		{
+			const Importer::Vertex& vertex = mesh.vertices[i];
+
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, signature), &signature, sizeof(uint16_t));
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, position), vertex.position, sizeof(vertex.position));
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, normal), vertex.normal, sizeof(vertex.normal));
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, uv), vertex.uv, sizeof(vertex.uv));
+			pRecord[offsetof(MDL_VERTEX_DATA, node_index)] = vertex.node_index;
+			pRecord[offsetof(MDL_VERTEX_DATA, bone_count)] = vertex.bone_count;
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, bone_indices), vertex.bone_indices, sizeof(vertex.bone_indices));
+			memcpy(pRecord + offsetof(MDL_VERTEX_DATA, bone_weights), vertex.bone_weights, sizeof(vertex.bone_weights));
+		}
+
+		WriteUInt32(MDL_END);
+
+		WriteListHeader(MDL_INDEX, static_cast<uint32_t>(mesh.indices.size()));
+		WriteBytes(mesh.indices.data(), mesh.indices.size() * sizeof(uint16_t));
+		WriteUInt32(MDL_END);
+
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+void MDL_Exporter::WriteListHeader(uint32_t type, uint32_t length)
+{
+	MDL_LIST_HEADER list_header = { 0 };
+	list_header.signature = MDL_LIST;
+	list_header.type = type;
+	list_header.length = length;
+
+	WriteBytes(&list_header, sizeof(MDL_LIST_HEADER));
+}
+
+bool MDL_Exporter::WriteString(const std::string& string)
+{
+	bool status = true;
+
+	// strings read from a file keep their terminator, others get one
+	size_t length = string.size();
+
+	if ((length > 0) && (string[length - 1] == 0))
+	{
+		length--;
+	}
+
+	if ((length >= 255) || (memchr(string.data(), 0, length) != nullptr))
+	{
+		Console::Write(L"Error: String %hs can not be written\n", string.c_str());
+		status = false;
+	}
+
+	if (status)
+	{
+		MDL_STRING_HEADER string_header;
+		memset(&string_header, 0, sizeof(MDL_STRING_HEADER));
+		string_header.signature = MDL_STRING;
+		string_header.length = static_cast<uint8_t>(length + 1);
+		WriteBytes(&string_header, sizeof(MDL_STRING_HEADER));
+
+		WriteBytes(string.c_str(), length + 1);
+		WriteUInt32(MDL_END);
+	}
+
+	return status;
+}
+
+void MDL_Exporter::WriteMatrix(const float* pMatrix)
+{
+	MDL_MATRIX_DATA matrix_data = { 0 };
+	matrix_data.signature = MDL_MATRIX4;
+	memcpy(matrix_data.elements, pMatrix, sizeof(matrix_data.elements));
+
+	WriteBytes(&matrix_data, sizeof(MDL_MATRIX_DATA));
+	WriteUInt32(MDL_END);
+}
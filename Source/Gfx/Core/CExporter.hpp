@@ -0,0 +1,41 @@
+#ifndef CG_EXPORTER_HPP
+#define CG_EXPORTER_HPP
+
+#include "CgExporter.hpp"
+
+class MDL_Exporter
+{
+private:
+	const Importer::MDL_DATA& m_rData;
+	uint32_t                  m_Version;
+	class File*               m_pFile;
+	std::vector<uint8_t>      m_Buffer;  // written to the file when full
+	std::vector<uint8_t>      m_Block;   // one block, for the checksums of the table of contents
+	std::vector<uint8_t>*     m_pOut;
+
+public:
+	MDL_Exporter(const Importer::MDL_DATA& rData, uint32_t version);
+	~MDL_Exporter(void);
+
+	bool Write(const wchar_t* path);
+
+private:
+	bool WriteTableOfContents(void);
+	bool WriteBlocks(void);
+	bool Flush(void);
+
+	void WriteBytes(const void* pBuffer, size_t numBytes);
+	void WriteUInt32(uint32_t value);
+
+	bool WriteBlock(uint32_t type, size_t first, size_t count);
+	bool WriteNode(const Importer::Node& node);
+	bool WriteBone(const Importer::Bone& bone);
+	bool WriteMtl(const Importer::Material& mtl);
+	bool WriteMesh(const Importer::Mesh& mesh);
+
+	void WriteListHeader(uint32_t type, uint32_t length);
+	bool WriteString(const std::string& string);
+	void WriteMatrix(const float* pMatrix);
+};
+
+#endif // CG_EXPORTER_HPP
@@ -1,8 +1,98 @@
 #include "CImporter.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
 #include "Cg.hpp"
 #include "MdlFormat.hpp"
 
+#if CG_MATH_AVX2
+#include <immintrin.h>
+#endif
+
+#define DECODE_VERTICES 16384 // vertices per parallel range of DecodeMeshes
+
+// ------------------------------------------ Checksum --------------------------------------------
+
+// CRC-32C tables for eight bytes at a time, table k advances the CRC of a byte by k more bytes
+struct CRC32C_TABLES
+{
+	uint32_t entries[8][256];
+
+	constexpr CRC32C_TABLES() : entries{}
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i;
+			for (uint32_t bit = 0; bit < 8; bit++)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+			}
+			entries[0][i] = crc;
+		}
+
+		for (uint32_t k = 1; k < 8; k++)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				entries[k][i] = (entries[k - 1][i] >> 8) ^ entries[0][entries[k - 1][i] & 0xFF];
+			}
+		}
+	}
+};
+
+static constexpr CRC32C_TABLES s_Crc32c;
+
+uint32_t MdlChecksum(const void* pData, size_t size)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(pData);
+	uint32_t crc = 0xFFFFFFFF;
+
+#if CG_MATH_AVX2 && (defined(_M_X64) || defined(__x86_64__))
+	// SSE4.2 CRC32 instruction, present on every AVX2 CPU
+	for (; size >= 8; size -= 8, p += 8)
+	{
+		uint64_t v = 0;
+		memcpy(&v, p, sizeof(uint64_t));
+		crc = static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+	}
+#else
+	for (; size >= 8; size -= 8, p += 8)
+	{
+		uint32_t lo = 0;
+		uint32_t hi = 0;
+		memcpy(&lo, p, sizeof(uint32_t));
+		memcpy(&hi, p + 4, sizeof(uint32_t));
+		lo ^= crc;
+
+		crc = s_Crc32c.entries[7][lo & 0xFF] ^ s_Crc32c.entries[6][(lo >> 8) & 0xFF] ^ s_Crc32c.entries[5][(lo >> 16) & 0xFF] ^ s_Crc32c.entries[4][lo >> 24] ^
+		      s_Crc32c.entries[3][hi & 0xFF] ^ s_Crc32c.entries[2][(hi >> 8) & 0xFF] ^ s_Crc32c.entries[1][(hi >> 16) & 0xFF] ^ s_Crc32c.entries[0][hi >> 24];
+	}
+#endif
+
+	for (; size > 0; size--, p++)
+	{
+		crc = s_Crc32c.entries[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+uint32_t MdlNameHash(const char* pName)
+{
+	uint32_t hash = 0x811C9DC5;
+
+	for (; *pName != 0; pName++)
+	{
+		hash = (hash ^ static_cast<uint8_t>(*pName)) * 0x01000193;
+	}
+
+	return hash;
+}
+
+// ------------------------------------------ Importer --------------------------------------------
+
 bool Importer::ReadMdl(const wchar_t* path, MDL_DATA& rData)
 {
 	bool status = true;
@@ -17,14 +107,263 @@ bool Importer::ReadMdl(const wchar_t* path, MDL_DATA& rData)
 	return status;
 }
 
-MDL_Importer::MDL_Importer(Importer::MDL_DATA& rData) : m_rData(rData)
+bool Importer::MapMdl(const wchar_t* path, MDL_VIEW& rView)
+{
+	bool status = true;
+
+	UnmapMdl(rView);
+
+	MDL_Importer importer(rView);
+
+	if (!importer.Map(path))
+	{
+		UnmapMdl(rView);
+		status = false;
+	}
+
+	return status;
+}
+
+void Importer::UnmapMdl(MDL_VIEW& rView)
+{
+	if (rView.pFile != nullptr)
+	{
+		MappedFile::Close(rView.pFile);
+		rView.pFile = nullptr;
+	}
+
+	rView.nodes.clear();
+	rView.bones.clear();
+	rView.meshes.clear();
+	rView.materials.clear();
+	rView.blocks.clear();
+	rView.version = 0;
+}
+
+bool Importer::OpenMdl(const wchar_t* path, MDL_VIEW& rView)
+{
+	bool status = true;
+
+	UnmapMdl(rView);
+
+	MDL_Importer importer(rView);
+
+	if (!importer.Open(path))
+	{
+		UnmapMdl(rView);
+		status = false;
+	}
+
+	return status;
+}
+
+bool Importer::LoadMdlBlock(MDL_VIEW& rView, uint32_t block)
+{
+	bool status = true;
+
+	if ((rView.pFile == nullptr) || (block >= rView.blocks.size()))
+	{
+		Console::Write(L"Error: Invalid MDL block %u\n", block);
+		status = false;
+	}
+
+	if (status && !rView.blocks[block].loaded)
+	{
+		MDL_Importer importer(rView);
+		status = importer.LoadBlock(block);
+	}
+
+	return status;
+}
+
+bool Importer::LoadMdlMesh(MDL_VIEW& rView, const char* pName)
+{
+	bool status = true;
+
+	// the names read from the file keep their terminator
+	auto findMesh = [&]()
+	{
+		bool found = false;
+		for (size_t i = 0; !found && (i < rView.meshes.size()); i++)
+		{
+			found = (strcmp(rView.meshes[i].name.c_str(), pName) == 0);
+		}
+		return found;
+	};
+
+	bool found = findMesh();
+
+	// on an error the blocks loaded here are unloaded again, LoadMdlBlock already undid the one that failed
+	const size_t nodeCount = rView.nodes.size();
+	const size_t boneCount = rView.bones.size();
+	const size_t meshCount = rView.meshes.size();
+	const size_t materialCount = rView.materials.size();
+	std::vector<uint32_t> loaded;
+
+	const uint32_t hash = MdlNameHash(pName);
+	for (uint32_t i = 0; status && !found && (i < rView.blocks.size()); i++)
+	{
+		const BlockInfo& block = rView.blocks[i];
+
+		if ((block.type == MDL_MESH) && (block.nameHash == hash) && !block.loaded)
+		{
+			status = LoadMdlBlock(rView, i);
+			found = status && findMesh();
+
+			if (status)
+			{
+				loaded.push_back(i);
+			}
+		}
+	}
+
+	if (status && !found)
+	{
+		Console::Write(L"Error: Mesh %hs not found\n", pName);
+		status = false;
+	}
+
+	if (!status)
+	{
+		rView.nodes.resize(nodeCount);
+		rView.bones.resize(boneCount);
+		rView.meshes.resize(meshCount);
+		rView.materials.resize(materialCount);
+
+		for (uint32_t i : loaded)
+		{
+			rView.blocks[i].loaded = false;
+		}
+	}
+
+	return status;
+}
+
+bool Importer::GetPositions(const std::vector<Vertex>& vertices, Vector3SoA& rPositions)
 {
-	m_pFile = nullptr;
+	return rPositions.Load(reinterpret_cast<const uint8_t*>(vertices.data()) + offsetof(Vertex, position), sizeof(Vertex), static_cast<uint32_t>(vertices.size()));
+}
+
+bool Importer::GetNormals(const std::vector<Vertex>& vertices, Vector3SoA& rNormals)
+{
+	return rNormals.Load(reinterpret_cast<const uint8_t*>(vertices.data()) + offsetof(Vertex, normal), sizeof(Vertex), static_cast<uint32_t>(vertices.size()));
+}
+
+void Importer::SetPositions(const Vector3SoA& positions, std::vector<Vertex>& vertices)
+{
+	vertices.resize(positions.count);
+	positions.Store(reinterpret_cast<uint8_t*>(vertices.data()) + offsetof(Vertex, position), sizeof(Vertex));
+}
+
+void Importer::SetNormals(const Vector3SoA& normals, std::vector<Vertex>& vertices)
+{
+	vertices.resize(normals.count);
+	normals.Store(reinterpret_cast<uint8_t*>(vertices.data()) + offsetof(Vertex, normal), sizeof(Vertex));
+}
+
+bool Importer::GetPositions(const MeshView& mesh, Vector3SoA& rPositions)
+{
+	return rPositions.Load(mesh.pVertices + offsetof(Vertex, position), mesh.vertexStride, mesh.vertexCount);
+}
+
+bool Importer::GetNormals(const MeshView& mesh, Vector3SoA& rNormals)
+{
+	return rNormals.Load(mesh.pVertices + offsetof(Vertex, normal), mesh.vertexStride, mesh.vertexCount);
+}
+
+void Importer::GetVertices(const MeshView& mesh, std::vector<Vertex>& rVertices)
+{
+	rVertices.resize(mesh.vertexCount);
+
+	for (uint32_t i = 0; i < mesh.vertexCount; i++)
+	{
+		memcpy(&rVertices[i], mesh.pVertices + static_cast<size_t>(i) * mesh.vertexStride, sizeof(Vertex));
+	}
+}
+
+void Importer::GetIndices(const MeshView& mesh, std::vector<uint16_t>& rIndices)
+{
+	rIndices.resize(mesh.indexCount);
+
+	if (mesh.indexCount > 0)
+	{
+		memcpy(rIndices.data(), mesh.pIndices, mesh.indexCount * sizeof(uint16_t));
+	}
+}
+
+// The vertex records of the file are a signature followed by the fields of Importer::Vertex at the same offsets
+static_assert(offsetof(MDL_VERTEX_DATA, normal) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, normal), "MDL vertex layout");
+static_assert(offsetof(MDL_VERTEX_DATA, uv) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, uv), "MDL vertex layout");
+static_assert(offsetof(MDL_VERTEX_DATA, node_index) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, node_index), "MDL vertex layout");
+static_assert(offsetof(MDL_VERTEX_DATA, bone_count) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, bone_count), "MDL vertex layout");
+static_assert(offsetof(MDL_VERTEX_DATA, bone_indices) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, bone_indices), "MDL vertex layout");
+static_assert(offsetof(MDL_VERTEX_DATA, bone_weights) - offsetof(MDL_VERTEX_DATA, position) == offsetof(Importer::Vertex, bone_weights), "MDL vertex layout");
+static_assert(sizeof(MDL_VERTEX_DATA) - offsetof(MDL_VERTEX_DATA, position) == sizeof(Importer::Vertex), "MDL vertex layout");
+
+MDL_Importer::MDL_Importer(Importer::MDL_DATA& rData) : m_rNodes(rData.nodes), m_rBones(rData.bones), m_rMaterials(rData.materials)
+{
+	m_pMappedFile = nullptr;
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+	m_pMeshes = &rData.meshes;
+	m_pMeshViews = &m_MeshViews;
+	m_pBlocks = nullptr;
+	m_pVersion = nullptr;
+	m_ppViewFile = nullptr;
+	m_Version = 0;
+}
+
+MDL_Importer::MDL_Importer(Importer::MDL_VIEW& rView) : m_rNodes(rView.nodes), m_rBones(rView.bones), m_rMaterials(rView.materials)
+{
+	m_pMappedFile = nullptr;
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+	m_pMeshes = nullptr;
+	m_pMeshViews = &rView.meshes;
+	m_pBlocks = &rView.blocks;
+	m_pVersion = &rView.version;
+	m_ppViewFile = &rView.pFile;
+	m_Version = rView.version;
 }
 
 MDL_Importer::~MDL_Importer(void)
 {
-	CgAssert(m_pFile == nullptr, L"MDL file not closed\n");
+	CgAssert(m_pMappedFile == nullptr, L"MDL file not closed\n");
+}
+
+bool MDL_Importer::ReadBytes(void* pBuffer, uint32_t numBytes)
+{
+	bool status = true;
+
+	const uint8_t* pBytes = MapBytes(numBytes);
+
+	if (pBytes != nullptr)
+	{
+		memcpy(pBuffer, pBytes, numBytes);
+	}
+	else
+	{
+		status = false;
+	}
+
+	return status;
+}
+
+const uint8_t* MDL_Importer::MapBytes(uint32_t numBytes)
+{
+	const uint8_t* pBytes = nullptr;
+
+	if (static_cast<size_t>(m_pEnd - m_pCursor) >= numBytes)
+	{
+		pBytes = m_pCursor;
+		m_pCursor += numBytes;
+	}
+	else
+	{
+		Console::Write(L"Error: Unexpected end of MDL file\n");
+	}
+
+	return pBytes;
 }
 
 bool MDL_Importer::ReadSignature(uint32_t expected_signature)
@@ -33,7 +372,7 @@ bool MDL_Importer::ReadSignature(uint32_t expected_signature)
 
 	uint32_t signature = 0;
 
-	if (m_pFile->Read(&signature))
+	if (ReadBytes(&signature, sizeof(uint32_t)))
 	{
 		if (signature != expected_signature)
 		{
@@ -53,22 +392,224 @@ bool MDL_Importer::Read(const wchar_t* path)
 {
 	bool status = true;
 
-	m_pFile = File::Open(path);
+	m_pMappedFile = MappedFile::Open(path);
+
+	if (m_pMappedFile == nullptr)
+	{
+		status = false;
+	}
+
+	// the structure is walked first, then the meshes are copied out of the mapping in parallel
+	if (status)
+	{
+		m_pCursor = m_pMappedFile->GetData();
+		m_pEnd = m_pCursor + m_pMappedFile->GetSize();
+
+		status = ReadHeader() && ReadBlocks() && DecodeMeshes(0);
+	}
+
+	if (m_pMappedFile != nullptr)
+	{
+		MappedFile::Close(m_pMappedFile);
+		m_pMappedFile = nullptr;
+	}
+
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+
+	return status;
+}
+
+bool MDL_Importer::Map(const wchar_t* path)
+{
+	bool status = true;
+
+	m_pMappedFile = MappedFile::Open(path);
+
+	if (m_pMappedFile == nullptr)
+	{
+		status = false;
+	}
+
+	if (status)
+	{
+		m_pCursor = m_pMappedFile->GetData();
+		m_pEnd = m_pCursor + m_pMappedFile->GetSize();
+
+		status = ReadHeader() && ReadBlocks() && DecodeMeshes(0);
+	}
+
+	// the mapping is handed to the view, the meshes point into it
+	if (m_pMappedFile != nullptr)
+	{
+		*m_ppViewFile = m_pMappedFile;
+		m_pMappedFile = nullptr;
+	}
+
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+
+	return status;
+}
+
+bool MDL_Importer::Open(const wchar_t* path)
+{
+	bool status = true;
+
+	m_pMappedFile = MappedFile::Open(path);
 
-	if (m_pFile == nullptr)
+	if (m_pMappedFile == nullptr)
 	{
 		status = false;
 	}
 
 	if (status)
 	{
-		MDL_HEADER mdl_header = { 0 };
+		m_pCursor = m_pMappedFile->GetData();
+		m_pEnd = m_pCursor + m_pMappedFile->GetSize();
 
-		if (m_pFile->ReadBytes(&mdl_header, sizeof(MDL_HEADER)))
+		status = ReadHeader();
+	}
+
+	// without a table of contents the blocks are found by reading them
+	if (status && (m_Version < MDL_VERSION_2))
+	{
+		status = ReadBlocks() && DecodeMeshes(0);
+	}
+
+	if (m_pMappedFile != nullptr)
+	{
+		*m_ppViewFile = m_pMappedFile;
+		m_pMappedFile = nullptr;
+	}
+
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+
+	return status;
+}
+
+bool MDL_Importer::LoadBlock(uint32_t block)
+{
+	bool status = true;
+
+	Importer::BlockInfo& rBlock = (*m_pBlocks)[block];
+	MappedFile* pFile = *m_ppViewFile;
+
+	// a block that fails to load leaves the view as it was, so that it can be loaded again
+	const size_t nodeCount = m_rNodes.size();
+	const size_t boneCount = m_rBones.size();
+	const size_t materialCount = m_rMaterials.size();
+	const size_t firstMesh = m_pMeshViews->size();
+
+	if ((rBlock.offset > pFile->GetSize()) || (rBlock.size > pFile->GetSize() - rBlock.offset))
+	{
+		Console::Write(L"Error: MDL block %u is outside the file\n", block);
+		status = false;
+	}
+
+	if (status)
+	{
+		m_pCursor = pFile->GetData() + rBlock.offset;
+		m_pEnd = m_pCursor + rBlock.size;
+
+		if ((m_Version >= MDL_VERSION_2) && (MdlChecksum(m_pCursor, static_cast<size_t>(rBlock.size)) != rBlock.checksum))
+		{
+			Console::Write(L"Error: MDL block %u checksum mismatch\n", block);
+			status = false;
+		}
+	}
+
+	MDL_BLOCK_HEADER block_header = { 0 };
+
+	if (status)
+	{
+		status = ReadBytes(&block_header, sizeof(MDL_BLOCK_HEADER));
+	}
+
+	if (status && ((block_header.signature != MDL_BLOCK) || (block_header.type != rBlock.type)))
+	{
+		Console::Write(L"Error: Expected MDL block\n");
+		status = false;
+	}
+
+	if (status)
+	{
+		status = ReadBlock(block_header);
+	}
+
+	if (status)
+	{
+		status = DecodeMeshes(firstMesh);
+	}
+
+	if (status && (m_pCursor != m_pEnd))
+	{
+		Console::Write(L"Error: MDL block %u size mismatch\n", block);
+		status = false;
+	}
+
+	if (status)
+	{
+		rBlock.loaded = true;
+	}
+	else
+	{
+		m_rNodes.resize(nodeCount);
+		m_rBones.resize(boneCount);
+		m_rMaterials.resize(materialCount);
+		m_pMeshViews->resize(firstMesh);
+	}
+
+	m_pCursor = nullptr;
+	m_pEnd = nullptr;
+
+	return status;
+}
+
+bool MDL_Importer::ReadHeader(void)
+{
+	bool status = true;
+
+	MDL_HEADER mdl_header = { 0 };
+
+	if (ReadBytes(&mdl_header, sizeof(MDL_HEADER)))
+	{
+		if (mdl_header.signature != MDL_SIG)
+		{
+			Console::Write(L"Error: Invalid MDL signature\n");
+			status = false;
+		}
+		else if (mdl_header.version > MDL_VERSION_2)
+		{
+			Console::Write(L"Error: Unsupported MDL version %u\n", mdl_header.version);
+			status = false;
+		}
+	}
+	else
+	{
+		status = false;
+	}
+
+	if (status)
+	{
+		m_Version = mdl_header.version;
+
+		if (m_pVersion != nullptr)
+		{
+			*m_pVersion = m_Version;
+		}
+	}
+
+	if (status && (m_Version >= MDL_VERSION_2))
+	{
+		MDL_TOC_HEADER toc_header = { 0 };
+
+		if (ReadBytes(&toc_header, sizeof(MDL_TOC_HEADER)))
 		{
-			if (mdl_header.signature != MDL_SIG)
+			if (toc_header.signature != MDL_TOC)
 			{
-				Console::Write(L"Error: Invalid MDL signature\n");
+				Console::Write(L"Error: Expected MDL table of contents\n");
 				status = false;
 			}
 		}
@@ -76,52 +617,214 @@ bool MDL_Importer::Read(const wchar_t* path)
 		{
 			status = false;
 		}
+
+		for (uint32_t i = 0; status && (i < toc_header.count); i++)
+		{
+			MDL_TOC_ENTRY toc_entry = { 0 };
+			status = ReadBytes(&toc_entry, sizeof(MDL_TOC_ENTRY));
+
+			if (status)
+			{
+				m_Toc.push_back(TOC_BLOCK{ toc_entry.offset, toc_entry.size, toc_entry.checksum, i });
+			}
+
+			if (status && (m_pBlocks != nullptr))
+			{
+				m_pBlocks->push_back(Importer::BlockInfo{ toc_entry.type, toc_entry.name_hash, toc_entry.offset, toc_entry.size, toc_entry.checksum, false });
+			}
+		}
+
+		// ReadBlocks looks the blocks up by offset
+		std::sort(m_Toc.begin(), m_Toc.end(), [](const TOC_BLOCK& a, const TOC_BLOCK& b) { return a.offset < b.offset; });
 	}
 
-	if (status)
+	return status;
+}
+
+bool MDL_Importer::ReadBlocks(void)
+{
+	bool status = true;
+
+	uint32_t next_uint32 = 0;
+	while (status)
 	{
-		uint32_t next_uint32 = 0;
-		while (true)
+		const uint8_t* pBlock = m_pCursor;
+		const uint64_t offset = static_cast<uint64_t>(pBlock - m_pMappedFile->GetData());
+
+		if (ReadBytes(&next_uint32, sizeof(uint32_t)))
 		{
-			if (m_pFile->Read(&next_uint32))
+			if (next_uint32 == MDL_BLOCK)
 			{
-				if (next_uint32 == MDL_BLOCK)
+				// version 2 blocks are checked against their table of contents entry before they are parsed, like LoadBlock
+				const TOC_BLOCK* pEntry = nullptr;
+
+				if (m_Version >= MDL_VERSION_2)
 				{
-					MDL_BLOCK_HEADER block_header = { 0 };
-					block_header.signature = next_uint32;
+					auto it = std::lower_bound(m_Toc.begin(), m_Toc.end(), offset, [](const TOC_BLOCK& entry, uint64_t value) { return entry.offset < value; });
 
-					if (m_pFile->ReadBytes(reinterpret_cast<uint8_t*>(&block_header) + sizeof(uint32_t), sizeof(MDL_BLOCK_HEADER) - sizeof(uint32_t))) // read the rest of the header
+					if ((it == m_Toc.end()) || (it->offset != offset))
 					{
-						status = ReadBlock(block_header);
+						Console::Write(L"Error: MDL block is not in the table of contents\n");
+						status = false;
 					}
-					else
+					else if (it->size > static_cast<uint64_t>(m_pEnd - pBlock))
 					{
+						Console::Write(L"Error: MDL block %u is outside the file\n", it->index);
 						status = false;
 					}
+					else if (MdlChecksum(pBlock, static_cast<size_t>(it->size)) != it->checksum)
+					{
+						Console::Write(L"Error: MDL block %u checksum mismatch\n", it->index);
+						status = false;
+					}
+					else
+					{
+						pEntry = &(*it);
+					}
+				}
+
+				MDL_BLOCK_HEADER block_header = { 0 };
+				block_header.signature = next_uint32;
+
+				if (status && ReadBytes(reinterpret_cast<uint8_t*>(&block_header) + sizeof(uint32_t), sizeof(MDL_BLOCK_HEADER) - sizeof(uint32_t))) // read the rest of the header
+				{
+					status = ReadBlock(block_header);
 				}
 				else
 				{
-					break;
+					status = false;
+				}
+
+				if (status && (pEntry != nullptr) && (static_cast<uint64_t>(m_pCursor - pBlock) != pEntry->size))
+				{
+					Console::Write(L"Error: MDL block %u size mismatch\n", pEntry->index);
+					status = false;
+				}
+
+				// mapped files list their blocks, version 1 files as they are read
+				if (status && (m_pBlocks != nullptr))
+				{
+					if (m_Version < MDL_VERSION_2)
+					{
+						m_pBlocks->push_back(Importer::BlockInfo{ block_header.type, 0, offset, static_cast<uint64_t>(m_pCursor - pBlock), 0, true });
+					}
+					else
+					{
+						(*m_pBlocks)[pEntry->index].loaded = true;
+					}
 				}
 			}
 			else
 			{
-				status = false;
 				break;
 			}
 		}
-
-		if (next_uint32 != MDL_EOF)
+		else
 		{
-			Console::Write(L"Error: Expected MDL EOF\n");
 			status = false;
 		}
 	}
 
-	if (m_pFile != nullptr)
+	if (status && (next_uint32 != MDL_EOF))
+	{
+		Console::Write(L"Error: Expected MDL EOF\n");
+		status = false;
+	}
+
+	return status;
+}
+
+bool MDL_Importer::DecodeMeshes(size_t firstMesh)
+{
+	bool status = true;
+
+	std::vector<Importer::MeshView>& rViews = *m_pMeshViews;
+
+	// the vertex lists are split in ranges so that a large mesh is spread over the workers too
+	struct RANGE
+	{
+		uint32_t mesh;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	std::vector<RANGE> ranges;
+
+	for (size_t i = firstMesh; i < rViews.size(); i++)
+	{
+		for (uint32_t first = 0; first < rViews[i].vertexCount; first += DECODE_VERTICES)
+		{
+			const uint32_t count = (rViews[i].vertexCount - first < DECODE_VERTICES) ? rViews[i].vertexCount - first : DECODE_VERTICES;
+			ranges.push_back(RANGE{ static_cast<uint32_t>(i), first, count });
+		}
+	}
+
+	// Read copies the lists, each mesh and each range has its own slot so the result does not depend on the scheduling
+	// the meshes are appended after the ones already in the output, like the views after firstMesh
+	const size_t firstOutput = (m_pMeshes != nullptr) ? m_pMeshes->size() : 0;
+
+	if (m_pMeshes != nullptr)
+	{
+		m_pMeshes->resize(firstOutput + (rViews.size() - firstMesh));
+
+		auto allocate = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const Importer::MeshView& view = rViews[firstMesh + i];
+				Importer::Mesh& rMesh = (*m_pMeshes)[firstOutput + i];
+
+				rMesh.name = view.name;
+				rMesh.vertices.resize(view.vertexCount);
+				Importer::GetIndices(view, rMesh.indices);
+			}
+		};
+
+		Parallel::For(static_cast<uint32_t>(rViews.size() - firstMesh), 1, allocate);
+	}
+
+	std::vector<uint8_t> valid(ranges.size(), 0);
+
+	auto decode = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t r = begin; r < end; r++)
+		{
+			const RANGE& range = ranges[r];
+			const Importer::MeshView& view = rViews[range.mesh];
+			const uint8_t* pRecord = view.pVertices + static_cast<size_t>(range.first) * view.vertexStride - offsetof(MDL_VERTEX_DATA, position);
+
+			uint32_t mismatches = 0;
+			for (uint32_t i = 0; i < range.count; i++, pRecord += view.vertexStride)
+			{
+				uint16_t signature = 0;
+				memcpy(&signature, pRecord + offsetof(MDL_VERTEX_DATA, signature), sizeof(uint16_t));
+				mismatches += (signature != MDL_VERTEX);
+			}
+
+			if ((mismatches == 0) && (m_pMeshes != nullptr))
+			{
+				Importer::Vertex* pVertex = (*m_pMeshes)[firstOutput + (range.mesh - firstMesh)].vertices.data() + range.first;
+				pRecord = view.pVertices + static_cast<size_t>(range.first) * view.vertexStride;
+
+				for (uint32_t i = 0; i < range.count; i++, pRecord += view.vertexStride)
+				{
+					memcpy(&pVertex[i], pRecord, sizeof(Importer::Vertex));
+				}
+			}
+
+			valid[r] = (mismatches == 0);
+		}
+	};
+
+	Parallel::For(static_cast<uint32_t>(ranges.size()), 1, decode);
+
+	for (size_t r = 0; status && (r < ranges.size()); r++)
 	{
-		File::Close(m_pFile);
-		m_pFile = nullptr;
+		if (!valid[r])
+		{
+			Console::Write(L"Error: Expected vertex\n");
+			status = false;
+		}
 	}
 
 	return status;
@@ -133,7 +836,7 @@ bool MDL_Importer::ReadBlock(MDL_BLOCK_HEADER& rBlockHeader)
 
 	if (status)
 	{
-		switch (rBlockHeader.signature)
+		switch (rBlockHeader.type)
 		{
 			case MDL_NODE:
 			{
@@ -173,7 +876,7 @@ bool MDL_Importer::ReadNodeBlock(MDL_BLOCK_HEADER& rBlockHeader)
 
 	MDL_LIST_HEADER list_header = { 0 };
 
-	if (!m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
+	if (!ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
 	{
 		status = false;
 	}
@@ -214,7 +917,7 @@ bool MDL_Importer::ReadBoneBlock(MDL_BLOCK_HEADER& rBlockHeader)
 
 	MDL_LIST_HEADER list_header = { 0 };
 
-	if (!m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
+	if (!ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
 	{
 		status = false;
 	}
@@ -255,7 +958,7 @@ bool MDL_Importer::ReadMtlBlock(MDL_BLOCK_HEADER& rBlockHeader)
 
 	MDL_LIST_HEADER list_header = { 0 };
 
-	if (!m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
+	if (!ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
 	{
 		status = false;
 	}
@@ -296,7 +999,7 @@ bool MDL_Importer::ReadMeshBlock(MDL_BLOCK_HEADER& rBlockHeader)
 
 	MDL_LIST_HEADER list_header = { 0 };
 
-	if (!m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
+	if (!ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
 	{
 		status = false;
 	}
@@ -336,8 +1039,8 @@ bool MDL_Importer::ReadNode(void)
 	bool status = true;
 	uint64_t node_signature = 0;
 
-	m_rData.nodes.push_back(Importer::Node());
-	Importer::Node& rNode = m_rData.nodes.back();
+	m_rNodes.push_back(Importer::Node());
+	Importer::Node& rNode = m_rNodes.back();
 
 	status = ReadSignature(MDL_NODE);
 
@@ -368,8 +1071,8 @@ bool MDL_Importer::ReadBone(void)
 {
 	bool status = true;
 
-	m_rData.bones.push_back(Importer::Bone());
-	Importer::Bone& rBone = m_rData.bones.back();
+	m_rBones.push_back(Importer::Bone());
+	Importer::Bone& rBone = m_rBones.back();
 
 	status = ReadSignature(MDL_BONE);
 
@@ -395,8 +1098,8 @@ bool MDL_Importer::ReadMtl(void)
 {
 	bool status = true;
 
-	m_rData.materials.push_back(Importer::Material());
-	Importer::Material& rMtl = m_rData.materials.back();
+	m_rMaterials.push_back(Importer::Material());
+	Importer::Material& rMtl = m_rMaterials.back();
 
 	status = ReadSignature(MDL_MTL);
 
@@ -422,8 +1125,8 @@ bool MDL_Importer::ReadMesh(void)
 {
 	bool status = true;
 
-	m_rData.meshes.push_back(Importer::Mesh());
-	Importer::Mesh& rMesh = m_rData.meshes.back();
+	m_pMeshViews->push_back(Importer::MeshView());
+	Importer::MeshView& rMesh = m_pMeshViews->back();
 
 	status = ReadSignature(MDL_MESH);
 
@@ -434,12 +1137,12 @@ bool MDL_Importer::ReadMesh(void)
 
 	if (status)
 	{
-		status = ReadVertexList(rMesh.vertices);
+		status = MapVertexList(rMesh);
 	}
 
 	if (status)
 	{
-		status = ReadIndexList(rMesh.indices);
+		status = MapIndexList(rMesh);
 	}
 
 	if (status)
@@ -450,21 +1153,20 @@ bool MDL_Importer::ReadMesh(void)
 	return status;
 }
 
-bool MDL_Importer::ReadVertexList(std::vector<Importer::Vertex>& rVertices)
+bool MDL_Importer::ReadListHeader(uint32_t type, MDL_LIST_HEADER& rListHeader)
 {
 	bool status = true;
-	MDL_LIST_HEADER list_header = { 0 };
 
-	if (m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
+	if (ReadBytes(&rListHeader, sizeof(MDL_LIST_HEADER)))
 	{
-		if (list_header.signature != MDL_LIST)
+		if (rListHeader.signature != MDL_LIST)
 		{
 			Console::Write(L"Error: Expected MDL list\n");
 			status = false;
 		}
-		else if (list_header.type != MDL_VERTEX)
+		else if (rListHeader.type != type)
 		{
-			Console::Write(L"Error: Expected vertex list\n");
+			Console::Write((type == MDL_VERTEX) ? L"Error: Expected vertex list\n" : L"Error: Expected index list\n");
 			status = false;
 		}
 	}
@@ -473,83 +1175,69 @@ bool MDL_Importer::ReadVertexList(std::vector<Importer::Vertex>& rVertices)
 		status = false;
 	}
 
-	if (status)
+	return status;
+}
+
+bool MDL_Importer::MapVertexList(Importer::MeshView& rMesh)
+{
+	bool status = true;
+	MDL_LIST_HEADER list_header = { 0 };
+
+	status = ReadListHeader(MDL_VERTEX, list_header);
+
+	if (status && (list_header.length > UINT32_MAX / sizeof(MDL_VERTEX_DATA)))
 	{
-		for (uint32_t i = 0; status && (i < list_header.length); i++)
-		{
-			MDL_VERTEX_DATA vertex_data = { 0 };
+		Console::Write(L"Error: Vertex list too large\n");
+		status = false;
+	}
 
-			if (m_pFile->ReadBytes(&vertex_data, sizeof(MDL_VERTEX_DATA)))
-			{
-				if (vertex_data.signature != MDL_VERTEX)
-				{
-					Console::Write(L"Error: Expected vertex\n");
-					status = false;
-				}
-				else
-				{
-					rVertices.push_back(Importer::Vertex());
-					Importer::Vertex& rVertex = rVertices.back();
-
-					memcpy(rVertex.position, vertex_data.position, sizeof(rVertex.position));
-					memcpy(rVertex.normal, vertex_data.normal, sizeof(rVertex.normal));
-					memcpy(rVertex.uv, vertex_data.uv, sizeof(rVertex.uv));
-					rVertex.node_index = vertex_data.node_index;
-					rVertex.bone_count = vertex_data.bone_count;
-					memcpy(rVertex.bone_indices, vertex_data.bone_indices, sizeof(rVertex.bone_indices));
-					memcpy(rVertex.bone_weights, vertex_data.bone_weights, sizeof(rVertex.bone_weights));
-				}
-			}
-			else
-			{
-				status = false;
-			}
-		}
+	const uint8_t* pRecords = nullptr;
+
+	if (status)
+	{
+		pRecords = MapBytes(list_header.length * static_cast<uint32_t>(sizeof(MDL_VERTEX_DATA)));
+		status = (pRecords != nullptr);
 	}
 
+	// the vertex signatures are checked by DecodeMeshes
 	if (status)
 	{
+		rMesh.pVertices = pRecords + offsetof(MDL_VERTEX_DATA, position);
+		rMesh.vertexStride = sizeof(MDL_VERTEX_DATA);
+		rMesh.vertexCount = list_header.length;
+
 		status = ReadSignature(MDL_END);
 	}
 
 	return status;
 }
 
-bool MDL_Importer::ReadIndexList(std::vector<uint16_t>& rIndices)
+bool MDL_Importer::MapIndexList(Importer::MeshView& rMesh)
 {
 	bool status = true;
 	MDL_LIST_HEADER list_header = { 0 };
 
-	if (m_pFile->ReadBytes(&list_header, sizeof(MDL_LIST_HEADER)))
-	{
-		if (list_header.signature != MDL_LIST)
-		{
-			Console::Write(L"Error: Expected MDL list\n");
-			status = false;
-		}
-		else if (list_header.type != MDL_INDEX)
-		{
-			Console::Write(L"Error: Expected index list\n");
-			status = false;
-		}
-	}
-	else
+	status = ReadListHeader(MDL_INDEX, list_header);
+
+	if (status && (list_header.length > UINT32_MAX / sizeof(uint16_t)))
 	{
+		Console::Write(L"Error: Index list too large\n");
 		status = false;
 	}
 
+	const uint8_t* pIndices = nullptr;
+
 	if (status)
 	{
-		rIndices.resize(list_header.length);
-
-		if (!m_pFile->ReadBytes(&rIndices[0], list_header.length * sizeof(uint16_t)))
-		{
-			status = false;
-		}
+		pIndices = MapBytes(list_header.length * sizeof(uint16_t));
+		status = (pIndices != nullptr);
 	}
 
 	if (status)
 	{
+		rMesh.pIndices = reinterpret_cast<const uint16_t*>(pIndices);
+		rMesh.indexCount = list_header.length;
+
 		status = ReadSignature(MDL_END);
 	}
 
@@ -561,7 +1249,7 @@ bool MDL_Importer::ReadString(std::string& rString)
 	bool status = true;
 
 	MDL_STRING_HEADER string_header = { 0 };
-	if (m_pFile->ReadBytes(&string_header, sizeof(MDL_STRING_HEADER)))
+	if (ReadBytes(&string_header, sizeof(MDL_STRING_HEADER)))
 	{
 		if (string_header.signature != MDL_STRING)
 		{
@@ -574,36 +1262,25 @@ bool MDL_Importer::ReadString(std::string& rString)
 		status = false;
 	}
 
+	// the length includes the terminator, which must be the only null character
 	if (status)
 	{
-		uint8_t  buffer[255] = { 0 };
-		uint32_t length = 0;
+		char buffer[255] = { 0 };
 
-		while(status && (length < sizeof(buffer)))
+		if (ReadBytes(buffer, string_header.length))
 		{
-			uint8_t c = 0;
-			if (m_pFile->Read(&c))
+			if ((string_header.length > 0) && (memchr(buffer, 0, string_header.length) == &buffer[string_header.length - 1]))
 			{
-				buffer[length++] = c;
-
-				if (c == 0)
-				{
-					break;
-				}
+				rString = std::string(buffer, string_header.length);
 			}
 			else
 			{
+				Console::Write(L"Error: String size mismatch\n");
 				status = false;
 			}
 		}
-
-		if (length == string_header.length)
-		{
-			rString = std::string(reinterpret_cast<char*>(buffer), length);
-		}
 		else
 		{
-			Console::Write(L"Error: String size mismatch\n");
 			status = false;
 		}
 	}
@@ -622,7 +1299,7 @@ bool MDL_Importer::ReadMatrix(float* pMatrix)
 
 	MDL_MATRIX_DATA matrix_data = { 0 };
 
-	if (m_pFile->ReadBytes(&matrix_data, sizeof(MDL_MATRIX_DATA)))
+	if (ReadBytes(&matrix_data, sizeof(MDL_MATRIX_DATA)))
 	{
 		if (matrix_data.signature == MDL_MATRIX4)
 		{
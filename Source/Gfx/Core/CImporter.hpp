@@ -6,16 +6,47 @@
 class MDL_Importer
 {
 private:
-	class File*         m_pFile;
-	Importer::MDL_DATA& m_rData;
+	struct TOC_BLOCK
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t checksum;
+		uint32_t index; // position in the table of contents and in m_pBlocks
+	};
+
+	class MappedFile*                 m_pMappedFile;
+	const uint8_t*                    m_pCursor;    // next byte of the mapping
+	const uint8_t*                    m_pEnd;
+	std::vector<Importer::Node>&      m_rNodes;
+	std::vector<Importer::Bone>&      m_rBones;
+	std::vector<Importer::Material>&  m_rMaterials;
+	std::vector<Importer::Mesh>*      m_pMeshes;    // Read
+	std::vector<Importer::MeshView>*  m_pMeshViews; // Map, or m_MeshViews for Read
+	std::vector<Importer::MeshView>   m_MeshViews;
+	std::vector<Importer::BlockInfo>* m_pBlocks;    // Map
+	uint32_t*                         m_pVersion;   // Map
+	class MappedFile**                m_ppViewFile;
+	uint32_t                          m_Version;
+	std::vector<TOC_BLOCK>            m_Toc;        // version 2 table of contents sorted by offset, for ReadBlocks
 
 public:
 	MDL_Importer(Importer::MDL_DATA& rData);
+	MDL_Importer(Importer::MDL_VIEW& rView);
 	~MDL_Importer(void);
 
 	bool Read(const wchar_t* path);
+	bool Map(const wchar_t* path);
+	bool Open(const wchar_t* path);
+	bool LoadBlock(uint32_t block);
 
 private:
+	bool ReadHeader(void);
+	bool ReadBlocks(void);
+	bool DecodeMeshes(size_t firstMesh);
+
+	bool ReadBytes(void* pBuffer, uint32_t numBytes);
+	const uint8_t* MapBytes(uint32_t numBytes);
+
 	bool ReadSignature(uint32_t expected_signature);
 
 	bool ReadBlock(struct MDL_BLOCK_HEADER& rBlockHeader);
@@ -29,11 +60,12 @@ private:
 	bool ReadMtl(void);
 	bool ReadMesh(void);
 
-	bool ReadIndexList(std::vector<uint16_t>& rIndices);
-	bool ReadVertexList(std::vector<Importer::Vertex>& rVertices);
+	bool ReadListHeader(uint32_t type, struct MDL_LIST_HEADER& rListHeader);
+	bool MapIndexList(Importer::MeshView& rMesh);
+	bool MapVertexList(Importer::MeshView& rMesh);
 
 	bool ReadString(std::string& rString);
 	bool ReadMatrix(float* pMatrix);
 };
 
-#endif // CG_IMPORTER_HPP
\ No newline at end of file
+#endif // CG_IMPORTER_HPP
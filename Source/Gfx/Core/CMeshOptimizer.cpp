@@ -0,0 +1,483 @@
+#include "CgImporter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Cg.hpp"
+
+/* Mesh optimization: Tipsify (Sander, Nehab and Barczak 2007) emits the triangles around a fanning vertex and picks */
+/* the next one among the vertices just emitted that stay in the cache. The result is cut into clusters where the */
+/* cache starts cold and where the ACMR of a prefix is already close to the one of its cluster, the clusters are then */
+/* sorted by how much they face away from the center so that the outside of the mesh is drawn first. Finally the */
+/* vertices are renumbered in the order of their first use. */
+
+#define INVALID_VERTEX UINT32_MAX
+
+// FIFO cache: the vertex of miss m is evicted by miss m + size, a flush advances the time by a whole cache
+struct VERTEX_CACHE
+{
+	std::vector<uint64_t> stamps; // time of the miss that inserted the vertex, 0 if never
+	uint64_t              size;
+	uint64_t              time;
+};
+
+// Transformed vertices, triangles and distinct vertices of a triangle list
+struct MISS_COUNTS
+{
+	uint64_t misses;
+	uint64_t triangles;
+	uint64_t referenced;
+};
+
+static void InitializeCache(VERTEX_CACHE& rCache, uint32_t vertexCount, uint32_t cacheSize)
+{
+	rCache.stamps.assign(vertexCount, 0);
+	rCache.size = cacheSize;
+	rCache.time = cacheSize;
+}
+
+// Returns 1 for a miss
+static inline uint32_t FetchVertex(VERTEX_CACHE& rCache, uint32_t v)
+{
+	uint32_t miss = 0;
+
+	if ((rCache.stamps[v] == 0) || (rCache.time - rCache.stamps[v] >= rCache.size))
+	{
+		rCache.stamps[v] = ++rCache.time;
+		miss = 1;
+	}
+
+	return miss;
+}
+
+static inline void FlushCache(VERTEX_CACHE& rCache)
+{
+	rCache.time += rCache.size;
+}
+
+static bool ValidateMesh(const Importer::Mesh& mesh, uint32_t cacheSize)
+{
+	bool status = true;
+
+	if (cacheSize < 3)
+	{
+		Console::Write(L"Error: Vertex cache of %u entries is too small\n", cacheSize);
+		status = false;
+	}
+
+	if (status && ((mesh.indices.size() % 3) != 0))
+	{
+		Console::Write(L"Error: Index count %zu is not a multiple of 3\n", mesh.indices.size());
+		status = false;
+	}
+
+	for (size_t i = 0; status && (i < mesh.indices.size()); i++)
+	{
+		if (mesh.indices[i] >= mesh.vertices.size())
+		{
+			Console::Write(L"Error: Index %u out of range (%zu vertices)\n", mesh.indices[i], mesh.vertices.size());
+			status = false;
+		}
+	}
+
+	return status;
+}
+
+static void CountMisses(const Importer::Mesh& mesh, uint32_t cacheSize, MISS_COUNTS& rCounts)
+{
+	VERTEX_CACHE cache;
+	InitializeCache(cache, static_cast<uint32_t>(mesh.vertices.size()), cacheSize);
+
+	std::vector<uint8_t> referenced(mesh.vertices.size(), 0);
+
+	rCounts.misses = 0;
+	rCounts.triangles = mesh.indices.size() / 3;
+	rCounts.referenced = 0;
+
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+	{
+		rCounts.misses += FetchVertex(cache, mesh.indices[i]);
+		rCounts.referenced += (referenced[mesh.indices[i]] == 0);
+		referenced[mesh.indices[i]] = 1;
+	}
+}
+
+static void SetStats(const MISS_COUNTS& counts, Importer::CACHE_STATS& rStats)
+{
+	rStats.acmr = (counts.triangles > 0) ? static_cast<float>(static_cast<double>(counts.misses) / static_cast<double>(counts.triangles)) : 0.0f;
+	rStats.atvr = (counts.referenced > 0) ? static_cast<float>(static_cast<double>(counts.misses) / static_cast<double>(counts.referenced)) : 0.0f;
+}
+
+// ----------------------------------------- Tipsify ----------------------------------------------
+
+static void Tipsify(const std::vector<uint16_t>& indices, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>& rOrder)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	// triangles around each vertex, live counts the ones not emitted yet
+	std::vector<uint32_t> live(vertexCount, 0);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		live[indices[i]]++;
+	}
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + live[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			adjacency[fill[indices[3 * t + k]]++] = t;
+		}
+	}
+
+	// stamps are the time a vertex entered the cache, time only advances on misses
+	std::vector<uint32_t> stamps(vertexCount, 0);
+	std::vector<uint8_t>  emitted(triangleCount, 0);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	uint32_t              time = cacheSize + 1;
+	uint32_t              cursor = 0;
+
+	rOrder.clear();
+	rOrder.reserve(triangleCount);
+
+	uint32_t fanning = INVALID_VERTEX;
+	for (; (cursor < vertexCount) && (fanning == INVALID_VERTEX); cursor++)
+	{
+		fanning = (live[cursor] > 0) ? cursor : INVALID_VERTEX;
+	}
+
+	while (fanning != INVALID_VERTEX)
+	{
+		candidates.clear();
+
+		for (uint32_t k = offsets[fanning]; k < offsets[fanning + 1]; k++)
+		{
+			const uint32_t t = adjacency[k];
+
+			if (!emitted[t])
+			{
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					const uint32_t v = indices[3 * t + j];
+
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+
+					if (time - stamps[v] > cacheSize)
+					{
+						stamps[v] = time++;
+					}
+				}
+
+				emitted[t] = 1;
+				rOrder.push_back(t);
+			}
+		}
+
+		// the candidate that stays longest in the cache once its remaining triangles are emitted, else the oldest
+		// cached one with triangles left (priority 0 when fanning it would push it out of the cache)
+		uint32_t next = INVALID_VERTEX;
+		uint32_t bestPriority = 0;
+
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			const uint32_t v = candidates[i];
+
+			if (live[v] > 0)
+			{
+				const uint32_t age = time - stamps[v];
+				const uint32_t priority = (age + 2 * live[v] <= cacheSize) ? age : 0;
+
+				if ((next == INVALID_VERTEX) || (priority > bestPriority))
+				{
+					next = v;
+					bestPriority = priority;
+				}
+			}
+		}
+
+		// dead end: the most recent vertex with triangles left, then the next one in index order
+		while ((next == INVALID_VERTEX) && !deadEnd.empty())
+		{
+			const uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+
+			next = (live[v] > 0) ? v : INVALID_VERTEX;
+		}
+
+		for (; (next == INVALID_VERTEX) && (cursor < vertexCount); cursor++)
+		{
+			next = (live[cursor] > 0) ? cursor : INVALID_VERTEX;
+		}
+
+		fanning = next;
+	}
+}
+
+// ----------------------------------------- Overdraw ---------------------------------------------
+
+static void SortClusters(const Importer::Mesh& mesh, const std::vector<uint32_t>& order, uint32_t cacheSize, float threshold, std::vector<uint32_t>& rSorted)
+{
+	const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	const uint32_t triangleCount = static_cast<uint32_t>(order.size());
+
+	VERTEX_CACHE cache;
+	InitializeCache(cache, vertexCount, cacheSize);
+
+	auto fetchTriangle = [&](uint32_t t)
+	{
+		return FetchVertex(cache, mesh.indices[3 * t]) + FetchVertex(cache, mesh.indices[3 * t + 1]) + FetchVertex(cache, mesh.indices[3 * t + 2]);
+	};
+
+	// hard boundaries where the cache starts cold, their order can change without changing the misses much
+	std::vector<uint32_t> hard;
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		if ((fetchTriangle(order[i]) == 3) || (i == 0))
+		{
+			hard.push_back(i);
+		}
+	}
+	hard.push_back(triangleCount);
+
+	// soft boundaries once the prefix of a cluster reaches threshold times the ACMR of the cluster
+	std::vector<uint32_t> clusters;
+	for (size_t c = 0; c + 1 < hard.size(); c++)
+	{
+		const uint32_t begin = hard[c];
+		const uint32_t end = hard[c + 1];
+
+		FlushCache(cache);
+		uint32_t clusterMisses = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			clusterMisses += fetchTriangle(order[i]);
+		}
+
+		const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+		clusters.push_back(begin);
+
+		FlushCache(cache);
+		uint32_t misses = 0;
+		uint32_t triangles = 0;
+		for (uint32_t i = begin; i + 1 < end; i++)
+		{
+			misses += fetchTriangle(order[i]);
+			triangles++;
+
+			if (static_cast<float>(misses) <= clusterThreshold * static_cast<float>(triangles))
+			{
+				clusters.push_back(i + 1);
+
+				FlushCache(cache);
+				misses = 0;
+				triangles = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	auto position = [&](uint32_t t, uint32_t k)
+	{
+		const float* p = mesh.vertices[mesh.indices[3 * t + k]].position;
+		return Vector3F(p[0], p[1], p[2]);
+	};
+
+	Vector3F center(0.0f, 0.0f, 0.0f);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		center += position(t, 0) + position(t, 1) + position(t, 2);
+	}
+	center *= (triangleCount > 0) ? 1.0f / static_cast<float>(3 * triangleCount) : 0.0f;
+
+	// area weighted centroid and normal of each cluster, the ones facing away from the center are drawn first
+	struct CLUSTER
+	{
+		float    key;
+		uint32_t index;
+	};
+
+	std::vector<CLUSTER> keys(clusters.size() - 1);
+	for (size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		Vector3F centroid(0.0f, 0.0f, 0.0f);
+		Vector3F normal(0.0f, 0.0f, 0.0f);
+		float    area = 0.0f;
+
+		for (uint32_t i = clusters[c]; i < clusters[c + 1]; i++)
+		{
+			const Vector3F p0 = position(order[i], 0);
+			const Vector3F p1 = position(order[i], 1);
+			const Vector3F p2 = position(order[i], 2);
+			const Vector3F n = Vector::Cross(p1 - p0, p2 - p0);
+			const float    a = Vector::Length(n);
+
+			centroid += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+
+		const float normalLength = Vector::Length(normal);
+
+		keys[c].key = ((area > 0.0f) && (normalLength > 0.0f)) ? Vector::Dot(centroid * (1.0f / area) - center, normal * (1.0f / normalLength)) : 0.0f;
+		keys[c].index = static_cast<uint32_t>(c);
+	}
+
+	std::stable_sort(keys.begin(), keys.end(), [](const CLUSTER& a, const CLUSTER& b) { return a.key > b.key; });
+
+	rSorted.clear();
+	rSorted.reserve(triangleCount);
+	for (size_t c = 0; c < keys.size(); c++)
+	{
+		rSorted.insert(rSorted.end(), order.begin() + clusters[keys[c].index], order.begin() + clusters[keys[c].index + 1]);
+	}
+}
+
+// ------------------------------------------ Optimize --------------------------------------------
+
+static bool Optimize(Importer::Mesh& rMesh, const Importer::OPTIMIZE_DESC& desc, MISS_COUNTS& rBefore, MISS_COUNTS& rAfter)
+{
+	bool status = ValidateMesh(rMesh, desc.cacheSize);
+
+	const uint32_t vertexCount = static_cast<uint32_t>(rMesh.vertices.size());
+
+	if (status)
+	{
+		CountMisses(rMesh, desc.cacheSize, rBefore);
+
+		std::vector<uint32_t> order;
+		Tipsify(rMesh.indices, vertexCount, desc.cacheSize, order);
+
+		if (desc.overdrawThreshold > 0.0f)
+		{
+			std::vector<uint32_t> sorted;
+			SortClusters(rMesh, order, desc.cacheSize, desc.overdrawThreshold, sorted);
+			order.swap(sorted);
+		}
+
+		// vertices in the order of their first use, the unused ones keep their order at the end
+		std::vector<uint32_t> remap(vertexCount, INVALID_VERTEX);
+		std::vector<uint16_t> indices(rMesh.indices.size());
+		uint32_t next = 0;
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const uint32_t v = rMesh.indices[3 * order[i] + k];
+
+				if (remap[v] == INVALID_VERTEX)
+				{
+					remap[v] = next++;
+				}
+
+				indices[3 * i + k] = static_cast<uint16_t>(remap[v]);
+			}
+		}
+
+		std::vector<Importer::Vertex> vertices(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] == INVALID_VERTEX)
+			{
+				remap[v] = next++;
+			}
+
+			vertices[remap[v]] = rMesh.vertices[v];
+		}
+
+		rMesh.vertices.swap(vertices);
+		rMesh.indices.swap(indices);
+
+		CountMisses(rMesh, desc.cacheSize, rAfter);
+	}
+
+	return status;
+}
+
+// ------------------------------------------ Importer --------------------------------------------
+
+bool Importer::GetCacheStats(const Mesh& mesh, uint32_t cacheSize, CACHE_STATS& rStats)
+{
+	bool status = ValidateMesh(mesh, cacheSize);
+
+	if (status)
+	{
+		MISS_COUNTS counts = { 0 };
+		CountMisses(mesh, cacheSize, counts);
+		SetStats(counts, rStats);
+	}
+
+	return status;
+}
+
+bool Importer::OptimizeMesh(Mesh& rMesh, const OPTIMIZE_DESC& desc, CACHE_STATS& rBefore, CACHE_STATS& rAfter)
+{
+	MISS_COUNTS before = { 0 };
+	MISS_COUNTS after = { 0 };
+
+	bool status = Optimize(rMesh, desc, before, after);
+
+	if (status)
+	{
+		SetStats(before, rBefore);
+		SetStats(after, rAfter);
+	}
+
+	return status;
+}
+
+bool Importer::OptimizeMdl(MDL_DATA& rData, const OPTIMIZE_DESC& desc, CACHE_STATS& rBefore, CACHE_STATS& rAfter)
+{
+	bool status = true;
+
+	const uint32_t meshCount = static_cast<uint32_t>(rData.meshes.size());
+
+	// each mesh has its own slot, the totals are summed in mesh order
+	std::vector<MISS_COUNTS> before(meshCount);
+	std::vector<MISS_COUNTS> after(meshCount);
+	std::vector<uint8_t>     valid(meshCount, 0);
+
+	auto optimize = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			valid[i] = Optimize(rData.meshes[i], desc, before[i], after[i]);
+		}
+	};
+
+	Parallel::For(meshCount, 1, optimize);
+
+	MISS_COUNTS totalBefore = { 0 };
+	MISS_COUNTS totalAfter = { 0 };
+
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		status = status && valid[i];
+
+		if (valid[i])
+		{
+			totalBefore.misses += before[i].misses;
+			totalBefore.triangles += before[i].triangles;
+			totalBefore.referenced += before[i].referenced;
+			totalAfter.misses += after[i].misses;
+			totalAfter.triangles += after[i].triangles;
+			totalAfter.referenced += after[i].referenced;
+		}
+	}
+
+	SetStats(totalBefore, rBefore);
+	SetStats(totalAfter, rAfter);
+
+	return status;
+}
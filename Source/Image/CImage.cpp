@@ -0,0 +1,425 @@
+#include "CgImage.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Cg.hpp"
+#include "CgMath.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+/* Image: each conversion is a row kernel run over the rows of the image by Parallel::For. The kernels convert the */
+/* row with SIMD and finish it with the scalar loop, which gives the same results. */
+/* The RGB expansion uses SSSE3 shuffles: GCC and Clang compile them with -mssse3 (or -mavx2), MSVC always compiles */
+/* them and the CPU is checked once at run time. */
+
+#if CG_MATH_SSE && (defined(__SSSE3__) || defined(_MSC_VER))
+#define IMAGE_SSSE3 1
+#endif
+
+#define RANGE_PIXELS 32768 // pixels per parallel range, rows are not split
+
+// sRGB curves as polynomials of the fourth root, least squares fits evaluated in Horner form (the same operations in the
+// SIMD and scalar code). The fourth root brings the exponents 2.4 and 1 / 2.4 close to 1, where low degrees suffice:
+// ToLinear is within 3e-6 of the exact curve (relative), ToSrgb within 0.007 of a UNORM8 step, so it rounds to the
+// exact byte except next to the halfway points and is never more than one step away
+#define SRGB_TO_LINEAR_C4  4.439586845e-02f
+#define SRGB_TO_LINEAR_C3 -2.307238587e-01f
+#define SRGB_TO_LINEAR_C2  9.078533520e-01f
+#define SRGB_TO_LINEAR_C1  2.990173794e-01f
+#define SRGB_TO_LINEAR_C0 -2.054125185e-02f
+
+#define LINEAR_TO_SRGB_C5 -8.788403851e-02f
+#define LINEAR_TO_SRGB_C4  3.483248676e-01f
+#define LINEAR_TO_SRGB_C3 -6.439126011e-01f
+#define LINEAR_TO_SRGB_C2  1.290746092e+00f
+#define LINEAR_TO_SRGB_C1  1.532225268e-01f
+#define LINEAR_TO_SRGB_C0 -6.052035594e-02f
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+#if IMAGE_SSSE3
+static bool HasSsse3(void)
+{
+#if defined(__SSSE3__)
+	return true;
+#else
+	static const bool ssse3 = []()
+	{
+		int info[4] = {};
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0; // ECX bit 9
+	}();
+	return ssse3;
+#endif
+}
+#endif
+
+// ((c + 0.055) / 1.055)^2.4 = x^2 * x^0.4 with x^0.4 = p(x^(1/4))
+static inline float ToLinear(float c)
+{
+	if (c <= 0.04045f)
+	{
+		return c / 12.92f;
+	}
+
+	const float x = c * (1.0f / 1.055f) + (0.055f / 1.055f);
+	const float u = std::sqrt(std::sqrt(x));
+	const float p = (((SRGB_TO_LINEAR_C4 * u + SRGB_TO_LINEAR_C3) * u + SRGB_TO_LINEAR_C2) * u + SRGB_TO_LINEAR_C1) * u + SRGB_TO_LINEAR_C0;
+	return (x * x) * p;
+}
+
+// 1.055 * l^(1 / 2.4) - 0.055 = p(l^(1/4)), l must be saturated
+static inline float ToSrgb(float l)
+{
+	if (l <= 0.0031308f)
+	{
+		return l * 12.92f;
+	}
+
+	const float q = std::sqrt(std::sqrt(l));
+	return ((((LINEAR_TO_SRGB_C5 * q + LINEAR_TO_SRGB_C4) * q + LINEAR_TO_SRGB_C3) * q + LINEAR_TO_SRGB_C2) * q + LINEAR_TO_SRGB_C1) * q + LINEAR_TO_SRGB_C0;
+}
+
+// Clamps to [0, 1] with NaN giving 1, like _mm_max_ps(_mm_min_ps(f, 1), 0)
+static inline float Saturate(float f)
+{
+	const float c = (f < 1.0f) ? f : 1.0f;
+	return (c > 0.0f) ? c : 0.0f;
+}
+
+static inline uint8_t ToUnorm8(float f)
+{
+	return static_cast<uint8_t>(static_cast<uint32_t>(Saturate(f) * 255.0f + 0.5f));
+}
+
+// Runs kernel(pSrcRow, pDstRow) over the rows, splitting them over the Parallel workers
+template <typename SRC, typename DST, typename KERNEL>
+static void ForEachRow(const SRC* pSrc, uint32_t srcPitch, DST* pDst, uint32_t dstPitch, uint32_t width, uint32_t height, KERNEL kernel)
+{
+	if ((width == 0) || (height == 0))
+	{
+		return;
+	}
+
+	auto rows = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			const SRC* pSrcRow = reinterpret_cast<const SRC*>(reinterpret_cast<const uint8_t*>(pSrc) + static_cast<size_t>(y) * srcPitch);
+			DST* pDstRow = reinterpret_cast<DST*>(reinterpret_cast<uint8_t*>(pDst) + static_cast<size_t>(y) * dstPitch);
+			kernel(pSrcRow, pDstRow);
+		}
+	};
+
+	Parallel::For(height, (width < RANGE_PIXELS) ? RANGE_PIXELS / width : 1, rows);
+}
+
+// ------------------------------------------ Rows ------------------------------------------------
+
+static void RgbToRgbaRow(const uint8_t* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if IMAGE_SSSE3
+	// sixteen pixels from three loads, realigned so that each register starts with a pixel
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha   = _mm_set1_epi32(static_cast<int>(0xFF000000));
+	const bool    ssse3   = HasSsse3();
+
+	for (; ssse3 && (x + 16 <= width); x += 16)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 3 * x));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 3 * x + 16));
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 3 * x + 32));
+
+		const __m128i p0 = a;
+		const __m128i p1 = _mm_alignr_epi8(b, a, 12);
+		const __m128i p2 = _mm_alignr_epi8(c, b, 8);
+		const __m128i p3 = _mm_srli_si128(c, 4);
+
+		__m128i* pOut = reinterpret_cast<__m128i*>(pDst + 4 * x);
+		_mm_storeu_si128(pOut + 0, _mm_or_si128(_mm_shuffle_epi8(p0, shuffle), alpha));
+		_mm_storeu_si128(pOut + 1, _mm_or_si128(_mm_shuffle_epi8(p1, shuffle), alpha));
+		_mm_storeu_si128(pOut + 2, _mm_or_si128(_mm_shuffle_epi8(p2, shuffle), alpha));
+		_mm_storeu_si128(pOut + 3, _mm_or_si128(_mm_shuffle_epi8(p3, shuffle), alpha));
+	}
+#endif
+
+	// one 32 bit store per pixel, the pixels are little endian
+	for (; x < width; x++)
+	{
+		const uint32_t pixel = pSrc[3 * x] | (pSrc[3 * x + 1] << 8) | (pSrc[3 * x + 2] << 16) | 0xFF000000;
+		memcpy(pDst + 4 * x, &pixel, sizeof(pixel));
+	}
+}
+
+static void BgraToRgbaRow(const uint8_t* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_SSE
+	// red and blue swap places in each 32 bit pixel
+	const __m128i maskGA = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+	const __m128i maskB  = _mm_set1_epi32(0x000000FF);
+
+	for (; x + 4 <= width; x += 4)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), maskB);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(v, maskB), 16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), _mm_or_si128(_mm_and_si128(v, maskGA), _mm_or_si128(r, b)));
+	}
+#endif
+
+	for (; x < width; x++)
+	{
+		const uint8_t b = pSrc[4 * x + 0];
+		const uint8_t g = pSrc[4 * x + 1];
+		const uint8_t r = pSrc[4 * x + 2];
+		const uint8_t a = pSrc[4 * x + 3];
+		pDst[4 * x + 0] = r;
+		pDst[4 * x + 1] = g;
+		pDst[4 * x + 2] = b;
+		pDst[4 * x + 3] = a;
+	}
+}
+
+static void PremultiplyRow(const uint8_t* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_SSE
+	// round(c * a / 255) is exactly (t + (t >> 8)) >> 8 with t = c * a + 128, alpha is multiplied by 255
+	const __m128i zero     = _mm_setzero_si128();
+	const __m128i maskRGB  = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+	const __m128i alpha255 = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+	const __m128i bias     = _mm_set1_epi16(128);
+
+	auto multiply = [&](__m128i c)
+	{
+		const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xFF), 0xFF);
+		const __m128i m = _mm_or_si128(_mm_and_si128(a, maskRGB), alpha255);
+		const __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, m), bias);
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	};
+
+	for (; x + 4 <= width; x += 4)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+		const __m128i lo = multiply(_mm_unpacklo_epi8(v, zero));
+		const __m128i hi = multiply(_mm_unpackhi_epi8(v, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), _mm_packus_epi16(lo, hi));
+	}
+#endif
+
+	for (; x < width; x++)
+	{
+		const uint32_t a = pSrc[4 * x + 3];
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const uint32_t t = pSrc[4 * x + k] * a + 128;
+			pDst[4 * x + k] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+		}
+		pDst[4 * x + 3] = static_cast<uint8_t>(a);
+	}
+}
+
+#if CG_MATH_SSE
+// Sixteen saturated floats to sixteen UNORM8 values
+static inline __m128i PackUnorm8(const __m128& f0, const __m128& f1, const __m128& f2, const __m128& f3)
+{
+	const __m128 one   = _mm_set1_ps(1.0f);
+	const __m128 zero  = _mm_setzero_ps();
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half  = _mm_set1_ps(0.5f);
+
+	auto convert = [&](__m128 f) { return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_max_ps(_mm_min_ps(f, one), zero), scale), half)); };
+
+	const __m128i lo = _mm_packs_epi32(convert(f0), convert(f1));
+	const __m128i hi = _mm_packs_epi32(convert(f2), convert(f3));
+	return _mm_packus_epi16(lo, hi);
+}
+
+// ToLinear of the color of one pixel, alpha (lane 3) is kept
+static inline __m128 ToLinear(__m128 c)
+{
+	const __m128 x = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(1.0f / 1.055f)), _mm_set1_ps(0.055f / 1.055f));
+	const __m128 u = _mm_sqrt_ps(_mm_sqrt_ps(x));
+
+	__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SRGB_TO_LINEAR_C4), u), _mm_set1_ps(SRGB_TO_LINEAR_C3));
+	p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(SRGB_TO_LINEAR_C2));
+	p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(SRGB_TO_LINEAR_C1));
+	p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(SRGB_TO_LINEAR_C0));
+
+	const __m128 curve  = _mm_mul_ps(_mm_mul_ps(x, x), p);
+	const __m128 linear = _mm_div_ps(c, _mm_set1_ps(12.92f));
+	const __m128 small  = _mm_cmple_ps(c, _mm_set1_ps(0.04045f));
+	const __m128 color  = _mm_or_ps(_mm_and_ps(small, linear), _mm_andnot_ps(small, curve));
+
+	const __m128 maskRGB = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	return _mm_or_ps(_mm_and_ps(maskRGB, color), _mm_andnot_ps(maskRGB, c));
+}
+
+// ToSrgb of the saturated color of one pixel, alpha (lane 3) is kept
+static inline __m128 ToSrgb(__m128 l)
+{
+	const __m128 q = _mm_sqrt_ps(_mm_sqrt_ps(l));
+
+	__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LINEAR_TO_SRGB_C5), q), _mm_set1_ps(LINEAR_TO_SRGB_C4));
+	p = _mm_add_ps(_mm_mul_ps(p, q), _mm_set1_ps(LINEAR_TO_SRGB_C3));
+	p = _mm_add_ps(_mm_mul_ps(p, q), _mm_set1_ps(LINEAR_TO_SRGB_C2));
+	p = _mm_add_ps(_mm_mul_ps(p, q), _mm_set1_ps(LINEAR_TO_SRGB_C1));
+	p = _mm_add_ps(_mm_mul_ps(p, q), _mm_set1_ps(LINEAR_TO_SRGB_C0));
+
+	const __m128 linear = _mm_mul_ps(l, _mm_set1_ps(12.92f));
+	const __m128 small  = _mm_cmple_ps(l, _mm_set1_ps(0.0031308f));
+	const __m128 color  = _mm_or_ps(_mm_and_ps(small, linear), _mm_andnot_ps(small, p));
+
+	const __m128 maskRGB = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	return _mm_or_ps(_mm_and_ps(maskRGB, color), _mm_andnot_ps(maskRGB, l));
+}
+#endif
+
+static void SrgbToLinearRow(const uint8_t* pSrc, float* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_SSE
+	// four pixels per load, widened to 32 bits and divided by 255 like the scalar loop
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128  scale = _mm_set1_ps(255.0f);
+
+	for (; x + 4 <= width; x += 4)
+	{
+		const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+		const __m128i lo = _mm_unpacklo_epi8(v, zero);
+		const __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+		float* p = pDst + 4 * x;
+		_mm_storeu_ps(p + 0,  ToLinear(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale)));
+		_mm_storeu_ps(p + 4,  ToLinear(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale)));
+		_mm_storeu_ps(p + 8,  ToLinear(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale)));
+		_mm_storeu_ps(p + 12, ToLinear(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale)));
+	}
+#endif
+
+	for (; x < width; x++)
+	{
+		pDst[4 * x + 0] = ToLinear(pSrc[4 * x + 0] / 255.0f);
+		pDst[4 * x + 1] = ToLinear(pSrc[4 * x + 1] / 255.0f);
+		pDst[4 * x + 2] = ToLinear(pSrc[4 * x + 2] / 255.0f);
+		pDst[4 * x + 3] = pSrc[4 * x + 3] / 255.0f;
+	}
+}
+
+static void LinearToSrgbRow(const float* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_SSE
+	// the encoded color and the linear alpha of four pixels are rounded to UNORM8 together
+	const __m128 one  = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	auto encode = [&](const float* p) { return ToSrgb(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(p), one), zero)); };
+
+	for (; x + 4 <= width; x += 4)
+	{
+		const float* p = pSrc + 4 * x;
+		const __m128i v = PackUnorm8(encode(p), encode(p + 4), encode(p + 8), encode(p + 12));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), v);
+	}
+#endif
+
+	for (; x < width; x++)
+	{
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			pDst[4 * x + k] = ToUnorm8(ToSrgb(Saturate(pSrc[4 * x + k])));
+		}
+		pDst[4 * x + 3] = ToUnorm8(pSrc[4 * x + 3]);
+	}
+}
+
+static void FloatToUnorm8Row(const float* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_SSE
+	for (; x + 4 <= width; x += 4)
+	{
+		const float* p = pSrc + 4 * x;
+		const __m128i v = PackUnorm8(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _mm_loadu_ps(p + 8), _mm_loadu_ps(p + 12));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), v);
+	}
+#endif
+
+	for (x *= 4; x < 4 * width; x++)
+	{
+		pDst[x] = ToUnorm8(pSrc[x]);
+	}
+}
+
+static void HalfToUnorm8Row(const uint16_t* pSrc, uint8_t* pDst, uint32_t width)
+{
+	uint32_t x = 0;
+
+#if CG_MATH_F16C
+	for (; x + 4 <= width; x += 4)
+	{
+		const __m128i* p = reinterpret_cast<const __m128i*>(pSrc + 4 * x);
+		const __m128i h0 = _mm_loadu_si128(p);
+		const __m128i h1 = _mm_loadu_si128(p + 1);
+		const __m128i v = PackUnorm8(_mm_cvtph_ps(h0), _mm_cvtph_ps(_mm_srli_si128(h0, 8)), _mm_cvtph_ps(h1), _mm_cvtph_ps(_mm_srli_si128(h1, 8)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), v);
+	}
+#endif
+
+	for (x *= 4; x < 4 * width; x++)
+	{
+		pDst[x] = ToUnorm8(Pack::DecodeHalf(pSrc[x]));
+	}
+}
+
+// --------------------------------------- Conversions --------------------------------------------
+
+void Image::RgbToRgba(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const uint8_t* pSrcRow, uint8_t* pDstRow) { RgbToRgbaRow(pSrcRow, pDstRow, width); });
+}
+
+void Image::BgraToRgba(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const uint8_t* pSrcRow, uint8_t* pDstRow) { BgraToRgbaRow(pSrcRow, pDstRow, width); });
+}
+
+void Image::Premultiply(const uint8_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const uint8_t* pSrcRow, uint8_t* pDstRow) { PremultiplyRow(pSrcRow, pDstRow, width); });
+}
+
+void Image::SrgbToLinear(const uint8_t* pSrc, uint32_t srcPitch, float* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const uint8_t* pSrcRow, float* pDstRow) { SrgbToLinearRow(pSrcRow, pDstRow, width); });
+}
+
+void Image::LinearToSrgb(const float* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const float* pSrcRow, uint8_t* pDstRow) { LinearToSrgbRow(pSrcRow, pDstRow, width); });
+}
+
+void Image::FloatToUnorm8(const float* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const float* pSrcRow, uint8_t* pDstRow) { FloatToUnorm8Row(pSrcRow, pDstRow, width); });
+}
+
+void Image::HalfToUnorm8(const uint16_t* pSrc, uint32_t srcPitch, uint8_t* pDst, uint32_t dstPitch, uint32_t width, uint32_t height)
+{
+	ForEachRow(pSrc, srcPitch, pDst, dstPitch, width, height, [width](const uint16_t* pSrcRow, uint8_t* pDstRow) { HalfToUnorm8Row(pSrcRow, pDstRow, width); });
+}
@@ -1,255 +1,113 @@
 #include "CMath.hpp"
 
 #include <cmath>
+#include <cstdarg>
+#include <cwchar>
 
-#include <algorithm>
-
+#ifdef _WIN32
 #include <strsafe.h>
+#else
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#endif
 
-#include "Cg.hpp"
-#include "CgDef.hpp"
 #include "CgMath.hpp"
 
-#define CMP(x0, x1)						\
-	if ((x0) < (x1)) return true;		\
-	else if ((x0) > (x1)) return false;	\
-
-#define ADD2(v0, v1, v) { (v)[0] = (v0)[0] + (v1)[0]; (v)[1] = (v0)[1] + (v1)[1]; }
-#define SUB2(v0, v1, v) { (v)[0] = (v0)[0] - (v1)[0]; (v)[1] = (v0)[1] - (v1)[1]; }
-#define ADD3(v0, v1, v) { (v)[0] = (v0)[0] + (v1)[0]; (v)[1] = (v0)[1] + (v1)[1]; (v)[2] = (v0)[2] + (v1)[2]; }
-#define SUB3(v0, v1, v) { (v)[0] = (v0)[0] - (v1)[0]; (v)[1] = (v0)[1] - (v1)[1]; (v)[2] = (v0)[2] - (v1)[2]; }
-#define ADD4(v0, v1, v) { (v)[0] = (v0)[0] + (v1)[0]; (v)[1] = (v0)[1] + (v1)[1]; (v)[2] = (v0)[2] + (v1)[2]; (v)[3] = (v0)[3] + (v1)[3]; }
-#define SUB4(v0, v1, v) { (v)[0] = (v0)[0] - (v1)[0]; (v)[1] = (v0)[1] - (v1)[1]; (v)[2] = (v0)[2] - (v1)[2]; (v)[3] = (v0)[3] - (v1)[3]; }
-
-#define MUL2(a, v0, v) { (v)[0] = (a) * (v0)[0]; (v)[1] = (a) * (v0)[1]; }
-#define MUL3(a, v0, v) { (v)[0] = (a) * (v0)[0]; (v)[1] = (a) * (v0)[1]; (v)[2] = (a) * (v0)[2]; }
-#define MUL4(a, v0, v) { (v)[0] = (a) * (v0)[0]; (v)[1] = (a) * (v0)[1]; (v)[2] = (a) * (v0)[2]; (v)[3] = (a) * (v0)[3]; }
-
-#define SQR(x) ((x) * (x))
-
-#define __DOT2(x0, y0, x1, y1) (((x0) * (x1)) + ((y0) * (y1)))
-#define __DOT3(x0, y0, z0, x1, y1, z1) (((x0) * (x1)) + ((y0) * (y1)) + ((z0) * (z1)))
-#define __DOT4(x0, y0, z0, w0, x1, y1, z1, w1) (((x0) * (x1)) + ((y0) * (y1)) + ((z0) * (z1)) + ((w0) * (w1)))
-
-#define DOT2(m, m0, m1, r, c) (m)[c][r] = __DOT2((m0)[0][r], (m0)[1][r], (m1)[c][0], (m1)[c][1])
-#define DOT3(m, m0, m1, r, c) (m)[c][r] = __DOT3((m0)[0][r], (m0)[1][r], (m0)[2][r], (m1)[c][0], (m1)[c][1], (m1)[c][2])
-#define DOT4(m, m0, m1, r, c) (m)[c][r] = __DOT4((m0)[0][r], (m0)[1][r], (m0)[2][r], (m0)[3][r], (m1)[c][0], (m1)[c][1], (m1)[c][2], (m1)[c][3])
-
 #define DET2(a, b, c, d) ((a) * (d) - (b) * (c))
 #define DET3(a, b, c, d, e, f, g, h, i) (((a) * DET2((e), (f), (h), (i))) - ((b) * DET2((d), (f), (g), (i))) + ((c) * DET2((d), (e), (g), (h))))
 
 // ------------------------------------ Helper functions ------------------------------------------
 
-template <typename T> void WriteToBuffer(wchar_t*& pBuffer, size_t& szBuffer, T t)
+// Formats into pBuffer and advances it past the output (the math sources also build outside of Windows, see Samples/MathBenchmark)
+static void PrintToBuffer(wchar_t*& pBuffer, size_t& szBuffer, const wchar_t* format, ...)
 {
-	if constexpr (std::is_arithmetic<T>::value)
+	va_list args;
+	va_start(args, format);
+
+#ifdef _WIN32
+	StringCchVPrintfExW(pBuffer, szBuffer, &pBuffer, &szBuffer, 0, format, args);
+#else
+	const int n = vswprintf(pBuffer, szBuffer, format, args);
+	if (n > 0)
 	{
-		if constexpr (std::is_floating_point<T>::value) { StringCchPrintfExW(pBuffer, szBuffer, &pBuffer, &szBuffer, 0, L"%f", t); }
-		else if constexpr (std::is_unsigned<T>::value)  { StringCchPrintfExW(pBuffer, szBuffer, &pBuffer, &szBuffer, 0, L"%llu", static_cast<uint64_t>(t)); }
-		else											{ StringCchPrintfExW(pBuffer, szBuffer, &pBuffer, &szBuffer, 0, L"%lli", static_cast<int64_t>(t));  }
+		pBuffer  += n;
+		szBuffer -= n;
 	}
-	else												{ StringCchPrintfExW(pBuffer, szBuffer, &pBuffer, &szBuffer, 0, L"%s", t); }
-}
-
-// ------------------------------------ Scalar functions ------------------------------------------
-
-template <typename T>
-T Step(T v0, T v1, T step)
-{
-	T d = v1 - v0;
-	
-	if constexpr (std::is_floating_point<T>::value) { return (std::fabs(d) > step) ? (v0 + std::copysign(step, d)) : v1; }
-	else if constexpr (std::is_signed<T>::value)    { return static_cast<T>((std::abs(static_cast<int64_t>(d)) > step) ? (v0 + std::copysign(step, d)) : v1); }
-	else                                            { return static_cast<T>((d > step) ? (v0 + step) : v1); }
-}
-
-template <typename T>
-T Clamp(T val, T min, T max)
-{
-	return std::max(std::min(val, max), min);
-}
-
-// ----------------------------- Scalar function instantiations -----------------------------------
-
-#define INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(X) \
-	template X Step(X v0, X v1, X step);		 \
-    template X Clamp(X val, X min, X max);       \
+#endif
 
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(int8_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(int16_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(int32_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(int64_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(uint8_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(uint16_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(uint32_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(uint64_t)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(float)
-INSTANTIATE_SCALAR_FUNCTION_TEMPLATES(double)
-
-// ----------------------------------------- Vector2 ----------------------------------------------
-
-template <typename T> Vector2<T>::Vector2() { for (uint32_t i = 0; i < 2; i++) { elements[i] = 0; } }
-template <typename T> Vector2<T>::Vector2(T t) : Vector2<T>(t, t) { }
-template <typename T> Vector2<T>::Vector2(const Vector2<T>& v) : Vector2<T>(v.x, v.y) { }
-template <typename T> Vector2<T>::Vector2(T _x, T _y) : Vector2<T>() { x = _x; y = _y; }
-
-template <typename T> Vector2<T>& Vector2<T>::operator = (const Vector2<T>& v)
-{
-	this->x = v.x;
-	this->y = v.y;
-	return *this;
+	va_end(args);
 }
 
-template <typename T> T& Vector2<T>::operator[] (uint32_t i) { return elements[i]; }
-template <typename T> const T& Vector2<T>::operator[] (uint32_t i) const { return elements[i]; }
-
-template <typename T> Vector2<T> Vector2<T>::operator + () const { return Vector2<T>(+x, +y); }
-template <typename T> Vector2<T> Vector2<T>::operator - () const
+template <typename T> void WriteToBuffer(wchar_t*& pBuffer, size_t& szBuffer, T t)
 {
-	if constexpr (std::is_signed<T>::value) { return Vector2<T>(-x, -y); }
-	else { CgAssert(false, __FUNCTION__ L": cannot use unary minus operator on unsigned type"); return *this; }
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		if constexpr (std::is_floating_point<T>::value) { PrintToBuffer(pBuffer, szBuffer, L"%f", t); }
+		else if constexpr (std::is_unsigned<T>::value)  { PrintToBuffer(pBuffer, szBuffer, L"%llu", static_cast<unsigned long long>(t)); }
+		else											{ PrintToBuffer(pBuffer, szBuffer, L"%lli", static_cast<long long>(t));  }
+	}
+	else												{ PrintToBuffer(pBuffer, szBuffer, L"%ls", t); }
 }
 
-template <typename T> Vector2<T>  Vector2<T>::operator +  (const Vector2<T>& v) const { return Vector2<T>(x + v.x, y + v.y); }
-template <typename T> Vector2<T>  Vector2<T>::operator -  (const Vector2<T>& v) const { return Vector2<T>(x - v.x, y - v.y); }
-template <typename T> Vector2<T>& Vector2<T>::operator += (const Vector2<T>& v) { x += v.x; y += v.y; return *this; }
-template <typename T> Vector2<T>& Vector2<T>::operator -= (const Vector2<T>& v) { x -= v.x; y -= v.y; return *this; }
-
-template <typename T> Vector2<T>  Vector2<T>::operator *  (T t) const { return Vector2<T>(x * t, y * t); }
-template <typename T> Vector2<T>& Vector2<T>::operator *= (T t) { x *= t; y *= t; return *this; }
-
-template <typename T> Vector2<T> operator * (T t, Vector2<T>& v) { return v * t; }
+// ------------------------------------ Scalar functions ------------------------------------------
 
-template <typename T> bool Vector2<T>::operator < (const Vector2<T>& v) const
+// Cephes style sin/cos for |x| <= 8192: x is reduced to r in [-pi/4, pi/4] with a three part pi/2 (the products j * pi/2 are exact)
+// then both minimax polynomials are evaluated, the quadrant j selects and negates them. Simd::SinCos evaluates the same operations.
+static void SinCosApprox(float x, float& s, float& c)
 {
-	CMP(this->x, v.x);
-	CMP(this->y, v.y);
-	return false;
-}
-
-template <typename T> bool Vector2<T>::operator == (const Vector2<T>& v) const { return (x == v.x) && (y == v.y); }
-template <typename T> bool Vector2<T>::operator != (const Vector2<T>& v) const { return (x != v.x) || (y != v.y); }
+	const float j = std::nearbyint(x * 0.636619772f); // round to nearest even, as _mm_cvtps_epi32
+	const float r = ((x - j * 1.5703125f) - j * 4.83751297e-4f) - j * 7.54978995e-8f;
+	const float z = r * r;
 
-// ----------------------------------------- Vector3 ----------------------------------------------
+	const float ps = r + r * z * (-1.66666546e-1f + z * (8.33216087e-3f + z * -1.95152959e-4f));
+	const float pc = (1.0f - 0.5f * z) + z * z * (4.16666457e-2f + z * (-1.38873163e-3f + z * 2.44331571e-5f));
 
-template <typename T> Vector3<T>::Vector3() { for (uint32_t i = 0; i < 3; i++) { elements[i] = 0; } }
-template <typename T> Vector3<T>::Vector3(T t) : Vector3<T>(t, t, t) { }
-template <typename T> Vector3<T>::Vector3(const Vector3<T>& v) : Vector3<T>(v.x, v.y, v.z) { }
-template <typename T> Vector3<T>::Vector3(T _x, T _y, T _z) : Vector3<T>() { x = _x; y = _y; z = _z; }
-
-template <typename T> Vector3<T>& Vector3<T>::operator = (const Vector3<T>& v)
-{
-	this->x = v.x;
-	this->y = v.y;
-	this->z = v.z;
-	return *this;
+	const int32_t q = static_cast<int32_t>(j);
+	s = ((q & 1) != 0) ? pc : ps;
+	c = ((q & 1) != 0) ? ps : pc;
+	if ((q & 2) != 0)       { s = -s; }
+	if (((q + 1) & 2) != 0) { c = -c; }
 }
 
-template <typename T> T& Vector3<T>::operator[] (uint32_t i) { return elements[i]; }
-template <typename T> const T& Vector3<T>::operator[] (uint32_t i) const { return elements[i]; }
-
-template <typename T> Vector3<T> Vector3<T>::operator + () const { return Vector3<T>(+x, +y, +z); }
-template <typename T> Vector3<T> Vector3<T>::operator - () const
+template <typename T> void SinCos(const T* pIn, T* pSin, T* pCos, uint32_t count)
 {
-	if constexpr (std::is_signed<T>::value) { return Vector3<T>(-x, -y, -z); }
-	else { CgAssert(false, __FUNCTION__ L": cannot use unary minus operator on unsigned type"); return *this; }
-}
-
-template <typename T> Vector3<T>  Vector3<T>::operator +  (const Vector3<T>& v) const { return Vector3<T>(x + v.x, y + v.y, z + v.z); }
-template <typename T> Vector3<T>  Vector3<T>::operator -  (const Vector3<T>& v) const { return Vector3<T>(x - v.x, y - v.y, z - v.z); }
-template <typename T> Vector3<T>& Vector3<T>::operator += (const Vector3<T>& v) { x += v.x; y += v.y; z += v.z; return *this; }
-template <typename T> Vector3<T>& Vector3<T>::operator -= (const Vector3<T>& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
-
-template <typename T> Vector3<T>  Vector3<T>::operator *  (T t) const { return Vector3<T>(x * t, y * t, z * t); }
-template <typename T> Vector3<T>& Vector3<T>::operator *= (T t) { x *= t; y *= t; z *= t; return *this; }
-
-template <typename T> Vector3<T> operator * (T t, Vector3<T>& v) { return v * t; }
-
-template <typename T> bool Vector3<T>::operator < (const Vector3<T>& v) const
-{
-	CMP(this->x, v.x);
-	CMP(this->y, v.y);
-	CMP(this->z, v.z);
-	return false;
-}
-
-template <typename T> bool Vector3<T>::operator == (const Vector3<T>& v) const { return (x == v.x) && (y == v.y) && (z == v.z); }
-template <typename T> bool Vector3<T>::operator != (const Vector3<T>& v) const { return (x != v.x) || (y != v.y) || (z != v.z); }
-
-// ----------------------------------------- Vector4 ----------------------------------------------
-
-template <typename T> Vector4<T>::Vector4() { for (uint32_t i = 0; i < 4; i++) { elements[i] = 0; } }
-template <typename T> Vector4<T>::Vector4(T t) : Vector4<T>(t, t, t, t) { }
-template <typename T> Vector4<T>::Vector4(const Vector4<T>& v) : Vector4<T>(v.x, v.y, v.z, v.w) { }
-template <typename T> Vector4<T>::Vector4(T _x, T _y, T _z, T _w) : Vector4<T>() { x = _x; y = _y; z = _z; w = _w; }
-
-template <typename T> Vector4<T>& Vector4<T>::operator = (const Vector4<T>& v)
-{
-	this->x = v.x;
-	this->y = v.y;
-	this->z = v.z;
-	this->w = v.w;
-	return *this;
+	if constexpr (std::is_same<T, float>::value)
+	{
+#if CG_MATH_SSE
+		Simd::SinCos(pIn, pSin, pCos, count);
+		return;
+#endif
+		for (uint32_t i = 0; i < count; i++) { SinCosApprox(pIn[i], pSin[i], pCos[i]); }
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const T x = pIn[i];
+			pSin[i] = std::sin(x);
+			pCos[i] = std::cos(x);
+		}
+	}
 }
 
-template <typename T> T& Vector4<T>::operator[] (uint32_t i) { return elements[i]; }
-template <typename T> const T& Vector4<T>::operator[] (uint32_t i) const { return elements[i]; }
-
-template <typename T> Vector4<T> Vector4<T>::operator + () const { return Vector4<T>(+x, +y, +z, +w); }
-template <typename T> Vector4<T> Vector4<T>::operator - () const
+template <typename T> void ReciprocalSqrt(const T* pIn, T* pOut, uint32_t count)
 {
-	if constexpr (std::is_signed<T>::value) { return Vector4<T>(-x, -y, -z, -w); }
-	else { CgAssert(false, __FUNCTION__ L": cannot use unary minus operator on unsigned type"); return *this; }
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::ReciprocalSqrt(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = static_cast<T>(1) / std::sqrt(pIn[i]); }
 }
 
-template <typename T> Vector4<T>  Vector4<T>::operator +  (const Vector4<T>& v) const { return Vector4<T>(x + v.x, y + v.y, z + v.z, w + v.w); }
-template <typename T> Vector4<T>  Vector4<T>::operator -  (const Vector4<T>& v) const { return Vector4<T>(x - v.x, y - v.y, z - v.z, w - v.w); }
-template <typename T> Vector4<T>& Vector4<T>::operator += (const Vector4<T>& v) { x += v.x; y += v.y; z += v.z; w += v.w; return *this; }
-template <typename T> Vector4<T>& Vector4<T>::operator -= (const Vector4<T>& v) { x -= v.x; y -= v.y; z -= v.z; w -= v.w; return *this; }
+// ------------------------- Scalar template/function instantiations ------------------------------
 
-template <typename T> Vector4<T>  Vector4<T>::operator *  (T t) const { return Vector4<T>(x * t, y * t, z * t, w * t); }
-template <typename T> Vector4<T>& Vector4<T>::operator *= (T t) { x *= t; y *= t; z *= t; w *= t; return *this; }
+#define INSTANTIATE_SCALAR_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)						\
+	template void SinCos(const X* pIn, X* pSin, X* pCos, uint32_t count);			\
+	template void ReciprocalSqrt(const X* pIn, X* pOut, uint32_t count);			\
 
-template <typename T> Vector4<T> operator * (T t, Vector4<T>& v) { return v * t; }
-
-template <typename T> bool Vector4<T>::operator < (const Vector4<T>& v) const
-{
-	CMP(this->x, v.x);
-	CMP(this->y, v.y);
-	CMP(this->z, v.z);
-	CMP(this->w, v.w);
-	return false;
-}
-
-template <typename T> bool Vector4<T>::operator == (const Vector4<T>& v) const { return (x == v.x) && (y == v.y) && (z == v.z) && (w == v.w); }
-template <typename T> bool Vector4<T>::operator != (const Vector4<T>& v) const { return (x != v.x) || (y != v.y) || (z != v.z) || (w != v.w); }
+INSTANTIATE_SCALAR_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
+INSTANTIATE_SCALAR_TEMPLATES_FOR_FLOATING_POINT_TYPE(double)
 
 // ------------------------------------ Vector functions ------------------------------------------
 
-template <typename T> T Vector::Length(const Vector2<T>& v) { return std::sqrt(SQR(v.x) + SQR(v.y)); }
-template <typename T> T Vector::Length(const Vector3<T>& v) { return std::sqrt(SQR(v.x) + SQR(v.y) + SQR(v.z)); }
-template <typename T> T Vector::Length(const Vector4<T>& v) { return std::sqrt(SQR(v.x) + SQR(v.y) + SQR(v.z) + SQR(v.w)); }
-
-template <typename T> T Vector::Dot(const Vector2<T>& v0, const Vector2<T>& v1) { return (v0.x * v1.x) + (v0.y + v1.y); }
-template <typename T> T Vector::Dot(const Vector3<T>& v0, const Vector3<T>& v1) { return (v0.x * v1.x) + (v0.y + v1.y) + (v0.z * v1.z); }
-template <typename T> T Vector::Dot(const Vector4<T>& v0, const Vector4<T>& v1) { return (v0.x * v1.x) + (v0.y + v1.y) + (v0.z * v1.z) + (v0.w * v1.w); }
-
-template <typename T> Vector2<T> Vector::Normalize(const Vector2<T>& v) { return v * (1.0f / Vector::Length(v)); }
-template <typename T> Vector3<T> Vector::Normalize(const Vector3<T>& v) { return v * (1.0f / Vector::Length(v)); }
-template <typename T> Vector4<T> Vector::Normalize(const Vector4<T>& v) { return v * (1.0f / Vector::Length(v)); }
-
-template <typename T> Vector3<T> Vector::Cross(const Vector3<T>& v0, const Vector3<T>& v1)
-{
-	T x = (v0.y * v1.z) - (v0.z * v1.y);
-	T y = (v0.x * v1.z) - (v0.z * v1.x);
-	T z = (v0.x * v1.y) - (v0.y * v1.x);
-	return Vector3<T>(x, -y, z);
-}
-
-template <typename T> T Vector::Distance(const Vector2<T>& v0, const Vector2<T>& v1) { return std::sqrt(SQR(v1.x - v0.x) + SQR(v1.y - v0.y)); }
-template <typename T> T Vector::Distance(const Vector3<T>& v0, const Vector3<T>& v1) { return std::sqrt(SQR(v1.x - v0.x) + SQR(v1.y - v0.y) + SQR(v1.z - v0.z)); }
-template <typename T> T Vector::Distance(const Vector4<T>& v0, const Vector4<T>& v1) { return std::sqrt(SQR(v1.x - v0.x) + SQR(v1.y - v0.y) + SQR(v1.z - v0.z) + SQR(v1.w - v0.w)); }
-
 template <typename T> std::wstring VectorToString(T* pElements, size_t nElements)
 {
 	wchar_t buffer[2048] = {};
@@ -277,31 +135,33 @@ template <typename T> std::wstring Vector::ToString(const Vector2<T>& v) { retur
 template <typename T> std::wstring Vector::ToString(const Vector3<T>& v) { return VectorToString(v.elements, _countof(v.elements)); }
 template <typename T> std::wstring Vector::ToString(const Vector4<T>& v) { return VectorToString(v.elements, _countof(v.elements)); }
 
+template <typename T> void Vector::Normalize(const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Normalize(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Vector::Normalize(pIn[i]); }
+}
+
+template <typename T> void Vector::Normalize(const Vector4<T>* pIn, Vector4<T>* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Normalize(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Vector::Normalize(pIn[i]); }
+}
+
 // ------------------------- Vector template/function instantiations ------------------------------
 
 #define INSTANTIATE_VECTOR_TEMPLATES_FOR_TYPE(X)                                        \
-    template struct Vector2<X>;                                                         \
-    template struct Vector3<X>;                                                         \
-    template struct Vector4<X>;                                                         \
 	template std::wstring Vector::ToString(const Vector2<X>& v);						\
 	template std::wstring Vector::ToString(const Vector3<X>& v);						\
 	template std::wstring Vector::ToString(const Vector4<X>& v);						\
 
 #define INSTANTIATE_VECTOR_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)							\
 	INSTANTIATE_VECTOR_TEMPLATES_FOR_TYPE(X)											\
-    template X Vector::Length(const Vector2<X>& v);                                     \
-    template X Vector::Length(const Vector3<X>& v);                                     \
-    template X Vector::Length(const Vector4<X>& v);                                     \
-    template X Vector::Dot(const Vector2<X>& v0, const Vector2<X>& v1);                 \
-    template X Vector::Dot(const Vector3<X>& v0, const Vector3<X>& v1);                 \
-    template X Vector::Dot(const Vector4<X>& v0, const Vector4<X>& v1);                 \
-    template Vector2<X> Vector::Normalize(const Vector2<X>& v0);                        \
-    template Vector3<X> Vector::Normalize(const Vector3<X>& v0);                        \
-    template Vector4<X> Vector::Normalize(const Vector4<X>& v0);                        \
-    template Vector3<X> Vector::Cross(const Vector3<X>& v0, const Vector3<X>& v1);      \
-	template X Vector::Distance(const Vector2<X>& v0, const Vector2<X>& v1);            \
-    template X Vector::Distance(const Vector3<X>& v0, const Vector3<X>& v1);            \
-    template X Vector::Distance(const Vector4<X>& v0, const Vector4<X>& v1);            \
+	template void Vector::Normalize(const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count); \
+	template void Vector::Normalize(const Vector4<X>* pIn, Vector4<X>* pOut, uint32_t count); \
 
 INSTANTIATE_VECTOR_TEMPLATES_FOR_TYPE(int8_t)
 INSTANTIATE_VECTOR_TEMPLATES_FOR_TYPE(int16_t)
@@ -317,21 +177,24 @@ INSTANTIATE_VECTOR_TEMPLATES_FOR_FLOATING_POINT_TYPE(double)
 
 // --------------------------------------- Quaternion ---------------------------------------------
 
-template <typename T> Quaternion<T>::Quaternion() { for (uint32_t i = 0; i < 4; i++) { elements[i] = 0; } }
-template <typename T> Quaternion<T>::Quaternion(const Vector3<T>& v) : Quaternion<T>(v.x, v.y, v.z) { }
-template <typename T> Quaternion<T>::Quaternion(const Vector4<T>& v) : Quaternion<T>(v.x, v.y, v.z, v.w) { }
-template <typename T> Quaternion<T>::Quaternion(T _x, T _y, T _z, T _w) : Quaternion<T>() { x = _x; y = _y; z = _z; w = _w; }
+// Rotation from the cosines and sines of the half Euler angles, shared with Quat::Convert (Simd::Convert uses the same order)
+template <typename T> static Quaternion<T> EulerToQuaternion(const Vector3<T>& c, const Vector3<T>& s)
+{
+	return Quaternion<T>(
+		s.x * c.y * c.z - c.x * s.y * s.z,
+		c.x * s.y * c.z + s.x * c.y * s.z,
+		c.x * c.y * s.z - s.x * s.y * c.z,
+		c.x * c.y * c.z + s.x * s.y * s.z
+	);
+}
 
 template <typename T> Quaternion<T>::Quaternion(T _x, T _y, T _z) : Quaternion<T>()
 {
-	const Vector3F h = Vector3<T>(_x, _y, _z) * 0.5f; // half-rotation vector
-	const Vector3F c(cosf(h.x), cosf(h.y), cosf(h.z));
-	const Vector3F s(sinf(h.x), sinf(h.y), sinf(h.z));
+	const Vector3<T> h = Vector3<T>(_x, _y, _z) * static_cast<T>(0.5); // half-rotation vector
+	const Vector3<T> c(std::cos(h.x), std::cos(h.y), std::cos(h.z));
+	const Vector3<T> s(std::sin(h.x), std::sin(h.y), std::sin(h.z));
 
-	w = c.x * c.y * c.z + s.x * s.y * s.z;
-	x = s.x * c.y * c.z - c.x * s.y * s.z;
-	y = c.x * s.y * c.z + s.x * c.y * s.z;
-	z = c.x * c.y * s.z - s.x * s.y * c.z;
+	*this = EulerToQuaternion(c, s);
 }
 
 template <typename T> Quaternion<T>::Quaternion(const struct Matrix3<T>& m) : Quaternion<T>()
@@ -370,590 +233,602 @@ template <typename T> Quaternion<T>::Quaternion(const struct Matrix3<T>& m) : Qu
 	}
 }
 
-template <typename T> Quaternion<T> Quaternion<T>::operator * (const Quaternion<T> & q) const
-{
-	Quaternion<T> r;
-	r.w = w*q.w - x*q.x - y*q.y - z*q.z;
-	r.x = w*q.x + x*q.w + y*q.z - z*q.y;
-	r.y = w*q.y - x*q.z + y*q.w + z*q.x;
-	r.z = w*q.z + x*q.y - y*q.x + z*q.w;
-	return r;
-}
+// ---------------------------------- Quaternion functions ----------------------------------------
 
-template <typename T> Quaternion<T>& Quaternion<T>::operator *= (const Quaternion<T>& q)
+template <typename T> void Quat::Normalize(const Quaternion<T>* pIn, Quaternion<T>* pOut, uint32_t count)
 {
-	Quaternion<T> r = *this;
-	w = r.w*q.w - r.x*q.x - r.y*q.y - r.z*q.z;
-	x = r.w*q.x + r.x*q.w + r.y*q.z - r.z*q.y;
-	y = r.w*q.y - r.x*q.z + r.y*q.w + r.z*q.x;
-	z = r.w*q.z + r.x*q.y - r.y*q.x + r.z*q.w;
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Normalize(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Quat::Normalize(pIn[i]); }
 }
 
-template <typename T> Quaternion<T>& Quaternion<T>::operator = (const Vector4<T>& v)
+template <typename T> void Quat::Multiply(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, Quaternion<T>* pOut, uint32_t count)
 {
-	w = v.w;
-	x = v.x;
-	y = v.y;
-	z = v.z;
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Multiply(pIn0, pIn1, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = pIn0[i] * pIn1[i]; }
 }
 
-template <typename T> Quaternion<T>& Quaternion<T>::operator = (const Quaternion& q)
+template <typename T> void Quat::Rotate(const Quaternion<T>& q, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	w = q.w;
-	x = q.x;
-	y = q.y;
-	z = q.z;
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Rotate(q, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = q.Rotate(pIn[i]); }
 }
 
-#define INSTANTIATE_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(X) \
-    template struct Quaternion<X>;
-
-INSTANTIATE_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
-
-// ----------------------------------------- Matrix2 ----------------------------------------------
-
-template <typename T> Matrix2<T>::Matrix2() : Matrix2<T>(static_cast<T>(1)) { }
-template <typename T> Matrix2<T>::Matrix2(T t)
+template <typename T> void Quat::Nlerp(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, T t, Quaternion<T>* pOut, uint32_t count)
 {
-	rows[0] = Vector2<T>(t, 0);
-	rows[1] = Vector2<T>(0, t);
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Nlerp(pIn0, pIn1, t, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Quat::Nlerp(pIn0[i], pIn1[i], t); }
 }
-template <typename T> Matrix2<T>::Matrix2(const Vector2<T>& v0, const Vector2<T>& v1)
+
+template <typename T> void Quat::Slerp(const Quaternion<T>* pIn0, const Quaternion<T>* pIn1, T t, Quaternion<T>* pOut, uint32_t count)
 {
-	rows[0] = v0;
-	rows[1] = v1;
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Quat::Slerp(pIn0[i], pIn1[i], t); }
 }
-template <typename T> Matrix2<T>::Matrix2(const Matrix2<T>& m) : Matrix2<T>(m[0], m[1]) { }
 
-template <typename T> Matrix2<T>& Matrix2<T>::operator = (const Matrix2<T>& m)
+template <typename T> void Quat::Convert(const Vector3<T>* pIn, Quaternion<T>* pOut, uint32_t count)
 {
-	this->rows[0] = m.rows[0];
-	this->rows[1] = m.rows[1];
-	return *this;
+	if constexpr (std::is_same<T, float>::value)
+	{
+#if CG_MATH_SSE
+		Simd::Convert(pIn, pOut, count);
+		return;
+#endif
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Vector3<T> h = pIn[i] * 0.5f;
+
+			Vector3<T> c, s;
+			for (uint32_t j = 0; j < 3; j++) { SinCosApprox(h[j], s[j], c[j]); }
+
+			pOut[i] = EulerToQuaternion(c, s);
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; i++) { pOut[i] = Quaternion<T>(pIn[i].x, pIn[i].y, pIn[i].z); }
+	}
 }
 
-template <typename T> Vector2<T>& Matrix2<T>::operator[] (uint32_t i) { return rows[i]; }
-template <typename T> const Vector2<T>& Matrix2<T>::operator[] (uint32_t i) const { return rows[i]; }
+// ----------------------- Quaternion template/function instantiations ----------------------------
+
+#define INSTANTIATE_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(X) \
+	template Quaternion<X>::Quaternion(X _x, X _y, X _z);			\
+	template Quaternion<X>::Quaternion(const Matrix3<X>& m);		\
+	template void Quat::Normalize(const Quaternion<X>* pIn, Quaternion<X>* pOut, uint32_t count);								\
+	template void Quat::Multiply(const Quaternion<X>* pIn0, const Quaternion<X>* pIn1, Quaternion<X>* pOut, uint32_t count);	\
+	template void Quat::Rotate(const Quaternion<X>& q, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count);				\
+	template void Quat::Nlerp(const Quaternion<X>* pIn0, const Quaternion<X>* pIn1, X t, Quaternion<X>* pOut, uint32_t count);	\
+	template void Quat::Slerp(const Quaternion<X>* pIn0, const Quaternion<X>* pIn1, X t, Quaternion<X>* pOut, uint32_t count);	\
+	template void Quat::Convert(const Vector3<X>* pIn, Quaternion<X>* pOut, uint32_t count);									\
+
+INSTANTIATE_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
+
+// ------------------------------------ Matrix functions ------------------------------------------
 
-template <typename T> Matrix2<T> Matrix2<T>::operator * (T t) const
+template <typename T> Matrix2<T> Matrix::Inverse(const Matrix2<T>& m)
 {
 	Matrix2<T> r;
-	MUL2(t, this->elements[0], r.elements[0]);
-	MUL2(t, this->elements[1], r.elements[1]);
-	return r;
+	T det = static_cast<T>(1) / DET2(m[0][0], m[0][1], m[1][0], m[1][1]);
+	
+	r[0][0] = m[1][1];
+	r[1][1] = m[0][0];
+	r[0][1] = -m[0][1];
+	r[1][0] = -m[1][0];
+
+	return (r * det);
 }
 
-template <typename T> Matrix2<T>& Matrix2<T>::operator *= (T t)
+template <typename T> Matrix3<T> Matrix::Inverse(const Matrix3<T>& m)
 {
-	MUL2(t, this->elements[0], this->elements[0]);
-	MUL2(t, this->elements[1], this->elements[1]);
-	return *this;
+	Matrix3<T> r;
+	T det = static_cast<T>(1) / DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]);
+	
+	r[0][0] = +DET2(m[1][1], m[1][2], m[2][1], m[2][2]);
+	r[1][0] = -DET2(m[1][0], m[1][2], m[2][0], m[2][2]);
+	r[2][0] = +DET2(m[1][0], m[1][1], m[2][0], m[2][1]);
+	r[0][1] = -DET2(m[0][1], m[0][2], m[2][1], m[2][2]);
+	r[1][1] = +DET2(m[0][0], m[0][2], m[2][0], m[2][2]);
+	r[2][1] = -DET2(m[0][0], m[0][1], m[2][0], m[2][1]);
+	r[0][2] = +DET2(m[0][1], m[0][2], m[1][1], m[1][2]);
+	r[1][2] = -DET2(m[0][0], m[0][2], m[1][0], m[1][2]);
+	r[2][2] = +DET2(m[0][0], m[0][1], m[1][0], m[1][1]);
+
+	return (r * det);
 }
 
-template <typename T> Matrix2<T> Matrix2<T>::operator + (const Matrix2<T>& m) const
+template <typename T> Matrix4<T> Matrix::Inverse(const Matrix4<T>& m)
 {
-	Matrix2<T> r;
-	ADD2(this->elements[0], m.elements[0], r.elements[0]);
-	ADD2(this->elements[1], m.elements[1], r.elements[1]);
-	return r;
+	Matrix4<T> r;
+
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Inverse(m, r); return r; }
+#endif
+
+	T m0 = m[0][0] * DET3(m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
+	T m1 = m[0][1] * DET3(m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
+	T m2 = m[0][2] * DET3(m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
+	T m3 = m[0][3] * DET3(m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
+	T det = static_cast<T>(1) / (m0 - m1 + m2 - m3);
+
+	r[0][0] = +DET3(m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
+	r[1][0] = -DET3(m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
+	r[2][0] = +DET3(m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
+	r[3][0] = -DET3(m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
+
+	r[0][1] = -DET3(m[0][1], m[0][2], m[0][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
+	r[1][1] = +DET3(m[0][0], m[0][2], m[0][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
+	r[2][1] = -DET3(m[0][0], m[0][1], m[0][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
+	r[3][1] = +DET3(m[0][0], m[0][1], m[0][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
+
+	r[0][2] = +DET3(m[0][1], m[0][2], m[0][3], m[1][1], m[1][2], m[1][3], m[3][1], m[3][2], m[3][3]);
+	r[1][2] = -DET3(m[0][0], m[0][2], m[0][3], m[1][0], m[1][2], m[1][3], m[3][0], m[3][2], m[3][3]);
+	r[2][2] = +DET3(m[0][0], m[0][1], m[0][3], m[1][0], m[1][1], m[1][3], m[3][0], m[3][1], m[3][3]);
+	r[3][2] = -DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[3][0], m[3][1], m[3][2]);
+
+	r[0][3] = -DET3(m[0][1], m[0][2], m[0][3], m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3]);
+	r[1][3] = +DET3(m[0][0], m[0][2], m[0][3], m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3]);
+	r[2][3] = -DET3(m[0][0], m[0][1], m[0][3], m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3]);
+	r[3][3] = +DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]);
+
+	return (r * det);
 }
 
-template <typename T> Matrix2<T> Matrix2<T>::operator - (const Matrix2<T>& m) const
+template <typename T> Matrix4<T> Matrix::InverseAffine(const Matrix4<T>& m)
 {
-	Matrix2<T> r;
-	SUB2(this->elements[0], m.elements[0], r.elements[0]);
-	SUB2(this->elements[1], m.elements[1], r.elements[1]);
+	Matrix4<T> r;
+
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::InverseAffine(m, r); return r; }
+#endif
+
+	// The 3x3 block is inverted with cross products: its inverse has the columns (a1 x a2, a2 x a0, a0 x a1) / det
+	const Vector3<T> a0(m[0][0], m[0][1], m[0][2]);
+	const Vector3<T> a1(m[1][0], m[1][1], m[1][2]);
+	const Vector3<T> a2(m[2][0], m[2][1], m[2][2]);
+
+	const Vector3<T> x0 = Vector::Cross(a1, a2);
+	const Vector3<T> x1 = Vector::Cross(a2, a0);
+	const Vector3<T> x2 = Vector::Cross(a0, a1);
+
+	const T s = static_cast<T>(1) / Vector::Dot(a0, x0);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		r[i] = Vector4<T>(x0[i] * s, x1[i] * s, x2[i] * s, 0);
+	}
+
+	// the translation is moved back through the inverted block
+	r[3] = -(r[0] * m[3][0] + r[1] * m[3][1] + r[2] * m[3][2]);
+	r[3][3] = static_cast<T>(1);
+
 	return r;
 }
 
-template <typename T> Matrix2<T>& Matrix2<T>::operator += (const Matrix2<T>& m)
+template <typename T> Matrix4<T> Matrix::InverseRigid(const Matrix4<T>& m)
 {
-	ADD2(this->elements[0], m.elements[0], this->elements[0]);
-	ADD2(this->elements[1], m.elements[1], this->elements[1]);
-	return *this;
-}
+	Matrix4<T> r;
 
-template <typename T> Matrix2<T>& Matrix2<T>::operator -= (const Matrix2<T>& m)
-{
-	SUB2(this->elements[0], m.elements[0], this->elements[0]);
-	SUB2(this->elements[1], m.elements[1], this->elements[1]);
-	return *this;
-}
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::InverseRigid(m, r); return r; }
+#endif
+
+	// The inverse of an orthonormal 3x3 block is its transpose
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		r[i] = Vector4<T>(m[0][i], m[1][i], m[2][i], 0);
+	}
+
+	r[3] = -(r[0] * m[3][0] + r[1] * m[3][1] + r[2] * m[3][2]);
+	r[3][3] = static_cast<T>(1);
 
-template <typename T> Matrix2<T> Matrix2<T>::operator * (const Matrix2<T>& m) const
-{
-	Matrix2<T> r;
-	DOT2(r.rows, this->rows, m.rows, 0, 0);
-	DOT2(r.rows, this->rows, m.rows, 0, 1);
-	DOT2(r.rows, this->rows, m.rows, 1, 0);
-	DOT2(r.rows, this->rows, m.rows, 1, 1);
 	return r;
 }
 
-template <typename T> Matrix2<T>& Matrix2<T>::operator *= (const Matrix2<T>& m)
+template <typename T> Matrix3x4<T> Matrix::Inverse(const Matrix3x4<T>& m)
 {
-	Matrix2<T> c(*this);
-	DOT2(this->rows, c.rows, m.rows, 0, 0);
-	DOT2(this->rows, c.rows, m.rows, 0, 1);
-	DOT2(this->rows, c.rows, m.rows, 1, 0);
-	DOT2(this->rows, c.rows, m.rows, 1, 1);
-	return *this;
+	// | L t |^-1 = | L^-1  -L^-1 * t |
+	// | 0 1 |      | 0      1        |
+	const Matrix3<T> l = Matrix::Inverse(Matrix3<T>(
+		Vector3<T>(m[0][0], m[0][1], m[0][2]),
+		Vector3<T>(m[1][0], m[1][1], m[1][2]),
+		Vector3<T>(m[2][0], m[2][1], m[2][2])
+	));
+	const Vector3<T> t(m[0][3], m[1][3], m[2][3]);
+
+	Matrix3x4<T> r;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		r[i] = Vector4<T>(l[i], -Vector::Dot(l[i], t));
+	}
+	return r;
 }
 
-template <typename T> Vector2<T> Matrix2<T>::operator * (const Vector2<T>& v) const
+template <typename T> std::wstring MatrixToString(T* pElements, size_t nRows, size_t nColumns)
 {
-	return Vector2<T>(
-		Vector::Dot<T>(v, rows[0]),
-		Vector::Dot<T>(v, rows[1])
-	);
-}
+	wchar_t buffer[2048] = {};
 
-// ----------------------------------------- Matrix3 ----------------------------------------------
+	wchar_t* pBuffer = buffer;
+	size_t szBuffer = _countof(buffer);
 
-template <typename T> Matrix3<T>::Matrix3() : Matrix3<T>(static_cast<T>(1)) { }
-template <typename T> Matrix3<T>::Matrix3(T t)
-{
-	rows[0] = Vector3<T>(t, 0, 0);
-	rows[1] = Vector3<T>(0, t, 0);
-	rows[2] = Vector3<T>(0, 0, t);
-}
-template <typename T> Matrix3<T>::Matrix3(const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2)
-{
-	rows[0] = v0;
-	rows[1] = v1;
-	rows[2] = v2;
-}
-template <typename T> Matrix3<T>::Matrix3(const Matrix3<T>& m) : Matrix3<T>(m[0], m[1], m[2]) { }
+	for (uint32_t i = 0; i < nRows; i++)
+	{
+		WriteToBuffer(pBuffer, szBuffer, L"[");
+		for (uint32_t j = 0; j < nColumns; j++)
+		{
+			WriteToBuffer(pBuffer, szBuffer, *(pElements + (i * nColumns) + j));
+			if (j != (nColumns - 1))
+			{
+				WriteToBuffer(pBuffer, szBuffer, L", ");
+			}
+		}
+		WriteToBuffer(pBuffer, szBuffer, L"]\n");
+	}
 
-template <typename T> Matrix3<T>& Matrix3<T>::operator = (const Matrix3<T>& m)
-{
-	rows[0] = m.rows[0];
-	rows[1] = m.rows[1];
-	rows[2] = m.rows[2];
-	return *this;
+	*pBuffer = 0; // null-terminate
+
+	return std::wstring(buffer);
 }
 
-template <typename T> Vector3<T>& Matrix3<T>::operator[] (uint32_t i) { return rows[i]; }
-template <typename T> const Vector3<T>& Matrix3<T>::operator[] (uint32_t i) const { return rows[i]; }
+template <typename T> std::wstring Matrix::ToString(const Matrix2<T>& m) { return MatrixToString(&m.elements[0][0], 2, 2); }
+template <typename T> std::wstring Matrix::ToString(const Matrix3<T>& m) { return MatrixToString(&m.elements[0][0], 3, 3); }
+template <typename T> std::wstring Matrix::ToString(const Matrix4<T>& m) { return MatrixToString(&m.elements[0][0], 4, 4); }
+template <typename T> std::wstring Matrix::ToString(const Matrix3x4<T>& m) { return MatrixToString(&m.elements[0][0], 3, 4); }
 
-template <typename T> Matrix3<T> Matrix3<T>::operator * (T t) const
+template <typename T> void Matrix::Transform(const Matrix4<T>& m, const Vector4<T>* pIn, Vector4<T>* pOut, uint32_t count)
 {
-	Matrix3<T> r;
-	MUL3(t, this->elements[0], r.elements[0]);
-	MUL3(t, this->elements[1], r.elements[1]);
-	MUL3(t, this->elements[2], r.elements[2]);
-	return r;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Transform(m, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = m * pIn[i]; }
 }
 
-template <typename T> Matrix3<T>& Matrix3<T>::operator *= (T t)
+template <typename T> void Matrix::TransformPoints(const Matrix4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	MUL3(t, this->elements[0], this->elements[0]);
-	MUL3(t, this->elements[1], this->elements[1]);
-	MUL3(t, this->elements[2], this->elements[2]);
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::TransformPoints(m, pIn, pOut, count); return; }
+#endif
+	// x * m[0] + y * m[1] + z * m[2] + m[3], the translation of Matrix::Translate is m[3]
+	const Matrix3x4<T> a(m);
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = a * Vector4<T>(pIn[i], static_cast<T>(1)); }
 }
 
-template <typename T> Matrix3<T> Matrix3<T>::operator + (const Matrix3<T>& m) const
+template <typename T> void Matrix::TransformVectors(const Matrix4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	Matrix3<T> r;
-	ADD3(this->elements[0], m.elements[0], r.elements[0]);
-	ADD3(this->elements[1], m.elements[1], r.elements[1]);
-	ADD3(this->elements[2], m.elements[2], r.elements[2]);
-	return r;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::TransformVectors(m, pIn, pOut, count); return; }
+#endif
+	const Matrix3x4<T> a(m);
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = a * Vector4<T>(pIn[i], static_cast<T>(0)); }
 }
 
-template <typename T> Matrix3<T> Matrix3<T>::operator - (const Matrix3<T>& m) const
+template <typename T> void Matrix::Multiply(const Matrix4<T>& m, const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count)
 {
-	Matrix3<T> r;
-	SUB3(this->elements[0], m.elements[0], r.elements[0]);
-	SUB3(this->elements[1], m.elements[1], r.elements[1]);
-	SUB3(this->elements[2], m.elements[2], r.elements[2]);
-	return r;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Multiply(m, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = m * pIn[i]; }
 }
 
-template <typename T> Matrix3<T>& Matrix3<T>::operator += (const Matrix3<T>& m)
+template <typename T> void Matrix::Multiply(const Matrix4<T>* pIn, const Matrix4<T>& m, Matrix4<T>* pOut, uint32_t count)
 {
-	ADD3(this->elements[0], m.elements[0], this->elements[0]);
-	ADD3(this->elements[1], m.elements[1], this->elements[1]);
-	ADD3(this->elements[2], m.elements[2], this->elements[2]);
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Multiply(pIn, m, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = pIn[i] * m; }
 }
 
-template <typename T> Matrix3<T>& Matrix3<T>::operator -= (const Matrix3<T>& m)
+template <typename T> void Matrix::InverseAffine(const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count)
 {
-	SUB3(this->elements[0], m.elements[0], this->elements[0]);
-	SUB3(this->elements[1], m.elements[1], this->elements[1]);
-	SUB3(this->elements[2], m.elements[2], this->elements[2]);
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::InverseAffine(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Matrix::InverseAffine(pIn[i]); }
 }
 
-template <typename T> Matrix3<T> Matrix3<T>::operator * (const Matrix3<T>& m) const
+template <typename T> void Matrix::InverseRigid(const Matrix4<T>* pIn, Matrix4<T>* pOut, uint32_t count)
 {
-	Matrix3<T> r;
-	DOT3(r.rows, rows, m.rows, 0, 0);
-	DOT3(r.rows, rows, m.rows, 0, 1);
-	DOT3(r.rows, rows, m.rows, 0, 2);
-	DOT3(r.rows, rows, m.rows, 1, 0);
-	DOT3(r.rows, rows, m.rows, 1, 1);
-	DOT3(r.rows, rows, m.rows, 1, 2);
-	DOT3(r.rows, rows, m.rows, 2, 0);
-	DOT3(r.rows, rows, m.rows, 2, 1);
-	DOT3(r.rows, rows, m.rows, 2, 2);
-	return r;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::InverseRigid(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Matrix::InverseRigid(pIn[i]); }
 }
 
-template <typename T> Matrix3<T>& Matrix3<T>::operator *= (const Matrix3<T>& m)
+template <typename T> void Matrix::TransformPoints(const Matrix3x4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	Matrix3<T> c(*this);
-	DOT3(rows, c.rows, m.rows, 0, 0);
-	DOT3(rows, c.rows, m.rows, 0, 1);
-	DOT3(rows, c.rows, m.rows, 0, 2);
-	DOT3(rows, c.rows, m.rows, 1, 0);
-	DOT3(rows, c.rows, m.rows, 1, 1);
-	DOT3(rows, c.rows, m.rows, 1, 2);
-	DOT3(rows, c.rows, m.rows, 2, 0);
-	DOT3(rows, c.rows, m.rows, 2, 1);
-	DOT3(rows, c.rows, m.rows, 2, 2);
-	return *this;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::TransformPoints(m, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = m * Vector4<T>(pIn[i], static_cast<T>(1)); }
 }
 
-template <typename T> Vector3<T> Matrix3<T>::operator * (const Vector3<T>& v) const
+template <typename T> void Matrix::TransformVectors(const Matrix3x4<T>& m, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	return Vector3<T>(
-		Vector::Dot<T>(v, rows[0]),
-		Vector::Dot<T>(v, rows[1]),
-		Vector::Dot<T>(v, rows[2])
-	);
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::TransformVectors(m, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = m * Vector4<T>(pIn[i], static_cast<T>(0)); }
 }
 
-// ----------------------------------------- Matrix4 ----------------------------------------------
-
-template <typename T> Matrix4<T>::Matrix4() : Matrix4<T>(static_cast<T>(1)) { }
-template <typename T> Matrix4<T>::Matrix4(T t)
+template <typename T> void Matrix::Multiply(const Matrix3x4<T>& m, const Matrix3x4<T>* pIn, Matrix3x4<T>* pOut, uint32_t count)
 {
-	rows[0] = Vector4<T>(t, 0, 0, 0);
-	rows[1] = Vector4<T>(0, t, 0, 0);
-	rows[2] = Vector4<T>(0, 0, t, 0);
-	rows[3] = Vector4<T>(0, 0, 0, t);
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Multiply(m, pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = m * pIn[i]; }
 }
-template <typename T> Matrix4<T>::Matrix4(const Vector4<T>& v0, const Vector4<T>& v1, const Vector4<T>& v2, const Vector4<T>& v3)
+
+template <typename T> void Matrix::Multiply(const Matrix3x4<T>* pIn, const Matrix3x4<T>& m, Matrix3x4<T>* pOut, uint32_t count)
 {
-	rows[0] = v0;
-	rows[1] = v1;
-	rows[2] = v2;
-	rows[3] = v3;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Multiply(pIn, m, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = pIn[i] * m; }
 }
-template <typename T> Matrix4<T>::Matrix4(const Matrix4<T>& m) : Matrix4<T>(m[0], m[1], m[2], m[3]) { }
 
-template <typename T> Matrix4<T>::Matrix4(const Quaternion<T>& q) : Matrix4<T>(1)
+template <typename T> void Matrix::Convert(const Matrix4<T>* pIn, Matrix3x4<T>* pOut, uint32_t count)
 {
-	float qxx = q.x * q.x;
-	float qxy = q.x * q.y;
-	float qxz = q.x * q.z;
-	float qxw = q.w * q.x;
-	float qyy = q.y * q.y;
-	float qyz = q.y * q.z;
-	float qyw = q.w * q.y;
-	float qzz = q.z * q.z;
-	float qzw = q.w * q.z;
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { Simd::Convert(pIn, pOut, count); return; }
+#endif
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Matrix3x4<T>(pIn[i]); }
+}
 
-	elements[0][0] = 1.0f - 2.0f * (qyy + qzz);
-	elements[0][1] = 2.0f * (qxy + qzw);
-	elements[0][2] = 2.0f * (qxz - qyw);
+template <typename T> void Matrix::Rotate(const Vector3<T>* pIn, Matrix4<T>* pOut, uint32_t count)
+{
+	Quaternion<T> q[64];
 
-	elements[1][0] = 2.0f * (qxy - qzw);
-	elements[1][1] = 1.0f - 2.0f * (qxx + qzz);
-	elements[1][2] = 2.0f * (qyz + qxw);
+	for (uint32_t i = 0; i < count; i += _countof(q))
+	{
+		const uint32_t n = (count - i < _countof(q)) ? (count - i) : static_cast<uint32_t>(_countof(q));
+		Quat::Convert(pIn + i, q, n);
 
-	elements[2][0] = 2.0f * (qxz + qyw);
-	elements[2][1] = 2.0f * (qyz - qxw);
-	elements[2][2] = 1.0f - 2.0f * (qxx + qyy);
+		for (uint32_t j = 0; j < n; j++) { pOut[i + j] = Matrix4<T>(q[j]); }
+	}
 }
 
-template <typename T> Matrix4<T>& Matrix4<T>::operator = (const Matrix4<T>& m)
-{
-	rows[0] = m.rows[0];
-	rows[1] = m.rows[1];
-	rows[2] = m.rows[2];
-	rows[3] = m.rows[3];
-	return *this;
-}
+// ------------------------- Matrix template/function instantiations ------------------------------
 
-template <typename T> Vector4<T>& Matrix4<T>::operator[] (uint32_t i) { return rows[i]; }
-template <typename T> const Vector4<T>& Matrix4<T>::operator[] (uint32_t i) const { return rows[i]; }
+#define INSTANTIATE_MATRIX_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)							\
+	template Matrix2<X> Matrix::Inverse(const Matrix2<X>& m);							\
+	template Matrix3<X> Matrix::Inverse(const Matrix3<X>& m);							\
+	template Matrix4<X> Matrix::Inverse(const Matrix4<X>& m);							\
+	template Matrix3x4<X> Matrix::Inverse(const Matrix3x4<X>& m);						\
+	template Matrix4<X> Matrix::InverseAffine(const Matrix4<X>& m);						\
+	template Matrix4<X> Matrix::InverseRigid(const Matrix4<X>& m);						\
+	template std::wstring Matrix::ToString(const Matrix2<X>& m);						\
+	template std::wstring Matrix::ToString(const Matrix3<X>& m);						\
+	template std::wstring Matrix::ToString(const Matrix4<X>& m);						\
+	template std::wstring Matrix::ToString(const Matrix3x4<X>& m);						\
+	template void Matrix::Transform(const Matrix4<X>& m, const Vector4<X>* pIn, Vector4<X>* pOut, uint32_t count);        \
+	template void Matrix::TransformPoints(const Matrix4<X>& m, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count);  \
+	template void Matrix::TransformVectors(const Matrix4<X>& m, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count); \
+	template void Matrix::Multiply(const Matrix4<X>& m, const Matrix4<X>* pIn, Matrix4<X>* pOut, uint32_t count);         \
+	template void Matrix::Multiply(const Matrix4<X>* pIn, const Matrix4<X>& m, Matrix4<X>* pOut, uint32_t count);         \
+	template void Matrix::InverseAffine(const Matrix4<X>* pIn, Matrix4<X>* pOut, uint32_t count);                         \
+	template void Matrix::InverseRigid(const Matrix4<X>* pIn, Matrix4<X>* pOut, uint32_t count);                          \
+	template void Matrix::TransformPoints(const Matrix3x4<X>& m, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count);  \
+	template void Matrix::TransformVectors(const Matrix3x4<X>& m, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count); \
+	template void Matrix::Multiply(const Matrix3x4<X>& m, const Matrix3x4<X>* pIn, Matrix3x4<X>* pOut, uint32_t count);     \
+	template void Matrix::Multiply(const Matrix3x4<X>* pIn, const Matrix3x4<X>& m, Matrix3x4<X>* pOut, uint32_t count);     \
+	template void Matrix::Convert(const Matrix4<X>* pIn, Matrix3x4<X>* pOut, uint32_t count);                               \
+	template void Matrix::Rotate(const Vector3<X>* pIn, Matrix4<X>* pOut, uint32_t count);                                  \
 
-template <typename T> Matrix4<T> Matrix4<T>::operator * (T t) const
-{
-	Matrix4<T> r;
-	MUL4(t, this->elements[0], r.elements[0]);
-	MUL4(t, this->elements[1], r.elements[1]);
-	MUL4(t, this->elements[2], r.elements[2]);
-	MUL4(t, this->elements[3], r.elements[3]);
-	return r;
-}
+INSTANTIATE_MATRIX_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
+INSTANTIATE_MATRIX_TEMPLATES_FOR_FLOATING_POINT_TYPE(double)
 
-template <typename T> Matrix4<T>& Matrix4<T>::operator *= (T t)
-{
-	MUL4(t, this->elements[0], this->elements[0]);
-	MUL4(t, this->elements[1], this->elements[1]);
-	MUL4(t, this->elements[2], this->elements[2]);
-	MUL4(t, this->elements[3], this->elements[3]);
-	return *this;
-}
+// ------------------------------------- Dual Quaternion -----------------------------------------
 
-template <typename T> Matrix4<T> Matrix4<T>::operator + (const Matrix4<T>& m) const
-{
-	Matrix4<T> r;
-	ADD4(this->elements[0], m.elements[0], r.elements[0]);
-	ADD4(this->elements[1], m.elements[1], r.elements[1]);
-	ADD4(this->elements[2], m.elements[2], r.elements[2]);
-	ADD4(this->elements[3], m.elements[3], r.elements[3]);
-	return r;
-}
+template <typename T> DualQuaternion<T>::DualQuaternion(const Matrix4<T>& m) : DualQuaternion<T>(
+	Quaternion<T>(Matrix3<T>(
+		Vector3<T>(m[0][0], m[0][1], m[0][2]),
+		Vector3<T>(m[1][0], m[1][1], m[1][2]),
+		Vector3<T>(m[2][0], m[2][1], m[2][2])
+	)),
+	Vector3<T>(m[3][0], m[3][1], m[3][2])) { }
 
-template <typename T> Matrix4<T> Matrix4<T>::operator - (const Matrix4<T>& m) const
+template <typename T> void DualQuat::Convert(const Matrix4<T>* pIn, DualQuaternion<T>* pOut, uint32_t count)
 {
-	Matrix4<T> r;
-	SUB4(this->elements[0], m.elements[0], r.elements[0]);
-	SUB4(this->elements[1], m.elements[1], r.elements[1]);
-	SUB4(this->elements[2], m.elements[2], r.elements[2]);
-	SUB4(this->elements[3], m.elements[3], r.elements[3]);
-	return r;
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = DualQuaternion<T>(pIn[i]); }
 }
 
-template <typename T> Matrix4<T>& Matrix4<T>::operator += (const Matrix4<T>& m)
+template <typename T> void DualQuat::Multiply(const DualQuaternion<T>* pIn0, const DualQuaternion<T>* pIn1, DualQuaternion<T>* pOut, uint32_t count)
 {
-	ADD4(this->elements[0], m.elements[0], this->elements[0]);
-	ADD4(this->elements[1], m.elements[1], this->elements[1]);
-	ADD4(this->elements[2], m.elements[2], this->elements[2]);
-	ADD4(this->elements[3], m.elements[3], this->elements[3]);
-	return *this;
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = pIn0[i] * pIn1[i]; }
 }
 
-template <typename T> Matrix4<T>& Matrix4<T>::operator -= (const Matrix4<T>& m)
+template <typename T> void DualQuat::TransformPoints(const DualQuaternion<T>& q, const Vector3<T>* pIn, Vector3<T>* pOut, uint32_t count)
 {
-	SUB4(this->elements[0], m.elements[0], this->elements[0]);
-	SUB4(this->elements[1], m.elements[1], this->elements[1]);
-	SUB4(this->elements[2], m.elements[2], this->elements[2]);
-	SUB4(this->elements[3], m.elements[3], this->elements[3]);
-	return *this;
+	// the translation is shared by every point
+	const Vector3<T> t = q.GetTranslation();
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = q.TransformVector(pIn[i]) + t; }
 }
 
-template <typename T> Matrix4<T> Matrix4<T>::operator * (const Matrix4<T>& m) const
-{
-	Matrix4<T> r;
-	DOT4(r.rows, rows, m.rows, 0, 0);
-	DOT4(r.rows, rows, m.rows, 0, 1);
-	DOT4(r.rows, rows, m.rows, 0, 2);
-	DOT4(r.rows, rows, m.rows, 0, 3);
-	DOT4(r.rows, rows, m.rows, 1, 0);
-	DOT4(r.rows, rows, m.rows, 1, 1);
-	DOT4(r.rows, rows, m.rows, 1, 2);
-	DOT4(r.rows, rows, m.rows, 1, 3);
-	DOT4(r.rows, rows, m.rows, 2, 0);
-	DOT4(r.rows, rows, m.rows, 2, 1);
-	DOT4(r.rows, rows, m.rows, 2, 2);
-	DOT4(r.rows, rows, m.rows, 2, 3);
-	DOT4(r.rows, rows, m.rows, 3, 0);
-	DOT4(r.rows, rows, m.rows, 3, 1);
-	DOT4(r.rows, rows, m.rows, 3, 2);
-	DOT4(r.rows, rows, m.rows, 3, 3);
-	return r;
-}
+// -------------------- Dual Quaternion template/function instantiations --------------------------
 
-template <typename T> Matrix4<T>& Matrix4<T>::operator *= (const Matrix4<T>& m)
-{
-	Matrix4<T> c(*this);
-	DOT4(rows, c.rows, m.rows, 0, 0);
-	DOT4(rows, c.rows, m.rows, 0, 1);
-	DOT4(rows, c.rows, m.rows, 0, 2);
-	DOT4(rows, c.rows, m.rows, 0, 3);
-	DOT4(rows, c.rows, m.rows, 1, 0);
-	DOT4(rows, c.rows, m.rows, 1, 1);
-	DOT4(rows, c.rows, m.rows, 1, 2);
-	DOT4(rows, c.rows, m.rows, 1, 3);
-	DOT4(rows, c.rows, m.rows, 2, 0);
-	DOT4(rows, c.rows, m.rows, 2, 1);
-	DOT4(rows, c.rows, m.rows, 2, 2);
-	DOT4(rows, c.rows, m.rows, 2, 3);
-	DOT4(rows, c.rows, m.rows, 3, 0);
-	DOT4(rows, c.rows, m.rows, 3, 1);
-	DOT4(rows, c.rows, m.rows, 3, 2);
-	DOT4(rows, c.rows, m.rows, 3, 3);
-	return *this;
-}
-
-template <typename T> Vector4<T> Matrix4<T>::operator * (const Vector4<T>& v) const
-{
-	return Vector4<T>(
-		Vector::Dot<T>(v, rows[0]),
-		Vector::Dot<T>(v, rows[1]),
-		Vector::Dot<T>(v, rows[2]),
-		Vector::Dot<T>(v, rows[3])
-	);
-}
+#define INSTANTIATE_DUAL_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)	\
+	template DualQuaternion<X>::DualQuaternion(const Matrix4<X>& m);		\
+	template void DualQuat::Convert(const Matrix4<X>* pIn, DualQuaternion<X>* pOut, uint32_t count);											\
+	template void DualQuat::Multiply(const DualQuaternion<X>* pIn0, const DualQuaternion<X>* pIn1, DualQuaternion<X>* pOut, uint32_t count);	\
+	template void DualQuat::TransformPoints(const DualQuaternion<X>& q, const Vector3<X>* pIn, Vector3<X>* pOut, uint32_t count);				\
 
-// ------------------------------------ Matrix functions ------------------------------------------
+INSTANTIATE_DUAL_QUATERNION_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
 
-template <typename T> Matrix2<T> Matrix::Inverse(const Matrix2<T>& m)
+// ---------------------------------------- Transform --------------------------------------------
+
+// Unit vector perpendicular to the unit vector v, crossed with the axis v has the smallest component along
+template <typename T> static Vector3<T> GetPerpendicular(const Vector3<T>& v)
 {
-	Matrix2<T> r;
-	T det = static_cast<T>(1) / DET2(m[0][0], m[0][1], m[1][0], m[1][1]);
-	
-	r[0][0] = m[1][1];
-	r[1][1] = m[0][0];
-	r[0][1] = -m[0][1];
-	r[1][0] = -m[1][0];
+	const Vector3<T> a = std::fabs(v[0]) < std::fabs(v[1])
+		? ((std::fabs(v[0]) < std::fabs(v[2])) ? Vector3<T>(1, 0, 0) : Vector3<T>(0, 0, 1))
+		: ((std::fabs(v[1]) < std::fabs(v[2])) ? Vector3<T>(0, 1, 0) : Vector3<T>(0, 0, 1));
 
-	return (r * det);
+	return Vector::Normalize(Vector::Cross(v, a));
 }
 
-template <typename T> Matrix3<T> Matrix::Inverse(const Matrix3<T>& m)
+template <typename T> Transform<T>::Transform(const Matrix4<T>& m) : Transform<T>()
 {
-	Matrix3<T> r;
-	T det = static_cast<T>(1) / DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]);
-	
-	r[0][0] = +DET2(m[1][1], m[1][2], m[2][1], m[2][2]);
-	r[1][0] = -DET2(m[1][0], m[1][2], m[2][0], m[2][2]);
-	r[2][0] = +DET2(m[1][0], m[1][1], m[2][0], m[2][1]);
-	r[0][1] = -DET2(m[0][1], m[0][2], m[2][1], m[2][2]);
-	r[1][1] = +DET2(m[0][0], m[0][2], m[2][0], m[2][2]);
-	r[2][1] = -DET2(m[0][0], m[0][1], m[2][0], m[2][1]);
-	r[0][2] = +DET2(m[0][1], m[0][2], m[1][1], m[1][2]);
-	r[1][2] = -DET2(m[0][0], m[0][2], m[1][0], m[1][2]);
-	r[2][2] = +DET2(m[0][0], m[0][1], m[1][0], m[1][1]);
+	// Axes shorter than this fraction of the longest one are treated as zero scale, their direction is rebuilt from the other axes
+	const T eps = static_cast<T>(1e-6);
 
-	return (r * det);
-}
+	translation = Vector3<T>(m[3][0], m[3][1], m[3][2]);
 
-template <typename T> Matrix4<T> Matrix::Inverse(const Matrix4<T>& m)
-{
-	Matrix4F r;
+	Vector3<T> axes[3];
+	T largest = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		axes[i]  = Vector3<T>(m[i][0], m[i][1], m[i][2]);
+		scale[i] = Vector::Length(axes[i]);
+		largest  = (scale[i] > largest) ? scale[i] : largest;
+	}
 
-	float m0 = m[0][0] * DET3(m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
-	float m1 = m[0][1] * DET3(m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
-	float m2 = m[0][2] * DET3(m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
-	float m3 = m[0][3] * DET3(m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
-	T det = static_cast<T>(1) / (m0 - m1 + m2 - m3);
+	// zero (or NaN) linear part, keep the identity rotation
+	if (!(largest > 0))
+	{
+		return;
+	}
 
-	r[0][0] = +DET3(m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
-	r[1][0] = -DET3(m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
-	r[2][0] = +DET3(m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
-	r[3][0] = -DET3(m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
+	// a mirror (negative determinant) is folded into the x scale so that the rotation stays proper
+	if (Vector::Dot(Vector::Cross(axes[0], axes[1]), axes[2]) < 0)
+	{
+		scale[0] = -scale[0];
+	}
 
-	r[0][1] = -DET3(m[0][1], m[0][2], m[0][3], m[2][1], m[2][2], m[2][3], m[3][1], m[3][2], m[3][3]);
-	r[1][1] = +DET3(m[0][0], m[0][2], m[0][3], m[2][0], m[2][2], m[2][3], m[3][0], m[3][2], m[3][3]);
-	r[2][1] = -DET3(m[0][0], m[0][1], m[0][3], m[2][0], m[2][1], m[2][3], m[3][0], m[3][1], m[3][3]);
-	r[3][1] = +DET3(m[0][0], m[0][1], m[0][2], m[2][0], m[2][1], m[2][2], m[3][0], m[3][1], m[3][2]);
+	bool bValid[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		bValid[i] = std::fabs(scale[i]) > largest * eps;
+		if (bValid[i]) { axes[i] *= static_cast<T>(1) / scale[i]; }
+	}
 
-	r[0][2] = +DET3(m[0][1], m[0][2], m[0][3], m[1][1], m[1][2], m[1][3], m[3][1], m[3][2], m[3][3]);
-	r[1][2] = -DET3(m[0][0], m[0][2], m[0][3], m[1][0], m[1][2], m[1][3], m[3][0], m[3][2], m[3][3]);
-	r[2][2] = +DET3(m[0][0], m[0][1], m[0][3], m[1][0], m[1][1], m[1][3], m[3][0], m[3][1], m[3][3]);
-	r[3][2] = -DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[3][0], m[3][1], m[3][2]);
+	// Gram-Schmidt orthonormalization of the x and y axes, which also removes any shear, z completes the right handed basis
+	Vector3<T> x = axes[0];
+	if (!bValid[0])
+	{
+		const Vector3<T> c = (bValid[1] && bValid[2]) ? Vector::Cross(axes[1], axes[2]) : Vector3<T>();
+		x = (Vector::Length(c) > eps) ? Vector::Normalize(c) : GetPerpendicular(bValid[1] ? axes[1] : axes[2]);
+	}
 
-	r[0][3] = -DET3(m[0][1], m[0][2], m[0][3], m[1][1], m[1][2], m[1][3], m[2][1], m[2][2], m[2][3]);
-	r[1][3] = +DET3(m[0][0], m[0][2], m[0][3], m[1][0], m[1][2], m[1][3], m[2][0], m[2][2], m[2][3]);
-	r[2][3] = -DET3(m[0][0], m[0][1], m[0][3], m[1][0], m[1][1], m[1][3], m[2][0], m[2][1], m[2][3]);
-	r[3][3] = +DET3(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]);
+	Vector3<T> y = bValid[1] ? axes[1] - x * Vector::Dot(axes[1], x) : Vector3<T>();
+	if (Vector::Length(y) > eps)
+	{
+		y = Vector::Normalize(y);
+	}
+	else
+	{
+		const Vector3<T> c = bValid[2] ? Vector::Cross(axes[2], x) : Vector3<T>();
+		y = (Vector::Length(c) > eps) ? Vector::Normalize(c) : GetPerpendicular(x);
+	}
 
-	return (r * det);
+	rotation = Quat::Normalize(Quaternion<T>(Matrix3<T>(x, y, Vector::Cross(x, y))));
 }
 
-template <typename T> Matrix2<T> Matrix::Transpose(const Matrix2<T>& m)
+template <typename T> void Xform::Multiply(const Transform<T>* pIn0, const Transform<T>* pIn1, Transform<T>* pOut, uint32_t count)
 {
-	return Matrix2<T> {
-		{ m[0][0], m[1][0] },
-		{ m[0][1], m[1][1] }
-	};
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = pIn0[i] * pIn1[i]; }
 }
 
-template <typename T> Matrix3<T> Matrix::Transpose(const Matrix3<T>& m)
+template <typename T> void Xform::Convert(const Matrix4<T>* pIn, Transform<T>* pOut, uint32_t count)
 {
-	return Matrix3<T> {
-		{ m[0][0], m[1][0], m[2][0] },
-		{ m[0][1], m[1][1], m[2][1] },
-		{ m[0][2], m[1][2], m[2][2] }
-	};
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Transform<T>(pIn[i]); }
 }
 
-template <typename T> Matrix4<T> Matrix::Transpose(const Matrix4<T>& m)
+template <typename T> void Xform::Convert(const Transform<T>* pIn, Matrix3x4<T>* pOut, uint32_t count)
 {
-	return Matrix4<T> {
-		{ m[0][0], m[1][0], m[2][0], m[3][0] },
-		{ m[0][1], m[1][1], m[2][1], m[3][1] },
-		{ m[0][2], m[1][2], m[2][2], m[3][2] },
-		{ m[0][3], m[1][3], m[2][3], m[3][3] }
-	};
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Matrix3x4<T>(pIn[i]); }
 }
 
-template <typename T> Matrix4<T> Matrix::Translate(const Vector3<T>& v)
-{
-	Matrix4F m(1.0f);
-	m[3] = Vector4F(v, 1.0f);
-	return m;
-}
+// ------------------------ Transform template/function instantiations ----------------------------
+
+#define INSTANTIATE_TRANSFORM_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)	\
+	template Transform<X>::Transform(const Matrix4<X>& m);			\
+	template void Xform::Multiply(const Transform<X>* pIn0, const Transform<X>* pIn1, Transform<X>* pOut, uint32_t count);	\
+	template void Xform::Convert(const Matrix4<X>* pIn, Transform<X>* pOut, uint32_t count);								\
+	template void Xform::Convert(const Transform<X>* pIn, Matrix3x4<X>* pOut, uint32_t count);								\
+
+INSTANTIATE_TRANSFORM_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
 
-template <typename T> Matrix4<T> Matrix::Scale(const Vector3<T>& v)
+// ----------------------------------------- Bounds ----------------------------------------------
+
+template <typename T> INTERSECTION Bounds::Classify(const Frustum<T>& f, const AABB<T>& b)
 {
-	Matrix4F m(1.0f);
-	m[0][0] = v.x;
-	m[1][1] = v.y;
-	m[2][2] = v.z;
-	return m;
+	const Vector3<T> c = b.GetCenter();
+	const Vector3<T> e = b.GetExtents();
+
+	INTERSECTION r = INTERSECTION_INSIDE;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		// distance of the center and the projection of the extents on the normal
+		const Plane<T>& p = f.planes[i];
+		const T d = p.Distance(c);
+		const T s = e[0] * std::fabs(p.normal[0]) + e[1] * std::fabs(p.normal[1]) + e[2] * std::fabs(p.normal[2]);
+
+		if (d + s < static_cast<T>(0)) { return INTERSECTION_OUTSIDE; }
+		if (d - s < static_cast<T>(0)) { r = INTERSECTION_PARTIAL; }
+	}
+
+	return r;
 }
 
-template <typename T> Matrix4<T> Matrix::Rotate(const Vector3<T>& v)
+template <typename T> INTERSECTION Bounds::Classify(const Frustum<T>& f, const Sphere<T>& s)
 {
-	return Matrix4F(Quaternion(v));
+	INTERSECTION r = INTERSECTION_INSIDE;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		const T d = f.planes[i].Distance(s.center);
+
+		if (d + s.radius < static_cast<T>(0)) { return INTERSECTION_OUTSIDE; }
+		if (d - s.radius < static_cast<T>(0)) { r = INTERSECTION_PARTIAL; }
+	}
+
+	return r;
 }
 
-template <typename T> std::wstring MatrixToString(T* pElements, size_t nElements)
+template <typename T, typename V> uint32_t CullVolumes(const Frustum<T>& f, const V* pIn, uint32_t count, uint32_t* pVisible)
 {
-	wchar_t buffer[2048] = {};
-
-	wchar_t* pBuffer = buffer;
-	size_t szBuffer = _countof(buffer);
+	uint32_t visible = 0;
 
-	for (uint32_t i = 0; i < nElements; i++)
+	for (uint32_t i = 0; i < (count + 31) / 32; i++) { pVisible[i] = 0; }
+	for (uint32_t i = 0; i < count; i++)
 	{
-		WriteToBuffer(pBuffer, szBuffer, L"[");
-		for (uint32_t j = 0; j < nElements; j++)
+		if (Bounds::Classify(f, pIn[i]) != INTERSECTION_OUTSIDE)
 		{
-			WriteToBuffer(pBuffer, szBuffer, *(pElements + (i * nElements) + j));
-			if (j != (nElements - 1))
-			{
-				WriteToBuffer(pBuffer, szBuffer, L", ");
-			}
+			pVisible[i / 32] |= 1U << (i % 32);
+			visible++;
 		}
-		WriteToBuffer(pBuffer, szBuffer, L"]\n");
 	}
 
-	*pBuffer = 0; // null-terminate
+	return visible;
+}
 
-	return std::wstring(buffer);
+template <typename T> uint32_t Bounds::Cull(const Frustum<T>& f, const AABB<T>* pIn, uint32_t count, uint32_t* pVisible)
+{
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { return Simd::Cull(f, pIn, count, pVisible); }
+#endif
+	return CullVolumes(f, pIn, count, pVisible);
 }
 
-template <typename T> std::wstring Matrix::ToString(const Matrix2<T>& m) { return MatrixToString(&m.elements[0][0], 2); }
-template <typename T> std::wstring Matrix::ToString(const Matrix3<T>& m) { return MatrixToString(&m.elements[0][0], 3); }
-template <typename T> std::wstring Matrix::ToString(const Matrix4<T>& m) { return MatrixToString(&m.elements[0][0], 4); }
+template <typename T> uint32_t Bounds::Cull(const Frustum<T>& f, const Sphere<T>* pIn, uint32_t count, uint32_t* pVisible)
+{
+#if CG_MATH_SSE
+	if constexpr (std::is_same<T, float>::value) { return Simd::Cull(f, pIn, count, pVisible); }
+#endif
+	return CullVolumes(f, pIn, count, pVisible);
+}
 
-// ------------------------- Matrix template/function instantiations ------------------------------
+// ------------------------- Bounds template/function instantiations ------------------------------
 
-#define INSTANTIATE_MATRIX_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)							\
-    template struct Matrix2<X>;                                                         \
-    template struct Matrix3<X>;                                                         \
-    template struct Matrix4<X>;                                                         \
-	template Matrix2<X> Matrix::Inverse(const Matrix2<X>& m);							\
-	template Matrix3<X> Matrix::Inverse(const Matrix3<X>& m);							\
-	template Matrix4<X> Matrix::Inverse(const Matrix4<X>& m);							\
-	template Matrix2<X> Matrix::Transpose(const Matrix2<X>& m);							\
-	template Matrix3<X> Matrix::Transpose(const Matrix3<X>& m);							\
-	template Matrix4<X> Matrix::Transpose(const Matrix4<X>& m);							\
-	template std::wstring Matrix::ToString(const Matrix2<X>& m);						\
-	template std::wstring Matrix::ToString(const Matrix3<X>& m);						\
-	template std::wstring Matrix::ToString(const Matrix4<X>& m);						\
+#define INSTANTIATE_BOUNDS_TEMPLATES_FOR_FLOATING_POINT_TYPE(X)												\
+	template INTERSECTION Bounds::Classify(const Frustum<X>& f, const AABB<X>& b);							\
+	template INTERSECTION Bounds::Classify(const Frustum<X>& f, const Sphere<X>& s);						\
+	template uint32_t Bounds::Cull(const Frustum<X>& f, const AABB<X>* pIn, uint32_t count, uint32_t* pVisible);	\
+	template uint32_t Bounds::Cull(const Frustum<X>& f, const Sphere<X>* pIn, uint32_t count, uint32_t* pVisible);	\
 
-INSTANTIATE_MATRIX_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
+INSTANTIATE_BOUNDS_TEMPLATES_FOR_FLOATING_POINT_TYPE(float)
+INSTANTIATE_BOUNDS_TEMPLATES_FOR_FLOATING_POINT_TYPE(double)
@@ -0,0 +1,266 @@
+#include "CgMath.hpp"
+
+#include <bit>
+
+/* Pack functions: the scalar functions are the reference implementation, the batched functions use the SSE (and F16C) kernels */
+/* in CMathSimd.cpp which evaluate the same operations, so that both give the same encodings and decoded values. */
+
+// smallest three components are in [-1/sqrt(2), 1/sqrt(2)], scaled to [-QUATERNION_RANGE, QUATERNION_RANGE] and offset to [0, 32767]
+const float QUATERNION_RANGE = 16383.5f;
+const float QUATERNION_SCALE = QUATERNION_RANGE * 1.41421356f;
+
+const float SNORM16_SCALE = 32767.0f;
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static inline int16_t ToSnorm16(float f)
+{
+	return static_cast<int16_t>(std::nearbyint(Clamp(f, -1.0f, 1.0f) * SNORM16_SCALE));
+}
+
+// D3D SNORM conversion, -32768 and -32767 are both -1
+static inline float FromSnorm16(int16_t s)
+{
+	return std::fmax(static_cast<float>(s) * (1.0f / SNORM16_SCALE), -1.0f);
+}
+
+// Scale of the position encoding, zero for flat boxes
+static inline Vector3F GetInverseExtents(const AABBF& b)
+{
+	const Vector3F e = b.GetExtents();
+
+	Vector3F r;
+	for (uint32_t i = 0; i < 3; i++) { r[i] = (e[i] > 0.0f) ? (1.0f / e[i]) : 0.0f; }
+	return r;
+}
+
+// ----------------------------------------- Quaternion -------------------------------------------
+
+PackedQuaternion Pack::EncodeQuaternion(const Quaternion<float>& q)
+{
+	uint32_t index = 0;
+	for (uint32_t i = 1; i < 4; i++)
+	{
+		if (std::fabs(q.elements[i]) > std::fabs(q.elements[index])) { index = i; }
+	}
+
+	const bool bNegate = std::signbit(q.elements[index]);
+
+	PackedQuaternion p = {};
+	for (uint32_t i = 0, j = 0; i < 4; i++)
+	{
+		if (i == index) { continue; }
+
+		const float v = bNegate ? -q.elements[i] : q.elements[i];
+		const float u = std::nearbyint(Clamp(v * QUATERNION_SCALE, -QUATERNION_RANGE, QUATERNION_RANGE) + QUATERNION_RANGE);
+		p.elements[j++] = static_cast<uint16_t>(static_cast<uint32_t>(u) << 1);
+	}
+
+	p.elements[0] |= static_cast<uint16_t>(index & 1);
+	p.elements[1] |= static_cast<uint16_t>(index >> 1);
+	return p;
+}
+
+Quaternion<float> Pack::DecodeQuaternion(const PackedQuaternion& p)
+{
+	const uint32_t index = (p.elements[0] & 1) | ((p.elements[1] & 1) << 1);
+
+	float v[3];
+	for (uint32_t i = 0; i < 3; i++) { v[i] = (static_cast<float>(p.elements[i] >> 1) - QUATERNION_RANGE) * (1.0f / QUATERNION_SCALE); }
+
+	Quaternion<float> q;
+	for (uint32_t i = 0, j = 0; i < 4; i++)
+	{
+		q.elements[i] = (i == index) ? std::sqrt(std::fmax(((1.0f - v[0] * v[0]) - v[1] * v[1]) - v[2] * v[2], 0.0f)) : v[j++];
+	}
+	return q;
+}
+
+// ------------------------------------------- Normal ---------------------------------------------
+
+// The unit vector is projected onto the octahedron |x| + |y| + |z| = 1, the lower half (z < 0) is folded over the diagonals
+PackedNormal Pack::EncodeNormal(const Vector3F& n)
+{
+	const float r = 1.0f / ((std::fabs(n.x) + std::fabs(n.y)) + std::fabs(n.z));
+
+	float u = n.x * r;
+	float v = n.y * r;
+	if (n.z < 0.0f)
+	{
+		const float fu = std::copysign(1.0f - std::fabs(v), u);
+		const float fv = std::copysign(1.0f - std::fabs(u), v);
+		u = fu;
+		v = fv;
+	}
+
+	PackedNormal p;
+	p.elements[0] = ToSnorm16(u);
+	p.elements[1] = ToSnorm16(v);
+	return p;
+}
+
+Vector3F Pack::DecodeNormal(const PackedNormal& p)
+{
+	float u = FromSnorm16(p.elements[0]);
+	float v = FromSnorm16(p.elements[1]);
+
+	const float z = (1.0f - std::fabs(u)) - std::fabs(v);
+	const float t = std::fmax(-z, 0.0f); // unfolds the lower half
+	u -= std::copysign(t, u);
+	v -= std::copysign(t, v);
+
+	return Vector::Normalize(Vector3F(u, v, z));
+}
+
+// ------------------------------------------ Position --------------------------------------------
+
+PackedPosition Pack::EncodePosition(const Vector3F& p, const AABBF& b)
+{
+	const Vector3F c = b.GetCenter();
+	const Vector3F r = GetInverseExtents(b);
+
+	PackedPosition s;
+	for (uint32_t i = 0; i < 3; i++) { s.elements[i] = ToSnorm16((p[i] - c[i]) * r[i]); }
+	s.elements[3] = static_cast<int16_t>(SNORM16_SCALE);
+	return s;
+}
+
+Vector3F Pack::DecodePosition(const PackedPosition& p, const AABBF& b)
+{
+	const Vector3F c = b.GetCenter();
+	const Vector3F e = b.GetExtents();
+
+	Vector3F r;
+	for (uint32_t i = 0; i < 3; i++) { r[i] = c[i] + e[i] * FromSnorm16(p.elements[i]); }
+	return r;
+}
+
+Matrix4F Pack::GetDecodeMatrix(const AABBF& b)
+{
+	return Matrix::Translate(b.GetCenter()) * Matrix::Scale(b.GetExtents());
+}
+
+// -------------------------------------------- Half ----------------------------------------------
+
+uint16_t Pack::EncodeHalf(float f)
+{
+	const uint32_t bits = std::bit_cast<uint32_t>(f);
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t a    = bits & 0x7FFFFFFF;
+
+	uint32_t h = 0;
+	if (a > 0x7F800000) // NaN
+	{
+		h = 0x7E00 | ((a >> 13) & 0x3FF);
+	}
+	else if (a >= 0x477FF000) // rounds to infinity (65520 and up)
+	{
+		h = 0x7C00;
+	}
+	else if (a < 0x38800000) // half denormal, adding 0.5 aligns the mantissa so the FPU rounds it to nearest even
+	{
+		h = std::bit_cast<uint32_t>(std::bit_cast<float>(a) + 0.5f) - 0x3F000000;
+	}
+	else // rebias the exponent and round the mantissa to nearest even
+	{
+		h = (a + 0xC8000FFF + ((a >> 13) & 1)) >> 13;
+	}
+
+	return static_cast<uint16_t>(sign | h);
+}
+
+float Pack::DecodeHalf(uint16_t h)
+{
+	const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+	const uint32_t a    = h & 0x7FFF;
+
+	uint32_t bits = 0;
+	if (a >= 0x7C00) // infinity and NaN, NaNs are quieted
+	{
+		bits = 0x7F800000 | (a << 13) | ((a > 0x7C00) ? 0x400000 : 0);
+	}
+	else if (a >= 0x400) // normal
+	{
+		bits = (a << 13) + 0x38000000;
+	}
+	else // denormal, exact in float
+	{
+		bits = std::bit_cast<uint32_t>(static_cast<float>(a) * 5.96046448e-8f);
+	}
+
+	return std::bit_cast<float>(sign | bits);
+}
+
+// ------------------------------------- Batched functions ----------------------------------------
+
+void Pack::EncodeQuaternions(const Quaternion<float>* pIn, PackedQuaternion* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::EncodeQuaternions(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::EncodeQuaternion(pIn[i]); }
+#endif
+}
+
+void Pack::DecodeQuaternions(const PackedQuaternion* pIn, Quaternion<float>* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::DecodeQuaternions(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::DecodeQuaternion(pIn[i]); }
+#endif
+}
+
+void Pack::EncodeNormals(const Vector3F* pIn, PackedNormal* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::EncodeNormals(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::EncodeNormal(pIn[i]); }
+#endif
+}
+
+void Pack::DecodeNormals(const PackedNormal* pIn, Vector3F* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::DecodeNormals(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::DecodeNormal(pIn[i]); }
+#endif
+}
+
+void Pack::EncodePositions(const Vector3F* pIn, const AABBF& b, PackedPosition* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::EncodePositions(pIn, b, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::EncodePosition(pIn[i], b); }
+#endif
+}
+
+void Pack::DecodePositions(const PackedPosition* pIn, const AABBF& b, Vector3F* pOut, uint32_t count)
+{
+#if CG_MATH_SSE
+	Simd::DecodePositions(pIn, b, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::DecodePosition(pIn[i], b); }
+#endif
+}
+
+void Pack::EncodeHalves(const float* pIn, uint16_t* pOut, uint32_t count)
+{
+#if CG_MATH_F16C
+	Simd::EncodeHalves(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::EncodeHalf(pIn[i]); }
+#endif
+}
+
+void Pack::DecodeHalves(const uint16_t* pIn, float* pOut, uint32_t count)
+{
+#if CG_MATH_F16C
+	Simd::DecodeHalves(pIn, pOut, count);
+#else
+	for (uint32_t i = 0; i < count; i++) { pOut[i] = Pack::DecodeHalf(pIn[i]); }
+#endif
+}
@@ -0,0 +1,1302 @@
+#include "CgMath.hpp"
+
+#if CG_MATH_SSE
+
+#include <immintrin.h>
+
+#include <bit>
+
+/* SSE kernels behind the Matrix4F product, inverse and the batched float functions (declared in CgMath.hpp). */
+/* The scalar templates in CgMath.inl/CMath.cpp are the reference implementation: multiplications, additions and matrix */
+/* products are evaluated in the same order as the reference so that their results match bit for bit, as long as the */
+/* compiler does not fuse a * b + c on either side (the MSVC default, -ffp-contract=off -fno-tree-vectorize for GCC, whose */
+/* vectorizer still fuses the quaternion products). Inverse uses a different (shorter) evaluation order and matches the */
+/* reference within rounding error, ReciprocalSqrt within its documented error. Samples/MathTests checks both. */
+
+#define SHUFFLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE((w), (z), (y), (x)))
+#define SPLAT(v, i)            _mm_shuffle_ps((v), (v), _MM_SHUFFLE((i), (i), (i), (i)))
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static inline __m128 Load(const Vector4F& v) { return _mm_loadu_ps(v.elements); }
+static inline void   Store(Vector4F& v, __m128 r) { _mm_storeu_ps(v.elements, r); }
+static inline __m128 Load(const Quaternion<float>& q) { return _mm_loadu_ps(q.elements); }
+static inline void   Store(Quaternion<float>& q, __m128 r) { _mm_storeu_ps(q.elements, r); }
+
+// w[0] * r[0] + w[1] * r[1] + w[2] * r[2] + w[3] * r[3]
+static inline __m128 Combine4(const __m128 r[4], __m128 w)
+{
+	__m128 v = _mm_mul_ps(SPLAT(w, 0), r[0]);
+	v = _mm_add_ps(v, _mm_mul_ps(SPLAT(w, 1), r[1]));
+	v = _mm_add_ps(v, _mm_mul_ps(SPLAT(w, 2), r[2]));
+	v = _mm_add_ps(v, _mm_mul_ps(SPLAT(w, 3), r[3]));
+	return v;
+}
+
+static inline void LoadMatrix(const Matrix4F& m, __m128 r[4])
+{
+	r[0] = _mm_loadu_ps(m.elements[0]);
+	r[1] = _mm_loadu_ps(m.elements[1]);
+	r[2] = _mm_loadu_ps(m.elements[2]);
+	r[3] = _mm_loadu_ps(m.elements[3]);
+}
+
+static inline void StoreMatrix(Matrix4F& m, const __m128 r[4])
+{
+	_mm_storeu_ps(m.elements[0], r[0]);
+	_mm_storeu_ps(m.elements[1], r[1]);
+	_mm_storeu_ps(m.elements[2], r[2]);
+	_mm_storeu_ps(m.elements[3], r[3]);
+}
+
+// Product with the same layout as the DOT4 reference: r[c] = sum_k (m1[c][k] * m0[k])
+static inline void MultiplyMatrix(const __m128 m0[4], const __m128 m1[4], __m128 r[4])
+{
+	r[0] = Combine4(m0, m1[0]);
+	r[1] = Combine4(m0, m1[1]);
+	r[2] = Combine4(m0, m1[2]);
+	r[3] = Combine4(m0, m1[3]);
+}
+
+// (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3) -> (x0 x1 x2 x3) (y0 y1 y2 y3) (z0 z1 z2 z3)
+static inline void LoadVector3x4(const Vector3F* pIn, __m128& x, __m128& y, __m128& z)
+{
+	const __m128 v0 = _mm_loadu_ps(pIn[0].elements);
+	const __m128 v1 = _mm_loadu_ps(pIn[1].elements + 1);
+	const __m128 v2 = _mm_loadu_ps(pIn[2].elements + 2);
+
+	x = _mm_shuffle_ps(v0, _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// (x0 x1 x2 x3) (y0 y1 y2 y3) (z0 z1 z2 z3) -> (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3)
+static inline void StoreVector3x4(Vector3F* pOut, __m128 x, __m128 y, __m128 z)
+{
+	const __m128 xy01 = _mm_unpacklo_ps(x, y);
+	const __m128 xy23 = _mm_unpackhi_ps(x, y);
+
+	const __m128 v0 = _mm_shuffle_ps(xy01, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+	const __m128 v1 = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), xy23, _MM_SHUFFLE(1, 0, 2, 0));
+	const __m128 v2 = SHUFFLE(_mm_shuffle_ps(xy23, z, _MM_SHUFFLE(3, 2, 3, 2)), 2, 0, 1, 3);
+
+	_mm_storeu_ps(pOut[0].elements, v0);
+	_mm_storeu_ps(pOut[1].elements + 1, v1);
+	_mm_storeu_ps(pOut[2].elements + 2, v2);
+}
+
+static inline void LoadMatrix(const Matrix3x4F& m, __m128 r[3])
+{
+	r[0] = _mm_loadu_ps(m.elements[0]);
+	r[1] = _mm_loadu_ps(m.elements[1]);
+	r[2] = _mm_loadu_ps(m.elements[2]);
+}
+
+static inline void StoreMatrix(Matrix3x4F& m, const __m128 r[3])
+{
+	_mm_storeu_ps(m.elements[0], r[0]);
+	_mm_storeu_ps(m.elements[1], r[1]);
+	_mm_storeu_ps(m.elements[2], r[2]);
+}
+
+// Affine product with the same layout as the Matrix3x4 reference: r[i] = sum_k (m0[i][k] * m1[k]) + <0, 0, 0, m0[i][3]>
+static inline void MultiplyAffine(const __m128 m0[3], const __m128 m1[3], __m128 r[3])
+{
+	const __m128 w = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		__m128 v = _mm_mul_ps(m1[0], SPLAT(m0[i], 0));
+		v = _mm_add_ps(v, _mm_mul_ps(m1[1], SPLAT(m0[i], 1)));
+		v = _mm_add_ps(v, _mm_mul_ps(m1[2], SPLAT(m0[i], 2)));
+		r[i] = _mm_add_ps(v, _mm_and_ps(m0[i], w));
+	}
+}
+
+// Prefetches p[index], only while index < count: a pointer further past the end than one element is undefined
+template <typename T> static inline void Prefetch(const T* p, uint32_t index, uint32_t count)
+{
+	if (index < count) { _mm_prefetch(reinterpret_cast<const char*>(p + index), _MM_HINT_T0); }
+}
+
+#if CG_MATH_AVX2
+// _MM_TRANSPOSE4_PS on both 128-bit halves at once
+static inline void Transpose4x2(__m256 v[4])
+{
+	const __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+	const __m256 t1 = _mm256_unpacklo_ps(v[2], v[3]);
+	const __m256 t2 = _mm256_unpackhi_ps(v[0], v[1]);
+	const __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+
+	v[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	v[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	v[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	v[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+#endif
+
+// 2x2 sub-matrix products used by Inverse, each sub-matrix is stored as (m00, m01, m10, m11)
+static inline __m128 Mat2Mul(__m128 a, __m128 b)    { return _mm_add_ps(_mm_mul_ps(a, SHUFFLE(b, 0, 3, 0, 3)), _mm_mul_ps(SHUFFLE(a, 1, 0, 3, 2), SHUFFLE(b, 2, 1, 2, 1))); } // A * B
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b) { return _mm_sub_ps(_mm_mul_ps(SHUFFLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SHUFFLE(a, 1, 1, 2, 2), SHUFFLE(b, 2, 3, 0, 1))); } // adj(A) * B
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b) { return _mm_sub_ps(_mm_mul_ps(a, SHUFFLE(b, 3, 0, 3, 0)), _mm_mul_ps(SHUFFLE(a, 1, 0, 3, 2), SHUFFLE(b, 2, 1, 2, 1))); } // A * adj(B)
+
+// ----------------------------------------- Matrix4 ----------------------------------------------
+
+void Simd::Multiply(const Matrix4F& m0, const Matrix4F& m1, Matrix4F& r)
+{
+	__m128 a[4], b[4], c[4];
+	LoadMatrix(m0, a);
+	LoadMatrix(m1, b);
+
+	MultiplyMatrix(a, b, c);
+
+	StoreMatrix(r, c);
+}
+
+void Simd::Inverse(const Matrix4F& m, Matrix4F& result)
+{
+	// Block-wise inverse: M = | A B |, using 2x2 adjugates instead of the 16 3x3 cofactors of the reference
+	//                         | C D |
+	__m128 r[4];
+	LoadMatrix(m, r);
+
+	const __m128 A = _mm_movelh_ps(r[0], r[1]);
+	const __m128 B = _mm_movehl_ps(r[1], r[0]);
+	const __m128 C = _mm_movelh_ps(r[2], r[3]);
+	const __m128 D = _mm_movehl_ps(r[3], r[2]);
+
+	// (|A|, |B|, |C|, |D|)
+	const __m128 det = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r[0], r[2], _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r[1], r[3], _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(r[0], r[2], _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r[1], r[3], _MM_SHUFFLE(2, 0, 2, 0)))
+	);
+
+	const __m128 detA = SPLAT(det, 0);
+	const __m128 detB = SPLAT(det, 1);
+	const __m128 detC = SPLAT(det, 2);
+	const __m128 detD = SPLAT(det, 3);
+
+	const __m128 DC = Mat2AdjMul(D, C);
+	const __m128 AB = Mat2AdjMul(A, B);
+
+	__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+	__m128 tr = _mm_mul_ps(AB, SHUFFLE(DC, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, SHUFFLE(tr, 2, 3, 0, 1));
+	tr = _mm_add_ps(tr, SHUFFLE(tr, 1, 0, 3, 2));
+
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	detM = _mm_sub_ps(detM, tr);
+
+	const __m128 rcp = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+	X = _mm_mul_ps(X, rcp);
+	Y = _mm_mul_ps(Y, rcp);
+	Z = _mm_mul_ps(Z, rcp);
+	W = _mm_mul_ps(W, rcp);
+
+	r[0] = _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3));
+	r[1] = _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2));
+	r[2] = _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3));
+	r[3] = _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2));
+
+	StoreMatrix(result, r);
+}
+
+// r[3] = -(r[0] * t.x + r[1] * t.y + r[2] * t.z) with w = 1, the translation of InverseAffine and InverseRigid
+static inline __m128 InverseTranslation(const __m128 r[3], __m128 t)
+{
+	const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	__m128 v = _mm_mul_ps(r[0], SPLAT(t, 0));
+	v = _mm_add_ps(v, _mm_mul_ps(r[1], SPLAT(t, 1)));
+	v = _mm_add_ps(v, _mm_mul_ps(r[2], SPLAT(t, 2)));
+	v = _mm_xor_ps(v, _mm_set1_ps(-0.0f));
+
+	return _mm_or_ps(_mm_and_ps(v, xyz), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// a.yzx * b.zxy - a.zxy * b.yzx, same order as Vector::Cross
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(SHUFFLE(a, 1, 2, 0, 3), SHUFFLE(b, 2, 0, 1, 3)), _mm_mul_ps(SHUFFLE(a, 2, 0, 1, 3), SHUFFLE(b, 1, 2, 0, 3)));
+}
+
+static inline void InverseAffineMatrix(__m128 r[4])
+{
+	const __m128 x0 = Cross(r[1], r[2]);
+	const __m128 x1 = Cross(r[2], r[0]);
+	const __m128 x2 = Cross(r[0], r[1]);
+
+	const __m128 d = _mm_mul_ps(r[0], x0);
+	const __m128 s = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(SPLAT(d, 0), SPLAT(d, 1)), SPLAT(d, 2)));
+
+	const __m128 t = r[3];
+	r[0] = _mm_mul_ps(x0, s);
+	r[1] = _mm_mul_ps(x1, s);
+	r[2] = _mm_mul_ps(x2, s);
+	r[3] = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+
+	r[3] = InverseTranslation(r, t);
+}
+
+static inline void InverseRigidMatrix(__m128 r[4])
+{
+	const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	const __m128 t = r[3];
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	r[0] = _mm_and_ps(r[0], xyz);
+	r[1] = _mm_and_ps(r[1], xyz);
+	r[2] = _mm_and_ps(r[2], xyz);
+
+	r[3] = InverseTranslation(r, t);
+}
+
+void Simd::InverseAffine(const Matrix4F& m, Matrix4F& result)
+{
+	__m128 r[4];
+	LoadMatrix(m, r);
+	InverseAffineMatrix(r);
+	StoreMatrix(result, r);
+}
+
+void Simd::InverseRigid(const Matrix4F& m, Matrix4F& result)
+{
+	__m128 r[4];
+	LoadMatrix(m, r);
+	InverseRigidMatrix(r);
+	StoreMatrix(result, r);
+}
+
+// ------------------------------------ Scalar functions ------------------------------------------
+
+// Four lanes of SinCosApprox (CMath.cpp) with the same operations: reduction by the quadrant j, both polynomials, then the
+// quadrant selects (j & 1) and negates (j & 2 for sin, (j + 1) & 2 for cos) them
+static inline void SinCos4(__m128 x, __m128& s, __m128& c)
+{
+	const __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+	const __m128  j = _mm_cvtepi32_ps(q);
+
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(4.83751297e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(7.54978995e-8f)));
+	const __m128 z = _mm_mul_ps(r, r);
+
+	__m128 ps = _mm_add_ps(_mm_set1_ps(8.33216087e-3f), _mm_mul_ps(z, _mm_set1_ps(-1.95152959e-4f)));
+	ps = _mm_add_ps(_mm_set1_ps(-1.66666546e-1f), _mm_mul_ps(z, ps));
+	ps = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), ps));
+
+	__m128 pc = _mm_add_ps(_mm_set1_ps(-1.38873163e-3f), _mm_mul_ps(z, _mm_set1_ps(2.44331571e-5f)));
+	pc = _mm_add_ps(_mm_set1_ps(4.16666457e-2f), _mm_mul_ps(z, pc));
+	pc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), pc));
+
+	const __m128i one  = _mm_set1_epi32(1);
+	const __m128i two  = _mm_set1_epi32(2);
+	const __m128  swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+
+	// 2 << 30 is the sign bit
+	const __m128 signS = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+	const __m128 signC = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+
+	s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps)), signS);
+	c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc)), signC);
+}
+
+void Simd::SinCos(const float* pIn, float* pSin, float* pCos, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 s, c;
+		SinCos4(_mm_loadu_ps(pIn + i), s, c);
+
+		_mm_storeu_ps(pSin + i, s);
+		_mm_storeu_ps(pCos + i, c);
+	}
+
+	// the last (count % 4) values go through a padded group
+	if (i < count)
+	{
+		float in[4] = {}, s[4], c[4];
+		for (uint32_t j = i; j < count; j++) { in[j - i] = pIn[j]; }
+
+		__m128 vs, vc;
+		SinCos4(_mm_loadu_ps(in), vs, vc);
+		_mm_storeu_ps(s, vs);
+		_mm_storeu_ps(c, vc);
+
+		for (uint32_t j = i; j < count; j++) { pSin[j] = s[j - i]; pCos[j] = c[j - i]; }
+	}
+}
+
+// rsqrt estimate (relative error <= 1.5 * 2^-12) refined by one Newton-Raphson step: y * (1.5 - 0.5 * x * y * y)
+static inline __m128 ReciprocalSqrt4(__m128 x)
+{
+	const __m128 y = _mm_rsqrt_ps(x);
+	return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), y), y)));
+}
+
+void Simd::ReciprocalSqrt(const float* pIn, float* pOut, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) { _mm_storeu_ps(pOut + i, ReciprocalSqrt4(_mm_loadu_ps(pIn + i))); }
+
+	if (i < count)
+	{
+		float in[4] = { 1.0f, 1.0f, 1.0f, 1.0f }, r[4];
+		for (uint32_t j = i; j < count; j++) { in[j - i] = pIn[j]; }
+
+		_mm_storeu_ps(r, ReciprocalSqrt4(_mm_loadu_ps(in)));
+		for (uint32_t j = i; j < count; j++) { pOut[j] = r[j - i]; }
+	}
+}
+
+// ------------------------------------- Batched functions ----------------------------------------
+
+void Simd::Normalize(const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 x, y, z;
+		LoadVector3x4(pIn + i, x, y, z);
+
+		__m128 l = _mm_mul_ps(x, x);
+		l = _mm_add_ps(l, _mm_mul_ps(y, y));
+		l = _mm_add_ps(l, _mm_mul_ps(z, z));
+		l = _mm_div_ps(one, _mm_sqrt_ps(l));
+
+		StoreVector3x4(pOut + i, _mm_mul_ps(x, l), _mm_mul_ps(y, l), _mm_mul_ps(z, l));
+	}
+
+	for (; i < count; i++) { pOut[i] = Vector::Normalize(pIn[i]); }
+}
+
+// Four element vectors (Vector4F, Quaternion<float>): only the squares are transposed to sum them in the reference
+// order, the vectors stay as they are and are scaled by their own lane of the reciprocal length
+template <typename V>
+static inline void Normalize4(const V* pIn, V* pOut, uint32_t count)
+{
+	uint32_t i = 0;
+
+#if CG_MATH_AVX2
+	// v[j] holds the vectors 2j and 2j + 1, the in-lane transpose puts vector 2k in lane k and 2k + 1 in lane k + 4
+	const __m256 one8 = _mm256_set1_ps(1.0f);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m256 v[4], s[4];
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			v[j] = _mm256_loadu_ps(pIn[i + 2 * j].elements);
+			s[j] = _mm256_mul_ps(v[j], v[j]);
+		}
+		Transpose4x2(s);
+
+		__m256 l = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(s[0], s[1]), s[2]), s[3]);
+		l = _mm256_div_ps(one8, _mm256_sqrt_ps(l));
+
+		_mm256_storeu_ps(pOut[i + 0].elements, _mm256_mul_ps(v[0], _mm256_permute_ps(l, _MM_SHUFFLE(0, 0, 0, 0))));
+		_mm256_storeu_ps(pOut[i + 2].elements, _mm256_mul_ps(v[1], _mm256_permute_ps(l, _MM_SHUFFLE(1, 1, 1, 1))));
+		_mm256_storeu_ps(pOut[i + 4].elements, _mm256_mul_ps(v[2], _mm256_permute_ps(l, _MM_SHUFFLE(2, 2, 2, 2))));
+		_mm256_storeu_ps(pOut[i + 6].elements, _mm256_mul_ps(v[3], _mm256_permute_ps(l, _MM_SHUFFLE(3, 3, 3, 3))));
+	}
+#endif
+
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 v[4], s[4];
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			v[j] = Load(pIn[i + j]);
+			s[j] = _mm_mul_ps(v[j], v[j]);
+		}
+		_MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+
+		__m128 l = _mm_add_ps(_mm_add_ps(_mm_add_ps(s[0], s[1]), s[2]), s[3]);
+		l = _mm_div_ps(one, _mm_sqrt_ps(l));
+
+		Store(pOut[i + 0], _mm_mul_ps(v[0], SPLAT(l, 0)));
+		Store(pOut[i + 1], _mm_mul_ps(v[1], SPLAT(l, 1)));
+		Store(pOut[i + 2], _mm_mul_ps(v[2], SPLAT(l, 2)));
+		Store(pOut[i + 3], _mm_mul_ps(v[3], SPLAT(l, 3)));
+	}
+
+	for (; i < count; i++)
+	{
+		if constexpr (std::is_same<V, Vector4F>::value) { pOut[i] = Vector::Normalize(pIn[i]); }
+		else                                            { pOut[i] = Quat::Normalize(pIn[i]); }
+	}
+}
+
+void Simd::Normalize(const Vector4F* pIn, Vector4F* pOut, uint32_t count)
+{
+	Normalize4(pIn, pOut, count);
+}
+
+void Simd::Transform(const Matrix4F& m, const Vector4F* pIn, Vector4F* pOut, uint32_t count)
+{
+	__m128 c[4];
+	LoadMatrix(m, c);
+	_MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+
+	uint32_t i = 0;
+
+#if CG_MATH_AVX2
+	// two vectors per register, the columns are repeated in both halves
+	const __m256 c0 = _mm256_set_m128(c[0], c[0]);
+	const __m256 c1 = _mm256_set_m128(c[1], c[1]);
+	const __m256 c2 = _mm256_set_m128(c[2], c[2]);
+	const __m256 c3 = _mm256_set_m128(c[3], c[3]);
+
+	for (; i + 2 <= count; i += 2)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		const __m256 v = _mm256_loadu_ps(pIn[i].elements);
+
+		__m256 r = _mm256_mul_ps(_mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), c1));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), c2));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)), c3));
+
+		_mm256_storeu_ps(pOut[i].elements, r);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		Prefetch(pIn, i + 16, count);
+		Store(pOut[i], Combine4(c, Load(pIn[i])));
+	}
+}
+
+// r[j] = dot(m[j], <v, w>), Matrix4F goes through Matrix3x4F(m) so that its translation m[3] is added to the points
+template <bool bPoints>
+static inline void TransformVector3(const Matrix3x4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	__m128 e[3][4];
+	for (uint32_t r = 0; r < 3; r++)
+	{
+		for (uint32_t c = 0; c < 4; c++) { e[r][c] = _mm_set1_ps(m.elements[r][c]); }
+	}
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 x, y, z;
+		LoadVector3x4(pIn + i, x, y, z);
+
+		__m128 r[3];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			r[j] = _mm_mul_ps(x, e[j][0]);
+			r[j] = _mm_add_ps(r[j], _mm_mul_ps(y, e[j][1]));
+			r[j] = _mm_add_ps(r[j], _mm_mul_ps(z, e[j][2]));
+			if constexpr (bPoints) { r[j] = _mm_add_ps(r[j], e[j][3]); }
+		}
+
+		StoreVector3x4(pOut + i, r[0], r[1], r[2]);
+	}
+
+	for (; i < count; i++) { pOut[i] = m * Vector4F(pIn[i], bPoints ? 1.0f : 0.0f); }
+}
+
+void Simd::TransformPoints(const Matrix4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	TransformVector3<true>(Matrix3x4F(m), pIn, pOut, count);
+}
+
+void Simd::TransformVectors(const Matrix4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	TransformVector3<false>(Matrix3x4F(m), pIn, pOut, count);
+}
+
+void Simd::Multiply(const Matrix4F& m, const Matrix4F* pIn, Matrix4F* pOut, uint32_t count)
+{
+	__m128 m0[4];
+	LoadMatrix(m, m0);
+
+#if CG_MATH_AVX2
+	const __m256 r0 = _mm256_set_m128(m0[0], m0[0]);
+	const __m256 r1 = _mm256_set_m128(m0[1], m0[1]);
+	const __m256 r2 = _mm256_set_m128(m0[2], m0[2]);
+	const __m256 r3 = _mm256_set_m128(m0[3], m0[3]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		for (uint32_t c = 0; c < 4; c += 2)
+		{
+			const __m256 w = _mm256_loadu_ps(pIn[i].elements[c]);
+
+			__m256 r = _mm256_mul_ps(_mm256_permute_ps(w, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(w, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(w, _MM_SHUFFLE(2, 2, 2, 2)), r2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(w, _MM_SHUFFLE(3, 3, 3, 3)), r3));
+
+			_mm256_storeu_ps(pOut[i].elements[c], r);
+		}
+	}
+#else
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 m1[4], r[4];
+		LoadMatrix(pIn[i], m1);
+		MultiplyMatrix(m0, m1, r);
+		StoreMatrix(pOut[i], r);
+	}
+#endif
+}
+
+void Simd::Multiply(const Matrix4F* pIn, const Matrix4F& m, Matrix4F* pOut, uint32_t count)
+{
+#if CG_MATH_AVX2
+	// w[p][k] holds m[2p][k] in the low half and m[2p + 1][k] in the high half
+	__m256 w[2][4];
+	for (uint32_t p = 0; p < 2; p++)
+	{
+		for (uint32_t k = 0; k < 4; k++) { w[p][k] = _mm256_set_m128(_mm_set1_ps(m.elements[2 * p + 1][k]), _mm_set1_ps(m.elements[2 * p][k])); }
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pIn[i].elements[0]));
+		const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pIn[i].elements[1]));
+		const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pIn[i].elements[2]));
+		const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pIn[i].elements[3]));
+
+		__m256 r[2];
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			r[p] = _mm256_mul_ps(w[p][0], b0);
+			r[p] = _mm256_add_ps(r[p], _mm256_mul_ps(w[p][1], b1));
+			r[p] = _mm256_add_ps(r[p], _mm256_mul_ps(w[p][2], b2));
+			r[p] = _mm256_add_ps(r[p], _mm256_mul_ps(w[p][3], b3));
+		}
+
+		_mm256_storeu_ps(pOut[i].elements[0], r[0]);
+		_mm256_storeu_ps(pOut[i].elements[2], r[1]);
+	}
+#else
+	__m128 m1[4];
+	LoadMatrix(m, m1);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 m0[4], r[4];
+		LoadMatrix(pIn[i], m0);
+		MultiplyMatrix(m0, m1, r);
+		StoreMatrix(pOut[i], r);
+	}
+#endif
+}
+
+void Simd::InverseAffine(const Matrix4F* pIn, Matrix4F* pOut, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 r[4];
+		LoadMatrix(pIn[i], r);
+		InverseAffineMatrix(r);
+		StoreMatrix(pOut[i], r);
+	}
+}
+
+void Simd::InverseRigid(const Matrix4F* pIn, Matrix4F* pOut, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 r[4];
+		LoadMatrix(pIn[i], r);
+		InverseRigidMatrix(r);
+		StoreMatrix(pOut[i], r);
+	}
+}
+
+// ---------------------------------------- Matrix3x4 ---------------------------------------------
+
+void Simd::Multiply(const Matrix3x4F& m0, const Matrix3x4F& m1, Matrix3x4F& r)
+{
+	__m128 a[3], b[3], c[3];
+	LoadMatrix(m0, a);
+	LoadMatrix(m1, b);
+
+	MultiplyAffine(a, b, c);
+
+	StoreMatrix(r, c);
+}
+
+void Simd::TransformPoints(const Matrix3x4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	TransformVector3<true>(m, pIn, pOut, count);
+}
+
+void Simd::TransformVectors(const Matrix3x4F& m, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	TransformVector3<false>(m, pIn, pOut, count);
+}
+
+void Simd::Multiply(const Matrix3x4F& m, const Matrix3x4F* pIn, Matrix3x4F* pOut, uint32_t count)
+{
+	__m128 m0[3];
+	LoadMatrix(m, m0);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 m1[3], r[3];
+		LoadMatrix(pIn[i], m1);
+		MultiplyAffine(m0, m1, r);
+		StoreMatrix(pOut[i], r);
+	}
+}
+
+void Simd::Multiply(const Matrix3x4F* pIn, const Matrix3x4F& m, Matrix3x4F* pOut, uint32_t count)
+{
+	__m128 m1[3];
+	LoadMatrix(m, m1);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 m0[3], r[3];
+		LoadMatrix(pIn[i], m0);
+		MultiplyAffine(m0, m1, r);
+		StoreMatrix(pOut[i], r);
+	}
+}
+
+void Simd::Convert(const Matrix4F* pIn, Matrix3x4F* pOut, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Prefetch(pIn, i + 4, count);
+
+		__m128 r[4];
+		LoadMatrix(pIn[i], r);
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+		StoreMatrix(pOut[i], r);
+	}
+}
+
+// ----------------------------------------- Bounds ----------------------------------------------
+
+// Plane coefficients splatted for testing four volumes at a time, a holds the absolute values of the normals
+struct FrustumPlanes
+{
+	__m128 n[6][3];
+	__m128 a[6][3];
+	__m128 d[6];
+
+	FrustumPlanes(const FrustumF& f)
+	{
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				n[p][k] = _mm_set1_ps(f.planes[p].normal[k]);
+				a[p][k] = _mm_set1_ps(std::fabs(f.planes[p].normal[k]));
+			}
+			d[p] = _mm_set1_ps(f.planes[p].distance);
+		}
+	}
+
+	// p.Distance(c) for the four points (x, y, z)
+	inline __m128 Distance(uint32_t p, __m128 x, __m128 y, __m128 z) const
+	{
+		__m128 r = _mm_mul_ps(x, n[p][0]);
+		r = _mm_add_ps(r, _mm_mul_ps(y, n[p][1]));
+		r = _mm_add_ps(r, _mm_mul_ps(z, n[p][2]));
+		return _mm_add_ps(r, d[p]);
+	}
+};
+
+// Scalar test for the volumes after the last group of four
+template <typename V>
+static inline uint32_t CullTail(const FrustumF& f, const V* pIn, uint32_t first, uint32_t count, uint32_t* pVisible)
+{
+	uint32_t visible = 0;
+	for (uint32_t i = first; i < count; i++)
+	{
+		if (Bounds::Classify(f, pIn[i]) != INTERSECTION_OUTSIDE)
+		{
+			pVisible[i / 32] |= 1U << (i % 32);
+			visible++;
+		}
+	}
+	return visible;
+}
+
+uint32_t Simd::Cull(const FrustumF& f, const AABBF* pIn, uint32_t count, uint32_t* pVisible)
+{
+	static_assert(sizeof(AABBF) == 2 * sizeof(Vector3F), "AABBF must be two packed Vector3F");
+
+	const FrustumPlanes planes(f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < (count + 31) / 32; i++) { pVisible[i] = 0; }
+
+	uint32_t visible = 0;
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		// four boxes are eight Vector3F: min0, max0, min1, max1, ...
+		const Vector3F* pv = reinterpret_cast<const Vector3F*>(pIn + i);
+
+		__m128 x0, y0, z0, x1, y1, z1;
+		LoadVector3x4(pv + 0, x0, y0, z0);
+		LoadVector3x4(pv + 4, x1, y1, z1);
+
+		const __m128 minX = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 minY = _mm_shuffle_ps(y0, y1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 minZ = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 maxX = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m128 maxY = _mm_shuffle_ps(y0, y1, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m128 maxZ = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(3, 1, 3, 1));
+
+		// same evaluation order as Bounds::Classify
+		const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+		const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+		const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+		const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+		__m128 outside = zero;
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			__m128 s = _mm_mul_ps(ex, planes.a[p][0]);
+			s = _mm_add_ps(s, _mm_mul_ps(ey, planes.a[p][1]));
+			s = _mm_add_ps(s, _mm_mul_ps(ez, planes.a[p][2]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(planes.Distance(p, cx, cy, cz), s), zero));
+		}
+
+		const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+		pVisible[i / 32] |= mask << (i % 32);
+		visible += std::popcount(mask);
+	}
+
+	return visible + CullTail(f, pIn, i, count, pVisible);
+}
+
+uint32_t Simd::Cull(const FrustumF& f, const SphereF* pIn, uint32_t count, uint32_t* pVisible)
+{
+	static_assert(sizeof(SphereF) == 4 * sizeof(float), "SphereF must be four packed floats");
+
+	const FrustumPlanes planes(f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < (count + 31) / 32; i++) { pVisible[i] = 0; }
+
+	uint32_t visible = 0;
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 v[4] = {
+			_mm_loadu_ps(pIn[i + 0].center.elements), _mm_loadu_ps(pIn[i + 1].center.elements),
+			_mm_loadu_ps(pIn[i + 2].center.elements), _mm_loadu_ps(pIn[i + 3].center.elements)
+		};
+		_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+
+		__m128 outside = zero;
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(planes.Distance(p, v[0], v[1], v[2]), v[3]), zero));
+		}
+
+		const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+		pVisible[i / 32] |= mask << (i % 32);
+		visible += std::popcount(mask);
+	}
+
+	return visible + CullTail(f, pIn, i, count, pVisible);
+}
+
+// ---------------------------------- Quaternion functions ----------------------------------------
+
+void Simd::Normalize(const Quaternion<float>* pIn, Quaternion<float>* pOut, uint32_t count)
+{
+	Normalize4(pIn, pOut, count);
+}
+
+// a * b on quaternions kept as they are: every column of Quaternion::operator * is a splat of a times b shuffled, with the
+// signs of the subtracted products flipped in b, so the lanes add the same products in the same order as the reference
+void Simd::Multiply(const Quaternion<float>* pIn0, const Quaternion<float>* pIn1, Quaternion<float>* pOut, uint32_t count)
+{
+	const __m128 sign0 = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+	const __m128 sign1 = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+	const __m128 sign2 = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+
+	uint32_t i = 0;
+
+#if CG_MATH_AVX2
+	// two quaternions per register, the shuffles stay within the halves
+	const __m256 sign0x2 = _mm256_set_m128(sign0, sign0);
+	const __m256 sign1x2 = _mm256_set_m128(sign1, sign1);
+	const __m256 sign2x2 = _mm256_set_m128(sign2, sign2);
+
+	for (; i + 2 <= count; i += 2)
+	{
+		Prefetch(pIn0, i + 16, count);
+		Prefetch(pIn1, i + 16, count);
+
+		const __m256 a = _mm256_loadu_ps(pIn0[i].elements);
+		const __m256 b = _mm256_loadu_ps(pIn1[i].elements);
+
+		__m256 r = _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(0, 0, 0, 0)), _mm256_xor_ps(_mm256_permute_ps(b, _MM_SHUFFLE(0, 1, 2, 3)), sign0x2)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(1, 1, 1, 1)), _mm256_xor_ps(_mm256_permute_ps(b, _MM_SHUFFLE(1, 0, 3, 2)), sign1x2)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 2, 2, 2)), _mm256_xor_ps(_mm256_permute_ps(b, _MM_SHUFFLE(2, 3, 0, 1)), sign2x2)));
+
+		_mm256_storeu_ps(pOut[i].elements, r);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const __m128 a = Load(pIn0[i]);
+		const __m128 b = Load(pIn1[i]);
+
+		// x: a3 b0 + a0 b3 + a1 b2 - a2 b1, y: a3 b1 - a0 b2 + a1 b3 + a2 b0, z: a3 b2 + a0 b1 - a1 b0 + a2 b3, w: a3 b3 - a0 b0 - a1 b1 - a2 b2
+		__m128 r = _mm_mul_ps(SPLAT(a, 3), b);
+		r = _mm_add_ps(r, _mm_mul_ps(SPLAT(a, 0), _mm_xor_ps(SHUFFLE(b, 3, 2, 1, 0), sign0)));
+		r = _mm_add_ps(r, _mm_mul_ps(SPLAT(a, 1), _mm_xor_ps(SHUFFLE(b, 2, 3, 0, 1), sign1)));
+		r = _mm_add_ps(r, _mm_mul_ps(SPLAT(a, 2), _mm_xor_ps(SHUFFLE(b, 1, 0, 3, 2), sign2)));
+
+		Store(pOut[i], r);
+	}
+}
+
+void Simd::Rotate(const Quaternion<float>& q, const Vector3F* pIn, Vector3F* pOut, uint32_t count)
+{
+	const __m128 ux = _mm_set1_ps(q.x);
+	const __m128 uy = _mm_set1_ps(q.y);
+	const __m128 uz = _mm_set1_ps(q.z);
+	const __m128 w  = _mm_set1_ps(q.w);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 x, y, z;
+		LoadVector3x4(pIn + i, x, y, z);
+
+		// t = 2 * (u x v), v' = v + w * t + u x t
+		const __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(uy, z), _mm_mul_ps(uz, y)), two);
+		const __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(uz, x), _mm_mul_ps(ux, z)), two);
+		const __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ux, y), _mm_mul_ps(uy, x)), two);
+
+		x = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(tx, w)), _mm_sub_ps(_mm_mul_ps(uy, tz), _mm_mul_ps(uz, ty)));
+		y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(ty, w)), _mm_sub_ps(_mm_mul_ps(uz, tx), _mm_mul_ps(ux, tz)));
+		z = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(tz, w)), _mm_sub_ps(_mm_mul_ps(ux, ty), _mm_mul_ps(uy, tx)));
+
+		StoreVector3x4(pOut + i, x, y, z);
+	}
+
+	for (; i < count; i++) { pOut[i] = q.Rotate(pIn[i]); }
+}
+
+void Simd::Nlerp(const Quaternion<float>* pIn0, const Quaternion<float>* pIn1, float t, Quaternion<float>* pOut, uint32_t count)
+{
+	const __m128 one  = _mm_set1_ps(1.0f);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 s    = _mm_set1_ps(t);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn0, i + 16, count);
+		Prefetch(pIn1, i + 16, count);
+
+		__m128 a[4] = { Load(pIn0[i + 0]), Load(pIn0[i + 1]), Load(pIn0[i + 2]), Load(pIn0[i + 3]) };
+		__m128 b[4] = { Load(pIn1[i + 0]), Load(pIn1[i + 1]), Load(pIn1[i + 2]), Load(pIn1[i + 3]) };
+		_MM_TRANSPOSE4_PS(a[0], a[1], a[2], a[3]);
+		_MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+
+		__m128 d = _mm_mul_ps(a[0], b[0]);
+		d = _mm_add_ps(d, _mm_mul_ps(a[1], b[1]));
+		d = _mm_add_ps(d, _mm_mul_ps(a[2], b[2]));
+		d = _mm_add_ps(d, _mm_mul_ps(a[3], b[3]));
+
+		// negate b where dot(a, b) < 0
+		const __m128 flip = _mm_and_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), sign);
+
+		__m128 r[4];
+		for (uint32_t j = 0; j < 4; j++) { r[j] = _mm_add_ps(a[j], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(b[j], flip), a[j]), s)); }
+
+		__m128 l = _mm_mul_ps(r[0], r[0]);
+		l = _mm_add_ps(l, _mm_mul_ps(r[1], r[1]));
+		l = _mm_add_ps(l, _mm_mul_ps(r[2], r[2]));
+		l = _mm_add_ps(l, _mm_mul_ps(r[3], r[3]));
+		l = _mm_div_ps(one, _mm_sqrt_ps(l));
+
+		for (uint32_t j = 0; j < 4; j++) { r[j] = _mm_mul_ps(r[j], l); }
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+
+		for (uint32_t j = 0; j < 4; j++) { Store(pOut[i + j], r[j]); }
+	}
+
+	for (; i < count; i++) { pOut[i] = Quat::Nlerp(pIn0[i], pIn1[i], t); }
+}
+
+// Quaternion(x, y, z) for four Euler angle vectors: the twelve half angles go through SinCos4 and the products follow EulerToQuaternion
+static inline void Convert4(const Vector3F* pIn, Quaternion<float>* pOut)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	__m128 x, y, z;
+	LoadVector3x4(pIn, x, y, z);
+
+	__m128 sx, cx, sy, cy, sz, cz;
+	SinCos4(_mm_mul_ps(x, half), sx, cx);
+	SinCos4(_mm_mul_ps(y, half), sy, cy);
+	SinCos4(_mm_mul_ps(z, half), sz, cz);
+
+	__m128 r[4];
+	r[0] = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(sx, cy), cz), _mm_mul_ps(_mm_mul_ps(cx, sy), sz));
+	r[1] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, sy), cz), _mm_mul_ps(_mm_mul_ps(sx, cy), sz));
+	r[2] = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), sz), _mm_mul_ps(_mm_mul_ps(sx, sy), cz));
+	r[3] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), cz), _mm_mul_ps(_mm_mul_ps(sx, sy), sz));
+
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	for (uint32_t j = 0; j < 4; j++) { Store(pOut[j], r[j]); }
+}
+
+void Simd::Convert(const Vector3F* pIn, Quaternion<float>* pOut, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+		Convert4(pIn + i, pOut + i);
+	}
+
+	if (i < count)
+	{
+		Vector3F in[4];
+		Quaternion<float> r[4];
+		for (uint32_t j = i; j < count; j++) { in[j - i] = pIn[j]; }
+
+		Convert4(in, r);
+		for (uint32_t j = i; j < count; j++) { pOut[j] = r[j - i]; }
+	}
+}
+
+// ----------------------------------------- Packing ----------------------------------------------
+// Same operations as the scalar functions in CMathPack.cpp, _mm_cvtps_epi32 rounds to nearest even like std::nearbyint
+
+const float QUATERNION_RANGE = 16383.5f;
+const float QUATERNION_SCALE = QUATERNION_RANGE * 1.41421356f;
+
+// Clamp(f, -1, 1) * 32767 rounded to int32
+static inline __m128i ToSnorm16(__m128 f)
+{
+	const __m128 c = _mm_max_ps(_mm_min_ps(f, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+	return _mm_cvtps_epi32(_mm_mul_ps(c, _mm_set1_ps(32767.0f)));
+}
+
+static inline __m128 FromSnorm16(__m128i s)
+{
+	return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(s), _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+}
+
+// Sign extends the low/high four int16 of v to int32
+static inline __m128i UnpackLo16(__m128i v) { return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); }
+static inline __m128i UnpackHi16(__m128i v) { return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16); }
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); } // mask ? a : b
+
+void Simd::EncodeQuaternions(const Quaternion<float>* pIn, PackedQuaternion* pOut, uint32_t count)
+{
+	const __m128 sign  = _mm_set1_ps(-0.0f);
+	const __m128 range = _mm_set1_ps(QUATERNION_RANGE);
+	const __m128 scale = _mm_set1_ps(QUATERNION_SCALE);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 q[4] = { Load(pIn[i + 0]), Load(pIn[i + 1]), Load(pIn[i + 2]), Load(pIn[i + 3]) };
+		_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+
+		__m128 a[4];
+		for (uint32_t j = 0; j < 4; j++) { a[j] = _mm_andnot_ps(sign, q[j]); }
+
+		// first component with the largest magnitude, as the scalar scan
+		const __m128 m  = _mm_max_ps(_mm_max_ps(a[0], a[1]), _mm_max_ps(a[2], a[3]));
+		const __m128 e0 = _mm_cmpeq_ps(a[0], m);
+		const __m128 e1 = _mm_andnot_ps(e0, _mm_cmpeq_ps(a[1], m));
+		const __m128 e2 = _mm_andnot_ps(_mm_or_ps(e0, e1), _mm_cmpeq_ps(a[2], m));
+		const __m128 e3 = _mm_andnot_ps(_mm_or_ps(_mm_or_ps(e0, e1), e2), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+		const __m128 largest = Select(e0, q[0], Select(e1, q[1], Select(e2, q[2], q[3])));
+		const __m128 negate  = _mm_and_ps(largest, sign);
+
+		// the three remaining components in order
+		const __m128 v[3] = {
+			Select(e0, q[1], q[0]),
+			Select(_mm_or_ps(e0, e1), q[2], q[1]),
+			Select(e3, q[2], q[3])
+		};
+
+		alignas(16) uint32_t u[3][4];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			const __m128 c = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_xor_ps(v[j], negate), scale), range), _mm_sub_ps(_mm_setzero_ps(), range));
+			_mm_store_si128(reinterpret_cast<__m128i*>(u[j]), _mm_slli_epi32(_mm_cvtps_epi32(_mm_add_ps(c, range)), 1));
+		}
+
+		const __m128i one  = _mm_set1_epi32(1);
+		const __m128i bit0 = _mm_and_si128(_mm_castps_si128(_mm_or_ps(e1, e3)), one);
+		const __m128i bit1 = _mm_and_si128(_mm_castps_si128(_mm_or_ps(e2, e3)), one);
+		_mm_store_si128(reinterpret_cast<__m128i*>(u[0]), _mm_or_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(u[0])), bit0));
+		_mm_store_si128(reinterpret_cast<__m128i*>(u[1]), _mm_or_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(u[1])), bit1));
+
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			for (uint32_t k = 0; k < 3; k++) { pOut[i + j].elements[k] = static_cast<uint16_t>(u[k][j]); }
+		}
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::EncodeQuaternion(pIn[i]); }
+}
+
+void Simd::DecodeQuaternions(const PackedQuaternion* pIn, Quaternion<float>* pOut, uint32_t count)
+{
+	const __m128 range = _mm_set1_ps(QUATERNION_RANGE);
+	const __m128 scale = _mm_set1_ps(1.0f / QUATERNION_SCALE);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		alignas(16) int32_t u[3][4];
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			for (uint32_t k = 0; k < 3; k++) { u[k][j] = pIn[i + j].elements[k]; }
+		}
+
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i e0  = _mm_load_si128(reinterpret_cast<const __m128i*>(u[0]));
+		const __m128i e1  = _mm_load_si128(reinterpret_cast<const __m128i*>(u[1]));
+		const __m128i e2  = _mm_load_si128(reinterpret_cast<const __m128i*>(u[2]));
+		const __m128i index = _mm_or_si128(_mm_and_si128(e0, one), _mm_slli_epi32(_mm_and_si128(e1, one), 1));
+
+		const __m128 v0 = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(e0, 1)), range), scale);
+		const __m128 v1 = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(e1, 1)), range), scale);
+		const __m128 v2 = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(e2, 1)), range), scale);
+
+		__m128 l = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(v0, v0));
+		l = _mm_sub_ps(l, _mm_mul_ps(v1, v1));
+		l = _mm_sub_ps(l, _mm_mul_ps(v2, v2));
+		l = _mm_sqrt_ps(_mm_max_ps(l, _mm_setzero_ps()));
+
+		const __m128 i0 = _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_setzero_si128()));
+		const __m128 i1 = _mm_castsi128_ps(_mm_cmpeq_epi32(index, one));
+		const __m128 i2 = _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(2)));
+		const __m128 i3 = _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(3)));
+
+		// (l v0 v1 v2), (v0 l v1 v2), (v0 v1 l v2) or (v0 v1 v2 l)
+		__m128 q[4];
+		q[0] = Select(i0, l, v0);
+		q[1] = Select(i0, v0, Select(i1, l, v1));
+		q[2] = Select(_mm_or_ps(i0, i1), v1, Select(i2, l, v2));
+		q[3] = Select(i3, l, v2);
+
+		_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+		for (uint32_t j = 0; j < 4; j++) { Store(pOut[i + j], q[j]); }
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::DecodeQuaternion(pIn[i]); }
+}
+
+void Simd::EncodeNormals(const Vector3F* pIn, PackedNormal* pOut, uint32_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 one  = _mm_set1_ps(1.0f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 x, y, z;
+		LoadVector3x4(pIn + i, x, y, z);
+
+		const __m128 r = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y)), _mm_andnot_ps(sign, z)));
+		__m128 u = _mm_mul_ps(x, r);
+		__m128 v = _mm_mul_ps(y, r);
+
+		// fold where z < 0: copysign(1 - |v|, u), copysign(1 - |u|, v)
+		const __m128 fold = _mm_cmplt_ps(z, _mm_setzero_ps());
+		const __m128 fu = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, v)), _mm_and_ps(u, sign));
+		const __m128 fv = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, u)), _mm_and_ps(v, sign));
+		u = Select(fold, fu, u);
+		v = Select(fold, fv, v);
+
+		const __m128i s = _mm_packs_epi32(ToSnorm16(u), ToSnorm16(v)); // u0 u1 u2 u3 v0 v1 v2 v3
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm_unpacklo_epi16(s, _mm_unpackhi_epi64(s, s)));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::EncodeNormal(pIn[i]); }
+}
+
+void Simd::DecodeNormals(const PackedNormal* pIn, Vector3F* pOut, uint32_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 one  = _mm_set1_ps(1.0f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + i)); // u0 v0 u1 v1 u2 v2 u3 v3
+		const __m128  lo = FromSnorm16(UnpackLo16(s));
+		const __m128  hi = FromSnorm16(UnpackHi16(s));
+
+		__m128 u = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 v = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+		const __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, u)), _mm_andnot_ps(sign, v));
+		const __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+		u = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(u, sign)));
+		v = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(v, sign)));
+
+		// same evaluation order as Vector::Normalize
+		__m128 l = _mm_mul_ps(u, u);
+		l = _mm_add_ps(l, _mm_mul_ps(v, v));
+		l = _mm_add_ps(l, _mm_mul_ps(z, z));
+		l = _mm_div_ps(one, _mm_sqrt_ps(l));
+
+		StoreVector3x4(pOut + i, _mm_mul_ps(u, l), _mm_mul_ps(v, l), _mm_mul_ps(z, l));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::DecodeNormal(pIn[i]); }
+}
+
+void Simd::EncodePositions(const Vector3F* pIn, const AABBF& b, PackedPosition* pOut, uint32_t count)
+{
+	const Vector3F c = b.GetCenter();
+	const Vector3F e = b.GetExtents();
+
+	__m128 vc[3], vr[3];
+	for (uint32_t k = 0; k < 3; k++)
+	{
+		vc[k] = _mm_set1_ps(c[k]);
+		vr[k] = _mm_set1_ps((e[k] > 0.0f) ? (1.0f / e[k]) : 0.0f);
+	}
+
+	const __m128i w = _mm_set1_epi32(32767);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Prefetch(pIn, i + 16, count);
+
+		__m128 x, y, z;
+		LoadVector3x4(pIn + i, x, y, z);
+
+		const __m128i sx = ToSnorm16(_mm_mul_ps(_mm_sub_ps(x, vc[0]), vr[0]));
+		const __m128i sy = ToSnorm16(_mm_mul_ps(_mm_sub_ps(y, vc[1]), vr[1]));
+		const __m128i sz = ToSnorm16(_mm_mul_ps(_mm_sub_ps(z, vc[2]), vr[2]));
+
+		// (x0..x3 y0..y3) (z0..z3 w w w w) -> x0 y0 z0 w x1 y1 z1 w, x2 y2 z2 w x3 y3 z3 w
+		const __m128i xy = _mm_packs_epi32(sx, sy);
+		const __m128i zw = _mm_packs_epi32(sz, w);
+		const __m128i lo = _mm_unpacklo_epi16(xy, zw);
+		const __m128i hi = _mm_unpackhi_epi16(xy, zw);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i + 0), _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i + 2), _mm_unpackhi_epi16(lo, hi));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::EncodePosition(pIn[i], b); }
+}
+
+void Simd::DecodePositions(const PackedPosition* pIn, const AABBF& b, Vector3F* pOut, uint32_t count)
+{
+	const Vector3F c = b.GetCenter();
+	const Vector3F e = b.GetExtents();
+
+	const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+	const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + i + 0));
+		const __m128i s23 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + i + 2));
+
+		__m128 v[4] = { FromSnorm16(UnpackLo16(s01)), FromSnorm16(UnpackHi16(s01)), FromSnorm16(UnpackLo16(s23)), FromSnorm16(UnpackHi16(s23)) };
+		_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+
+		StoreVector3x4(pOut + i, _mm_add_ps(cx, _mm_mul_ps(ex, v[0])), _mm_add_ps(cy, _mm_mul_ps(ey, v[1])), _mm_add_ps(cz, _mm_mul_ps(ez, v[2])));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::DecodePosition(pIn[i], b); }
+}
+
+#if CG_MATH_F16C
+void Simd::EncodeHalves(const float* pIn, uint16_t* pOut, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm256_cvtps_ph(_mm256_loadu_ps(pIn + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::EncodeHalf(pIn[i]); }
+}
+
+void Simd::DecodeHalves(const uint16_t* pIn, float* pOut, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(pOut + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + i))));
+	}
+
+	for (; i < count; i++) { pOut[i] = Pack::DecodeHalf(pIn[i]); }
+}
+#endif
+
+#endif // CG_MATH_SSE
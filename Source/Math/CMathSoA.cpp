@@ -0,0 +1,670 @@
+#include "CgMath.hpp"
+
+#include <cstring>
+
+#include "Cg.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#endif
+
+/* Vector3SoA/Vector4SoA streams and their bulk functions. */
+/* The vector loops use aligned loads and stores on the component arrays and fall back to scalar code for the */
+/* remaining elements, the results match the scalar Vector functions bit for bit. */
+
+#define STREAM_ALIGNMENT 32 // bytes
+#define STREAM_ROUNDING  8  // elements, keeps every component array aligned
+
+#if CG_MATH_AVX2
+#define LANES          8
+#define LANE           __m256
+#define LOAD(p)        _mm256_load_ps(p)
+#define STORE(p, v)    _mm256_store_ps((p), (v))
+#define STOREU(p, v)   _mm256_storeu_ps((p), (v))
+#define SET1(s)        _mm256_set1_ps(s)
+#define ADD(a, b)      _mm256_add_ps((a), (b))
+#define SUB(a, b)      _mm256_sub_ps((a), (b))
+#define MUL(a, b)      _mm256_mul_ps((a), (b))
+#define DIV(a, b)      _mm256_div_ps((a), (b))
+#define SQRT(a)        _mm256_sqrt_ps(a)
+#elif CG_MATH_SSE
+#define LANES          4
+#define LANE           __m128
+#define LOAD(p)        _mm_load_ps(p)
+#define STORE(p, v)    _mm_store_ps((p), (v))
+#define STOREU(p, v)   _mm_storeu_ps((p), (v))
+#define SET1(s)        _mm_set1_ps(s)
+#define ADD(a, b)      _mm_add_ps((a), (b))
+#define SUB(a, b)      _mm_sub_ps((a), (b))
+#define MUL(a, b)      _mm_mul_ps((a), (b))
+#define DIV(a, b)      _mm_div_ps((a), (b))
+#define SQRT(a)        _mm_sqrt_ps(a)
+#endif
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+// Grows the N component arrays of a stream so that they can hold n elements, the first count elements are kept
+template <uint32_t N>
+static bool Reserve(float* (&pArrays)[N], uint32_t count, uint32_t& capacity, void*& pMemory, uint32_t n)
+{
+	bool status = true;
+
+	if (n > capacity)
+	{
+		const uint32_t newCapacity = (n + STREAM_ROUNDING - 1) & ~(STREAM_ROUNDING - 1);
+
+		void* pNewMemory = Memory::Allocate(N * newCapacity * sizeof(float) + STREAM_ALIGNMENT, true);
+
+		if (pNewMemory == nullptr)
+		{
+			Console::Write(L"Error: Could not allocate a vector stream of %u elements\n", n);
+			status = false;
+		}
+
+		if (status)
+		{
+			float* pBase = reinterpret_cast<float*>((reinterpret_cast<uintptr_t>(pNewMemory) + STREAM_ALIGNMENT - 1) & ~static_cast<uintptr_t>(STREAM_ALIGNMENT - 1));
+
+			for (uint32_t i = 0; i < N; i++)
+			{
+				float* pArray = pBase + i * newCapacity;
+
+				if (count > 0)
+				{
+					memcpy(pArray, pArrays[i], count * sizeof(float));
+				}
+
+				pArrays[i] = pArray;
+			}
+
+			if (pMemory != nullptr)
+			{
+				Memory::Release(pMemory);
+			}
+
+			pMemory  = pNewMemory;
+			capacity = newCapacity;
+		}
+	}
+
+	return status;
+}
+
+template <uint32_t N>
+static void Clear(float* (&pArrays)[N], uint32_t first, uint32_t last)
+{
+	if (last > first)
+	{
+		for (uint32_t i = 0; i < N; i++)
+		{
+			memset(pArrays[i] + first, 0, (last - first) * sizeof(float));
+		}
+	}
+}
+
+static bool CheckSize(uint32_t c0, uint32_t c1)
+{
+	bool status = (c0 == c1);
+
+	if (!status)
+	{
+		Console::Write(L"Error: Vector stream sizes do not match (%u, %u)\n", c0, c1);
+	}
+
+	return status;
+}
+
+static inline const float* Element(const void* pBase, size_t stride, uint32_t i) { return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pBase) + i * stride); }
+static inline float*       Element(void* pBase, size_t stride, uint32_t i)       { return reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(pBase) + i * stride); }
+
+// ---------------------------------------- Vector3SoA --------------------------------------------
+
+Vector3SoA::Vector3SoA() : x(nullptr), y(nullptr), z(nullptr), count(0), capacity(0), pMemory(nullptr) { }
+Vector3SoA::Vector3SoA(const Vector3SoA& v) : Vector3SoA() { *this = v; }
+Vector3SoA::Vector3SoA(Vector3SoA&& v) noexcept : Vector3SoA() { *this = static_cast<Vector3SoA&&>(v); }
+Vector3SoA::~Vector3SoA() { Release(); }
+
+Vector3SoA& Vector3SoA::operator = (const Vector3SoA& v)
+{
+	if ((this != &v) && Resize(v.count))
+	{
+		memcpy(x, v.x, count * sizeof(float));
+		memcpy(y, v.y, count * sizeof(float));
+		memcpy(z, v.z, count * sizeof(float));
+	}
+	return *this;
+}
+
+Vector3SoA& Vector3SoA::operator = (Vector3SoA&& v) noexcept
+{
+	if (this != &v)
+	{
+		Release();
+
+		x = v.x; y = v.y; z = v.z;
+		count = v.count;
+		capacity = v.capacity;
+		pMemory = v.pMemory;
+
+		v.x = v.y = v.z = nullptr;
+		v.count = v.capacity = 0;
+		v.pMemory = nullptr;
+	}
+	return *this;
+}
+
+bool Vector3SoA::Resize(uint32_t n)
+{
+	float* pArrays[3] = { x, y, z };
+
+	bool status = Reserve(pArrays, count, capacity, pMemory, n);
+
+	if (status)
+	{
+		Clear(pArrays, count, n);
+
+		x = pArrays[0];
+		y = pArrays[1];
+		z = pArrays[2];
+		count = n;
+	}
+
+	return status;
+}
+
+void Vector3SoA::Release()
+{
+	if (pMemory != nullptr)
+	{
+		Memory::Release(pMemory);
+	}
+
+	x = y = z = nullptr;
+	count = capacity = 0;
+	pMemory = nullptr;
+}
+
+Vector3F Vector3SoA::Get(uint32_t i) const { return Vector3F(x[i], y[i], z[i]); }
+void     Vector3SoA::Set(uint32_t i, const Vector3F& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+
+bool Vector3SoA::Load(const Vector3F* pIn, uint32_t n) { return Load(pIn, sizeof(Vector3F), n); }
+bool Vector3SoA::Load(const std::vector<Vector3F>& v) { return Load(v.data(), sizeof(Vector3F), static_cast<uint32_t>(v.size())); }
+
+bool Vector3SoA::Load(const void* pIn, size_t stride, uint32_t n)
+{
+	bool status = Resize(n);
+
+	if (status)
+	{
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const float* p = Element(pIn, stride, i);
+			x[i] = p[0];
+			y[i] = p[1];
+			z[i] = p[2];
+		}
+	}
+
+	return status;
+}
+
+void Vector3SoA::Store(Vector3F* pOut) const { Store(pOut, sizeof(Vector3F)); }
+
+void Vector3SoA::Store(std::vector<Vector3F>& v) const
+{
+	v.resize(count);
+	Store(v.data(), sizeof(Vector3F));
+}
+
+void Vector3SoA::Store(void* pOut, size_t stride) const
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float* p = Element(pOut, stride, i);
+		p[0] = x[i];
+		p[1] = y[i];
+		p[2] = z[i];
+	}
+}
+
+// ---------------------------------------- Vector4SoA --------------------------------------------
+
+Vector4SoA::Vector4SoA() : x(nullptr), y(nullptr), z(nullptr), w(nullptr), count(0), capacity(0), pMemory(nullptr) { }
+Vector4SoA::Vector4SoA(const Vector4SoA& v) : Vector4SoA() { *this = v; }
+Vector4SoA::Vector4SoA(Vector4SoA&& v) noexcept : Vector4SoA() { *this = static_cast<Vector4SoA&&>(v); }
+Vector4SoA::~Vector4SoA() { Release(); }
+
+Vector4SoA& Vector4SoA::operator = (const Vector4SoA& v)
+{
+	if ((this != &v) && Resize(v.count))
+	{
+		memcpy(x, v.x, count * sizeof(float));
+		memcpy(y, v.y, count * sizeof(float));
+		memcpy(z, v.z, count * sizeof(float));
+		memcpy(w, v.w, count * sizeof(float));
+	}
+	return *this;
+}
+
+Vector4SoA& Vector4SoA::operator = (Vector4SoA&& v) noexcept
+{
+	if (this != &v)
+	{
+		Release();
+
+		x = v.x; y = v.y; z = v.z; w = v.w;
+		count = v.count;
+		capacity = v.capacity;
+		pMemory = v.pMemory;
+
+		v.x = v.y = v.z = v.w = nullptr;
+		v.count = v.capacity = 0;
+		v.pMemory = nullptr;
+	}
+	return *this;
+}
+
+bool Vector4SoA::Resize(uint32_t n)
+{
+	float* pArrays[4] = { x, y, z, w };
+
+	bool status = Reserve(pArrays, count, capacity, pMemory, n);
+
+	if (status)
+	{
+		Clear(pArrays, count, n);
+
+		x = pArrays[0];
+		y = pArrays[1];
+		z = pArrays[2];
+		w = pArrays[3];
+		count = n;
+	}
+
+	return status;
+}
+
+void Vector4SoA::Release()
+{
+	if (pMemory != nullptr)
+	{
+		Memory::Release(pMemory);
+	}
+
+	x = y = z = w = nullptr;
+	count = capacity = 0;
+	pMemory = nullptr;
+}
+
+Vector4F Vector4SoA::Get(uint32_t i) const { return Vector4F(x[i], y[i], z[i], w[i]); }
+void     Vector4SoA::Set(uint32_t i, const Vector4F& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; w[i] = v.w; }
+
+bool Vector4SoA::Load(const Vector4F* pIn, uint32_t n) { return Load(pIn, sizeof(Vector4F), n); }
+bool Vector4SoA::Load(const std::vector<Vector4F>& v) { return Load(v.data(), sizeof(Vector4F), static_cast<uint32_t>(v.size())); }
+
+bool Vector4SoA::Load(const void* pIn, size_t stride, uint32_t n)
+{
+	bool status = Resize(n);
+
+	if (status)
+	{
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const float* p = Element(pIn, stride, i);
+			x[i] = p[0];
+			y[i] = p[1];
+			z[i] = p[2];
+			w[i] = p[3];
+		}
+	}
+
+	return status;
+}
+
+void Vector4SoA::Store(Vector4F* pOut) const { Store(pOut, sizeof(Vector4F)); }
+
+void Vector4SoA::Store(std::vector<Vector4F>& v) const
+{
+	v.resize(count);
+	Store(v.data(), sizeof(Vector4F));
+}
+
+void Vector4SoA::Store(void* pOut, size_t stride) const
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float* p = Element(pOut, stride, i);
+		p[0] = x[i];
+		p[1] = y[i];
+		p[2] = z[i];
+		p[3] = w[i];
+	}
+}
+
+// -------------------------------------- Bulk functions ------------------------------------------
+
+bool Vector::Add(const Vector3SoA& v0, const Vector3SoA& v1, Vector3SoA& r)
+{
+	bool status = CheckSize(v0.count, v1.count) && r.Resize(v0.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			STORE(r.x + i, ADD(LOAD(v0.x + i), LOAD(v1.x + i)));
+			STORE(r.y + i, ADD(LOAD(v0.y + i), LOAD(v1.y + i)));
+			STORE(r.z + i, ADD(LOAD(v0.z + i), LOAD(v1.z + i)));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.x[i] = v0.x[i] + v1.x[i];
+			r.y[i] = v0.y[i] + v1.y[i];
+			r.z[i] = v0.z[i] + v1.z[i];
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Add(const Vector4SoA& v0, const Vector4SoA& v1, Vector4SoA& r)
+{
+	bool status = CheckSize(v0.count, v1.count) && r.Resize(v0.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			STORE(r.x + i, ADD(LOAD(v0.x + i), LOAD(v1.x + i)));
+			STORE(r.y + i, ADD(LOAD(v0.y + i), LOAD(v1.y + i)));
+			STORE(r.z + i, ADD(LOAD(v0.z + i), LOAD(v1.z + i)));
+			STORE(r.w + i, ADD(LOAD(v0.w + i), LOAD(v1.w + i)));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.x[i] = v0.x[i] + v1.x[i];
+			r.y[i] = v0.y[i] + v1.y[i];
+			r.z[i] = v0.z[i] + v1.z[i];
+			r.w[i] = v0.w[i] + v1.w[i];
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Scale(const Vector3SoA& v, float s, Vector3SoA& r)
+{
+	bool status = r.Resize(v.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		const LANE t = SET1(s);
+
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			STORE(r.x + i, MUL(LOAD(v.x + i), t));
+			STORE(r.y + i, MUL(LOAD(v.y + i), t));
+			STORE(r.z + i, MUL(LOAD(v.z + i), t));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.x[i] = v.x[i] * s;
+			r.y[i] = v.y[i] * s;
+			r.z[i] = v.z[i] * s;
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Scale(const Vector4SoA& v, float s, Vector4SoA& r)
+{
+	bool status = r.Resize(v.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		const LANE t = SET1(s);
+
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			STORE(r.x + i, MUL(LOAD(v.x + i), t));
+			STORE(r.y + i, MUL(LOAD(v.y + i), t));
+			STORE(r.z + i, MUL(LOAD(v.z + i), t));
+			STORE(r.w + i, MUL(LOAD(v.w + i), t));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.x[i] = v.x[i] * s;
+			r.y[i] = v.y[i] * s;
+			r.z[i] = v.z[i] * s;
+			r.w[i] = v.w[i] * s;
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Dot(const Vector3SoA& v0, const Vector3SoA& v1, float* pOut)
+{
+	bool status = CheckSize(v0.count, v1.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		for (; i + LANES <= v0.count; i += LANES)
+		{
+			LANE d = MUL(LOAD(v0.x + i), LOAD(v1.x + i));
+			d = ADD(d, MUL(LOAD(v0.y + i), LOAD(v1.y + i)));
+			d = ADD(d, MUL(LOAD(v0.z + i), LOAD(v1.z + i)));
+			STOREU(pOut + i, d);
+		}
+#endif
+
+		for (; i < v0.count; i++)
+		{
+			pOut[i] = (v0.x[i] * v1.x[i]) + (v0.y[i] * v1.y[i]) + (v0.z[i] * v1.z[i]);
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Dot(const Vector4SoA& v0, const Vector4SoA& v1, float* pOut)
+{
+	bool status = CheckSize(v0.count, v1.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		for (; i + LANES <= v0.count; i += LANES)
+		{
+			LANE d = MUL(LOAD(v0.x + i), LOAD(v1.x + i));
+			d = ADD(d, MUL(LOAD(v0.y + i), LOAD(v1.y + i)));
+			d = ADD(d, MUL(LOAD(v0.z + i), LOAD(v1.z + i)));
+			d = ADD(d, MUL(LOAD(v0.w + i), LOAD(v1.w + i)));
+			STOREU(pOut + i, d);
+		}
+#endif
+
+		for (; i < v0.count; i++)
+		{
+			pOut[i] = (v0.x[i] * v1.x[i]) + (v0.y[i] * v1.y[i]) + (v0.z[i] * v1.z[i]) + (v0.w[i] * v1.w[i]);
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Cross(const Vector3SoA& v0, const Vector3SoA& v1, Vector3SoA& r)
+{
+	bool status = CheckSize(v0.count, v1.count) && r.Resize(v0.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			const LANE x0 = LOAD(v0.x + i), y0 = LOAD(v0.y + i), z0 = LOAD(v0.z + i);
+			const LANE x1 = LOAD(v1.x + i), y1 = LOAD(v1.y + i), z1 = LOAD(v1.z + i);
+
+			STORE(r.x + i, SUB(MUL(y0, z1), MUL(z0, y1)));
+			STORE(r.y + i, SUB(MUL(z0, x1), MUL(x0, z1)));
+			STORE(r.z + i, SUB(MUL(x0, y1), MUL(y0, x1)));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			const Vector3F c = Vector::Cross(v0.Get(i), v1.Get(i));
+			r.Set(i, c);
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Normalize(const Vector3SoA& v, Vector3SoA& r)
+{
+	bool status = r.Resize(v.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		const LANE one = SET1(1.0f);
+
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			const LANE x = LOAD(v.x + i), y = LOAD(v.y + i), z = LOAD(v.z + i);
+
+			LANE l = MUL(x, x);
+			l = ADD(l, MUL(y, y));
+			l = ADD(l, MUL(z, z));
+			l = DIV(one, SQRT(l));
+
+			STORE(r.x + i, MUL(x, l));
+			STORE(r.y + i, MUL(y, l));
+			STORE(r.z + i, MUL(z, l));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.Set(i, Vector::Normalize(v.Get(i)));
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Normalize(const Vector4SoA& v, Vector4SoA& r)
+{
+	bool status = r.Resize(v.count);
+
+	if (status)
+	{
+		uint32_t i = 0;
+
+#if CG_MATH_SSE
+		const LANE one = SET1(1.0f);
+
+		for (; i + LANES <= r.count; i += LANES)
+		{
+			const LANE x = LOAD(v.x + i), y = LOAD(v.y + i), z = LOAD(v.z + i), w = LOAD(v.w + i);
+
+			LANE l = MUL(x, x);
+			l = ADD(l, MUL(y, y));
+			l = ADD(l, MUL(z, z));
+			l = ADD(l, MUL(w, w));
+			l = DIV(one, SQRT(l));
+
+			STORE(r.x + i, MUL(x, l));
+			STORE(r.y + i, MUL(y, l));
+			STORE(r.z + i, MUL(z, l));
+			STORE(r.w + i, MUL(w, l));
+		}
+#endif
+
+		for (; i < r.count; i++)
+		{
+			r.Set(i, Vector::Normalize(v.Get(i)));
+		}
+	}
+
+	return status;
+}
+
+bool Vector::Length(const Vector3SoA& v, float* pOut)
+{
+	uint32_t i = 0;
+
+#if CG_MATH_SSE
+	for (; i + LANES <= v.count; i += LANES)
+	{
+		const LANE x = LOAD(v.x + i), y = LOAD(v.y + i), z = LOAD(v.z + i);
+
+		LANE l = MUL(x, x);
+		l = ADD(l, MUL(y, y));
+		l = ADD(l, MUL(z, z));
+		STOREU(pOut + i, SQRT(l));
+	}
+#endif
+
+	for (; i < v.count; i++)
+	{
+		pOut[i] = Vector::Length(v.Get(i));
+	}
+
+	return true;
+}
+
+bool Vector::Length(const Vector4SoA& v, float* pOut)
+{
+	uint32_t i = 0;
+
+#if CG_MATH_SSE
+	for (; i + LANES <= v.count; i += LANES)
+	{
+		const LANE x = LOAD(v.x + i), y = LOAD(v.y + i), z = LOAD(v.z + i), w = LOAD(v.w + i);
+
+		LANE l = MUL(x, x);
+		l = ADD(l, MUL(y, y));
+		l = ADD(l, MUL(z, z));
+		l = ADD(l, MUL(w, w));
+		STOREU(pOut + i, SQRT(l));
+	}
+#endif
+
+	for (; i < v.count; i++)
+	{
+		pOut[i] = Vector::Length(v.Get(i));
+	}
+
+	return true;
+}
@@ -0,0 +1,520 @@
+#include "CgParticles.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "Cg.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#endif
+
+/* ParticleSystem: the streams hold the capacity and the first m_Count particles are alive. Update integrates the */
+/* particles in ranges on the Parallel workers, then removes the dead ones on the calling thread. The emission draws */
+/* from eight xorshift generators, one per lane, stepped together so that every build emits the same particles. */
+
+#define UPDATE_GRAIN 8192    // particles per parallel range, a multiple of 8 keeps the ranges aligned
+#define MIN_LIFETIME 1.0e-3f // seconds
+
+#if CG_MATH_AVX2
+#define LANES            8
+#define LANE             __m256
+#define LOAD(p)          _mm256_load_ps(p)
+#define STORE(p, v)      _mm256_store_ps((p), (v))
+#define SET1(s)          _mm256_set1_ps(s)
+#define ADD(a, b)        _mm256_add_ps((a), (b))
+#define SUB(a, b)        _mm256_sub_ps((a), (b))
+#define MUL(a, b)        _mm256_mul_ps((a), (b))
+#define DIV(a, b)        _mm256_div_ps((a), (b))
+#define SQRT(a)          _mm256_sqrt_ps(a)
+#define AND(a, b)        _mm256_and_ps((a), (b))
+#define LESS(a, b)       _mm256_cmp_ps((a), (b), _CMP_LT_OQ)
+#define GREATER(a, b)    _mm256_cmp_ps((a), (b), _CMP_GT_OQ)
+#define SELECT(m, a, b)  _mm256_blendv_ps((b), (a), (m))
+#elif CG_MATH_SSE
+#define LANES            4
+#define LANE             __m128
+#define LOAD(p)          _mm_load_ps(p)
+#define STORE(p, v)      _mm_store_ps((p), (v))
+#define SET1(s)          _mm_set1_ps(s)
+#define ADD(a, b)        _mm_add_ps((a), (b))
+#define SUB(a, b)        _mm_sub_ps((a), (b))
+#define MUL(a, b)        _mm_mul_ps((a), (b))
+#define DIV(a, b)        _mm_div_ps((a), (b))
+#define SQRT(a)          _mm_sqrt_ps(a)
+#define AND(a, b)        _mm_and_ps((a), (b))
+#define LESS(a, b)       _mm_cmplt_ps((a), (b))
+#define GREATER(a, b)    _mm_cmpgt_ps((a), (b))
+#define SELECT(m, a, b)  _mm_or_ps(_mm_and_ps((m), (a)), _mm_andnot_ps((m), (b)))
+#endif
+
+struct SIMULATION_STEP
+{
+	float dt;
+	float damping;     // velocity scale of the step
+	float bounce;      // 1 + restitution
+	float gravity[3];  // velocity change of the step
+};
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static inline uint32_t XorShift(uint32_t x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+// pOut[i] = base + jitter * (2u - 1) with u uniform in [0, 1), the lanes of the generator produce pOut[i] for i % 8
+static void RandomFill(float* pOut, uint32_t count, float base, float jitter, uint32_t* pSeeds)
+{
+	const float unit = 1.0f / 16777216.0f;
+	uint32_t i = 0;
+
+#if CG_MATH_AVX2
+	__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSeeds));
+	for (; i + 8 <= count; i += 8)
+	{
+		s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+		s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+		s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+
+		const __m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(s, 8)), _mm256_set1_ps(2.0f * unit));
+		_mm256_storeu_ps(pOut + i, _mm256_add_ps(_mm256_set1_ps(base), _mm256_mul_ps(_mm256_set1_ps(jitter), _mm256_sub_ps(u, _mm256_set1_ps(1.0f)))));
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(pSeeds), s);
+#elif CG_MATH_SSE
+	__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSeeds));
+	__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSeeds + 4));
+	for (; i + 8 <= count; i += 8)
+	{
+		s0 = _mm_xor_si128(s0, _mm_slli_epi32(s0, 13));
+		s1 = _mm_xor_si128(s1, _mm_slli_epi32(s1, 13));
+		s0 = _mm_xor_si128(s0, _mm_srli_epi32(s0, 17));
+		s1 = _mm_xor_si128(s1, _mm_srli_epi32(s1, 17));
+		s0 = _mm_xor_si128(s0, _mm_slli_epi32(s0, 5));
+		s1 = _mm_xor_si128(s1, _mm_slli_epi32(s1, 5));
+
+		const __m128 u0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s0, 8)), _mm_set1_ps(2.0f * unit));
+		const __m128 u1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s1, 8)), _mm_set1_ps(2.0f * unit));
+		_mm_storeu_ps(pOut + i,     _mm_add_ps(_mm_set1_ps(base), _mm_mul_ps(_mm_set1_ps(jitter), _mm_sub_ps(u0, _mm_set1_ps(1.0f)))));
+		_mm_storeu_ps(pOut + i + 4, _mm_add_ps(_mm_set1_ps(base), _mm_mul_ps(_mm_set1_ps(jitter), _mm_sub_ps(u1, _mm_set1_ps(1.0f)))));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pSeeds), s0);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pSeeds + 4), s1);
+#endif
+
+	// the last partial step advances all the lanes as well
+	for (; i < count; i += 8)
+	{
+		for (uint32_t k = 0; k < 8; k++)
+		{
+			pSeeds[k] = XorShift(pSeeds[k]);
+
+			if (i + k < count)
+			{
+				const float u = static_cast<float>(static_cast<int32_t>(pSeeds[k] >> 8)) * (2.0f * unit);
+				pOut[i + k] = base + jitter * (u - 1.0f);
+			}
+		}
+	}
+}
+
+static void Fill(float* pOut, uint32_t count, float value)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		pOut[i] = value;
+	}
+}
+
+static inline uint32_t PackColor(float r, float g, float b, float a)
+{
+	const float c[4] = { r, g, b, a };
+
+	uint32_t color = 0;
+	for (uint32_t k = 0; k < 4; k++)
+	{
+		// clamped like _mm_max_ps(_mm_min_ps(c, 1), 0)
+		const float s = (c[k] < 1.0f) ? ((c[k] > 0.0f) ? c[k] : 0.0f) : 1.0f;
+		color |= static_cast<uint32_t>(s * 255.0f + 0.5f) << (8 * k);
+	}
+
+	return color;
+}
+
+// ---------------------------------------- Particles ---------------------------------------------
+
+ParticleSystem::ParticleSystem(void) : m_Count(0), m_Seeds{}, m_Simulation{}
+{
+	Initialize(0, 0);
+}
+
+bool ParticleSystem::Initialize(uint32_t capacity, uint32_t seed)
+{
+	bool status = true;
+
+	m_Count = 0;
+
+	status = m_Positions.Resize(capacity) && m_Velocities.Resize(capacity) && m_Colors.Resize(capacity) && m_Life.Resize(capacity);
+
+	if (!status)
+	{
+		Console::Write(L"Error: Could not allocate %u particles\n", capacity);
+
+		m_Positions.Release();
+		m_Velocities.Release();
+		m_Colors.Release();
+		m_Life.Release();
+	}
+
+	// distinct non zero lane states from the seed
+	for (uint32_t k = 0; k < 8; k++)
+	{
+		uint32_t s = (seed + k) * 0x9E3779B9 + 0x7F4A7C15;
+		s = (s ^ (s >> 16)) * 0x85EBCA6B;
+		s = (s ^ (s >> 13)) * 0xC2B2AE35;
+		s ^= s >> 16;
+		m_Seeds[k] = (s != 0) ? s : 0x6C8E9CF5;
+	}
+
+	return status;
+}
+
+void ParticleSystem::SetSimulation(const SIMULATION_DESC& desc)
+{
+	m_Simulation = desc;
+}
+
+void ParticleSystem::AddCollider(const PlaneF& plane)
+{
+	m_Planes.push_back(plane);
+}
+
+void ParticleSystem::AddCollider(const SphereF& sphere)
+{
+	m_Spheres.push_back(sphere);
+}
+
+void ParticleSystem::ClearColliders(void)
+{
+	m_Planes.clear();
+	m_Spheres.clear();
+}
+
+uint32_t ParticleSystem::Emit(const EMITTER_DESC& desc, uint32_t count)
+{
+	const uint32_t capacity = m_Positions.count;
+	const uint32_t n = (count < capacity - m_Count) ? count : capacity - m_Count;
+	const uint32_t first = m_Count;
+
+	RandomFill(m_Positions.x + first, n, desc.position.x, desc.extents.x, m_Seeds);
+	RandomFill(m_Positions.y + first, n, desc.position.y, desc.extents.y, m_Seeds);
+	RandomFill(m_Positions.z + first, n, desc.position.z, desc.extents.z, m_Seeds);
+	RandomFill(m_Velocities.x + first, n, desc.velocity.x, desc.velocityJitter.x, m_Seeds);
+	RandomFill(m_Velocities.y + first, n, desc.velocity.y, desc.velocityJitter.y, m_Seeds);
+	RandomFill(m_Velocities.z + first, n, desc.velocity.z, desc.velocityJitter.z, m_Seeds);
+	RandomFill(m_Life.y + first, n, desc.lifetime, desc.lifetimeJitter, m_Seeds);
+
+	for (uint32_t i = first; i < first + n; i++)
+	{
+		m_Life.y[i] = 1.0f / ((m_Life.y[i] > MIN_LIFETIME) ? m_Life.y[i] : MIN_LIFETIME);
+	}
+
+	Fill(m_Colors.x + first, n, desc.color.x);
+	Fill(m_Colors.y + first, n, desc.color.y);
+	Fill(m_Colors.z + first, n, desc.color.z);
+	Fill(m_Colors.w + first, n, desc.color.w);
+	Fill(m_Life.x + first, n, 0.0f);
+	Fill(m_Life.z + first, n, desc.size);
+
+	m_Count += n;
+
+	return n;
+}
+
+void ParticleSystem::Update(float dt)
+{
+	SIMULATION_STEP step = {};
+	step.dt         = dt;
+	step.damping    = (1.0f - m_Simulation.drag * dt > 0.0f) ? 1.0f - m_Simulation.drag * dt : 0.0f;
+	step.bounce     = 1.0f + m_Simulation.restitution;
+	step.gravity[0] = m_Simulation.gravity.x * dt;
+	step.gravity[1] = m_Simulation.gravity.y * dt;
+	step.gravity[2] = m_Simulation.gravity.z * dt;
+
+	const PlaneF* pPlanes = m_Planes.data();
+	const SphereF* pSpheres = m_Spheres.data();
+	const uint32_t planeCount = static_cast<uint32_t>(m_Planes.size());
+	const uint32_t sphereCount = static_cast<uint32_t>(m_Spheres.size());
+
+	float* px = m_Positions.x;
+	float* py = m_Positions.y;
+	float* pz = m_Positions.z;
+	float* vx = m_Velocities.x;
+	float* vy = m_Velocities.y;
+	float* vz = m_Velocities.z;
+	float* pAge = m_Life.x;
+
+	auto integrate = [&](uint32_t begin, uint32_t end)
+	{
+		uint32_t i = begin;
+
+#if CG_MATH_SSE
+		const LANE dt = SET1(step.dt);
+		const LANE damping = SET1(step.damping);
+		const LANE bounce = SET1(step.bounce);
+		const LANE zero = SET1(0.0f);
+
+		for (; i + LANES <= end; i += LANES)
+		{
+			LANE x = LOAD(px + i);
+			LANE y = LOAD(py + i);
+			LANE z = LOAD(pz + i);
+			LANE u = MUL(ADD(LOAD(vx + i), SET1(step.gravity[0])), damping);
+			LANE v = MUL(ADD(LOAD(vy + i), SET1(step.gravity[1])), damping);
+			LANE w = MUL(ADD(LOAD(vz + i), SET1(step.gravity[2])), damping);
+
+			x = ADD(x, MUL(u, dt));
+			y = ADD(y, MUL(v, dt));
+			z = ADD(z, MUL(w, dt));
+
+			for (uint32_t c = 0; c < planeCount; c++)
+			{
+				const LANE nx = SET1(pPlanes[c].normal.x);
+				const LANE ny = SET1(pPlanes[c].normal.y);
+				const LANE nz = SET1(pPlanes[c].normal.z);
+
+				// push the particles behind the plane back onto it and reflect their approaching velocity
+				const LANE d = ADD(ADD(MUL(nx, x), MUL(ny, y)), ADD(MUL(nz, z), SET1(pPlanes[c].distance)));
+				const LANE inside = LESS(d, zero);
+				const LANE depth = AND(inside, d);
+				x = SUB(x, MUL(nx, depth));
+				y = SUB(y, MUL(ny, depth));
+				z = SUB(z, MUL(nz, depth));
+
+				const LANE vn = ADD(ADD(MUL(nx, u), MUL(ny, v)), MUL(nz, w));
+				const LANE s = AND(AND(inside, LESS(vn, zero)), MUL(bounce, vn));
+				u = SUB(u, MUL(nx, s));
+				v = SUB(v, MUL(ny, s));
+				w = SUB(w, MUL(nz, s));
+			}
+
+			for (uint32_t c = 0; c < sphereCount; c++)
+			{
+				const LANE dx = SUB(x, SET1(pSpheres[c].center.x));
+				const LANE dy = SUB(y, SET1(pSpheres[c].center.y));
+				const LANE dz = SUB(z, SET1(pSpheres[c].center.z));
+				const LANE r = SET1(pSpheres[c].radius);
+
+				// the normal is the direction from the center, up for a particle at the center
+				const LANE length = SQRT(ADD(ADD(MUL(dx, dx), MUL(dy, dy)), MUL(dz, dz)));
+				const LANE inside = LESS(length, r);
+				const LANE valid = GREATER(length, zero);
+				const LANE inv = DIV(SET1(1.0f), SELECT(valid, length, SET1(1.0f)));
+				const LANE nx = SELECT(valid, MUL(dx, inv), zero);
+				const LANE ny = SELECT(valid, MUL(dy, inv), SET1(1.0f));
+				const LANE nz = SELECT(valid, MUL(dz, inv), zero);
+
+				const LANE depth = AND(inside, SUB(r, length));
+				x = ADD(x, MUL(nx, depth));
+				y = ADD(y, MUL(ny, depth));
+				z = ADD(z, MUL(nz, depth));
+
+				const LANE vn = ADD(ADD(MUL(nx, u), MUL(ny, v)), MUL(nz, w));
+				const LANE s = AND(AND(inside, LESS(vn, zero)), MUL(bounce, vn));
+				u = SUB(u, MUL(nx, s));
+				v = SUB(v, MUL(ny, s));
+				w = SUB(w, MUL(nz, s));
+			}
+
+			STORE(px + i, x);
+			STORE(py + i, y);
+			STORE(pz + i, z);
+			STORE(vx + i, u);
+			STORE(vy + i, v);
+			STORE(vz + i, w);
+			STORE(pAge + i, ADD(LOAD(pAge + i), dt));
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			float x = px[i];
+			float y = py[i];
+			float z = pz[i];
+			float u = (vx[i] + step.gravity[0]) * step.damping;
+			float v = (vy[i] + step.gravity[1]) * step.damping;
+			float w = (vz[i] + step.gravity[2]) * step.damping;
+
+			x += u * step.dt;
+			y += v * step.dt;
+			z += w * step.dt;
+
+			for (uint32_t c = 0; c < planeCount; c++)
+			{
+				const Vector3F& n = pPlanes[c].normal;
+				const float d = (n.x * x + n.y * y) + (n.z * z + pPlanes[c].distance);
+
+				if (d < 0.0f)
+				{
+					x -= n.x * d;
+					y -= n.y * d;
+					z -= n.z * d;
+
+					const float vn = (n.x * u + n.y * v) + n.z * w;
+					if (vn < 0.0f)
+					{
+						const float s = step.bounce * vn;
+						u -= n.x * s;
+						v -= n.y * s;
+						w -= n.z * s;
+					}
+				}
+			}
+
+			for (uint32_t c = 0; c < sphereCount; c++)
+			{
+				const float dx = x - pSpheres[c].center.x;
+				const float dy = y - pSpheres[c].center.y;
+				const float dz = z - pSpheres[c].center.z;
+				const float r = pSpheres[c].radius;
+				const float length = std::sqrt((dx * dx + dy * dy) + dz * dz);
+
+				if (length < r)
+				{
+					const float inv = 1.0f / ((length > 0.0f) ? length : 1.0f);
+					const float nx = (length > 0.0f) ? dx * inv : 0.0f;
+					const float ny = (length > 0.0f) ? dy * inv : 1.0f;
+					const float nz = (length > 0.0f) ? dz * inv : 0.0f;
+					const float depth = r - length;
+
+					x += nx * depth;
+					y += ny * depth;
+					z += nz * depth;
+
+					const float vn = (nx * u + ny * v) + nz * w;
+					if (vn < 0.0f)
+					{
+						const float s = step.bounce * vn;
+						u -= nx * s;
+						v -= ny * s;
+						w -= nz * s;
+					}
+				}
+			}
+
+			px[i] = x;
+			py[i] = y;
+			pz[i] = z;
+			vx[i] = u;
+			vy[i] = v;
+			vz[i] = w;
+			pAge[i] += step.dt;
+		}
+	};
+	Parallel::For(m_Count, UPDATE_GRAIN, integrate);
+
+	// the last particle takes the slot of a dead one, it is tested in turn
+	float* const pStreams[] = { px, py, pz, vx, vy, vz, m_Colors.x, m_Colors.y, m_Colors.z, m_Colors.w, m_Life.x, m_Life.y, m_Life.z };
+
+	for (uint32_t i = 0; i < m_Count; )
+	{
+		if (m_Life.x[i] * m_Life.y[i] < 1.0f)
+		{
+			i++;
+			continue;
+		}
+
+		m_Count--;
+		for (float* pStream : pStreams)
+		{
+			pStream[i] = pStream[m_Count];
+		}
+	}
+}
+
+// WriteVertices stores the position and the size of a vertex as one vector of four floats
+static_assert(offsetof(ParticleSystem::Vertex, position) == 0, "Particle vertex layout");
+static_assert(offsetof(ParticleSystem::Vertex, size) == 3 * sizeof(float), "Particle vertex layout");
+
+uint32_t ParticleSystem::WriteVertices(Vertex* pOut) const
+{
+	auto write = [&](uint32_t begin, uint32_t end)
+	{
+		uint32_t i = begin;
+
+#if CG_MATH_SSE
+		// four particles are transposed into the position and size of four vertices
+		const __m128 one   = _mm_set1_ps(1.0f);
+		const __m128 zero  = _mm_setzero_ps();
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half  = _mm_set1_ps(0.5f);
+
+		auto toUnorm8 = [&](__m128 c) { return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_max_ps(_mm_min_ps(c, one), zero), scale), half)); };
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x = _mm_load_ps(m_Positions.x + i);
+			__m128 y = _mm_load_ps(m_Positions.y + i);
+			__m128 z = _mm_load_ps(m_Positions.z + i);
+			__m128 s = _mm_load_ps(m_Life.z + i);
+			_MM_TRANSPOSE4_PS(x, y, z, s);
+
+			const __m128 fade = _mm_sub_ps(one, _mm_mul_ps(_mm_load_ps(m_Life.x + i), _mm_load_ps(m_Life.y + i)));
+			const __m128i r = toUnorm8(_mm_load_ps(m_Colors.x + i));
+			const __m128i g = toUnorm8(_mm_load_ps(m_Colors.y + i));
+			const __m128i b = toUnorm8(_mm_load_ps(m_Colors.z + i));
+			const __m128i a = toUnorm8(_mm_mul_ps(_mm_load_ps(m_Colors.w + i), fade));
+
+			alignas(16) uint32_t colors[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(colors), _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24))));
+
+			_mm_storeu_ps(reinterpret_cast<float*>(&pOut[i + 0]), x);
+			_mm_storeu_ps(reinterpret_cast<float*>(&pOut[i + 1]), y);
+			_mm_storeu_ps(reinterpret_cast<float*>(&pOut[i + 2]), z);
+			_mm_storeu_ps(reinterpret_cast<float*>(&pOut[i + 3]), s);
+			pOut[i + 0].color = colors[0];
+			pOut[i + 1].color = colors[1];
+			pOut[i + 2].color = colors[2];
+			pOut[i + 3].color = colors[3];
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			const float fade = 1.0f - m_Life.x[i] * m_Life.y[i];
+
+			pOut[i].position[0] = m_Positions.x[i];
+			pOut[i].position[1] = m_Positions.y[i];
+			pOut[i].position[2] = m_Positions.z[i];
+			pOut[i].size        = m_Life.z[i];
+			pOut[i].color       = PackColor(m_Colors.x[i], m_Colors.y[i], m_Colors.z[i], m_Colors.w[i] * fade);
+		}
+	};
+	Parallel::For(m_Count, UPDATE_GRAIN, write);
+
+	return m_Count;
+}
+
+uint32_t ParticleSystem::GetCount(void) const
+{
+	return m_Count;
+}
+
+uint32_t ParticleSystem::GetCapacity(void) const
+{
+	return m_Positions.count;
+}
+
+const Vector3SoA& ParticleSystem::GetPositions(void) const
+{
+	return m_Positions;
+}
+
+const Vector3SoA& ParticleSystem::GetVelocities(void) const
+{
+	return m_Velocities;
+}
@@ -0,0 +1,458 @@
+#include "CgSpatial.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "Cg.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#endif
+
+/* Broadphase: each frame the keys of the sorted entries are refreshed from the bounds and the entries are re-sorted */
+/* with an insertion sort, which is linear when the bodies only moved a little. The sweep then walks the sorted */
+/* bodies of each slab and tests each one against the bodies that start before it ends, eight (AVX2) or four (SSE) */
+/* at a time. Splitting along a second axis removes most of the bodies that only overlap along the sweep axis. */
+
+#define FLAG_ALIVE        0x01
+#define FLAG_ORDERED      0x02       // the handle has an entry in m_Order
+#define SORT_SHIFT_BUDGET 4          // shifts per entry before the insertion sort falls back to the radix sort
+#define RADIX_BITS        11         // three passes over the 32 bits of the keys
+#define AXIS_HYSTERESIS   2.0        // variance ratio that changes the sweep axis
+#define SLAB_BODY_SIZES   4.0        // slab width in average body sizes along the slab axis
+#define MAX_SLABS         64
+#define MIN_SLAB_BODIES   1024       // bodies per slab below which more slabs do not pay for the copies
+#define SWEEP_RANGE       1024       // sorted bodies per parallel sweep range
+#define SWEEP_PADDING     8          // NaN entries after each slab that stop the vector loads
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static inline void AddPair(std::vector<Broadphase::Pair>& rPairs, uint32_t a, uint32_t b)
+{
+	rPairs.push_back((a < b) ? Broadphase::Pair{ a, b } : Broadphase::Pair{ b, a });
+}
+
+// Least significant digit radix sort of the entries by key, the float bits are flipped into unsigned integer order
+template <typename ENTRY>
+static void RadixSort(std::vector<ENTRY>& rEntries, std::vector<ENTRY>& rScratch)
+{
+	const uint32_t count = static_cast<uint32_t>(rEntries.size());
+	const uint32_t buckets = 1U << RADIX_BITS;
+
+	rScratch.resize(count);
+
+	ENTRY* pIn  = rEntries.data();
+	ENTRY* pOut = rScratch.data();
+
+	auto getDigit = [](float key, uint32_t shift)
+	{
+		const uint32_t bits = std::bit_cast<uint32_t>(key);
+		const uint32_t sortable = bits ^ ((bits & 0x80000000) ? 0xFFFFFFFF : 0x80000000);
+		return (sortable >> shift) & ((1U << RADIX_BITS) - 1);
+	};
+
+	for (uint32_t shift = 0; shift < 32; shift += RADIX_BITS)
+	{
+		uint32_t offsets[1U << RADIX_BITS] = {};
+		for (uint32_t i = 0; i < count; i++) { offsets[getDigit(pIn[i].key, shift)]++; }
+
+		uint32_t sum = 0;
+		for (uint32_t b = 0; b < buckets; b++)
+		{
+			const uint32_t n = offsets[b];
+			offsets[b] = sum;
+			sum += n;
+		}
+
+		for (uint32_t i = 0; i < count; i++) { pOut[offsets[getDigit(pIn[i].key, shift)]++] = pIn[i]; }
+
+		ENTRY* pSwap = pIn;
+		pIn  = pOut;
+		pOut = pSwap;
+	}
+
+	// an odd number of passes leaves the result in the scratch buffer
+	if (pIn != rEntries.data())
+	{
+		rEntries.swap(rScratch);
+	}
+}
+
+// pSlabs holds the min and max of the sweep axis, the slab axis and the last axis, the slabs are followed by NaN padding
+// A pair found in the range is reported when the larger min along the slab axis is in [low, high), which holds for
+// exactly one of the slabs that the two bodies share
+static void Sweep(const float* const* pSlabs, const uint32_t* pHandles, uint32_t begin, uint32_t end, float low, float high, std::vector<Broadphase::Pair>& rPairs)
+{
+	const float* pMinA = pSlabs[0];
+	const float* pMaxA = pSlabs[1];
+	const float* pMinB = pSlabs[2];
+	const float* pMaxB = pSlabs[3];
+	const float* pMinC = pSlabs[4];
+	const float* pMaxC = pSlabs[5];
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		// the bodies after i start after its min, they overlap along the sweep axis while they start before its max
+#if CG_MATH_AVX2
+		const __m256 maxA = _mm256_set1_ps(pMaxA[i]);
+		const __m256 minB = _mm256_set1_ps(pMinB[i]);
+		const __m256 maxB = _mm256_set1_ps(pMaxB[i]);
+		const __m256 minC = _mm256_set1_ps(pMinC[i]);
+		const __m256 maxC = _mm256_set1_ps(pMaxC[i]);
+		const __m256 lowB  = _mm256_set1_ps(low);
+		const __m256 highB = _mm256_set1_ps(high);
+
+		for (uint32_t j = i + 1; ; j += 8)
+		{
+			const __m256 inA = _mm256_cmp_ps(_mm256_loadu_ps(pMinA + j), maxA, _CMP_LE_OQ);
+			const uint32_t inMask = static_cast<uint32_t>(_mm256_movemask_ps(inA));
+			if (inMask == 0)
+			{
+				break;
+			}
+
+			const __m256 minBj = _mm256_loadu_ps(pMinB + j);
+			const __m256 owner = _mm256_max_ps(minBj, minB);
+
+			__m256 overlap = _mm256_and_ps(inA, _mm256_cmp_ps(minBj, maxB, _CMP_LE_OQ));
+			overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(pMaxB + j), minB, _CMP_GE_OQ));
+			overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(pMinC + j), maxC, _CMP_LE_OQ));
+			overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(pMaxC + j), minC, _CMP_GE_OQ));
+			overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(owner, lowB, _CMP_GE_OQ));
+			overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(owner, highB, _CMP_LT_OQ));
+
+			for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(overlap)); mask != 0; mask &= mask - 1)
+			{
+				AddPair(rPairs, pHandles[i], pHandles[j + static_cast<uint32_t>(std::countr_zero(mask))]);
+			}
+
+			if (inMask != 0xFF)
+			{
+				break;
+			}
+		}
+#elif CG_MATH_SSE
+		const __m128 maxA = _mm_set1_ps(pMaxA[i]);
+		const __m128 minB = _mm_set1_ps(pMinB[i]);
+		const __m128 maxB = _mm_set1_ps(pMaxB[i]);
+		const __m128 minC = _mm_set1_ps(pMinC[i]);
+		const __m128 maxC = _mm_set1_ps(pMaxC[i]);
+		const __m128 lowB  = _mm_set1_ps(low);
+		const __m128 highB = _mm_set1_ps(high);
+
+		for (uint32_t j = i + 1; ; j += 4)
+		{
+			const __m128 inA = _mm_cmple_ps(_mm_loadu_ps(pMinA + j), maxA);
+			const uint32_t inMask = static_cast<uint32_t>(_mm_movemask_ps(inA));
+			if (inMask == 0)
+			{
+				break;
+			}
+
+			const __m128 minBj = _mm_loadu_ps(pMinB + j);
+			const __m128 owner = _mm_max_ps(minBj, minB);
+
+			__m128 overlap = _mm_and_ps(inA, _mm_cmple_ps(minBj, maxB));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_loadu_ps(pMaxB + j), minB));
+			overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_loadu_ps(pMinC + j), maxC));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_loadu_ps(pMaxC + j), minC));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(owner, lowB));
+			overlap = _mm_and_ps(overlap, _mm_cmplt_ps(owner, highB));
+
+			for (uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(overlap)); mask != 0; mask &= mask - 1)
+			{
+				AddPair(rPairs, pHandles[i], pHandles[j + static_cast<uint32_t>(std::countr_zero(mask))]);
+			}
+
+			if (inMask != 0xF)
+			{
+				break;
+			}
+		}
+#else
+		// the NaN padding fails the comparison and ends the loop
+		for (uint32_t j = i + 1; pMinA[j] <= pMaxA[i]; j++)
+		{
+			const float owner = (pMinB[j] > pMinB[i]) ? pMinB[j] : pMinB[i];
+
+			if ((pMinB[j] <= pMaxB[i]) && (pMaxB[j] >= pMinB[i]) && (pMinC[j] <= pMaxC[i]) && (pMaxC[j] >= pMinC[i]) &&
+			    (owner >= low) && (owner < high))
+			{
+				AddPair(rPairs, pHandles[i], pHandles[j]);
+			}
+		}
+#endif
+	}
+}
+
+// ---------------------------------------- Bodies ------------------------------------------------
+
+Broadphase::Broadphase(void) : m_Axis(0), m_BodyCount(0), m_Added(0), m_Removed(0)
+{
+}
+
+uint32_t Broadphase::Add(const AABBF& bounds)
+{
+	uint32_t handle = 0;
+
+	if (m_Free.empty())
+	{
+		handle = static_cast<uint32_t>(m_Bounds.size());
+		m_Bounds.push_back(bounds);
+		m_Flags.push_back(0);
+	}
+	else
+	{
+		handle = m_Free.back();
+		m_Free.pop_back();
+		m_Bounds[handle] = bounds;
+	}
+
+	// a handle removed and added again before the next sort keeps its entry
+	if ((m_Flags[handle] & FLAG_ORDERED) == 0)
+	{
+		m_Order.push_back({ bounds.min[m_Axis], handle });
+		m_Added++;
+	}
+
+	m_Flags[handle] = FLAG_ALIVE | FLAG_ORDERED;
+	m_BodyCount++;
+
+	return handle;
+}
+
+void Broadphase::Remove(uint32_t handle)
+{
+	m_Flags[handle] &= ~FLAG_ALIVE;
+	m_Free.push_back(handle);
+	m_BodyCount--;
+	m_Removed++;
+}
+
+void Broadphase::Update(uint32_t handle, const AABBF& bounds)
+{
+	m_Bounds[handle] = bounds;
+}
+
+void Broadphase::Update(const uint32_t* pHandles, const AABBF* pBounds, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_Bounds[pHandles[i]] = pBounds[i];
+	}
+}
+
+const AABBF& Broadphase::GetBounds(uint32_t handle) const
+{
+	return m_Bounds[handle];
+}
+
+uint32_t Broadphase::GetBodyCount(void) const
+{
+	return m_BodyCount;
+}
+
+// ----------------------------------------- Pairs ------------------------------------------------
+
+void Broadphase::Sort(void)
+{
+	if (m_Removed > 0)
+	{
+		auto removed = [this](const Entry& e)
+		{
+			if ((m_Flags[e.handle] & FLAG_ALIVE) != 0)
+			{
+				return false;
+			}
+
+			m_Flags[e.handle] &= ~FLAG_ORDERED;
+			return true;
+		};
+
+		m_Order.erase(std::remove_if(m_Order.begin(), m_Order.end(), removed), m_Order.end());
+		m_Removed = 0;
+	}
+
+	const uint32_t count = static_cast<uint32_t>(m_Order.size());
+
+	// sweep along the axis with the largest variance of the centers and split along the second, they give the fewest false overlaps
+	double sum[3] = {};
+	double sumSquared[3] = {};
+	double sumSize[3] = {};
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const AABBF& b = m_Bounds[m_Order[i].handle];
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const double c = 0.5 * (static_cast<double>(b.min[k]) + static_cast<double>(b.max[k]));
+			sum[k]        += c;
+			sumSquared[k] += c * c;
+			sumSize[k]    += static_cast<double>(b.max[k]) - static_cast<double>(b.min[k]);
+		}
+	}
+
+	double variance[3] = {};
+	if (count > 0)
+	{
+		for (uint32_t k = 0; k < 3; k++) { variance[k] = (sumSquared[k] - sum[k] * sum[k] / count) / count; }
+	}
+
+	bool bResort = (m_Added > count / 8);
+
+	const uint32_t axis = (variance[0] >= variance[1]) ? ((variance[0] >= variance[2]) ? 0 : 2) : ((variance[1] >= variance[2]) ? 1 : 2);
+	if (variance[axis] > AXIS_HYSTERESIS * variance[m_Axis])
+	{
+		m_Axis  = axis;
+		bResort = true;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_Order[i].key = m_Bounds[m_Order[i].handle].min[m_Axis];
+	}
+
+	// insertion sort, the order of the previous frame is almost sorted
+	if (!bResort)
+	{
+		const uint64_t budget = static_cast<uint64_t>(SORT_SHIFT_BUDGET) * count;
+		uint64_t shifts = 0;
+
+		for (uint32_t i = 1; (i < count) && !bResort; i++)
+		{
+			const Entry e = m_Order[i];
+
+			uint32_t j = i;
+			while ((j > 0) && (m_Order[j - 1].key > e.key))
+			{
+				m_Order[j] = m_Order[j - 1];
+				j--;
+			}
+
+			m_Order[j] = e;
+			shifts += i - j;
+			bResort = (shifts > budget);
+		}
+	}
+
+	if (bResort)
+	{
+		RadixSort(m_Order, m_Scratch);
+	}
+
+	m_Added = 0;
+
+	// slabs of a few body sizes across the centers within two standard deviations, the outer slabs are unbounded
+	const uint32_t axisB = (variance[(m_Axis + 1) % 3] >= variance[(m_Axis + 2) % 3]) ? (m_Axis + 1) % 3 : (m_Axis + 2) % 3;
+	const uint32_t axisC = 3 - m_Axis - axisB;
+	const uint32_t axes[3] = { m_Axis, axisB, axisC };
+
+	const double spread = 4.0 * std::sqrt(variance[axisB]);
+	const double width = SLAB_BODY_SIZES * ((count > 0) ? sumSize[axisB] / count : 0.0);
+	const double slabs = (width > 0.0) ? spread / width : 1.0;
+	const uint32_t maxSlabs = (1 + count / MIN_SLAB_BODIES < MAX_SLABS) ? 1 + count / MIN_SLAB_BODIES : MAX_SLABS;
+	const uint32_t slabCount = (slabs >= maxSlabs) ? maxSlabs : ((slabs >= 1.0) ? static_cast<uint32_t>(slabs) : 1);
+
+	const float origin = static_cast<float>(((count > 0) ? sum[axisB] / count : 0.0) - 0.5 * spread);
+	const float slabWidth = static_cast<float>(spread / slabCount);
+	const float invWidth = (slabWidth > 0.0f) ? 1.0f / slabWidth : 0.0f;
+
+	float bounds[MAX_SLABS + 1];
+	bounds[0]         = -INF;
+	bounds[slabCount] = INF;
+	for (uint32_t s = 1; s < slabCount; s++)
+	{
+		bounds[s] = origin + slabWidth * s;
+	}
+
+	// the estimate is off by one at most next to a bound, the bounds decide
+	auto getSlab = [&](float x)
+	{
+		const float f = (x - origin) * invWidth;
+		uint32_t s = (f > 0.0f) ? ((f < static_cast<float>(slabCount - 1)) ? static_cast<uint32_t>(f) : slabCount - 1) : 0;
+		while (x < bounds[s]) { s--; }
+		while ((s + 1 < slabCount) && (x >= bounds[s + 1])) { s++; } // x = INF belongs to the last slab
+		return s;
+	};
+
+	// a stable distribution keeps every slab sorted, bodies crossing slab bounds are copied into each slab
+	uint32_t first[MAX_SLABS + 1] = {};
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const AABBF& b = m_Bounds[m_Order[i].handle];
+		for (uint32_t s = getSlab(b.min[axisB]), last = getSlab(b.max[axisB]); s <= last; s++) { first[s + 1]++; }
+	}
+
+	for (uint32_t s = 0; s < slabCount; s++) { first[s + 1] += first[s] + SWEEP_PADDING; }
+
+	const uint32_t total = first[slabCount];
+	for (uint32_t k = 0; k < 6; k++)
+	{
+		m_Slabs[k].assign(total, NAN);
+	}
+	m_SlabHandles.resize(total);
+
+	uint32_t next[MAX_SLABS];
+	for (uint32_t s = 0; s < slabCount; s++) { next[s] = first[s]; }
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t handle = m_Order[i].handle;
+		const AABBF& b = m_Bounds[handle];
+
+		for (uint32_t s = getSlab(b.min[axisB]), last = getSlab(b.max[axisB]); s <= last; s++)
+		{
+			const uint32_t p = next[s]++;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				m_Slabs[2 * k][p]     = b.min[axes[k]];
+				m_Slabs[2 * k + 1][p] = b.max[axes[k]];
+			}
+			m_SlabHandles[p] = handle;
+		}
+	}
+
+	m_Ranges.clear();
+	for (uint32_t s = 0; s < slabCount; s++)
+	{
+		for (uint32_t begin = first[s]; begin < next[s]; begin += SWEEP_RANGE)
+		{
+			const uint32_t end = (next[s] - begin > SWEEP_RANGE) ? begin + SWEEP_RANGE : next[s];
+			m_Ranges.push_back({ begin, end, bounds[s], bounds[s + 1] });
+		}
+	}
+}
+
+uint32_t Broadphase::FindPairs(std::vector<Pair>& rPairs)
+{
+	const size_t first = rPairs.size();
+
+	Sort();
+
+	const uint32_t rangeCount = static_cast<uint32_t>(m_Ranges.size());
+	if (m_RangePairs.size() < rangeCount)
+	{
+		m_RangePairs.resize(rangeCount);
+	}
+
+	const float* pSlabs[6];
+	for (uint32_t k = 0; k < 6; k++) { pSlabs[k] = m_Slabs[k].data(); }
+
+	auto sweep = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t r = begin; r < end; r++)
+		{
+			const Range& range = m_Ranges[r];
+			m_RangePairs[r].clear();
+			Sweep(pSlabs, m_SlabHandles.data(), range.begin, range.end, range.low, range.high, m_RangePairs[r]);
+		}
+	};
+	Parallel::For(rangeCount, 1, sweep);
+
+	for (uint32_t r = 0; r < rangeCount; r++)
+	{
+		rPairs.insert(rPairs.end(), m_RangePairs[r].begin(), m_RangePairs[r].end());
+	}
+
+	return static_cast<uint32_t>(rPairs.size() - first);
+}
@@ -0,0 +1,463 @@
+#include "CgSpatial.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+#include "Cg.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#endif
+
+/* LightClusters: the rays through the tile corners are unprojected once per build, and the box of a cluster bounds */
+/* the eight points where its four corner rays cross the two depths of its slice. Each slice keeps a bit per light */
+/* for each of its tiles, so the indices of a cluster come out in light order when the bits are walked. */
+
+#define MAX_LIGHTS      0xFFFF
+#define BOUNDS_MIN_X    0
+#define BOUNDS_MAX_X    3
+#define BOUNDS_CENTER_X 6
+#define BOUNDS_RADIUS   9
+#define TILE_GROUP      8 // tiles of a light mask, the tiles of a slice are padded to a multiple
+
+#if CG_MATH_AVX2
+#define LANES            8
+#define LANE             __m256
+#define LOAD(p)          _mm256_loadu_ps(p)
+#define SET1(s)          _mm256_set1_ps(s)
+#define ADD(a, b)        _mm256_add_ps((a), (b))
+#define SUB(a, b)        _mm256_sub_ps((a), (b))
+#define MUL(a, b)        _mm256_mul_ps((a), (b))
+#define MAX(a, b)        _mm256_max_ps((a), (b))
+#define SQRT(a)          _mm256_sqrt_ps(a)
+#define AND(a, b)        _mm256_and_ps((a), (b))
+#define LESS_EQUAL(a, b) _mm256_cmp_ps((a), (b), _CMP_LE_OQ)
+#define MASK(a)          static_cast<uint32_t>(_mm256_movemask_ps(a))
+#elif CG_MATH_SSE
+#define LANES            4
+#define LANE             __m128
+#define LOAD(p)          _mm_loadu_ps(p)
+#define SET1(s)          _mm_set1_ps(s)
+#define ADD(a, b)        _mm_add_ps((a), (b))
+#define SUB(a, b)        _mm_sub_ps((a), (b))
+#define MUL(a, b)        _mm_mul_ps((a), (b))
+#define MAX(a, b)        _mm_max_ps((a), (b))
+#define SQRT(a)          _mm_sqrt_ps(a)
+#define AND(a, b)        _mm_and_ps((a), (b))
+#define LESS_EQUAL(a, b) _mm_cmple_ps((a), (b))
+#define MASK(a)          static_cast<uint32_t>(_mm_movemask_ps(a))
+#else
+#define LANES            8
+#endif
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+// m applied like the view-projection of FrustumF: r[i] = m[0][i] * v.x + m[1][i] * v.y + m[2][i] * v.z + m[3][i] * v.w
+static inline Vector4F Apply(const Matrix4F& m, const Vector4F& v)
+{
+	return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w;
+}
+
+static inline Vector3F Unproject(const Matrix4F& inverse, float x, float y, float z)
+{
+	const Vector4F p = Apply(inverse, Vector4F(x, y, z, 1.0f));
+	return Vector3F(p.x, p.y, p.z) * (1.0f / p.w);
+}
+
+// Light l (the bit of the slice light list) touches the tiles of the set bits of the returned mask, tiles [t, t + LANES)
+static inline uint32_t TestClusters(const float* const* ppBounds, uint32_t t, const Vector3F& position, float range)
+{
+#if CG_MATH_SSE
+	const LANE px = SET1(position.x);
+	const LANE py = SET1(position.y);
+	const LANE pz = SET1(position.z);
+	const LANE zero = SET1(0.0f);
+
+	// distance from the light to the box
+	const LANE dx = MAX(MAX(SUB(LOAD(ppBounds[BOUNDS_MIN_X + 0] + t), px), SUB(px, LOAD(ppBounds[BOUNDS_MAX_X + 0] + t))), zero);
+	const LANE dy = MAX(MAX(SUB(LOAD(ppBounds[BOUNDS_MIN_X + 1] + t), py), SUB(py, LOAD(ppBounds[BOUNDS_MAX_X + 1] + t))), zero);
+	const LANE dz = MAX(MAX(SUB(LOAD(ppBounds[BOUNDS_MIN_X + 2] + t), pz), SUB(pz, LOAD(ppBounds[BOUNDS_MAX_X + 2] + t))), zero);
+
+	return MASK(LESS_EQUAL(ADD(ADD(MUL(dx, dx), MUL(dy, dy)), MUL(dz, dz)), SET1(range * range)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t k = 0; k < LANES; k++)
+	{
+		float d2 = 0.0f;
+		for (uint32_t a = 0; a < 3; a++)
+		{
+			const float low = ppBounds[BOUNDS_MIN_X + a][t + k] - position[a];
+			const float high = position[a] - ppBounds[BOUNDS_MAX_X + a][t + k];
+			const float d = (low > high) ? ((low > 0.0f) ? low : 0.0f) : ((high > 0.0f) ? high : 0.0f);
+			d2 += d * d;
+		}
+
+		mask |= (d2 <= range * range) ? (1U << k) : 0;
+	}
+	return mask;
+#endif
+}
+
+// Cone of a spot light against the bounding spheres of the clusters, the clusters in front of the apex, behind the
+// range or farther from the axis than the angle are culled
+static inline uint32_t TestCone(const float* const* ppBounds, uint32_t t, const Vector3F& apex, const Vector3F& axis, float range, float cosAngle, float sinAngle)
+{
+#if CG_MATH_SSE
+	const LANE vx = SUB(LOAD(ppBounds[BOUNDS_CENTER_X + 0] + t), SET1(apex.x));
+	const LANE vy = SUB(LOAD(ppBounds[BOUNDS_CENTER_X + 1] + t), SET1(apex.y));
+	const LANE vz = SUB(LOAD(ppBounds[BOUNDS_CENTER_X + 2] + t), SET1(apex.z));
+	const LANE r = LOAD(ppBounds[BOUNDS_RADIUS] + t);
+
+	const LANE length2 = ADD(ADD(MUL(vx, vx), MUL(vy, vy)), MUL(vz, vz));
+	const LANE along = ADD(ADD(MUL(vx, SET1(axis.x)), MUL(vy, SET1(axis.y))), MUL(vz, SET1(axis.z)));
+	const LANE across = SQRT(MAX(SUB(length2, MUL(along, along)), SET1(0.0f)));
+	const LANE distance = SUB(MUL(SET1(cosAngle), across), MUL(along, SET1(sinAngle)));
+
+	const LANE inside = AND(LESS_EQUAL(distance, r), LESS_EQUAL(along, ADD(r, SET1(range))));
+	return MASK(AND(inside, LESS_EQUAL(SUB(SET1(0.0f), r), along)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t k = 0; k < LANES; k++)
+	{
+		const float vx = ppBounds[BOUNDS_CENTER_X + 0][t + k] - apex.x;
+		const float vy = ppBounds[BOUNDS_CENTER_X + 1][t + k] - apex.y;
+		const float vz = ppBounds[BOUNDS_CENTER_X + 2][t + k] - apex.z;
+		const float r = ppBounds[BOUNDS_RADIUS][t + k];
+
+		const float length2 = (vx * vx + vy * vy) + vz * vz;
+		const float along = (vx * axis.x + vy * axis.y) + vz * axis.z;
+		const float across2 = length2 - along * along;
+		const float distance = cosAngle * std::sqrt((across2 > 0.0f) ? across2 : 0.0f) - along * sinAngle;
+
+		mask |= (distance <= r && along <= r + range && -r <= along) ? (1U << k) : 0;
+	}
+	return mask;
+#endif
+}
+
+// ------------------------------------- Light Clusters -------------------------------------------
+
+LightClusters::LightClusters(void) : m_Desc{}, m_TileStride(0), m_DepthRow()
+{
+}
+
+bool LightClusters::Initialize(const CLUSTER_DESC& desc)
+{
+	bool status = true;
+
+	if (desc.tilesX == 0 || desc.tilesY == 0 || desc.slices == 0)
+	{
+		Console::Write(L"Error: Invalid cluster grid %u x %u x %u\n", desc.tilesX, desc.tilesY, desc.slices);
+		status = false;
+	}
+
+	if (status && !(desc.nearDepth > 0.0f && desc.farDepth > desc.nearDepth))
+	{
+		Console::Write(L"Error: Invalid cluster depth range [%f, %f]\n", desc.nearDepth, desc.farDepth);
+		status = false;
+	}
+
+	if (status)
+	{
+		m_Desc = desc;
+		m_TileStride = (desc.tilesX * desc.tilesY + TILE_GROUP - 1) & ~(TILE_GROUP - 1U);
+
+		// the padding clusters have empty boxes and are never touched
+		const uint32_t size = m_TileStride * desc.slices;
+		for (uint32_t a = 0; a < 3; a++)
+		{
+			m_Bounds[BOUNDS_MIN_X + a].assign(size, FLT_MAX);
+			m_Bounds[BOUNDS_MAX_X + a].assign(size, -FLT_MAX);
+			m_Bounds[BOUNDS_CENTER_X + a].assign(size, 0.0f);
+		}
+		m_Bounds[BOUNDS_RADIUS].assign(size, -1.0f);
+
+		m_Rays.resize(2 * (desc.tilesX + 1) * (desc.tilesY + 1));
+		m_SliceLights.resize(desc.slices);
+		m_SliceMasks.resize(desc.slices);
+		m_SliceIndices.resize(desc.slices);
+		m_Clusters.assign(desc.tilesX * desc.tilesY * desc.slices, Cluster{ 0, 0 });
+		m_Indices.clear();
+		m_Lights.clear();
+	}
+
+	return status;
+}
+
+bool LightClusters::Build(const Matrix4F& view, const Matrix4F& projection, const Light* pLights, uint32_t count)
+{
+	bool status = true;
+
+	if (m_Clusters.empty())
+	{
+		Console::Write(L"Error: Light clusters are not initialized\n");
+		status = false;
+	}
+
+	if (status && count > MAX_LIGHTS)
+	{
+		Console::Write(L"Error: Light count %u exceeds %u\n", count, static_cast<uint32_t>(MAX_LIGHTS));
+		status = false;
+	}
+
+	if (status)
+	{
+		const uint32_t tilesX = m_Desc.tilesX;
+		const uint32_t tilesY = m_Desc.tilesY;
+		const uint32_t slices = m_Desc.slices;
+
+		// two points of the ray through each tile corner, away from the z of an infinite (or reversed) far plane
+		const Matrix4F inverse = Matrix::Inverse(projection);
+		for (uint32_t y = 0; y <= tilesY; y++)
+		{
+			for (uint32_t x = 0; x <= tilesX; x++)
+			{
+				const float ndcX = -1.0f + 2.0f * static_cast<float>(x) / static_cast<float>(tilesX);
+				const float ndcY = 1.0f - 2.0f * static_cast<float>(y) / static_cast<float>(tilesY);
+				const Vector3F p0 = Unproject(inverse, ndcX, ndcY, 0.25f);
+				const Vector3F p1 = Unproject(inverse, ndcX, ndcY, 0.75f);
+
+				m_Rays[2 * (y * (tilesX + 1) + x) + 0] = p0;
+				m_Rays[2 * (y * (tilesX + 1) + x) + 1] = p1 - p0;
+			}
+		}
+
+		m_DepthRow = Vector4F(projection[0][3], projection[1][3], projection[2][3], projection[3][3]);
+
+		float scale = 0.0f;
+		float bias = 0.0f;
+		GetSliceParameters(scale, bias);
+
+		const Vector3F depthAxis(m_DepthRow.x, m_DepthRow.y, m_DepthRow.z);
+		const float depthScale = Vector::Length(depthAxis);
+
+		auto getSlice = [&](float depth)
+		{
+			const float s = std::floor(std::log2(depth) * scale + bias);
+			return static_cast<uint32_t>((s > 0.0f) ? ((s < static_cast<float>(slices - 1)) ? s : static_cast<float>(slices - 1)) : 0.0f);
+		};
+
+		for (uint32_t s = 0; s < slices; s++)
+		{
+			m_SliceLights[s].clear();
+		}
+
+		// view space lights and the slices their range overlaps
+		m_Lights.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Light& light = pLights[i];
+			ViewLight& rView = m_Lights[i];
+
+			const Vector4F p = Apply(view, Vector4F(light.position, 1.0f));
+			const Vector4F d = Apply(view, Vector4F(light.direction, 0.0f));
+			const float angle = (light.angle < 1.57079633f) ? ((light.angle > 0.0f) ? light.angle : 0.0f) : 1.57079633f;
+
+			rView.position  = Vector3F(p.x, p.y, p.z);
+			rView.range     = light.range;
+			rView.direction = (light.type == LIGHT_SPOT) ? Vector::Normalize(Vector3F(d.x, d.y, d.z)) : Vector3F();
+			rView.cosAngle  = std::cos(angle);
+			rView.sinAngle  = std::sin(angle);
+			rView.type      = light.type;
+
+			const float depth = Vector::Dot(depthAxis, rView.position) + m_DepthRow.w;
+			const float extent = light.range * depthScale;
+
+			if (!(light.range > 0.0f) || depth + extent < m_Desc.nearDepth || depth - extent > m_Desc.farDepth)
+			{
+				rView.firstSlice = 1;
+				rView.lastSlice = 0;
+				continue;
+			}
+
+			rView.firstSlice = getSlice((depth - extent > m_Desc.nearDepth) ? depth - extent : m_Desc.nearDepth);
+			rView.lastSlice = getSlice((depth + extent < m_Desc.farDepth) ? depth + extent : m_Desc.farDepth);
+
+			for (uint32_t s = rView.firstSlice; s <= rView.lastSlice; s++)
+			{
+				m_SliceLights[s].push_back(i);
+			}
+		}
+
+		auto buildSlices = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t s = begin; s < end; s++)
+			{
+				BuildSlice(s);
+			}
+		};
+		Parallel::For(slices, 1, buildSlices);
+
+		// the lists of the slices are concatenated, the offsets of the clusters were relative to their slice
+		std::vector<uint32_t> bases(slices);
+		uint32_t total = 0;
+		for (uint32_t s = 0; s < slices; s++)
+		{
+			bases[s] = total;
+			total += static_cast<uint32_t>(m_SliceIndices[s].size());
+		}
+
+		m_Indices.resize(total);
+
+		const uint32_t tiles = tilesX * tilesY;
+		auto gather = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t s = begin; s < end; s++)
+			{
+				std::copy(m_SliceIndices[s].begin(), m_SliceIndices[s].end(), m_Indices.begin() + bases[s]);
+
+				for (uint32_t t = 0; t < tiles; t++)
+				{
+					m_Clusters[s * tiles + t].offset += bases[s];
+				}
+			}
+		};
+		Parallel::For(slices, 1, gather);
+	}
+
+	return status;
+}
+
+void LightClusters::BuildSlice(uint32_t slice)
+{
+	const uint32_t tilesX = m_Desc.tilesX;
+	const uint32_t tiles = m_Desc.tilesX * m_Desc.tilesY;
+	const uint32_t first = slice * m_TileStride;
+
+	// depths of the slice
+	const float step = std::log2(m_Desc.farDepth / m_Desc.nearDepth) / static_cast<float>(m_Desc.slices);
+	const float depths[2] =
+	{
+		m_Desc.nearDepth * std::exp2(step * static_cast<float>(slice)),
+		m_Desc.nearDepth * std::exp2(step * static_cast<float>(slice + 1))
+	};
+
+	const Vector3F depthAxis(m_DepthRow.x, m_DepthRow.y, m_DepthRow.z);
+
+	for (uint32_t t = 0; t < tiles; t++)
+	{
+		const uint32_t x = t % tilesX;
+		const uint32_t y = t / tilesX;
+		const uint32_t corners[4] = { y * (tilesX + 1) + x, y * (tilesX + 1) + x + 1, (y + 1) * (tilesX + 1) + x, (y + 1) * (tilesX + 1) + x + 1 };
+
+		AABBF box;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const Vector3F& origin = m_Rays[2 * corners[c] + 0];
+			const Vector3F& direction = m_Rays[2 * corners[c] + 1];
+			const float w0 = Vector::Dot(depthAxis, origin) + m_DepthRow.w;
+			const float dw = Vector::Dot(depthAxis, direction);
+
+			for (uint32_t d = 0; d < 2; d++)
+			{
+				box.Merge(origin + direction * ((depths[d] - w0) / dw));
+			}
+		}
+
+		const Vector3F center = box.GetCenter();
+		for (uint32_t a = 0; a < 3; a++)
+		{
+			m_Bounds[BOUNDS_MIN_X + a][first + t] = box.min[a];
+			m_Bounds[BOUNDS_MAX_X + a][first + t] = box.max[a];
+			m_Bounds[BOUNDS_CENTER_X + a][first + t] = center[a];
+		}
+		m_Bounds[BOUNDS_RADIUS][first + t] = Vector::Length(box.GetExtents());
+	}
+
+	const float* ppBounds[10];
+	for (uint32_t k = 0; k < 10; k++)
+	{
+		ppBounds[k] = m_Bounds[k].data() + first;
+	}
+
+	// bit l of the words of a tile is set when light l of the slice touches the cluster
+	const std::vector<uint32_t>& lights = m_SliceLights[slice];
+	const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+	const uint32_t words = (lightCount + 31) / 32;
+
+	std::vector<uint32_t>& rMasks = m_SliceMasks[slice];
+	rMasks.assign(tiles * words, 0);
+
+	for (uint32_t l = 0; l < lightCount; l++)
+	{
+		const ViewLight& light = m_Lights[lights[l]];
+		const uint32_t word = l / 32;
+		const uint32_t bit = 1U << (l % 32);
+
+		for (uint32_t t = 0; t < tiles; t += TILE_GROUP)
+		{
+			uint32_t mask = 0;
+			for (uint32_t k = 0; k < TILE_GROUP; k += LANES)
+			{
+				mask |= TestClusters(ppBounds, t + k, light.position, light.range) << k;
+			}
+
+			// the padding past the last tile passes for an unbounded range, it has no masks
+			if (tiles - t < TILE_GROUP)
+			{
+				mask &= (1U << (tiles - t)) - 1;
+			}
+
+			if (mask != 0 && light.type == LIGHT_SPOT)
+			{
+				uint32_t cone = 0;
+				for (uint32_t k = 0; k < TILE_GROUP; k += LANES)
+				{
+					cone |= TestCone(ppBounds, t + k, light.position, light.direction, light.range, light.cosAngle, light.sinAngle) << k;
+				}
+				mask &= cone;
+			}
+
+			while (mask != 0)
+			{
+				const uint32_t k = static_cast<uint32_t>(std::countr_zero(mask));
+				rMasks[(t + k) * words + word] |= bit;
+				mask &= mask - 1;
+			}
+		}
+	}
+
+	std::vector<uint16_t>& rIndices = m_SliceIndices[slice];
+	rIndices.clear();
+
+	for (uint32_t t = 0; t < tiles; t++)
+	{
+		Cluster& rCluster = m_Clusters[slice * tiles + t];
+		rCluster.offset = static_cast<uint32_t>(rIndices.size());
+
+		for (uint32_t w = 0; w < words; w++)
+		{
+			for (uint32_t bits = rMasks[t * words + w]; bits != 0; bits &= bits - 1)
+			{
+				rIndices.push_back(static_cast<uint16_t>(lights[w * 32 + static_cast<uint32_t>(std::countr_zero(bits))]));
+			}
+		}
+
+		rCluster.count = static_cast<uint32_t>(rIndices.size()) - rCluster.offset;
+	}
+}
+
+void LightClusters::GetSliceParameters(float& rScale, float& rBias) const
+{
+	const float range = std::log2(m_Desc.farDepth / m_Desc.nearDepth);
+
+	rScale = (range > 0.0f) ? static_cast<float>(m_Desc.slices) / range : 0.0f;
+	rBias = -rScale * std::log2((m_Desc.nearDepth > 0.0f) ? m_Desc.nearDepth : 1.0f);
+}
+
+const std::vector<LightClusters::Cluster>& LightClusters::GetClusters(void) const
+{
+	return m_Clusters;
+}
+
+const std::vector<uint16_t>& LightClusters::GetIndices(void) const
+{
+	return m_Indices;
+}
+
+uint32_t LightClusters::GetClusterCount(void) const
+{
+	return static_cast<uint32_t>(m_Clusters.size());
+}
@@ -0,0 +1,450 @@
+#include "CgSpatial.hpp"
+
+#include <bit>
+
+#include "Cg.hpp"
+
+/* LooseOctree: the node of an object is found from the size and the center of its world bounds alone, so a move */
+/* that stays in the same cell only rewrites the packed bounds. Nodes are created on the path of an insertion and */
+/* released when they hold no object and no child, the tree only covers the occupied part of the world. */
+
+#define QUERY_STACK_SIZE 256        // each level pushes at most 7 more nodes than it pops
+#define CULL_BATCH       256        // objects culled per call of Bounds::Cull
+#define SUBTREE_FLAG     0x80000000 // stack entries of subtrees inside the query volume, appended without tests
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+static inline bool Overlaps(const AABBF& a, const AABBF& b)
+{
+	return (a.min.x <= b.max.x) && (a.max.x >= b.min.x) &&
+	       (a.min.y <= b.max.y) && (a.max.y >= b.min.y) &&
+	       (a.min.z <= b.max.z) && (a.max.z >= b.min.z);
+}
+
+static inline bool Contains(const AABBF& outer, const AABBF& inner)
+{
+	return (inner.min.x >= outer.min.x) && (inner.max.x <= outer.max.x) &&
+	       (inner.min.y >= outer.min.y) && (inner.max.y <= outer.max.y) &&
+	       (inner.min.z >= outer.min.z) && (inner.max.z <= outer.max.z);
+}
+
+static inline float GetDistanceSquared(const AABBF& b, const Vector3F& p)
+{
+	float d = 0.0f;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const float e = (p[i] < b.min[i]) ? b.min[i] - p[i] : ((p[i] > b.max[i]) ? p[i] - b.max[i] : 0.0f);
+		d += e * e;
+	}
+
+	return d;
+}
+
+// Squared distance of the box corner farthest from p
+static inline float GetFarthestSquared(const AABBF& b, const Vector3F& p)
+{
+	float d = 0.0f;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const float e0 = std::fabs(p[i] - b.min[i]);
+		const float e1 = std::fabs(p[i] - b.max[i]);
+		const float e  = (e0 > e1) ? e0 : e1;
+		d += e * e;
+	}
+
+	return d;
+}
+
+// ------------------------------------- Construction ---------------------------------------------
+
+LooseOctree::LooseOctree(void) : m_FreeObject(INVALID_HANDLE), m_ObjectCount(0), m_Origin(), m_Size(1.0f), m_MaxDepth(0)
+{
+	const uint32_t cell[3] = { 0, 0, 0 };
+	AllocateNode(INVALID_HANDLE, 0, cell);
+}
+
+bool LooseOctree::Initialize(const AABBF& worldBounds, uint32_t maxDepth)
+{
+	bool status = true;
+
+	const Vector3F size = worldBounds.max - worldBounds.min;
+	const float edge = (size.x >= size.y) ? ((size.x >= size.z) ? size.x : size.z) : ((size.y >= size.z) ? size.y : size.z);
+
+	if (!(size.x >= 0.0f) || !(size.y >= 0.0f) || !(size.z >= 0.0f) || !(edge > 0.0f) || !std::isfinite(edge))
+	{
+		Console::Write(L"Error: Invalid octree bounds\n");
+		status = false;
+	}
+
+	if (maxDepth > MAX_DEPTH)
+	{
+		Console::Write(L"Error: Octree depth %u exceeds %u\n", maxDepth, static_cast<uint32_t>(MAX_DEPTH));
+		status = false;
+	}
+
+	if (status)
+	{
+		m_Nodes.clear();
+		m_FreeNodes.clear();
+		m_Objects.clear();
+		m_FreeObject  = INVALID_HANDLE;
+		m_ObjectCount = 0;
+		m_Origin      = worldBounds.min;
+		m_Size        = edge;
+		m_MaxDepth    = maxDepth;
+
+		const uint32_t cell[3] = { 0, 0, 0 };
+		AllocateNode(INVALID_HANDLE, 0, cell);
+	}
+
+	return status;
+}
+
+uint32_t LooseOctree::AllocateNode(uint32_t parent, uint32_t depth, const uint32_t* pCell)
+{
+	uint32_t index = 0;
+
+	if (m_FreeNodes.empty())
+	{
+		index = static_cast<uint32_t>(m_Nodes.size());
+		m_Nodes.emplace_back();
+	}
+	else
+	{
+		index = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+	}
+
+	// the cell is expanded by half its size on every side
+	const float size = m_Size / static_cast<float>(1U << depth);
+	const Vector3F cellMin(m_Origin.x + pCell[0] * size, m_Origin.y + pCell[1] * size, m_Origin.z + pCell[2] * size);
+	const Vector3F margin(0.5f * size);
+
+	Node& node = m_Nodes[index];
+	node.looseBounds = AABBF(cellMin - margin, cellMin + Vector3F(size) + margin);
+	node.cell[0]     = pCell[0];
+	node.cell[1]     = pCell[1];
+	node.cell[2]     = pCell[2];
+	node.depth       = depth;
+	node.parent      = parent;
+	node.childCount  = 0;
+	node.bounds.clear();
+	node.objects.clear();
+	for (uint32_t i = 0; i < 8; i++) { node.children[i] = 0; }
+
+	return index;
+}
+
+// ---------------------------------------- Updates -----------------------------------------------
+
+// Finds the depth and the cell of the node that stores an object with the given world bounds
+static void FindCell(const AABBF& b, const Vector3F& origin, float worldSize, uint32_t maxDepth, uint32_t& rDepth, uint32_t* pCell)
+{
+	const Vector3F center = b.GetCenter();
+	const Vector3F size = b.max - b.min;
+	const float edge = (size.x >= size.y) ? ((size.x >= size.z) ? size.x : size.z) : ((size.y >= size.z) ? size.y : size.z);
+
+	rDepth = 0;
+	pCell[0] = pCell[1] = pCell[2] = 0;
+
+	// objects centered outside the world (or with NaN bounds) stay in the root
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (!((center[i] >= origin[i]) && (center[i] <= origin[i] + worldSize)))
+		{
+			return;
+		}
+	}
+
+	// deepest level whose cells are still at least as large as the object
+	float cellSize = worldSize;
+	while ((rDepth < maxDepth) && (0.5f * cellSize >= edge))
+	{
+		cellSize *= 0.5f;
+		rDepth++;
+	}
+
+	const uint32_t last = (1U << rDepth) - 1;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const uint32_t c = static_cast<uint32_t>((center[i] - origin[i]) / cellSize);
+		pCell[i] = (c > last) ? last : c;
+	}
+}
+
+void LooseOctree::Link(uint32_t handle, const AABBF& worldBounds)
+{
+	uint32_t depth = 0;
+	uint32_t cell[3] = {};
+	FindCell(worldBounds, m_Origin, m_Size, m_MaxDepth, depth, cell);
+
+	// walk down from the root, creating the missing nodes of the path
+	uint32_t index = 0;
+	for (uint32_t level = 1; level <= depth; level++)
+	{
+		const uint32_t shift = depth - level;
+		const uint32_t path[3] = { cell[0] >> shift, cell[1] >> shift, cell[2] >> shift };
+		const uint32_t child = (path[0] & 1) | ((path[1] & 1) << 1) | ((path[2] & 1) << 2);
+
+		if (m_Nodes[index].children[child] == 0)
+		{
+			const uint32_t created = AllocateNode(index, level, path);
+			m_Nodes[index].children[child] = created;
+			m_Nodes[index].childCount++;
+		}
+
+		index = m_Nodes[index].children[child];
+	}
+
+	Node& node = m_Nodes[index];
+	Object& object = m_Objects[handle];
+	object.node = index;
+	object.slot = static_cast<uint32_t>(node.objects.size());
+	node.objects.push_back(handle);
+	node.bounds.push_back(worldBounds);
+}
+
+void LooseOctree::Unlink(uint32_t handle)
+{
+	Object& object = m_Objects[handle];
+	uint32_t index = object.node;
+
+	// the last object of the node takes the slot
+	Node& node = m_Nodes[index];
+	const uint32_t last = node.objects.back();
+	node.objects[object.slot] = last;
+	node.bounds[object.slot]  = node.bounds.back();
+	m_Objects[last].slot      = object.slot;
+	node.objects.pop_back();
+	node.bounds.pop_back();
+
+	// release the nodes left without objects and children
+	while ((index != 0) && m_Nodes[index].objects.empty() && (m_Nodes[index].childCount == 0))
+	{
+		const uint32_t parent = m_Nodes[index].parent;
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			if (m_Nodes[parent].children[i] == index)
+			{
+				m_Nodes[parent].children[i] = 0;
+				m_Nodes[parent].childCount--;
+			}
+		}
+
+		m_FreeNodes.push_back(index);
+		index = parent;
+	}
+
+	object.node = INVALID_HANDLE;
+}
+
+uint32_t LooseOctree::Insert(const AABBF& bounds, const Matrix4F& world)
+{
+	uint32_t handle = m_FreeObject;
+
+	if (handle == INVALID_HANDLE)
+	{
+		handle = static_cast<uint32_t>(m_Objects.size());
+		m_Objects.emplace_back();
+	}
+	else
+	{
+		m_FreeObject = m_Objects[handle].slot;
+	}
+
+	m_Objects[handle].bounds = bounds;
+	Link(handle, Bounds::Transform(bounds, world));
+	m_ObjectCount++;
+
+	return handle;
+}
+
+void LooseOctree::Move(uint32_t handle, const Matrix4F& world)
+{
+	const Object& object = m_Objects[handle];
+	const AABBF worldBounds = Bounds::Transform(object.bounds, world);
+
+	uint32_t depth = 0;
+	uint32_t cell[3] = {};
+	FindCell(worldBounds, m_Origin, m_Size, m_MaxDepth, depth, cell);
+
+	Node& node = m_Nodes[object.node];
+	if ((node.depth == depth) && (node.cell[0] == cell[0]) && (node.cell[1] == cell[1]) && (node.cell[2] == cell[2]))
+	{
+		node.bounds[object.slot] = worldBounds;
+	}
+	else
+	{
+		Unlink(handle);
+		Link(handle, worldBounds);
+	}
+}
+
+void LooseOctree::Move(const uint32_t* pHandles, const Matrix4F* pWorlds, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Move(pHandles[i], pWorlds[i]);
+	}
+}
+
+void LooseOctree::SetBounds(uint32_t handle, const AABBF& bounds, const Matrix4F& world)
+{
+	m_Objects[handle].bounds = bounds;
+	Move(handle, world);
+}
+
+void LooseOctree::Remove(uint32_t handle)
+{
+	Unlink(handle);
+
+	m_Objects[handle].slot = m_FreeObject;
+	m_FreeObject = handle;
+	m_ObjectCount--;
+}
+
+// ---------------------------------------- Queries -----------------------------------------------
+
+// Depth first traversal, classify returns the intersection of the query with a loose node box and test the
+// overlap of the query with the packed world bounds of count objects, setting bits of pVisible as Bounds::Cull does
+template <typename NODE, typename CLASSIFY, typename TEST>
+static uint32_t QueryNodes(const std::vector<NODE>& nodes, CLASSIFY classify, TEST test, std::vector<uint32_t>& rHandles)
+{
+	const size_t first = rHandles.size();
+
+	uint32_t stack[QUERY_STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const uint32_t entry = stack[--top];
+		const NODE& node = nodes[entry & ~SUBTREE_FLAG];
+
+		// the root also holds the objects outside the world, its loose box is not a bound
+		const INTERSECTION r = (entry & SUBTREE_FLAG) ? INTERSECTION_INSIDE : ((entry == 0) ? INTERSECTION_PARTIAL : classify(node.looseBounds));
+
+		if (r == INTERSECTION_OUTSIDE)
+		{
+			continue;
+		}
+
+		if (r == INTERSECTION_INSIDE)
+		{
+			rHandles.insert(rHandles.end(), node.objects.begin(), node.objects.end());
+		}
+		else
+		{
+			const uint32_t count = static_cast<uint32_t>(node.objects.size());
+			for (uint32_t batch = 0; batch < count; batch += CULL_BATCH)
+			{
+				const uint32_t n = (count - batch < CULL_BATCH) ? count - batch : CULL_BATCH;
+
+				uint32_t visible[CULL_BATCH / 32];
+				if (test(&node.bounds[batch], n, visible) == 0)
+				{
+					continue;
+				}
+
+				for (uint32_t w = 0; w < (n + 31) / 32; w++)
+				{
+					for (uint32_t mask = visible[w]; mask != 0; mask &= mask - 1)
+					{
+						rHandles.push_back(node.objects[batch + 32 * w + static_cast<uint32_t>(std::countr_zero(mask))]);
+					}
+				}
+			}
+		}
+
+		const uint32_t flag = (r == INTERSECTION_INSIDE) ? SUBTREE_FLAG : 0;
+		for (uint32_t i = 0; (node.childCount > 0) && (i < 8); i++)
+		{
+			if (node.children[i] != 0)
+			{
+				stack[top++] = node.children[i] | flag;
+			}
+		}
+	}
+
+	return static_cast<uint32_t>(rHandles.size() - first);
+}
+
+uint32_t LooseOctree::Query(const FrustumF& frustum, std::vector<uint32_t>& rHandles) const
+{
+	auto classify = [&](const AABBF& b) { return Bounds::Classify(frustum, b); };
+	auto test = [&](const AABBF* pBounds, uint32_t count, uint32_t* pVisible) { return Bounds::Cull(frustum, pBounds, count, pVisible); };
+
+	return QueryNodes(m_Nodes, classify, test, rHandles);
+}
+
+uint32_t LooseOctree::Query(const SphereF& sphere, std::vector<uint32_t>& rHandles) const
+{
+	const float r2 = sphere.radius * sphere.radius;
+
+	auto classify = [&](const AABBF& b)
+	{
+		if (GetDistanceSquared(b, sphere.center) > r2)   { return INTERSECTION_OUTSIDE; }
+		if (GetFarthestSquared(b, sphere.center) <= r2) { return INTERSECTION_INSIDE; }
+		return INTERSECTION_PARTIAL;
+	};
+
+	auto test = [&](const AABBF* pBounds, uint32_t count, uint32_t* pVisible)
+	{
+		uint32_t visible = 0;
+		for (uint32_t i = 0; i < (count + 31) / 32; i++) { pVisible[i] = 0; }
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (GetDistanceSquared(pBounds[i], sphere.center) <= r2)
+			{
+				pVisible[i / 32] |= 1U << (i % 32);
+				visible++;
+			}
+		}
+		return visible;
+	};
+
+	return QueryNodes(m_Nodes, classify, test, rHandles);
+}
+
+uint32_t LooseOctree::Query(const AABBF& box, std::vector<uint32_t>& rHandles) const
+{
+	auto classify = [&](const AABBF& b)
+	{
+		if (!Overlaps(box, b)) { return INTERSECTION_OUTSIDE; }
+		if (Contains(box, b))  { return INTERSECTION_INSIDE; }
+		return INTERSECTION_PARTIAL;
+	};
+
+	auto test = [&](const AABBF* pBounds, uint32_t count, uint32_t* pVisible)
+	{
+		uint32_t visible = 0;
+		for (uint32_t i = 0; i < (count + 31) / 32; i++) { pVisible[i] = 0; }
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (Overlaps(box, pBounds[i]))
+			{
+				pVisible[i / 32] |= 1U << (i % 32);
+				visible++;
+			}
+		}
+		return visible;
+	};
+
+	return QueryNodes(m_Nodes, classify, test, rHandles);
+}
+
+const AABBF& LooseOctree::GetWorldBounds(uint32_t handle) const
+{
+	const Object& object = m_Objects[handle];
+	return m_Nodes[object.node].bounds[object.slot];
+}
+
+uint32_t LooseOctree::GetObjectCount(void) const
+{
+	return m_ObjectCount;
+}
+
+uint32_t LooseOctree::GetNodeCount(void) const
+{
+	return static_cast<uint32_t>(m_Nodes.size() - m_FreeNodes.size());
+}
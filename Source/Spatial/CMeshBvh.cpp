@@ -0,0 +1,884 @@
+#include "CgSpatial.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "Cg.hpp"
+
+#if CG_MATH_SSE
+#include <immintrin.h>
+#endif
+
+/* MeshBvh: a binary hierarchy is built with binned SAH over the triangle centroids, then collapsed into nodes of */
+/* four children by opening the largest inner child until four slots are used. The top of the tree is split on the */
+/* calling thread until the ranges are small enough, the remaining subtrees are built in parallel and spliced in. */
+
+#define SAH_BINS        16
+#define TRAVERSAL_COST  1.0f // cost of visiting a node relative to one triangle test
+#define MAX_BUILD_DEPTH 48   // deeper ranges are split at the object median, which bounds the traversal stack
+#define MAX_TREE_DEPTH  80   // MAX_BUILD_DEPTH plus the median splits of 2^32 triangles
+#define STACK_SIZE      256  // each level pushes at most 3 more nodes than it pops, the pushes are checked anyway
+#define TASK_TRIANGLES  4096 // smallest range built as a parallel task
+#define MIN_DIRECTION   1.0e-20f
+
+// Binary node of the build, leaves have count > 0
+struct BUILD_NODE
+{
+	AABBF    bounds;
+	uint32_t first; // leaf: first reference, inner: left child
+	uint32_t right;
+	uint32_t count;
+};
+
+struct BUILD_TASK
+{
+	uint32_t                node; // top tree node that the subtree root replaces
+	uint32_t                begin;
+	uint32_t                end;
+	uint32_t                depth;
+	std::vector<BUILD_NODE> nodes;
+};
+
+struct BUILD_STATE
+{
+	std::vector<AABBF>    bounds;    // per triangle
+	std::vector<Vector3F> centroids; // per triangle
+	std::vector<uint32_t> refs;      // triangle indices, partitioned into the leaf ranges
+};
+
+struct RAY
+{
+	Vector3F origin;
+	Vector3F invDirection;
+	bool     bNegative[3]; // the near planes of the slabs are the max planes
+};
+
+// ------------------------------------ Helper functions ------------------------------------------
+
+// Half the surface area, enough for the SAH ratios
+static inline float GetArea(const AABBF& b)
+{
+	const Vector3F d = b.max - b.min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static inline uint32_t GetLargestAxis(const Vector3F& v)
+{
+	return (v.x >= v.y) ? ((v.x >= v.z) ? 0 : 2) : ((v.y >= v.z) ? 1 : 2);
+}
+
+static void SetSlot(MeshBvh::Node& rNode, uint32_t i, const AABBF& b, uint32_t child, uint32_t count)
+{
+	rNode.minX[i]  = b.min.x;
+	rNode.minY[i]  = b.min.y;
+	rNode.minZ[i]  = b.min.z;
+	rNode.maxX[i]  = b.max.x;
+	rNode.maxY[i]  = b.max.y;
+	rNode.maxZ[i]  = b.max.z;
+	rNode.child[i] = child;
+	rNode.count[i] = count;
+}
+
+static RAY MakeRay(const Vector3F& origin, const Vector3F& direction)
+{
+	RAY ray = {};
+	ray.origin = origin;
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		// tiny components keep the slab distances finite, (min - o) * inv is never 0 * inf
+		const float d = (std::fabs(direction[i]) < MIN_DIRECTION) ? std::copysign(MIN_DIRECTION, direction[i]) : direction[i];
+		ray.invDirection[i] = 1.0f / d;
+		ray.bNegative[i]    = d < 0.0f;
+	}
+
+	return ray;
+}
+
+// Slab test of the four child boxes against [0, tMax], returns the mask of the boxes hit and writes their entry distances
+// Selecting the planes by the direction signs makes the inverted boxes of unused slots miss
+static inline uint32_t IntersectBoxes(const MeshBvh::Node& node, const RAY& ray, float tMax, float* pNear)
+{
+	const float* pNearX = ray.bNegative[0] ? node.maxX : node.minX;
+	const float* pNearY = ray.bNegative[1] ? node.maxY : node.minY;
+	const float* pNearZ = ray.bNegative[2] ? node.maxZ : node.minZ;
+	const float* pFarX  = ray.bNegative[0] ? node.minX : node.maxX;
+	const float* pFarY  = ray.bNegative[1] ? node.minY : node.maxY;
+	const float* pFarZ  = ray.bNegative[2] ? node.minZ : node.maxZ;
+
+#if CG_MATH_SSE
+	const __m128 ox = _mm_set1_ps(ray.origin.x);
+	const __m128 oy = _mm_set1_ps(ray.origin.y);
+	const __m128 oz = _mm_set1_ps(ray.origin.z);
+	const __m128 ix = _mm_set1_ps(ray.invDirection.x);
+	const __m128 iy = _mm_set1_ps(ray.invDirection.y);
+	const __m128 iz = _mm_set1_ps(ray.invDirection.z);
+
+	const __m128 nx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pNearX), ox), ix);
+	const __m128 ny = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pNearY), oy), iy);
+	const __m128 nz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pNearZ), oz), iz);
+	const __m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pFarX), ox), ix);
+	const __m128 fy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pFarY), oy), iy);
+	const __m128 fz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pFarZ), oz), iz);
+
+	const __m128 tn = _mm_max_ps(_mm_max_ps(nx, ny), _mm_max_ps(nz, _mm_setzero_ps()));
+	const __m128 tf = _mm_min_ps(_mm_min_ps(fx, fy), _mm_min_ps(fz, _mm_set1_ps(tMax)));
+
+	_mm_storeu_ps(pNear, tn);
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tn, tf)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const float nx = (pNearX[i] - ray.origin.x) * ray.invDirection.x;
+		const float ny = (pNearY[i] - ray.origin.y) * ray.invDirection.y;
+		const float nz = (pNearZ[i] - ray.origin.z) * ray.invDirection.z;
+		const float fx = (pFarX[i] - ray.origin.x) * ray.invDirection.x;
+		const float fy = (pFarY[i] - ray.origin.y) * ray.invDirection.y;
+		const float fz = (pFarZ[i] - ray.origin.z) * ray.invDirection.z;
+
+		const float nz0 = (nz > 0.0f) ? nz : 0.0f;
+		const float tn  = (nx > ny) ? ((nx > nz0) ? nx : nz0) : ((ny > nz0) ? ny : nz0);
+		const float tf0 = (fz < tMax) ? fz : tMax;
+		const float tf  = (fx < fy) ? ((fx < tf0) ? fx : tf0) : ((fy < tf0) ? fy : tf0);
+
+		pNear[i] = tn;
+		mask |= (tn <= tf) ? (1u << i) : 0;
+	}
+	return mask;
+#endif
+}
+
+// Mask of the four child boxes overlapping b
+static inline uint32_t OverlapBoxes(const MeshBvh::Node& node, const AABBF& b)
+{
+#if CG_MATH_SSE
+	__m128 m = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), _mm_set1_ps(b.max.x)), _mm_cmple_ps(_mm_set1_ps(b.min.x), _mm_loadu_ps(node.maxX)));
+	m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), _mm_set1_ps(b.max.y)), _mm_cmple_ps(_mm_set1_ps(b.min.y), _mm_loadu_ps(node.maxY))));
+	m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), _mm_set1_ps(b.max.z)), _mm_cmple_ps(_mm_set1_ps(b.min.z), _mm_loadu_ps(node.maxZ))));
+	return static_cast<uint32_t>(_mm_movemask_ps(m));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const bool bOverlap = (node.minX[i] <= b.max.x) && (b.min.x <= node.maxX[i]) &&
+		                      (node.minY[i] <= b.max.y) && (b.min.y <= node.maxY[i]) &&
+		                      (node.minZ[i] <= b.max.z) && (b.min.z <= node.maxZ[i]);
+		mask |= bOverlap ? (1u << i) : 0;
+	}
+	return mask;
+#endif
+}
+
+// Two sided Moller-Trumbore test, writes the hit when it is closer than rHit.distance
+static inline bool IntersectTriangle(const MeshBvh::Triangle& tri, const Vector3F& origin, const Vector3F& direction, MeshBvh::Hit& rHit)
+{
+	const Vector3F p   = Vector::Cross(direction, tri.e2);
+	const float    det = Vector::Dot(tri.e1, p);
+
+	if (det == 0.0f) // parallel to the plane, or a degenerate triangle
+	{
+		return false;
+	}
+
+	const float    inv = 1.0f / det;
+	const Vector3F s   = origin - tri.v0;
+	const float    u   = Vector::Dot(s, p) * inv;
+
+	if ((u < 0.0f) || (u > 1.0f))
+	{
+		return false;
+	}
+
+	const Vector3F q = Vector::Cross(s, tri.e1);
+	const float    v = Vector::Dot(direction, q) * inv;
+
+	if ((v < 0.0f) || (u + v > 1.0f))
+	{
+		return false;
+	}
+
+	const float t = Vector::Dot(tri.e2, q) * inv;
+
+	if ((t < 0.0f) || (t > rHit.distance))
+	{
+		return false;
+	}
+
+	rHit.distance = t;
+	rHit.u        = u;
+	rHit.v        = v;
+	rHit.triangle = tri.index;
+	return true;
+}
+
+// Separating axis test of a triangle against the box with center c and half size h (Akenine-Moller)
+static bool OverlapTriangle(const MeshBvh::Triangle& tri, const Vector3F& c, const Vector3F& h)
+{
+	const Vector3F v[3] = { tri.v0 - c, tri.v0 - c + tri.e1, tri.v0 - c + tri.e2 };
+	const Vector3F e[3] = { tri.e1, tri.e2 - tri.e1, -tri.e2 };
+
+	// box face normals
+	for (uint32_t k = 0; k < 3; k++)
+	{
+		const float lo = (v[0][k] < v[1][k]) ? ((v[0][k] < v[2][k]) ? v[0][k] : v[2][k]) : ((v[1][k] < v[2][k]) ? v[1][k] : v[2][k]);
+		const float hi = (v[0][k] > v[1][k]) ? ((v[0][k] > v[2][k]) ? v[0][k] : v[2][k]) : ((v[1][k] > v[2][k]) ? v[1][k] : v[2][k]);
+		if ((lo > h[k]) || (hi < -h[k]))
+		{
+			return false;
+		}
+	}
+
+	// triangle normal
+	const Vector3F n = Vector::Cross(tri.e1, tri.e2);
+	const float    r = h.x * std::fabs(n.x) + h.y * std::fabs(n.y) + h.z * std::fabs(n.z);
+	if (std::fabs(Vector::Dot(n, v[0])) > r)
+	{
+		return false;
+	}
+
+	// cross products of the box axes and the triangle edges
+	for (uint32_t j = 0; j < 3; j++)
+	{
+		const Vector3F axes[3] = { Vector3F(0.0f, -e[j].z, e[j].y), Vector3F(e[j].z, 0.0f, -e[j].x), Vector3F(-e[j].y, e[j].x, 0.0f) };
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const Vector3F& a = axes[i];
+
+			const float p0 = Vector::Dot(v[0], a);
+			const float p1 = Vector::Dot(v[1], a);
+			const float p2 = Vector::Dot(v[2], a);
+			const float lo = (p0 < p1) ? ((p0 < p2) ? p0 : p2) : ((p1 < p2) ? p1 : p2);
+			const float hi = (p0 > p1) ? ((p0 > p2) ? p0 : p2) : ((p1 > p2) ? p1 : p2);
+			const float ra = h.x * std::fabs(a.x) + h.y * std::fabs(a.y) + h.z * std::fabs(a.z);
+
+			if ((lo > ra) || (hi < -ra))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// ------------------------------------------ Build -----------------------------------------------
+
+// Chooses the split of refs[begin, end) and partitions the range, returns false when the range becomes a leaf
+static bool Split(BUILD_STATE& s, const AABBF& bounds, uint32_t begin, uint32_t end, uint32_t depth, uint32_t& rMid)
+{
+	const uint32_t count = end - begin;
+	uint32_t*      pRefs = s.refs.data();
+
+	AABBF centroidBounds;
+	for (uint32_t i = begin; i < end; i++) { centroidBounds.Merge(s.centroids[pRefs[i]]); }
+
+	const Vector3F extents = centroidBounds.max - centroidBounds.min;
+
+	float    bestCost = INF;
+	uint32_t bestAxis = 0;
+	uint32_t bestBin  = 0;
+
+	for (uint32_t axis = 0; (depth < MAX_BUILD_DEPTH) && (axis < 3); axis++)
+	{
+		if (!(extents[axis] > 0.0f))
+		{
+			continue;
+		}
+
+		const float scale = SAH_BINS / extents[axis];
+
+		AABBF    binBounds[SAH_BINS];
+		uint32_t binCounts[SAH_BINS] = {};
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const uint32_t b   = static_cast<uint32_t>((s.centroids[pRefs[i]][axis] - centroidBounds.min[axis]) * scale);
+			const uint32_t bin = (b < SAH_BINS - 1) ? b : SAH_BINS - 1;
+			binBounds[bin].Merge(s.bounds[pRefs[i]]);
+			binCounts[bin]++;
+		}
+
+		// cost of splitting after bin i: left count * left area + right count * right area
+		float    rightCost[SAH_BINS] = {};
+		AABBF    right;
+		uint32_t rightCount = 0;
+		for (uint32_t i = SAH_BINS - 1; i > 0; i--)
+		{
+			right.Merge(binBounds[i]);
+			rightCount += binCounts[i];
+			rightCost[i - 1] = (rightCount > 0) ? rightCount * GetArea(right) : 0.0f;
+		}
+
+		AABBF    left;
+		uint32_t leftCount = 0;
+		for (uint32_t i = 0; i < SAH_BINS - 1; i++)
+		{
+			left.Merge(binBounds[i]);
+			leftCount += binCounts[i];
+
+			const float cost = ((leftCount > 0) ? leftCount * GetArea(left) : 0.0f) + rightCost[i];
+			if ((leftCount > 0) && (leftCount < count) && (cost < bestCost))
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin  = i;
+			}
+		}
+	}
+
+	const bool bSplit = bestCost < INF;
+
+	// a leaf is made when it is allowed and cheaper than the traversal step plus the expected triangle tests
+	if ((count <= MeshBvh::MAX_LEAF_TRIANGLES) && (!bSplit || (static_cast<float>(count) <= TRAVERSAL_COST + bestCost / GetArea(bounds))))
+	{
+		return false;
+	}
+
+	if (bSplit)
+	{
+		const float scale = SAH_BINS / extents[bestAxis];
+		const float origin = centroidBounds.min[bestAxis];
+
+		uint32_t* pMid = std::partition(pRefs + begin, pRefs + end, [&](uint32_t r)
+		{
+			const uint32_t b = static_cast<uint32_t>((s.centroids[r][bestAxis] - origin) * scale);
+			return ((b < SAH_BINS - 1) ? b : SAH_BINS - 1) <= bestBin;
+		});
+
+		rMid = static_cast<uint32_t>(pMid - pRefs);
+	}
+	else
+	{
+		// too deep, or every centroid in the same place: object median along the largest extent
+		const uint32_t axis = GetLargestAxis(extents);
+
+		rMid = begin + count / 2;
+		std::nth_element(pRefs + begin, pRefs + rMid, pRefs + end, [&](uint32_t a, uint32_t b) { return s.centroids[a][axis] < s.centroids[b][axis]; });
+	}
+
+	return true;
+}
+
+static AABBF GetRangeBounds(const BUILD_STATE& s, uint32_t begin, uint32_t end)
+{
+	AABBF b;
+	for (uint32_t i = begin; i < end; i++) { b.Merge(s.bounds[s.refs[i]]); }
+	return b;
+}
+
+// Builds the subtree of refs[begin, end) under nodes[index]
+static void BuildSubtree(BUILD_STATE& s, std::vector<BUILD_NODE>& nodes, uint32_t index, uint32_t begin, uint32_t end, uint32_t depth)
+{
+	const AABBF bounds = GetRangeBounds(s, begin, end);
+
+	uint32_t mid = 0;
+	if (Split(s, bounds, begin, end, depth, mid))
+	{
+		const uint32_t left = static_cast<uint32_t>(nodes.size());
+		nodes.resize(left + 2);
+		nodes[index] = { bounds, left, left + 1, 0 };
+
+		BuildSubtree(s, nodes, left, begin, mid, depth + 1);
+		BuildSubtree(s, nodes, left + 1, mid, end, depth + 1);
+	}
+	else
+	{
+		nodes[index] = { bounds, begin, 0, end - begin };
+	}
+}
+
+// Converts the binary subtree under index into nodes of four children, returns the index of its node
+static uint32_t Collapse(const std::vector<BUILD_NODE>& bin, uint32_t index, std::vector<MeshBvh::Node>& nodes)
+{
+	uint32_t slots[4] = {};
+	uint32_t n = 0;
+
+	if (bin[index].count > 0)
+	{
+		slots[n++] = index; // the whole tree is one leaf
+	}
+	else
+	{
+		slots[n++] = bin[index].first;
+		slots[n++] = bin[index].right;
+	}
+
+	// open the inner child with the largest surface area until the slots are used
+	while (n < 4)
+	{
+		uint32_t best     = n;
+		float    bestArea = -1.0f;
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const float area = GetArea(bin[slots[i]].bounds);
+			if ((bin[slots[i]].count == 0) && (area > bestArea))
+			{
+				best     = i;
+				bestArea = area;
+			}
+		}
+
+		if (best == n)
+		{
+			break;
+		}
+
+		const uint32_t c = slots[best];
+		slots[best] = bin[c].first;
+		slots[n++]  = bin[c].right;
+	}
+
+	const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+	nodes.push_back(MeshBvh::Node());
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (i >= n)
+		{
+			SetSlot(nodes[nodeIndex], i, AABBF(), 0, 0);
+		}
+		else if (bin[slots[i]].count > 0)
+		{
+			SetSlot(nodes[nodeIndex], i, bin[slots[i]].bounds, bin[slots[i]].first, bin[slots[i]].count);
+		}
+		else
+		{
+			const uint32_t child = Collapse(bin, slots[i], nodes); // may reallocate nodes
+			SetSlot(nodes[nodeIndex], i, bin[slots[i]].bounds, child, 0);
+		}
+	}
+
+	return nodeIndex;
+}
+
+// ----------------------------------------- MeshBvh ----------------------------------------------
+
+MeshBvh::MeshBvh(void)
+{
+}
+
+bool MeshBvh::Build(const Importer::Mesh& mesh)
+{
+	std::vector<Vector3F> positions(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		positions[i] = Vector3F(mesh.vertices[i].position[0], mesh.vertices[i].position[1], mesh.vertices[i].position[2]);
+	}
+
+	return Build(positions.data(), static_cast<uint32_t>(positions.size()), mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()));
+}
+
+bool MeshBvh::Build(const Vector3F* pPositions, uint32_t vertexCount, const uint16_t* pIndices, uint32_t indexCount)
+{
+	bool status = true;
+
+	m_Nodes.clear();
+	m_Triangles.clear();
+	m_Bounds = AABBF();
+
+	if ((indexCount % 3) != 0)
+	{
+		Console::Write(L"Error: Index count %u is not a multiple of 3\n", indexCount);
+		status = false;
+	}
+
+	for (uint32_t i = 0; status && (i < indexCount); i++)
+	{
+		if (pIndices[i] >= vertexCount)
+		{
+			Console::Write(L"Error: Index %u out of range (%u vertices)\n", pIndices[i], vertexCount);
+			status = false;
+		}
+	}
+
+	const uint32_t triangleCount = indexCount / 3;
+
+	if (status && (triangleCount > 0))
+	{
+		BUILD_STATE s;
+		s.bounds.resize(triangleCount);
+		s.centroids.resize(triangleCount);
+		s.refs.resize(triangleCount);
+
+		auto prepare = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				AABBF b;
+				for (uint32_t k = 0; k < 3; k++) { b.Merge(pPositions[pIndices[3 * i + k]]); }
+				s.bounds[i]    = b;
+				s.centroids[i] = b.GetCenter();
+				s.refs[i]      = i;
+			}
+		};
+		Parallel::For(triangleCount, TASK_TRIANGLES, prepare);
+
+		// top of the tree: ranges larger than a task are split here, breadth first
+		const uint32_t taskSize = (triangleCount / (8 * Parallel::GetThreadCount()) > TASK_TRIANGLES) ? triangleCount / (8 * Parallel::GetThreadCount()) : TASK_TRIANGLES;
+
+		std::vector<BUILD_NODE> nodes(1);
+		std::vector<BUILD_TASK> tasks;
+		std::vector<BUILD_TASK> queue(1);
+		queue[0] = { 0, 0, triangleCount, 0, {} };
+
+		for (size_t q = 0; q < queue.size(); q++)
+		{
+			const BUILD_TASK range = { queue[q].node, queue[q].begin, queue[q].end, queue[q].depth, {} };
+
+			uint32_t mid = 0;
+			if (range.end - range.begin <= taskSize)
+			{
+				tasks.push_back(range);
+			}
+			else
+			{
+				const AABBF bounds = GetRangeBounds(s, range.begin, range.end);
+				Split(s, bounds, range.begin, range.end, range.depth, mid); // always splits, the range is larger than a leaf
+
+				const uint32_t left = static_cast<uint32_t>(nodes.size());
+				nodes.resize(left + 2);
+				nodes[range.node] = { bounds, left, left + 1, 0 };
+
+				queue.push_back({ left, range.begin, mid, range.depth + 1, {} });
+				queue.push_back({ left + 1, mid, range.end, range.depth + 1, {} });
+			}
+		}
+
+		auto build = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				tasks[i].nodes.resize(1);
+				BuildSubtree(s, tasks[i].nodes, 0, tasks[i].begin, tasks[i].end, tasks[i].depth);
+			}
+		};
+		Parallel::For(static_cast<uint32_t>(tasks.size()), 1, build);
+
+		// splice the subtrees in task order, the root of a subtree takes the place of its top tree node
+		for (const BUILD_TASK& task : tasks)
+		{
+			const uint32_t offset = static_cast<uint32_t>(nodes.size()) - 1;
+
+			for (size_t j = 0; j < task.nodes.size(); j++)
+			{
+				BUILD_NODE node = task.nodes[j];
+				if (node.count == 0)
+				{
+					node.first += offset;
+					node.right += offset;
+				}
+
+				if (j == 0) { nodes[task.node] = node; }
+				else        { nodes.push_back(node); }
+			}
+		}
+
+		m_Nodes.reserve(nodes.size() / 2 + 1);
+		Collapse(nodes, 0, m_Nodes);
+
+		m_Triangles.resize(triangleCount);
+		for (uint32_t i = 0; i < triangleCount; i++)
+		{
+			const uint32_t t = s.refs[i];
+			const Vector3F v0 = pPositions[pIndices[3 * t]];
+
+			m_Triangles[i].v0    = v0;
+			m_Triangles[i].e1    = pPositions[pIndices[3 * t + 1]] - v0;
+			m_Triangles[i].e2    = pPositions[pIndices[3 * t + 2]] - v0;
+			m_Triangles[i].index = t;
+		}
+
+		m_Bounds = nodes[0].bounds;
+	}
+
+	return status;
+}
+
+// ----------------------------------------- Queries ----------------------------------------------
+
+bool MeshBvh::Raycast(const Vector3F& origin, const Vector3F& direction, float maxDistance, Hit& rHit) const
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	const RAY ray = MakeRay(origin, direction);
+
+	Hit hit = { maxDistance, 0.0f, 0.0f, 0 };
+	bool bHit = false;
+
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = m_Nodes[stack[--top]];
+
+		float    tNear[4];
+		uint32_t mask = IntersectBoxes(node, ray, hit.distance, tNear);
+
+		// order the children near to far: the leaves are tested right away, which shortens the ray,
+		// the inner nodes are pushed far to near so that the nearest one is visited next
+		uint32_t order[4];
+		uint32_t n = 0;
+		for (; mask != 0; mask &= mask - 1)
+		{
+			const uint32_t i = static_cast<uint32_t>(std::countr_zero(mask));
+
+			uint32_t j = n++;
+			for (; (j > 0) && (tNear[order[j - 1]] > tNear[i]); j--) { order[j] = order[j - 1]; }
+			order[j] = i;
+		}
+
+		for (uint32_t k = 0; k < n; k++)
+		{
+			const uint32_t i = order[k];
+			for (uint32_t t = 0; t < node.count[i]; t++)
+			{
+				bHit |= IntersectTriangle(m_Triangles[node.child[i] + t], origin, direction, hit);
+			}
+		}
+
+		for (uint32_t k = n; k > 0; k--)
+		{
+			const uint32_t i = order[k - 1];
+			if ((node.count[i] == 0) && (tNear[i] <= hit.distance) && (top < STACK_SIZE))
+			{
+				stack[top++] = node.child[i];
+			}
+		}
+	}
+
+	if (bHit)
+	{
+		rHit = hit;
+	}
+
+	return bHit;
+}
+
+bool MeshBvh::IntersectSegment(const Vector3F& p0, const Vector3F& p1) const
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	const Vector3F direction = p1 - p0;
+	const RAY      ray       = MakeRay(p0, direction);
+
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = m_Nodes[stack[--top]];
+
+		float tNear[4];
+		for (uint32_t mask = IntersectBoxes(node, ray, 1.0f, tNear); mask != 0; mask &= mask - 1)
+		{
+			const uint32_t i = static_cast<uint32_t>(std::countr_zero(mask));
+
+			if (node.count[i] == 0)
+			{
+				if (top < STACK_SIZE) { stack[top++] = node.child[i]; }
+				continue;
+			}
+
+			for (uint32_t t = 0; t < node.count[i]; t++)
+			{
+				Hit hit = { 1.0f, 0.0f, 0.0f, 0 };
+				if (IntersectTriangle(m_Triangles[node.child[i] + t], p0, direction, hit))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+uint32_t MeshBvh::Overlap(const AABBF& box, std::vector<uint32_t>& rTriangles) const
+{
+	const size_t first = rTriangles.size();
+
+	if (m_Nodes.empty())
+	{
+		return 0;
+	}
+
+	const Vector3F center  = box.GetCenter();
+	const Vector3F extents = box.GetExtents();
+
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = m_Nodes[stack[--top]];
+
+		for (uint32_t mask = OverlapBoxes(node, box); mask != 0; mask &= mask - 1)
+		{
+			const uint32_t i = static_cast<uint32_t>(std::countr_zero(mask));
+
+			if (node.count[i] == 0)
+			{
+				if (top < STACK_SIZE) { stack[top++] = node.child[i]; }
+				continue;
+			}
+
+			for (uint32_t t = 0; t < node.count[i]; t++)
+			{
+				const Triangle& tri = m_Triangles[node.child[i] + t];
+				if (OverlapTriangle(tri, center, extents))
+				{
+					rTriangles.push_back(tri.index);
+				}
+			}
+		}
+	}
+
+	return static_cast<uint32_t>(rTriangles.size() - first);
+}
+
+const AABBF& MeshBvh::GetBounds(void) const
+{
+	return m_Bounds;
+}
+
+uint32_t MeshBvh::GetNodeCount(void) const
+{
+	return static_cast<uint32_t>(m_Nodes.size());
+}
+
+uint32_t MeshBvh::GetTriangleCount(void) const
+{
+	return static_cast<uint32_t>(m_Triangles.size());
+}
+
+// ------------------------------------- Serialization --------------------------------------------
+
+bool MeshBvh::Save(std::vector<uint8_t>& rData) const
+{
+	bool status = true;
+
+	HEADER header = {};
+	header.signature     = SIGNATURE;
+	header.version       = VERSION;
+	header.nodeCount     = static_cast<uint32_t>(m_Nodes.size());
+	header.triangleCount = static_cast<uint32_t>(m_Triangles.size());
+	memcpy(&header.bounds[0], m_Bounds.min.elements, 3 * sizeof(float));
+	memcpy(&header.bounds[3], m_Bounds.max.elements, 3 * sizeof(float));
+
+	const size_t offset = rData.size();
+	const size_t nodeBytes = m_Nodes.size() * sizeof(Node);
+	const size_t triangleBytes = m_Triangles.size() * sizeof(Triangle);
+
+	rData.resize(offset + sizeof(HEADER) + nodeBytes + triangleBytes);
+
+	uint8_t* pData = rData.data() + offset;
+	memcpy(pData, &header, sizeof(HEADER));
+	if (nodeBytes > 0)     { memcpy(pData + sizeof(HEADER), m_Nodes.data(), nodeBytes); }
+	if (triangleBytes > 0) { memcpy(pData + sizeof(HEADER) + nodeBytes, m_Triangles.data(), triangleBytes); }
+
+	return status;
+}
+
+bool MeshBvh::Load(const uint8_t* pData, size_t size)
+{
+	bool status = true;
+
+	HEADER header = {};
+
+	if ((pData == nullptr) || (size < sizeof(HEADER)))
+	{
+		Console::Write(L"Error: BVH data too small\n");
+		status = false;
+	}
+
+	if (status)
+	{
+		memcpy(&header, pData, sizeof(HEADER));
+
+		if ((header.signature != SIGNATURE) || (header.version != VERSION))
+		{
+			Console::Write(L"Error: Invalid BVH signature or version\n");
+			status = false;
+		}
+		else if (size != sizeof(HEADER) + static_cast<size_t>(header.nodeCount) * sizeof(Node) + static_cast<size_t>(header.triangleCount) * sizeof(Triangle))
+		{
+			Console::Write(L"Error: BVH size mismatch\n");
+			status = false;
+		}
+	}
+
+	std::vector<Node>     nodes;
+	std::vector<Triangle> triangles;
+
+	if (status)
+	{
+		nodes.resize(header.nodeCount);
+		triangles.resize(header.triangleCount);
+
+		if (header.nodeCount > 0)     { memcpy(nodes.data(), pData + sizeof(HEADER), nodes.size() * sizeof(Node)); }
+		if (header.triangleCount > 0) { memcpy(triangles.data(), pData + sizeof(HEADER) + nodes.size() * sizeof(Node), triangles.size() * sizeof(Triangle)); }
+
+		// the traversal trusts the child references and the depth, children always follow their parent and have only one,
+		// a node reached from two parents could be deeper than the depth seen through the last one
+		std::vector<uint32_t> depths(header.nodeCount, 0);
+		std::vector<uint8_t>  referenced(header.nodeCount, 0);
+		for (uint32_t i = 0; status && (i < header.nodeCount); i++)
+		{
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				const uint32_t child = nodes[i].child[k];
+				const uint32_t count = nodes[i].count[k];
+
+				const bool bValid = (count > 0) ? ((count <= MAX_LEAF_TRIANGLES) && (count <= header.triangleCount) && (child <= header.triangleCount - count))
+				                                : ((child > i) && (child < header.nodeCount)) || (nodes[i].minX[k] > nodes[i].maxX[k]);
+				if (!bValid)
+				{
+					Console::Write(L"Error: Invalid BVH node %u\n", i);
+					status = false;
+					break;
+				}
+
+				if ((count == 0) && (child > i) && (child < header.nodeCount))
+				{
+					if (referenced[child] != 0)
+					{
+						Console::Write(L"Error: BVH node %u has more than one parent\n", child);
+						status = false;
+						break;
+					}
+
+					referenced[child] = 1;
+					depths[child] = depths[i] + 1;
+					if (depths[child] > MAX_TREE_DEPTH)
+					{
+						Console::Write(L"Error: BVH deeper than %u levels\n", MAX_TREE_DEPTH);
+						status = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if (status)
+	{
+		m_Nodes     = std::move(nodes);
+		m_Triangles = std::move(triangles);
+		m_Bounds    = AABBF(Vector3F(header.bounds[0], header.bounds[1], header.bounds[2]), Vector3F(header.bounds[3], header.bounds[4], header.bounds[5]));
+	}
+
+	return status;
+}
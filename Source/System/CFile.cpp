@@ -5,7 +5,12 @@
 
 File* File::Open(const wchar_t* Path)
 {
-	return static_cast<File*>(CFile::Open(Path));
+	return static_cast<File*>(CFile::Open(Path, File::READ));
+}
+
+File* File::Open(const wchar_t* Path, MODE Mode)
+{
+	return static_cast<File*>(CFile::Open(Path, Mode));
 }
 
 File* File::Open(const FILE_PATH& Path)
@@ -46,18 +51,26 @@ CFile::~CFile()
 	CgAssert(hFile == nullptr, L"File handle not closed\n");
 }
 
-CFile* CFile::Open(const wchar_t* Path)
+CFile* CFile::Open(const wchar_t* Path, File::MODE Mode)
 {
 	CFile* pCFile = new CFile();
 
-	pCFile->hFile = CreateFile(Path, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (Mode == File::WRITE)
+	{
+		pCFile->hFile = CreateFile(Path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	}
+	else
+	{
+		pCFile->hFile = CreateFile(Path, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	}
 	
 	if (pCFile->hFile == INVALID_HANDLE_VALUE)
 	{
+		pCFile->hFile = nullptr;
 		delete pCFile;
 		pCFile = nullptr;
 
-		Console::Write(L"Error: Could not open file %s for reading\n", Path);
+		Console::Write((Mode == File::WRITE) ? L"Error: Could not open file %s for writing\n" : L"Error: Could not open file %s for reading\n", Path);
 	}
 
 	return pCFile;
@@ -120,8 +133,9 @@ bool CFile::ReadBytes(void* pBuffer, uint32_t numBytes)
 
 	DWORD bytesRead = 0;
 
-	if (ReadFile(hFile, pBuffer, numBytes, &bytesRead, NULL) != 0)
+	if (ReadFile(hFile, pBuffer, numBytes, &bytesRead, NULL) == 0)
 	{
+		Console::Write(L"Error: Could not read %u bytes from file\n", numBytes);
 		status = false;
 	}
 	else
@@ -154,3 +168,18 @@ uint64_t CFile::GetSize(void)
 
 	return size;
 }
+
+bool CFile::WriteBytes(const void* pBuffer, uint32_t numBytes)
+{
+	bool status = true;
+
+	DWORD bytesWritten = 0;
+
+	if ((WriteFile(hFile, pBuffer, numBytes, &bytesWritten, NULL) == 0) || (bytesWritten != numBytes))
+	{
+		Console::Write(L"Error: Could not write %u bytes to file\n", numBytes);
+		status = false;
+	}
+
+	return status;
+}
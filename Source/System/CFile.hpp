@@ -14,7 +14,7 @@ private:
 	~CFile();
 
 public:
-	static CFile* Open(const wchar_t* Path);
+	static CFile* Open(const wchar_t* Path, File::MODE Mode);
 	static void   Close(CFile* pCFile);
 
 public:
@@ -30,6 +30,7 @@ public:
 	virtual uint64_t GetSize(void);
 
 	virtual bool ReadBytes(void* pBuffer, uint32_t numBytes);
+	virtual bool WriteBytes(const void* pBuffer, uint32_t numBytes);
 };
 
 #endif // CG_CFILE_HPP
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "CMappedFile.hpp"
+
+#include <windows.h>
+
+MappedFile* MappedFile::Open(const wchar_t* Path)
+{
+	return static_cast<MappedFile*>(CMappedFile::Open(Path));
+}
+
+void MappedFile::Close(MappedFile* pIMappedFile)
+{
+	return CMappedFile::Close(static_cast<CMappedFile*>(pIMappedFile));
+}
+
+CMappedFile::CMappedFile()
+{
+	hFile = nullptr;
+	hMapping = nullptr;
+	pData = nullptr;
+	nSize = 0;
+}
+
+CMappedFile::~CMappedFile()
+{
+	CgAssert(hFile == nullptr, L"Mapped file handle not closed\n");
+}
+
+CMappedFile* CMappedFile::Open(const wchar_t* Path)
+{
+	bool status = true;
+
+	CMappedFile* pCMappedFile = new CMappedFile();
+
+	pCMappedFile->hFile = CreateFile(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (pCMappedFile->hFile == INVALID_HANDLE_VALUE)
+	{
+		Console::Write(L"Error: Could not open file %s for reading\n", Path);
+		status = false;
+	}
+
+	if (status)
+	{
+		LARGE_INTEGER fileSize = {};
+
+		if (GetFileSizeEx(pCMappedFile->hFile, &fileSize) != 0)
+		{
+			pCMappedFile->nSize = fileSize.QuadPart;
+		}
+		else
+		{
+			Console::Write(L"Error: Could not get file size\n");
+			status = false;
+		}
+	}
+
+	// empty files cannot be mapped, they have no data
+	if (status && (pCMappedFile->nSize > 0))
+	{
+		if (pCMappedFile->nSize > static_cast<uint64_t>(SIZE_MAX))
+		{
+			Console::Write(L"Error: File %s is too large to map\n", Path);
+			status = false;
+		}
+	}
+
+	if (status && (pCMappedFile->nSize > 0))
+	{
+		pCMappedFile->hMapping = CreateFileMapping(pCMappedFile->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (pCMappedFile->hMapping != NULL)
+		{
+			pCMappedFile->pData = static_cast<const uint8_t*>(MapViewOfFile(pCMappedFile->hMapping, FILE_MAP_READ, 0, 0, 0));
+		}
+
+		if (pCMappedFile->pData == nullptr)
+		{
+			Console::Write(L"Error: Could not map file %s\n", Path);
+			status = false;
+		}
+	}
+
+	if (!status)
+	{
+		CMappedFile::Close(pCMappedFile);
+		pCMappedFile = nullptr;
+	}
+
+	return pCMappedFile;
+}
+
+void CMappedFile::Close(CMappedFile* pCMappedFile)
+{
+	if (pCMappedFile->pData != nullptr)
+	{
+		UnmapViewOfFile(pCMappedFile->pData);
+		pCMappedFile->pData = nullptr;
+	}
+
+	if (pCMappedFile->hMapping != nullptr)
+	{
+		CloseHandle(pCMappedFile->hMapping);
+		pCMappedFile->hMapping = nullptr;
+	}
+
+	if ((pCMappedFile->hFile != nullptr) && (pCMappedFile->hFile != INVALID_HANDLE_VALUE))
+	{
+		CloseHandle(pCMappedFile->hFile);
+	}
+	pCMappedFile->hFile = nullptr;
+
+	delete pCMappedFile;
+}
+
+const uint8_t* CMappedFile::GetData(void)
+{
+	return pData;
+}
+
+uint64_t CMappedFile::GetSize(void)
+{
+	return nSize;
+}
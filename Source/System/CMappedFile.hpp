@@ -0,0 +1,28 @@
+#ifndef CG_CMAPPEDFILE_HPP
+#define CG_CMAPPEDFILE_HPP
+
+#include "Cg.hpp"
+#include "CgDef.hpp"
+
+class CMappedFile : public MappedFile
+{
+private:
+	HANDLE         hFile;
+	HANDLE         hMapping;
+	const uint8_t* pData;
+	uint64_t       nSize;
+
+private:
+	CMappedFile();
+	~CMappedFile();
+
+public:
+	static CMappedFile* Open(const wchar_t* Path);
+	static void         Close(CMappedFile* pCMappedFile);
+
+public:
+	virtual const uint8_t* GetData(void);
+	virtual uint64_t       GetSize(void);
+};
+
+#endif // CG_CMAPPEDFILE_HPP
@@ -0,0 +1,166 @@
+#include "Cg.hpp"
+#include "CParallel.hpp"
+
+/* Fixed pool of worker threads started by CgInitialize. A For call publishes one job, the workers and the calling */
+/* thread take ranges from a shared counter until none are left. Without workers (before CgInitialize, or on a */
+/* single core machine) For runs every range on the calling thread. */
+
+std::vector<std::thread> CParallel::m_Workers;
+std::mutex               CParallel::m_JobMutex;
+std::mutex               CParallel::m_Mutex;
+std::condition_variable  CParallel::m_WorkReady;
+std::condition_variable  CParallel::m_WorkDone;
+CParallel::JOB           CParallel::m_Job = {};
+uint64_t                 CParallel::m_Generation = 0;
+uint32_t                 CParallel::m_nActive = 0;
+bool                     CParallel::m_bExit = false;
+std::atomic<uint32_t>    CParallel::m_NextRange(0);
+std::atomic<uint32_t>    CParallel::m_nRemaining(0);
+
+static thread_local bool t_bInRange = false;
+
+uint32_t Parallel::GetThreadCount(void)
+{
+	return CParallel::GetThreadCount();
+}
+
+void Parallel::For(uint32_t Count, uint32_t Grain, RANGE_FUNCTION pFunction, void* pContext)
+{
+	CParallel::For(Count, Grain, pFunction, pContext);
+}
+
+bool CParallel::Initialize(void)
+{
+	bool status = true;
+
+	const uint32_t nCores = std::thread::hardware_concurrency();
+
+	m_bExit = false;
+
+	for (uint32_t i = 1; i < nCores; i++)
+	{
+		m_Workers.push_back(std::thread(WorkerMain));
+	}
+
+	return status;
+}
+
+bool CParallel::Uninitialize(void)
+{
+	bool status = true;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bExit = true;
+	}
+	m_WorkReady.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+	m_Workers.clear();
+
+	return status;
+}
+
+uint32_t CParallel::GetThreadCount(void)
+{
+	return static_cast<uint32_t>(m_Workers.size()) + 1;
+}
+
+void CParallel::For(uint32_t Count, uint32_t Grain, Parallel::RANGE_FUNCTION pFunction, void* pContext)
+{
+	JOB job = {};
+	job.pFunction = pFunction;
+	job.pContext  = pContext;
+	job.Count     = Count;
+	job.Grain     = (Grain > 0) ? Grain : 1;
+	job.nRanges   = static_cast<uint32_t>((static_cast<uint64_t>(Count) + job.Grain - 1) / job.Grain);
+
+	if (t_bInRange || m_Workers.empty() || (job.nRanges <= 1))
+	{
+		const bool bInRange = t_bInRange;
+		t_bInRange = true;
+		for (uint32_t begin = 0; begin < Count; begin += job.Grain)
+		{
+			pFunction(pContext, begin, (Count - begin > job.Grain) ? begin + job.Grain : Count);
+		}
+		t_bInRange = bInRange;
+		return;
+	}
+
+	std::lock_guard<std::mutex> jobLock(m_JobMutex);
+
+	{
+		// a worker that woke up after the previous job finished may still hold it, the counters are reset once it let go
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, []() { return m_nActive == 0; });
+
+		m_Job = job;
+		m_NextRange.store(0);
+		m_nRemaining.store(job.nRanges);
+		m_Generation++;
+	}
+	m_WorkReady.notify_all();
+
+	RunRanges(job);
+
+	// the job is finished when every range ran and no worker still reads it, the next job can then reuse the counters
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, []() { return (m_nRemaining.load() == 0) && (m_nActive == 0); });
+}
+
+void CParallel::WorkerMain(void)
+{
+	uint64_t generation = 0;
+
+	while (true)
+	{
+		JOB job = {};
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkReady.wait(lock, [&]() { return m_bExit || (m_Generation != generation); });
+
+			if (m_bExit)
+			{
+				break;
+			}
+
+			generation = m_Generation;
+			job = m_Job;
+			m_nActive++;
+		}
+
+		RunRanges(job);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_nActive--;
+		}
+		m_WorkDone.notify_all();
+	}
+}
+
+void CParallel::RunRanges(const JOB& job)
+{
+	t_bInRange = true;
+
+	uint32_t i = 0;
+	while ((i = m_NextRange.fetch_add(1)) < job.nRanges)
+	{
+		const uint32_t begin = i * job.Grain;
+		const uint32_t end   = (job.Count - begin > job.Grain) ? begin + job.Grain : job.Count;
+
+		job.pFunction(job.pContext, begin, end);
+
+		if (m_nRemaining.fetch_sub(1) == 1)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_WorkDone.notify_all();
+		}
+	}
+
+	t_bInRange = false;
+}
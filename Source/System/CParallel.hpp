@@ -0,0 +1,48 @@
+#ifndef CG_CPARALLEL_HPP
+#define CG_CPARALLEL_HPP
+
+#include "Cg.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CParallel
+{
+private:
+	struct JOB
+	{
+		Parallel::RANGE_FUNCTION pFunction;
+		void*                    pContext;
+		uint32_t                 Count;
+		uint32_t                 Grain;
+		uint32_t                 nRanges;
+	};
+
+	static std::vector<std::thread> m_Workers;
+	static std::mutex               m_JobMutex;  // one For at a time
+	static std::mutex               m_Mutex;     // guards the fields below
+	static std::condition_variable  m_WorkReady;
+	static std::condition_variable  m_WorkDone;
+	static JOB                      m_Job;
+	static uint64_t                 m_Generation;
+	static uint32_t                 m_nActive;   // workers still holding the current job
+	static bool                     m_bExit;
+	static std::atomic<uint32_t>    m_NextRange;
+	static std::atomic<uint32_t>    m_nRemaining;
+
+public:
+	static bool Initialize(void);
+	static bool Uninitialize(void);
+
+	static uint32_t GetThreadCount(void);
+	static void     For(uint32_t Count, uint32_t Grain, Parallel::RANGE_FUNCTION pFunction, void* pContext);
+
+private:
+	static void WorkerMain(void);
+	static void RunRanges(const JOB& job);
+};
+
+#endif // CG_CPARALLEL_HPP